@@ -717,6 +717,11 @@ namespace compiler {
 				case compiletime::TypeDescriptor::typeDictionary: {
 
 
+				} break;
+
+				case compiletime::TypeDescriptor::typeSet: {
+
+
 				} break;
 
 				case compiletime::TypeDescriptor::typeString: {
@@ -795,7 +800,9 @@ namespace compiler {
 			} break;
 
 			default: {
-
+				//other sends aren't lowered yet. Conversion messages 
+				//(stringVal etc) will call the runtime function from
+				//Compiletime::conversionRuntimeFunction here
 			} break;
 		}
 
@@ -856,6 +863,11 @@ namespace compiler {
 				const compiletime::Instance& inst = i.second;
 					
 			}
+
+			//string literals are constant data, nothing runs at startup
+			for (const auto& s : scope.getStaticStrings()) {
+				module->staticStringGlobal(s.second);
+			}
 			for (const auto& v : scope.getVariables()) {
 				const compiletime::Variable& var = v.second;
 				auto varName = var.getFullyQualifiedName();
@@ -1183,6 +1195,7 @@ namespace compiler {
 				s.assign(node.val);
 				std::string name = generateTempInstanceName(&node);
 				currentModule->getCurrentScope()->addStringLiteral(name, s);
+				currentModule->getCurrentScope()->addStaticString(name, node.val);
 					
 				compiletime::Instance newInst;
 				newInst.setName(name);
@@ -1,6 +1,7 @@
 #include "compiletime.h"
 
 #include "Compiler.h"
+#include "runtime_string_flags.h"
 
 
 namespace compiletime {
@@ -138,6 +139,48 @@ namespace compiletime {
 		currentNamespace = &globalNamespace;
 	}
 
+	llvm::GlobalVariable* Module::staticStringGlobal(const StaticString& str)
+	{
+		auto found = staticStrings.find(str.chars);
+		if (found != staticStrings.end()) {
+			return found->second;
+		}
+
+		auto& ctx = llvmModulePtr->getContext();
+		auto charTy = llvm::Type::getInt8Ty(ctx);
+		auto int32Ty = llvm::Type::getInt32Ty(ctx);
+		auto int64Ty = llvm::Type::getInt64Ty(ctx);
+
+		//the chars follow the header, like a runtime allocated string
+		typesystem::uint64T size = str.chars.size();
+		typesystem::uint64T capacity = size < 23 ? 23 : size;
+		auto charsTy = llvm::ArrayType::get(charTy, capacity + 1);
+		auto stringTy = llvm::StructType::get(ctx, { llvm::PointerType::get(charTy, 0), int64Ty, int64Ty, int64Ty, int32Ty, int32Ty, charsTy });
+
+		auto global = new llvm::GlobalVariable(*llvmModulePtr, stringTy, true, llvm::GlobalValue::PrivateLinkage, nullptr, ".strlit");
+		global->setAlignment(llvm::Align(8));
+		global->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+
+		llvm::Constant* charsIndex[] = { llvm::ConstantInt::get(int32Ty, 0), llvm::ConstantInt::get(int32Ty, 6), llvm::ConstantInt::get(int32Ty, 0) };
+		auto data = llvm::ConstantExpr::getInBoundsGetElementPtr(stringTy, global, charsIndex);
+
+		CppString chars = str.chars;
+		chars.resize(capacity + 1, 0);
+
+		global->setInitializer(llvm::ConstantStruct::get(stringTy, {
+			data,
+			llvm::ConstantInt::get(int64Ty, size),
+			llvm::ConstantInt::get(int64Ty, capacity),
+			llvm::ConstantInt::get(int64Ty, str.hash()),
+			llvm::ConstantInt::get(int32Ty, str.flags()),
+			llvm::ConstantInt::get(int32Ty, 1),
+			llvm::ConstantDataArray::getString(ctx, chars, false) }));
+
+		staticStrings.insert(std::make_pair(str.chars, global));
+
+		return global;
+	}
+
 	void Module::createGlobalScope(compiler::Compiler& c)
 	{
 		globalEnv = new ScopedEnvironment(c);
@@ -373,6 +416,14 @@ namespace compiletime {
 		auto res = strings.insert(std::make_pair(name, strlit));
 	}
 
+	void ScopedEnvironment::addStaticString(const CppString& name, const CppString& chars)
+	{
+		if (staticStrings.count(name) != 0) {
+			return;
+		}
+		staticStrings.insert(std::make_pair(name, StaticString(chars)));
+	}
+
 	void ScopedEnvironment::addPrimLiteral(const CppString& name, const Primitive& prim)
 	{
 		if (primitives.count(name) != 0) {
@@ -432,7 +483,8 @@ namespace compiletime {
 			{TypeDescriptor::typeString, "string"},
 			{TypeDescriptor::typeArray, "array"},
 			{TypeDescriptor::typeDictionary, "dictionary"},
-			{TypeDescriptor::typeMessage, "message"}
+			{TypeDescriptor::typeMessage, "message"},
+			{TypeDescriptor::typeSet, "set"}
 		};
 	}
 
@@ -446,4 +498,146 @@ namespace compiletime {
 	{
 		return Compiletime::primitiveTypes;
 	}
+
+	CppString Compiletime::hashtableRuntimeSuffix(TypeDescriptor keyType, TypeDescriptor valType)
+	{
+		CppString keyPart;
+		switch (keyType) {
+			case TypeDescriptor::typeInteger32: case TypeDescriptor::typeUInteger32: {
+				keyPart = "i32";
+			}break;
+
+			case TypeDescriptor::typeInteger64: case TypeDescriptor::typeUInteger64: {
+				keyPart = "i64";
+			}break;
+
+			case TypeDescriptor::typeString: {
+				keyPart = "str";
+			}break;
+
+			default: {
+				return CppString();
+			}break;
+		}
+
+		CppString valPart;
+		switch (valType) {
+			case TypeDescriptor::typeInteger32: case TypeDescriptor::typeUInteger32: {
+				valPart = "i32";
+			}break;
+
+			case TypeDescriptor::typeInteger64: case TypeDescriptor::typeUInteger64: {
+				valPart = "i64";
+			}break;
+
+			case TypeDescriptor::typeDouble64: {
+				valPart = "f64";
+			}break;
+
+			default: {
+				return CppString();
+			}break;
+		}
+
+		return keyPart + "_" + valPart;
+	}
+
+	CppString Compiletime::conversionRuntimeFunction(TypeDescriptor receiverType, const CppString& selector)
+	{
+		switch (receiverType) {
+			case TypeDescriptor::typeInteger8: case TypeDescriptor::typeInteger16: 
+			case TypeDescriptor::typeInteger32: case TypeDescriptor::typeInteger64: {
+				if (selector == "stringVal") {
+					return "Runtime_int64_stringVal";
+				}
+			}break;
+
+			case TypeDescriptor::typeUInteger8: case TypeDescriptor::typeUInteger16:
+			case TypeDescriptor::typeUInteger32: case TypeDescriptor::typeUInteger64: {
+				if (selector == "stringVal") {
+					return "Runtime_uint64_stringVal";
+				}
+			}break;
+
+			case TypeDescriptor::typeDouble32: case TypeDescriptor::typeDouble64: {
+				if (selector == "stringVal") {
+					return "Runtime_real64_stringVal";
+				}
+			}break;
+
+			case TypeDescriptor::typeString: {
+				if (selector == "intVal") {
+					return "Runtime_string_intVal";
+				}
+				if (selector == "realVal") {
+					return "Runtime_string_realVal";
+				}
+			}break;
+
+			default: {
+			}break;
+		}
+
+		return CppString();
+	}
+
+
+
+	typesystem::uint64T StaticString::hash() const
+	{
+		return PerfectHash::hashKey(chars);
+	}
+
+	typesystem::uint32T StaticString::flags() const
+	{
+		return RUNTIME_STRING_FLAGS_STATIC | (isValidUtf8(chars) ? RUNTIME_STRING_FLAG_UTF8_VALID : 0);
+	}
+
+	bool StaticString::isValidUtf8(const CppString& chars)
+	{
+		size_t i = 0;
+		while (i < chars.size()) {
+			typesystem::uint8T lead = (typesystem::uint8T)chars[i];
+			size_t count = 0;
+			typesystem::uint32T codePoint = 0;
+			if (lead < 0x80) {
+				i++;
+				continue;
+			}
+			else if (lead >= 0xC2 && lead <= 0xDF) {
+				count = 1;
+				codePoint = lead & 0x1F;
+			}
+			else if (lead >= 0xE0 && lead <= 0xEF) {
+				count = 2;
+				codePoint = lead & 0x0F;
+			}
+			else if (lead >= 0xF0 && lead <= 0xF4) {
+				count = 3;
+				codePoint = lead & 0x07;
+			}
+			else {
+				return false;
+			}
+
+			if (i + count >= chars.size()) {
+				return false;
+			}
+			for (size_t k = 1; k <= count; k++) {
+				typesystem::uint8T cont = (typesystem::uint8T)chars[i + k];
+				if ((cont & 0xC0) != 0x80) {
+					return false;
+				}
+				codePoint = (codePoint << 6) | (cont & 0x3F);
+			}
+
+			//overlong forms, surrogates, past U+10FFFF
+			if ((2 == count && codePoint < 0x800) || (3 == count && (codePoint < 0x10000 || codePoint > 0x10FFFF)) ||
+				(codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+				return false;
+			}
+			i += count + 1;
+		}
+		return true;
+	}
 }
@@ -12,6 +12,7 @@
 #include <chrono>
 
 #include "datatypes.h"
+#include "perfect_hash.h"
 
 
 #include "llvm/IR/Module.h"
@@ -471,6 +472,28 @@ namespace compiletime {
 		CppString remotePath;
 	};
 
+	/*
+	* a string literal, emitted as constant data laid out as a 
+	* Runtime_static_string (see scratch_runtime.h): the string header 
+	* with size and hash worked out here, followed by the chars. The 
+	* runtime treats it as immortal, so using it costs no allocation 
+	* or copy at runtime or at startup
+	*/
+	class StaticString {
+	public:
+		CppString chars;
+
+		StaticString() {}
+		StaticString(const CppString& c) :chars(c) {}
+
+		//Runtime_string_hash of the chars
+		typesystem::uint64T hash() const;
+		//Runtime_static_string_flags, plus utf8 valid if the chars are
+		typesystem::uint32T flags() const;
+
+		static bool isValidUtf8(const CppString& chars);
+	};
+
 	class Module : public CodeElement {
 	public:
 
@@ -512,6 +535,10 @@ namespace compiletime {
 		NamespaceBlock* createNewNamespace(const CppString& name);
 
 		virtual bool scopeConsideredGlobal() const { return true; }
+
+		//the constant for a string literal, literals with the same 
+		//chars share one
+		::llvm::GlobalVariable* staticStringGlobal(const StaticString& str);
 	private:
 		ScopedEnvironment* globalEnv = nullptr;
 		ScopedEnvironment* currentScope = nullptr;
@@ -521,6 +548,8 @@ namespace compiletime {
 		std::map<CppString, Import> imports;
 		NamespaceBlock globalNamespace;
 		NamespaceBlock* currentNamespace;
+
+		std::map<CppString, ::llvm::GlobalVariable*> staticStrings;
 	};
 
 
@@ -713,6 +742,12 @@ namespace compiletime {
 			return strings.find(name)->second;
 		}
 
+		void addStaticString(const CppString& name, const CppString& chars);
+
+		const std::map<CppString, StaticString>& getStaticStrings() const {
+			return staticStrings;
+		}
+
 
 		void addPrimLiteral(const CppString& name, const Primitive& prim);
 
@@ -746,6 +781,7 @@ namespace compiletime {
 		std::map<CppString, SendMessage> msgSends;
 
 		std::map<CppString, datatypes::string> strings;
+		std::map<CppString, StaticString> staticStrings;
 
 		std::map<CppString, Primitive> primitives;
 
@@ -761,6 +797,17 @@ namespace compiletime {
 		static bool init();
 
 		static const std::map< TypeDescriptor, std::string>& globalPrims();
+
+		//suffix of the runtime's typed hashtable insert/at for a 
+		//key/value pair, i.e. Runtime_hashtable_insert_<suffix>,
+		//empty if the pair only has the generic calls
+		static CppString hashtableRuntimeSuffix(TypeDescriptor keyType, TypeDescriptor valType);
+
+		//runtime function implementing a conversion message 
+		//(stringVal, intVal, realVal) sent to a receiver of the given
+		//type, empty if the runtime has none for it. Nothing calls it
+		//yet, only assignment sends are lowered so far
+		static CppString conversionRuntimeFunction(TypeDescriptor receiverType, const CppString& selector);
 	private:			
 		Compiletime();
 
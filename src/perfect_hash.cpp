@@ -0,0 +1,114 @@
+#include "perfect_hash.h"
+
+#include <algorithm>
+
+
+namespace compiletime {
+
+	typesystem::uint64T PerfectHash::hashKey(const CppString& key)
+	{
+		typesystem::uint64T result = 0;
+		for (auto ch : key) {
+			result ^= (typesystem::uint64T)(typesystem::uint8T)ch;
+			result *= 1099511628211ULL;
+		}
+		return result;
+	}
+
+	typesystem::uint64T PerfectHash::bucketFor(typesystem::uint64T hash, typesystem::uint64T bucketCount)
+	{
+		hash = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccdULL;
+		return (hash ^ (hash >> 33)) % bucketCount;
+	}
+
+	typesystem::uint64T PerfectHash::slotFor(typesystem::uint64T hash, typesystem::uint32T seed, typesystem::uint64T size)
+	{
+		hash += ((typesystem::uint64T)seed + 1) * 0x9e3779b97f4a7c15ULL;
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+		return (hash ^ (hash >> 31)) % size;
+	}
+
+	//hash and displace. Keys are grouped into buckets, averaging 4
+	//keys each, then starting with the biggest bucket each one gets 
+	//the first seed that puts all its keys in free slots
+	bool PerfectHash::build(const std::vector<CppString>& keys)
+	{
+		const typesystem::uint32T maxSeed = 1 << 20;
+
+		seeds.clear();
+		slots.clear();
+		if (keys.empty()) {
+			return true;
+		}
+
+		typesystem::uint64T size = keys.size();
+		std::vector<typesystem::uint64T> hashes(size);
+		for (typesystem::uint64T i = 0; i < size; i++) {
+			hashes[i] = hashKey(keys[i]);
+		}
+
+		//slots only depend on the hash, keys hashing the same (equal 
+		//ones included) never separate whatever the seed
+		std::vector<typesystem::uint64T> sorted(hashes);
+		std::sort(sorted.begin(), sorted.end());
+		if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+			return false;
+		}
+
+		std::vector<std::vector<typesystem::uint64T>> buckets((size + 3) / 4);
+		for (typesystem::uint64T i = 0; i < size; i++) {
+			buckets[bucketFor(hashes[i], buckets.size())].push_back(i);
+		}
+
+		std::vector<typesystem::uint64T> order(buckets.size());
+		for (typesystem::uint64T b = 0; b < order.size(); b++) {
+			order[b] = b;
+		}
+		std::stable_sort(order.begin(), order.end(), [&](typesystem::uint64T lhs, typesystem::uint64T rhs) {
+			return buckets[lhs].size() > buckets[rhs].size();
+		});
+
+		seeds.assign(buckets.size(), 0);
+		slots.assign(size, 0);
+		std::vector<bool> taken(size, false);
+		std::vector<typesystem::uint64T> placed;
+
+		for (auto b : order) {
+			const auto& bucket = buckets[b];
+			if (bucket.empty()) {
+				break;
+			}
+
+			bool found = false;
+			for (typesystem::uint32T seed = 0; seed < maxSeed && !found; seed++) {
+				placed.clear();
+				found = true;
+				for (auto k : bucket) {
+					auto slot = slotFor(hashes[k], seed, size);
+					if (taken[slot] || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+						found = false;
+						break;
+					}
+					placed.push_back(slot);
+				}
+
+				if (found) {
+					seeds[b] = seed;
+					for (typesystem::uint64T i = 0; i < bucket.size(); i++) {
+						slots[bucket[i]] = placed[i];
+						taken[placed[i]] = true;
+					}
+				}
+			}
+
+			if (!found) {
+				seeds.clear();
+				slots.clear();
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
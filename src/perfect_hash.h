@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "types.h"
+
+
+namespace compiletime {
+
+	typedef std::string CppString;
+
+	/*
+	* minimal perfect hash over a dictionary's literal keys, emitted as
+	* a Runtime_static_dictionary (see scratch_runtime.h). Key i goes in
+	* slot slots[i], buckets get the seeds that make that collision free.
+	* Kept apart from compiletime.h so it builds without LLVM
+	*/
+	class PerfectHash {
+	public:
+		std::vector<typesystem::uint32T> seeds;
+		std::vector<typesystem::uint64T> slots;
+
+		//false for duplicate keys (or keys with the same hash), or if 
+		//no seeds could be found. The dictionary has to be built at 
+		//runtime then
+		bool build(const std::vector<CppString>& keys);
+
+		typesystem::uint64T bucketCount() const { return seeds.size(); }
+
+		//these have to match the runtime's Runtime_static_dictionary_hash,
+		//Runtime_static_dictionary_bucket/slot. The hash is also what
+		//Runtime_string_hash gives for the key, so lookups by string use
+		//the hash cached in it
+		static typesystem::uint64T hashKey(const CppString& key);
+		static typesystem::uint64T bucketFor(typesystem::uint64T hash, typesystem::uint64T bucketCount);
+		static typesystem::uint64T slotFor(typesystem::uint64T hash, typesystem::uint32T seed, typesystem::uint64T size);
+	};
+}
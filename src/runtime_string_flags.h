@@ -0,0 +1,23 @@
+#pragma once
+
+//runtime_string_flags.h
+
+/*
+* Runtime_string flag bits, shared by the runtime (scratch_runtime.h,
+* Runtime_string_flags) and the compiler, which bakes them into the
+* string literals it emits as Runtime_static_strings. Plain defines,
+* no includes, so both sides can pull this in
+*/
+
+//owned by the intern pool, see Runtime_string_intern
+#define RUNTIME_STRING_FLAG_INTERNED		0x0001
+#define RUNTIME_STRING_FLAG_VIEW			0x0002
+//Runtime_string_is_utf8 has looked at the chars, and what it found
+#define RUNTIME_STRING_FLAG_UTF8_CHECKED	0x0004
+#define RUNTIME_STRING_FLAG_UTF8_VALID		0x0008
+#define RUNTIME_STRING_FLAG_IMMORTAL		0x0010
+//the separate buffer belongs to the holder in parent
+#define RUNTIME_STRING_FLAG_SHARED_BUFFER	0x0020
+
+//what every string literal starts out with
+#define RUNTIME_STRING_FLAGS_STATIC		(RUNTIME_STRING_FLAG_IMMORTAL | RUNTIME_STRING_FLAG_UTF8_CHECKED)
@@ -37,30 +37,6 @@ public:
 };
 
 
-class Decimal {
-	double d=0.0;
-public:
-	Decimal() {}
-	Decimal(double v):d(v) {}
-
-	Decimal& operator=(double v) {
-		d = v;
-		return *this;
-	}
-
-	int32T intpart() const {
-		return (int32T)d;
-	}
-	int32T decimal(int ndr) const {
-		auto tmp = (d - (double)intpart());
-		for (int i = 0; i < ndr; i++) {
-			tmp *= 10.0;
-		}
-		return (int32T)tmp;
-	}
-};
-
-
 extern uint64T Runtime_mem_cpy(void* src, void* dest, uint64T size);
 
 int main()
@@ -87,9 +63,8 @@ int main()
 	v = 574743;
 	Runtime_hashtable_insert(ht, &k, &v);
 	t.stop();
-	Decimal dur(t);
 
-	Runtime_printf("took: %d.%d ms\n", dur.intpart(), dur.decimal(3));
+	Runtime_printf("took: %.3f ms\n", (double)t);
 
 	auto val = Runtime_hashtable_at(ht, &k);
 	Runtime_printf("k: %d, v: %d \n", k, *((int32T*)val) );
@@ -107,8 +82,7 @@ int main()
 	}
 
 	t.stop();
-	dur = t;
-	Runtime_printf("Runtime_hashtable_insert took: %d.%d ms for %d \n", dur.intpart(), dur.decimal(3), (int)Runtime_hashtable_size(ht));
+	Runtime_printf("Runtime_hashtable_insert took: %.3f ms for %d \n", (double)t, (int)Runtime_hashtable_size(ht));
 
 	k = 234 * 3 + 1;
 
@@ -118,8 +92,7 @@ int main()
 
 	Runtime_printf("k: %d, v: %d \n", k, *((int32T*)val));
 	
-	dur = t;
-	Runtime_printf("took: %d.%d ms\n", dur.intpart(), dur.decimal(3));
+	Runtime_printf("took: %.3f ms\n", (double)t);
 
 	Runtime_hashtable_erase(ht, &k);
 
@@ -133,8 +106,7 @@ int main()
 	t.start();
 	Runtime_hashtable_delete(ht);
 	t.stop();
-	dur = t;
-	Runtime_printf("Runtime_hashtable_delete took: %d.%d ms\n", dur.intpart(), dur.decimal(3));
+	Runtime_printf("Runtime_hashtable_delete took: %.3f ms\n", (double)t);
 
 
 
@@ -2,6 +2,7 @@
 
 //#include <cstdio>
 #include <Windows.h>
+#include <intrin.h>
 #include <functional>
 #include <string>
 
@@ -39,15 +40,22 @@ constexpr size_t Runtime_FNV_prime = 16777619U;
 
 
 //platform/os calls
-void Win32_printf_arglist(const char* fmtStr, va_list argList);
-void Win32_debug_printf_arglist(const char* fmtStr, va_list argList);
-void Win32_debug_printf(const char* fmtStr,...);
+void* Win32_stdout_handle(bool* isConsolePtr);
+void Win32_write_file(void* handle, const void* data, uint64T size);
+void Win32_debug_output(const char* str);
 void Win32_Runtime_error(int32T err);
 void Win32_Memory_init(void* mem, uint64T size);
 void* Win32_Runtime_alloc(uint64T size);
 void Win32_Runtime_free(void* mem);
 char** Win32_get_command_line(int32T* argcPtr);
 void Win32_Runtime_assert(const char* msg, const char* functionName, const char* filename, uint64T lineno );
+void* Win32_map_file(const char* path, uint64T* sizePtr, bool writable, bool create, void** fileHandlePtr, void** mappingHandlePtr);
+bool Win32_flush_mapped_file(void* view, uint64T size, void* fileHandle);
+void Win32_unmap_file(void* view, void* fileHandle, void* mappingHandle);
+void Win32_lock_init(void* lock);
+void Win32_lock_acquire(void* lock);
+void Win32_lock_release(void* lock);
+uint32T Win32_current_thread_id();
 
 
 
@@ -104,6 +112,10 @@ struct Runtime_memory_info {
 	//uint8T wiould be 1, etc
 	uint64T size;
 	void* memPtr;
+
+	//keeps the header 32 bytes so the memory handed 
+	//out is 16 byte aligned
+	uint64T reserved;
 };
 
 
@@ -139,8 +151,48 @@ struct Runtime_stack_array {
 };
 
 
+struct Runtime_mapped_array {
+
+	//number of elements in array, from the file header
+	uint64T size;
+	//points into the mapped view, dataOffset bytes
+	//past the header
+	void* data;
+	//info about the array, potentially
+	//shared amongst array instances
+	Runtime_array_info* infoPtr;
+
+	//start of the mapped view
+	Runtime_mapped_array_header* header;
+	uint64T mappedSize;
+	Runtime_array_map_mode mode;
+
+	//OS handles for the file and mapping objects
+	void* fileHandle;
+	void* mappingHandle;
+};
+
+
+struct Runtime_bit_array {
+
+	//number of bits in the array
+	uint64T size;
+	//number of bits allocated, always a multiple of 64
+	uint64T capacity;
+
+	//packed bits, bit i is (data[i/64] >> (i%64)) & 1
+	//bits past size in the last word are always 0
+	uint64T* data;
+
+	Runtime_array_info* infoPtr;
+};
+
+
 #define RUNTIME_HEAP_ARRAY(arr) ((Runtime_heap_array*)((Runtime_array*)arr)->internalData)
 #define RUNTIME_STACK_ARRAY(arr) ((Runtime_stack_array*)((Runtime_array*)arr)->internalData)
+#define RUNTIME_MAPPED_ARRAY(arr) ((Runtime_mapped_array*)((Runtime_array*)arr)->internalData)
+#define RUNTIME_BIT_ARRAY(arr) ((Runtime_bit_array*)((Runtime_array*)arr)->internalData)
+#define RUNTIME_BIT_ARRAY_WORDS(bitCount) (((bitCount) + 63) >> 6)
 
 //meta data about array data
 struct Runtime_hashtable_info {
@@ -151,31 +203,95 @@ struct Runtime_hashtable_info {
 	//length in bytes for each key/value
 	uint64T keyStride;
 	uint64T valStride;
+
+	//registry entries for the key/value types, 
+	//for the copy/destroy/hash/equals hooks
+	Runtime_type_info* keyTypeInfo;
+	Runtime_type_info* valTypeInfo;
+
+	//hashtable slot layout, key at 0, value at valOffset
+	uint64T valOffset;
+	uint64T slotStride;
+	//the larger of the key/value alignments, at least 8
+	uint64T slotAlign;
+	//ordered hashtable entries, slot followed by the hash
+	uint64T entryStride;
+
+	//insert/at specialized for the key/value pair, nullptr 
+	//if there's no specialization for it
+	void (*typedInsert)(Runtime_hashtable_handle self, void* key, void* val);
+	void* (*typedAt)(Runtime_hashtable_handle self, void* key);
 };
 
 
+//descriptors below this are looked up directly in builtinTypeSlots
+#define RUNTIME_BUILTIN_TYPE_TABLE_SIZE	256
+#define RUNTIME_NO_TYPE_SLOT	0xFFFF
 
 
+//all the per type lists are indexed by "slot". Built-in types
+//take the first slots, user types follow in registration order.
+//Lists are allocated for typeSlotCapacity slots up front so
+//pointers into them stay valid as types get registered
+struct Runtime_hashtable_object;
+
 struct Runtime_Instance {
+	//descriptor -> slot for built-in types
+	uint16T builtinTypeSlots[RUNTIME_BUILTIN_TYPE_TABLE_SIZE];
+	uint32T builtinTypeCount;
+	uint32T userTypeCount;
+	uint32T typeSlotCapacity;
+
+	Runtime_type_info* typeInfoList;
+
 	Runtime_array_info* arrayInfoList;
 	uint32T arrayInfoListSize;
 	uint32T initialArrayInfoSize;
 
-
-	Runtime_hashtable_info* hashtableInfoList;
-	uint32T hashtableInfoListSize;
-	uint32T initialHashtableInfoSize;
+	//typeSlotCapacity rows of typeSlotCapacity entries, 
+	//row k is allocated the first time a hashtable with 
+	//a key in slot k is created
+	Runtime_hashtable_info** hashtableInfoRows;
+
+	//sets, hashtable info with no value, indexed by key slot
+	Runtime_hashtable_info* setInfoList;
+
+	//Runtime_hashtable_set_stats_dump, the largest tables
+	//deleted so far, biggest first
+	void* hashtableStatsLock;
+	uint32T hashtableStatsDumpCount;
+	uint32T hashtableStatsCount;
+	Runtime_hashtable_stats* hashtableStats;
+	//hashtables created while the dump is on and not deleted yet, 
+	//linked through liveNext/livePrev under hashtableStatsLock, so
+	//the dump sees the ones still alive at terminate too
+	Runtime_hashtable_object* liveHashtables;
+
+	//Runtime_string_intern. The pool is a set of the interned strings,
+	//internCache is a lock free, direct mapped (by hash) cache in 
+	//front of it
+	void* internLock;
+	Runtime_set_handle internPool;
+	Runtime_string_handle volatile* internCache;
 };
 
 Runtime_Instance* runtimeInstancePtr = nullptr;
 Runtime_memory_info nilInfo;
 uint64T totalBytesHeapAllocated;
 
-#define RUNTIME_ARRAY_CAPACITY_MULTIPLIER	1.5
-#define RUNTIME_ARRAY_CAPACITY_SMALL_MULTIPLIER	2.0
 
+enum Runtime_cpu_features {
+	rtCpuPopcnt = 0x0001,
+	rtCpuSSSE3 = 0x0002,
+	rtCpuSSE42 = 0x0004,
+	rtCpuAVX2 = 0x0008,
+};
+
+//some set of Runtime_cpu_features, filled in by Runtime_init
+uint32T runtimeCpuFeatures = 0;
 
-#define WIN32_MAX_PRINTF_BUFFER_SIZE  1024 
+#define RUNTIME_ARRAY_CAPACITY_MULTIPLIER	1.5
+#define RUNTIME_ARRAY_CAPACITY_SMALL_MULTIPLIER	2.0
 
 
 //----------------------------------------------------------------------------
@@ -184,48 +300,38 @@ uint64T totalBytesHeapAllocated;
 
 
 
-void Win32_printf_arglist(const char* fmtStr, va_list argList)
+//isConsole is false when stdout is redirected to a file or pipe
+void* Win32_stdout_handle(bool* isConsolePtr)
 {
-	char buf[WIN32_MAX_PRINTF_BUFFER_SIZE];
-	int res = wvsprintfA(buf, fmtStr, argList);
-	if (res > 0 && res < (sizeof(buf) - 1)) {
-
-		buf[res] = 0;
-		DWORD done;
-		WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), buf, lstrlen(buf), &done, NULL);
-	}
-
+	HANDLE handle = GetStdHandle(STD_OUTPUT_HANDLE);
+	*isConsolePtr = FILE_TYPE_CHAR == GetFileType(handle);
+	return handle;
 }
 
-
-void Win32_debug_printf_arglist(const char* fmtStr, va_list argList)
+void Win32_write_file(void* handle, const void* data, uint64T size)
 {
-	char buf[WIN32_MAX_PRINTF_BUFFER_SIZE];
-	int res = wvsprintfA(buf, fmtStr, argList);
-	if (res > 0 && res < (sizeof(buf) - 1)) {
-		buf[res] = 0;	
-
-		DWORD done;
-		WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), buf, lstrlen(buf), &done, NULL);
-
-		OutputDebugStringA(buf);
+	auto src = (const uint8T*)data;
+	while (size > 0) {
+		DWORD chunk = size > 0x40000000 ? 0x40000000 : (DWORD)size;
+		DWORD done = 0;
+		if (!WriteFile((HANDLE)handle, src, chunk, &done, NULL) || 0 == done) {
+			break;
+		}
+		src += done;
+		size -= done;
 	}
 }
 
-void Win32_debug_printf(const char* fmtStr, ...)
+void Win32_debug_output(const char* str)
 {
-	va_list argList;
-	va_start(argList, fmtStr);
-
-	Win32_debug_printf_arglist(fmtStr, argList);
-
-	va_end(argList);
+	OutputDebugStringA(str);
 }
 
 
 void Win32_Runtime_error(int32T err)
 {
 	Runtime_printf("Exiting with error code : %d\n", err);
+	Runtime_output_flush();
 	ExitProcess(err);
 }
 
@@ -335,6 +441,110 @@ void Win32_Runtime_assert(const char* msg, const char* functionName, const char*
 }
 
 
+//maps the whole file. If create is true the file is
+//created/truncated and grown to *sizePtr bytes, otherwise
+//*sizePtr is set to the size of the existing file
+void* Win32_map_file(const char* path, uint64T* sizePtr, bool writable, bool create, void** fileHandlePtr, void** mappingHandlePtr)
+{
+	*fileHandlePtr = nullptr;
+	*mappingHandlePtr = nullptr;
+
+	DWORD access = writable ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ;
+	DWORD creation = create ? CREATE_ALWAYS : OPEN_EXISTING;
+
+	HANDLE file = CreateFileA(path, access, FILE_SHARE_READ, NULL, creation, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file) {
+		Runtime_debug_printf("CreateFileA failed for %s, err: %d \n", path, GetLastError());
+		return nullptr;
+	}
+
+	uint64T size = *sizePtr;
+	if (!create) {
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(file, &fileSize)) {
+			Runtime_debug_printf("GetFileSizeEx failed for %s, err: %d \n", path, GetLastError());
+			CloseHandle(file);
+			return nullptr;
+		}
+		size = (uint64T)fileSize.QuadPart;
+	}
+
+	if (0 == size) {
+		//can't map an empty file
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	//for a new file this also extends it to size bytes
+	HANDLE mapping = CreateFileMappingA(file, NULL, writable ? PAGE_READWRITE : PAGE_READONLY, (DWORD)(size >> 32), (DWORD)(size & 0xFFFFFFFF), NULL);
+	if (NULL == mapping) {
+		Runtime_debug_printf("CreateFileMappingA failed for %s, err: %d \n", path, GetLastError());
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	void* view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+	if (nullptr == view) {
+		Runtime_debug_printf("MapViewOfFile failed for %s, err: %d \n", path, GetLastError());
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return nullptr;
+	}
+
+	*sizePtr = size;
+	*fileHandlePtr = file;
+	*mappingHandlePtr = mapping;
+
+	return view;
+}
+
+bool Win32_flush_mapped_file(void* view, uint64T size, void* fileHandle)
+{
+	if (!FlushViewOfFile(view, size)) {
+		Runtime_debug_printf("FlushViewOfFile failed, err: %d \n", GetLastError());
+		return false;
+	}
+	//FlushViewOfFile only queues the writes, wait for them to hit the disk
+	return FlushFileBuffers((HANDLE)fileHandle) ? true : false;
+}
+
+void Win32_unmap_file(void* view, void* fileHandle, void* mappingHandle)
+{
+	if (nullptr != view) {
+		UnmapViewOfFile(view);
+	}
+	if (nullptr != mappingHandle) {
+		CloseHandle((HANDLE)mappingHandle);
+	}
+	if (nullptr != fileHandle) {
+		CloseHandle((HANDLE)fileHandle);
+	}
+}
+
+
+//lock is an SRWLOCK, which is pointer sized and
+//needs no cleanup
+void Win32_lock_init(void* lock)
+{
+	InitializeSRWLock((PSRWLOCK)lock);
+}
+
+void Win32_lock_acquire(void* lock)
+{
+	AcquireSRWLockExclusive((PSRWLOCK)lock);
+}
+
+void Win32_lock_release(void* lock)
+{
+	ReleaseSRWLockExclusive((PSRWLOCK)lock);
+}
+
+uint32T Win32_current_thread_id()
+{
+	return GetCurrentThreadId();
+}
+
+
 //end of platform specific stuff
 //----------------------------------------------------------------------------
 
@@ -399,6 +609,10 @@ uint64T Runtime_calc_stride_for_type(Runtime_TypeDescriptor type)
 			result = sizeof(void*);
 		}break;
 
+		case typeSet: {
+			result = sizeof(void*);
+		}break;
+
 		case typeMessage: {
 			result = sizeof(void*);
 		}break;
@@ -417,44 +631,86 @@ uint64T Runtime_calc_stride_for_type(Runtime_TypeDescriptor type)
 
 
 
-void Runtime_printf_arglist(const char* fmtStr, va_list argList)
+void Runtime_error(int32T errCode)
 {
-	Win32_printf_arglist(fmtStr, argList);
+	Win32_Runtime_error(errCode);
 }
 
 
-
-void Runtime_debug_printf(const char* fmtStr, ...)
+uint32T Runtime_detect_cpu_features()
 {
-#ifdef SCRATCH_RUNTIME_DEBUG
-	Win32_debug_printf("DEBUG ");
-	va_list argList;
-	va_start(argList, fmtStr);
-
-	Win32_debug_printf_arglist(fmtStr, argList);
-
-	va_end(argList);
-#endif
-}
+	uint32T result = 0;
+	int regs[4] = { 0 };
 
+	__cpuid(regs, 0);
+	int maxLeaf = regs[0];
 
-void Runtime_printf(const char* fmtStr, ...)
-{
-
-	va_list argList;
-	va_start(argList, fmtStr);
+	if (maxLeaf >= 1) {
+		__cpuid(regs, 1);
+		if (regs[2] & (1 << 23)) {
+			result |= rtCpuPopcnt;
+		}
+		if (regs[2] & (1 << 9)) {
+			result |= rtCpuSSSE3;
+		}
+		if (regs[2] & (1 << 20)) {
+			result |= rtCpuSSE42;
+		}
+	}
 
-	Runtime_printf_arglist(fmtStr, argList);
+	if (maxLeaf >= 7) {
+		__cpuidex(regs, 7, 0);
+		if (regs[1] & (1 << 5)) {
+			result |= rtCpuAVX2;
+		}
+	}
 
-	va_end(argList);
+	return result;
 }
 
+inline bool Runtime_cpu_has(Runtime_cpu_features feature)
+{
+	return (runtimeCpuFeatures & feature) != 0;
+}
 
+//SWAR fallback for CPUs without POPCNT
+inline uint64T Runtime_popcount64_swar(uint64T v)
+{
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (v * 0x0101010101010101ULL) >> 56;
+}
 
+inline uint64T Runtime_popcount64(uint64T v)
+{
+	return Runtime_cpu_has(rtCpuPopcnt) ? __popcnt64(v) : Runtime_popcount64_swar(v);
+}
 
-void Runtime_error(int32T errCode)
+uint64T Runtime_popcount_words(const uint64T* words, uint64T count)
 {
-	Win32_Runtime_error(errCode);
+	uint64T i = 0;
+
+	if (Runtime_cpu_has(rtCpuPopcnt)) {
+		//independent accumulators so the popcnt's can overlap
+		uint64T c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+		for (; i + 4 <= count; i += 4) {
+			c0 += __popcnt64(words[i]);
+			c1 += __popcnt64(words[i + 1]);
+			c2 += __popcnt64(words[i + 2]);
+			c3 += __popcnt64(words[i + 3]);
+		}
+		for (; i < count; i++) {
+			c0 += __popcnt64(words[i]);
+		}
+		return c0 + c1 + c2 + c3;
+	}
+
+	uint64T result = 0;
+	for (; i < count; i++) {
+		result += Runtime_popcount64_swar(words[i]);
+	}
+	return result;
 }
 
 
@@ -643,6 +899,154 @@ bool Runtime_isMemOnStack(Runtime_objectinfo_ptr* objInfo)
 
 
 
+//----------------------------------------------------------------------------
+//type registry
+
+
+inline uint32T Runtime_type_slot(Runtime_TypeDescriptor type)
+{
+	uint32T t = (uint32T)type;
+	if (t < RUNTIME_BUILTIN_TYPE_TABLE_SIZE) {
+		return runtimeInstancePtr->builtinTypeSlots[t];
+	}
+
+	if (t >= typeUserTypeBase && (t - typeUserTypeBase) < runtimeInstancePtr->userTypeCount) {
+		return runtimeInstancePtr->builtinTypeCount + (t - typeUserTypeBase);
+	}
+
+	return RUNTIME_NO_TYPE_SLOT;
+}
+
+inline bool Runtime_is_user_type(Runtime_TypeDescriptor type)
+{
+	return (uint32T)type >= typeUserTypeBase;
+}
+
+
+//stride for an element held by value
+uint64T Runtime_type_info_stride(const Runtime_type_info* info)
+{
+	if (0 == info->alignment) {
+		return info->size;
+	}
+	return (info->size + info->alignment - 1) & ~(info->alignment - 1);
+}
+
+
+void Runtime_hashtable_info_select_typed(Runtime_hashtable_info* htInfo);
+
+void Runtime_hashtable_info_init(Runtime_hashtable_info* htInfo, uint32T keySlot, uint32T valSlot)
+{
+	Runtime_Memory_init(htInfo, sizeof(Runtime_hashtable_info));
+
+	Runtime_type_info* keyInfo = &runtimeInstancePtr->typeInfoList[keySlot];
+	Runtime_type_info* valInfo = &runtimeInstancePtr->typeInfoList[valSlot];
+
+	htInfo->keyType = keyInfo->type;
+	htInfo->valueType = valInfo->type;
+	htInfo->keyStride = runtimeInstancePtr->arrayInfoList[keySlot].stride;
+	htInfo->valStride = runtimeInstancePtr->arrayInfoList[valSlot].stride;
+	htInfo->keyTypeInfo = keyInfo;
+	htInfo->valTypeInfo = valInfo;
+
+	uint64T keyAlign = keyInfo->alignment > 8 ? keyInfo->alignment : 8;
+	uint64T valAlign = valInfo->alignment > 8 ? valInfo->alignment : 8;
+	uint64T slotAlign = keyAlign > valAlign ? keyAlign : valAlign;
+
+	htInfo->valOffset = (htInfo->keyStride + valAlign - 1) & ~(valAlign - 1);
+	htInfo->slotStride = (htInfo->valOffset + htInfo->valStride + slotAlign - 1) & ~(slotAlign - 1);
+	htInfo->slotAlign = slotAlign;
+	htInfo->entryStride = (htInfo->slotStride + sizeof(uint64T) + slotAlign - 1) & ~(slotAlign - 1);
+
+	Runtime_hashtable_info_select_typed(htInfo);
+}
+
+//info for a set of keys in keySlot, laid out like a hashtable 
+//with a zero sized value
+void Runtime_set_info_init(Runtime_hashtable_info* htInfo, uint32T keySlot)
+{
+	Runtime_Memory_init(htInfo, sizeof(Runtime_hashtable_info));
+
+	Runtime_type_info* keyInfo = &runtimeInstancePtr->typeInfoList[keySlot];
+
+	htInfo->keyType = keyInfo->type;
+	htInfo->valueType = typeUnknown;
+	htInfo->keyStride = runtimeInstancePtr->arrayInfoList[keySlot].stride;
+	htInfo->valStride = 0;
+	htInfo->keyTypeInfo = keyInfo;
+	//typeUnknown's slot, no hooks
+	htInfo->valTypeInfo = &runtimeInstancePtr->typeInfoList[0];
+
+	uint64T slotAlign = keyInfo->alignment > 8 ? keyInfo->alignment : 8;
+
+	htInfo->slotStride = (htInfo->keyStride + slotAlign - 1) & ~(slotAlign - 1);
+	htInfo->valOffset = htInfo->slotStride;
+	htInfo->slotAlign = slotAlign;
+	htInfo->entryStride = (htInfo->slotStride + sizeof(uint64T) + slotAlign - 1) & ~(slotAlign - 1);
+}
+
+
+//fills in the info lists for a slot that's just been added
+void Runtime_type_slot_init(uint32T slot, const Runtime_type_info* info)
+{
+	runtimeInstancePtr->typeInfoList[slot] = *info;
+
+	Runtime_array_info* arrInfo = &runtimeInstancePtr->arrayInfoList[slot];
+	Runtime_Memory_init(arrInfo, sizeof(Runtime_array_info));
+	arrInfo->elementType = info->type;
+	arrInfo->stride = Runtime_is_user_type(info->type) ? Runtime_type_info_stride(info) : Runtime_calc_stride_for_type(info->type);
+
+	runtimeInstancePtr->arrayInfoListSize = slot + 1;
+
+	Runtime_set_info_init(&runtimeInstancePtr->setInfoList[slot], slot);
+
+	//rows that already exist need the new column
+	for (uint32T k = 0; k < slot; k++) {
+		auto row = runtimeInstancePtr->hashtableInfoRows[k];
+		if (nullptr != row) {
+			Runtime_hashtable_info_init(&row[slot], k, slot);
+		}
+	}
+}
+
+
+Runtime_TypeDescriptor Runtime_register_type(const Runtime_type_info* info)
+{
+	if (nullptr == info || 0 == info->size ||
+		info->alignment > 16 || (0 != (info->alignment & (info->alignment - 1))) ||
+		runtimeInstancePtr->userTypeCount >= Runtime_max_user_types) {
+		Runtime_debug_printf("Runtime_register_type: can't register type\n");
+		return typeUnknown;
+	}
+
+	auto type = (Runtime_TypeDescriptor)(typeUserTypeBase + runtimeInstancePtr->userTypeCount);
+	auto slot = runtimeInstancePtr->builtinTypeCount + runtimeInstancePtr->userTypeCount;
+
+	Runtime_type_info newInfo = *info;
+	newInfo.type = type;
+	if (typeRecord != newInfo.baseType && typeClass != newInfo.baseType) {
+		newInfo.baseType = typeRecord;
+	}
+
+	runtimeInstancePtr->userTypeCount++;
+	Runtime_type_slot_init(slot, &newInfo);
+
+	return type;
+}
+
+const Runtime_type_info* Runtime_get_type_info(Runtime_TypeDescriptor type)
+{
+	auto slot = Runtime_type_slot(type);
+
+	return RUNTIME_NO_TYPE_SLOT == slot ? nullptr : &runtimeInstancePtr->typeInfoList[slot];
+}
+
+//type registry end
+//----------------------------------------------------------------------------
+
+
+
+
 
 //----------------------------------------------------------------------------
 //array 
@@ -651,7 +1055,9 @@ bool Runtime_isMemOnStack(Runtime_objectinfo_ptr* objInfo)
 
 enum Runtime_Array_Flags {
 	rtArrayDynamic = 0x0000,
-	rtArrayStatic = 0x0001
+	rtArrayStatic = 0x0001,
+	rtArrayMapped = 0x0002,
+	rtArrayBits = 0x0003
 };
 
 
@@ -664,17 +1070,13 @@ struct Runtime_array {
 
 
 
+Runtime_array_info* Runtime_array_get_info(Runtime_array_handle self);
+
 Runtime_array_info* Runtime_get_array_info_for_type(Runtime_TypeDescriptor type)
 {
-	Runtime_array_info* result = nullptr;
-	for (uint32T i = 0; i < runtimeInstancePtr->arrayInfoListSize; i++) {
-		if (type == runtimeInstancePtr->arrayInfoList[i].elementType) {
-			result = &runtimeInstancePtr->arrayInfoList[i];
-			break;
-		}
-	}
+	auto slot = Runtime_type_slot(type);
 
-	return result;
+	return RUNTIME_NO_TYPE_SLOT == slot ? nullptr : &runtimeInstancePtr->arrayInfoList[slot];
 }
 
 
@@ -695,6 +1097,22 @@ bool Runtime_stack_array_init(Runtime_stack_array* arr)
 	return true;
 }
 
+bool Runtime_mapped_array_init(Runtime_mapped_array* arr)
+{
+
+	Runtime_Memory_init(arr, sizeof(Runtime_mapped_array));
+
+	return true;
+}
+
+bool Runtime_bit_array_init(Runtime_bit_array* arr)
+{
+
+	Runtime_Memory_init(arr, sizeof(Runtime_bit_array));
+
+	return true;
+}
+
 
 bool Runtime_array_init(Runtime_array_handle arr)
 {
@@ -702,6 +1120,10 @@ bool Runtime_array_init(Runtime_array_handle arr)
 	return (arrPtr == nullptr) ? false :
 		(arrPtr->flags == rtArrayDynamic) ?
 		Runtime_heap_array_init(RUNTIME_HEAP_ARRAY(arr)) :
+		(arrPtr->flags == rtArrayMapped) ?
+		Runtime_mapped_array_init(RUNTIME_MAPPED_ARRAY(arr)) :
+		(arrPtr->flags == rtArrayBits) ?
+		Runtime_bit_array_init(RUNTIME_BIT_ARRAY(arr)) :
 		Runtime_stack_array_init( RUNTIME_STACK_ARRAY(arr) );
 }
 
@@ -742,12 +1164,43 @@ void Runtime_array_heap_free_data(Runtime_array_handle self)
 		} break;
 
 		default: {
+			if (Runtime_is_user_type(internArr->infoPtr->elementType)) {
+				auto typeInfo = Runtime_get_type_info(internArr->infoPtr->elementType);
+				if (nullptr != typeInfo->destroy) {
+					auto elem = (uint8T*)internArr->data;
+					for (uint64T i = 0; i < internArr->size; i++) {
+						typeInfo->destroy(elem);
+						elem += internArr->infoPtr->stride;
+					}
+				}
+			}
 			Runtime_free(internArr->data);
 		} break;
 	}
 	internArr->data = nullptr;
 }
 
+//copies count elements into uninitialized dest, through the type's
+//copy hook if it has one, matching the destroy in heap_free_data
+void Runtime_array_copy_elements(Runtime_array_info* info, void* dest, const void* src, uint64T count)
+{
+	if (Runtime_is_user_type(info->elementType)) {
+		auto typeInfo = Runtime_get_type_info(info->elementType);
+		if (nullptr != typeInfo->copy) {
+			auto srcElem = (const uint8T*)src;
+			auto destElem = (uint8T*)dest;
+			for (uint64T i = 0; i < count; i++) {
+				typeInfo->copy(destElem, srcElem);
+				srcElem += info->stride;
+				destElem += info->stride;
+			}
+			return;
+		}
+	}
+
+	Runtime_mem_cpy((void*)src, dest, count * info->stride);
+}
+
 void Runtime_array_heap_reserve(Runtime_array_handle self)
 {
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
@@ -768,7 +1221,8 @@ void Runtime_array_heap_reserve(Runtime_array_handle self)
 
 		Runtime_mem_cpy(elem, destElem, internArr->infoPtr->stride * internArr->size);
 
-		Runtime_array_heap_free_data(self);
+		//elements were moved, not copied, so just release the old block
+		Runtime_free(internArr->data);
 	}
 
 	internArr->data = newData;
@@ -786,6 +1240,12 @@ Runtime_array_handle Runtime_array_new_struct(uint32T flags)
 	else if (flags == rtArrayStatic) {
 		allocSize += sizeof(Runtime_stack_array);
 	}
+	else if (flags == rtArrayMapped) {
+		allocSize += sizeof(Runtime_mapped_array);
+	}
+	else if (flags == rtArrayBits) {
+		allocSize += sizeof(Runtime_bit_array);
+	}
 
 	auto memPtr = Runtime_alloc(allocSize, typeArray);
 	result = (Runtime_array*)memPtr;
@@ -799,12 +1259,24 @@ Runtime_array_handle Runtime_array_new_struct(uint32T flags)
 		Runtime_stack_array* internArr = (Runtime_stack_array*)(((uint8T*)result) + sizeof(Runtime_array));
 		result->internalData = internArr;
 	}
+	else if (flags == rtArrayMapped) {
+		Runtime_mapped_array* internArr = (Runtime_mapped_array*)(((uint8T*)result) + sizeof(Runtime_array));
+		result->internalData = internArr;
+	}
+	else if (flags == rtArrayBits) {
+		Runtime_bit_array* internArr = (Runtime_bit_array*)(((uint8T*)result) + sizeof(Runtime_array));
+		result->internalData = internArr;
+	}
 
 	return (Runtime_array_handle) result;
 }
 
 Runtime_array_handle Runtime_array_new_empty(Runtime_TypeDescriptor type)
 {
+	if (typeBit1 == type) {
+		return Runtime_bitarray_new(0);
+	}
+
 	Runtime_array_handle result = Runtime_array_new_struct(rtArrayDynamic);
 
 	if (!Runtime_array_init(result)) {
@@ -831,6 +1303,10 @@ Runtime_array_handle Runtime_array_new_empty(Runtime_TypeDescriptor type)
 
 Runtime_array_handle Runtime_array_new(uint64T size, Runtime_TypeDescriptor type)
 {
+	if (typeBit1 == type) {
+		return Runtime_bitarray_new(size);
+	}
+
 	Runtime_array_handle result = Runtime_array_new_empty(type);
 	Runtime_heap_array* internArr = (Runtime_heap_array*)(((uint8T*)result) + sizeof(Runtime_array));	
 	internArr->size = size;	
@@ -843,13 +1319,18 @@ Runtime_array_handle Runtime_array_new(uint64T size, Runtime_TypeDescriptor type
 
 Runtime_array_handle Runtime_array_new_copy(Runtime_array_handle rhs)
 {
-	Runtime_heap_array* rhsInternArr = RUNTIME_HEAP_ARRAY(rhs);
+	//rhs may be a stack or mapped array, the copy is always on the heap
+	auto rhsInfo = Runtime_array_get_info(rhs);
+	auto rhsSize = Runtime_array_size(rhs);
 
-	Runtime_array_handle result = Runtime_array_new(rhsInternArr->size, rhsInternArr->infoPtr->elementType);
+	Runtime_array_handle result = Runtime_array_new(rhsSize, rhsInfo->elementType);
 
-	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(result);
+	if (rtArrayBits == ((Runtime_array*)rhs)->flags) {
+		Runtime_mem_cpy(RUNTIME_BIT_ARRAY(rhs)->data, RUNTIME_BIT_ARRAY(result)->data, RUNTIME_BIT_ARRAY_WORDS(rhsSize) * sizeof(uint64T));
+		return result;
+	}
 
-	Runtime_mem_cpy(rhsInternArr->data, internArr->data, rhsInternArr->size * rhsInternArr->infoPtr->stride);
+	Runtime_array_copy_elements(rhsInfo, RUNTIME_HEAP_ARRAY(result)->data, Runtime_array_data(rhs), rhsSize);
 
 	return result;
 }
@@ -871,13 +1352,22 @@ void Runtime_array_clear(Runtime_array_handle self)
 {	
 	Runtime_array* selfArr = (Runtime_array * )self;
 
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags || rtArrayBits == selfArr->flags);
 
 	if (rtArrayDynamic == selfArr->flags) {
 		Runtime_array_heap_free_data(self);
 		Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
 		internArr->size = 0;
 	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		if (nullptr != internArr->data) {
+			Runtime_free(internArr->data);
+		}
+		internArr->data = nullptr;
+		internArr->size = 0;
+		internArr->capacity = 0;
+	}
 	else if (rtArrayStatic == selfArr->flags) {
 
 	}
@@ -887,9 +1377,13 @@ void Runtime_array_delete(Runtime_array_handle self)
 {		
 	//Runtime_debug_printf("Runtime_array_delete %p size: %d cap: %d\n", self, (int)Runtime_array_size(self), (int)Runtime_array_capacity(self));
 	Runtime_array* selfArr = (Runtime_array*)self;
-	if (rtArrayDynamic == selfArr->flags) {
+	if (rtArrayDynamic == selfArr->flags || rtArrayBits == selfArr->flags) {
 		Runtime_array_clear(self);
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		Win32_unmap_file(internArr->header, internArr->fileHandle, internArr->mappingHandle);
+	}
 	else {
 		
 	}
@@ -908,6 +1402,14 @@ void* Runtime_array_begin(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		return internArr->data;
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		return internArr->data;
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		return internArr->data;
+	}
 	return nullptr;
 }
 
@@ -922,8 +1424,16 @@ void* Runtime_array_end(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		return (void*)((uint8T*)internArr->data + internArr->size * internArr->infoPtr->stride);
 	}
-	return nullptr;
-
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		return (void*)((uint8T*)internArr->data + internArr->size * internArr->infoPtr->stride);
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		return (void*)(internArr->data + RUNTIME_BIT_ARRAY_WORDS(internArr->size));
+	}
+	return nullptr;
+
 }
 
 void* Runtime_array_at(Runtime_array_handle self, uint64T index)
@@ -939,6 +1449,15 @@ void* Runtime_array_at(Runtime_array_handle self, uint64T index)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		result = ((uint8T*)internArr->data) + index * internArr->infoPtr->stride;
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		result = ((uint8T*)internArr->data) + index * internArr->infoPtr->stride;
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		//the word holding the bit
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		result = internArr->data + (index >> 6);
+	}
 	return result;
 }
 
@@ -957,6 +1476,14 @@ Runtime_array_info* Runtime_array_get_info(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		result = internArr->infoPtr;
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		result = internArr->infoPtr;
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		result = internArr->infoPtr;
+	}
 
 	return result;
 }
@@ -979,6 +1506,14 @@ uint64T Runtime_array_size_bytes(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		result = (internArr->size * internArr->infoPtr->stride);
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		result = (internArr->size * internArr->infoPtr->stride);
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		result = internArr->capacity / 8;
+	}
 
 	return result;
 }
@@ -994,6 +1529,14 @@ uint64T Runtime_array_size(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		return internArr->size;
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		return internArr->size;
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		return internArr->size;
+	}
 	
 	return 0;
 }
@@ -1009,6 +1552,14 @@ void* Runtime_array_data(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		return internArr ->data;
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		return internArr->data;
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		return internArr->data;
+	}
 
 	return nullptr;
 }
@@ -1017,9 +1568,12 @@ void* Runtime_array_data(Runtime_array_handle self)
 uint64T Runtime_array_capacity(Runtime_array_handle self)
 {
 	Runtime_array* selfArr = (Runtime_array*)self;
-	if (rtArrayStatic == selfArr->flags) {
+	if (rtArrayStatic == selfArr->flags || rtArrayMapped == selfArr->flags) {
 		return 0;
 	}
+	if (rtArrayBits == selfArr->flags) {
+		return RUNTIME_BIT_ARRAY(self)->capacity;
+	}
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);	
 	return internArr->capacity;
 }
@@ -1031,6 +1585,14 @@ Runtime_TypeDescriptor Runtime_array_type(Runtime_array_handle self)
 		Runtime_stack_array* internArr = RUNTIME_STACK_ARRAY(self);
 		return internArr->infoPtr->elementType;
 	}
+	else if (rtArrayMapped == selfArr->flags) {
+		Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+		return internArr->infoPtr->elementType;
+	}
+	else if (rtArrayBits == selfArr->flags) {
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		return internArr->infoPtr->elementType;
+	}
 
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
 	return internArr->infoPtr->elementType;
@@ -1039,7 +1601,14 @@ Runtime_TypeDescriptor Runtime_array_type(Runtime_array_handle self)
 void Runtime_array_reserve(Runtime_array_handle self, uint64T newCapacity)
 {
 	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	if (rtArrayBits == selfArr->flags) {
+		Runtime_bitarray_reserve(self, newCapacity);
+		return;
+	}
+	if (rtArrayDynamic != selfArr->flags) {
+		Runtime_debug_printf("Can't reserve a fixed size array");
+		return;
+	}
 
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
 	 
@@ -1055,7 +1624,14 @@ void Runtime_array_reserve(Runtime_array_handle self, uint64T newCapacity)
 Runtime_array_handle Runtime_array_resize(Runtime_array_handle self, uint64T newSize)
 {
 	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	if (rtArrayBits == selfArr->flags) {
+		Runtime_bitarray_resize(self, newSize);
+		return self;
+	}
+	if (rtArrayDynamic != selfArr->flags) {
+		Runtime_debug_printf("Can't resize a fixed size array");
+		return self;
+	}
 
 
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
@@ -1076,11 +1652,7 @@ Runtime_array_handle Runtime_array_resize(Runtime_array_handle self, uint64T new
 
 void Runtime_array_append(Runtime_array_handle self, void* newElement)
 {
-	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
-
-	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
-	Runtime_array_insert(self, newElement, internArr->size);
+	Runtime_array_insert(self, newElement, Runtime_array_size(self));
 }
 
 void Runtime_array_append_from(Runtime_array_handle self, Runtime_array_handle src)
@@ -1091,7 +1663,14 @@ void Runtime_array_append_from(Runtime_array_handle self, Runtime_array_handle s
 	}
 
 	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	if (rtArrayBits == selfArr->flags) {
+		Runtime_bitarray_append_from(self, src);
+		return;
+	}
+	if (rtArrayDynamic != selfArr->flags) {
+		Runtime_debug_printf("Can't append to a fixed size array");
+		return;
+	}
 
 	
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
@@ -1110,8 +1689,11 @@ void Runtime_array_append_from(Runtime_array_handle self, Runtime_array_handle s
 		return;
 	}
 
-	if ((internArr->size + srcSize) == internArr->capacity) {
+	if ((internArr->size + srcSize) > internArr->capacity) {
 		internArr->capacity = ((double)(internArr->capacity + srcCapacity)) * RUNTIME_ARRAY_CAPACITY_MULTIPLIER;
+		if (internArr->capacity < internArr->size + srcSize) {
+			internArr->capacity = internArr->size + srcSize;
+		}
 		Runtime_array_heap_reserve(self);
 	}
 
@@ -1119,7 +1701,7 @@ void Runtime_array_append_from(Runtime_array_handle self, Runtime_array_handle s
 	auto srcPtr = Runtime_array_at(src, 0);
 
 
-	Runtime_mem_cpy(srcPtr, destPtr, srcSize * internArr->infoPtr->stride);
+	Runtime_array_copy_elements(internArr->infoPtr, destPtr, srcPtr, srcSize);
 
 	internArr->size += srcSize;
 }
@@ -1127,13 +1709,22 @@ void Runtime_array_append_from(Runtime_array_handle self, Runtime_array_handle s
 void Runtime_array_insert(Runtime_array_handle self, void* newElement, uint64T insertAt)
 {
 	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	if (rtArrayBits == selfArr->flags) {
+		Runtime_bitarray_insert(self, insertAt, 0 != *(uint8T*)newElement);
+		return;
+	}
+	if (rtArrayDynamic != selfArr->flags) {
+		Runtime_debug_printf("Can't insert into a fixed size array");
+		return;
+	}
 
 
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
 
 	if (internArr->size == internArr->capacity) {
-		internArr->capacity = ((double)internArr->capacity) * RUNTIME_ARRAY_CAPACITY_MULTIPLIER;
+		//an empty array has 0 capacity, and 1 * 1.5 truncates back to 1
+		uint64T newCapacity = ((double)internArr->capacity) * RUNTIME_ARRAY_CAPACITY_MULTIPLIER;
+		internArr->capacity = newCapacity > internArr->capacity ? newCapacity : internArr->capacity + 4;
 		Runtime_array_heap_reserve(self);
 	}
 	auto oldSz = internArr->size;
@@ -1141,33 +1732,50 @@ void Runtime_array_insert(Runtime_array_handle self, void* newElement, uint64T i
 
 
 	auto ptr = Runtime_array_at(self, insertAt);
-	auto src = (uint8T*)ptr;
-	
-
-	auto end = src;
 
-	src = (uint8T*)Runtime_array_end(self);
+	//shift [insertAt, size) up one element, back to front
+	if (insertAt < oldSz) {
+		auto stride = internArr->infoPtr->stride;
+		auto src = (uint8T*)Runtime_array_end(self) - 1;
+		auto dest = src + stride;
+		auto end = (uint8T*)ptr;
 
-	auto dest = src + internArr->infoPtr->stride; //one forward
+		while (src >= end) {
 
-	while (src> end) {
+			*dest = *src;
 
-		*dest = *src;
-
-		dest--;
-		src--;
+			dest--;
+			src--;
+		}
 	}
 	
 
-	Runtime_mem_cpy(newElement, ptr, internArr->infoPtr->stride);
+	Runtime_array_copy_elements(internArr->infoPtr, ptr, newElement, 1);
 
 	internArr->size++;
 }
 
+inline void Runtime_bitarray_mask_tail(Runtime_bit_array* internArr);
+
 void Runtime_array_bytes_copy(Runtime_array_handle self, Runtime_array_handle src)
 {
 	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	if (rtArrayBits == selfArr->flags || rtArrayBits == ((Runtime_array*)src)->flags) {
+		if (selfArr->flags != ((Runtime_array*)src)->flags) {
+			Runtime_debug_printf("Can't copy between bit and non bit arrays");
+			return;
+		}
+		//whole words, the size of self doesn't change
+		Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+		auto bitCount = internArr->size < RUNTIME_BIT_ARRAY(src)->size ? internArr->size : RUNTIME_BIT_ARRAY(src)->size;
+		Runtime_mem_cpy(RUNTIME_BIT_ARRAY(src)->data, internArr->data, RUNTIME_BIT_ARRAY_WORDS(bitCount) * sizeof(uint64T));
+		Runtime_bitarray_mask_tail(internArr);
+		return;
+	}
+	if (rtArrayDynamic != selfArr->flags) {
+		Runtime_debug_printf("Can't copy into a fixed size array");
+		return;
+	}
 
 
 	auto srcInfo = Runtime_array_get_info(src);
@@ -1189,14 +1797,24 @@ void Runtime_array_copy(Runtime_array_handle self, Runtime_array_handle src)
 	}
 
 	Runtime_array* selfArr = (Runtime_array*)self;
-	RUNTIME_ASSERT(rtArrayDynamic == selfArr->flags);
+	if (rtArrayBits == selfArr->flags) {
+		Runtime_bitarray_copy(self, src);
+		return;
+	}
+	if (rtArrayDynamic != selfArr->flags) {
+		Runtime_debug_printf("Can't copy into a fixed size array");
+		return;
+	}
+	if (rtArrayBits == ((Runtime_array*)src)->flags) {
+		Runtime_debug_printf("Can't copy between bit and non bit arrays");
+		return;
+	}
 
 
 	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
 
 
 	auto srcSize = Runtime_array_size(src);
-	auto srcCapacity = Runtime_array_capacity(src);
 	auto srcInfo = Runtime_array_get_info(src);
 
 
@@ -1209,29 +1827,39 @@ void Runtime_array_copy(Runtime_array_handle self, Runtime_array_handle src)
 
 	internArr->infoPtr = srcInfo;
 
-	if ((srcSize) == internArr->capacity) {
-		
-		internArr->capacity = ((double)(internArr->capacity + srcCapacity)) * RUNTIME_ARRAY_CAPACITY_MULTIPLIER;
-		Runtime_array_heap_reserve(self);
+	//clear let go of the old block
+	if (srcSize > internArr->capacity) {
+		internArr->capacity = srcSize;
 	}
+	Runtime_array_heap_reserve(self);
 	internArr->size = srcSize;
 
 	
-	Runtime_array_bytes_copy(self,src);
+	Runtime_array_copy_elements(srcInfo, internArr->data, Runtime_array_data(src), srcSize);
 }
 
 Runtime_array_cmp_result Runtime_array_compare(Runtime_array_handle self, Runtime_array_handle rhs)
 {
 	Runtime_array_cmp_result result = rtArrayCmpEqual;
 
-	Runtime_heap_array* internArr = RUNTIME_HEAP_ARRAY(self);
-	Runtime_heap_array* rhsInternArr = RUNTIME_HEAP_ARRAY(rhs);
+	auto info = Runtime_array_get_info(self);
+	auto rhsInfo = Runtime_array_get_info(rhs);
 
-	if (internArr->infoPtr->elementType != rhsInternArr->infoPtr->elementType) {
+	if (info->elementType != rhsInfo->elementType) {
 		return rtArrayCmpInvalid;
 	}
 
-	switch (internArr->infoPtr->elementType) {
+	switch (info->elementType) {
+		case typeBit1: {
+			//bits past size are always 0, so whole words can be compared
+			auto sz = RUNTIME_BIT_ARRAY_WORDS(Runtime_array_size(self)) * sizeof(uint64T);
+			auto szRhs = RUNTIME_BIT_ARRAY_WORDS(Runtime_array_size(rhs)) * sizeof(uint64T);
+			if (Runtime_array_size(self) != Runtime_array_size(rhs)) {
+				return Runtime_array_size(self) < Runtime_array_size(rhs) ? rtArrayCmpLt : rtArrayCmpGt;
+			}
+			result = (Runtime_array_cmp_result)Runtime_mem_cmp(Runtime_array_data(self), sz, Runtime_array_data(rhs), szRhs);
+		} break;
+
 		case typeClass: {
 
 		} break;
@@ -1254,9 +1882,9 @@ Runtime_array_cmp_result Runtime_array_compare(Runtime_array_handle self, Runtim
 		} break;
 
 		default: {
-			auto sz = internArr->size * internArr->infoPtr->stride;
-			auto szRhs = rhsInternArr->size * rhsInternArr->infoPtr->stride;
-			result = (Runtime_array_cmp_result)Runtime_mem_cmp(internArr->data, sz, rhsInternArr->data, szRhs);
+			auto sz = Runtime_array_size(self) * info->stride;
+			auto szRhs = Runtime_array_size(rhs) * rhsInfo->stride;
+			result = (Runtime_array_cmp_result)Runtime_mem_cmp(Runtime_array_data(self), sz, Runtime_array_data(rhs), szRhs);
 
 		} break;
 	}
@@ -1266,1005 +1894,8441 @@ Runtime_array_cmp_result Runtime_array_compare(Runtime_array_handle self, Runtim
 	return result;
 }
 
-//array end
-//----------------------------------------------------------------------------
-
 
+#define RUNTIME_MAPPED_ARRAY_DATA_OFFSET	64
 
-//----------------------------------------------------------------------------
-//strings
 
-struct Runtime_string {
+Runtime_array_handle Runtime_array_new_mapped_struct(
+	Runtime_mapped_array_header* header,
+	uint64T mappedSize,
+	Runtime_array_map_mode mode,
+	Runtime_array_info* info,
+	void* fileHandle,
+	void* mappingHandle)
+{
+	Runtime_array_handle result = Runtime_array_new_struct(rtArrayMapped);
+	Runtime_array_init(result);
+
+	Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(result);
+	internArr->size = header->count;
+	internArr->data = ((uint8T*)header) + header->dataOffset;
+	internArr->infoPtr = info;
+	internArr->header = header;
+	internArr->mappedSize = mappedSize;
+	internArr->mode = mode;
+	internArr->fileHandle = fileHandle;
+	internArr->mappingHandle = mappingHandle;
 
-	void* internalData;
-};
+	return result;
+}
 
-uint64T Runtime_c_str_length(const charT* c_strPtr)
+Runtime_array_handle Runtime_array_new_mapped(const char* path, Runtime_TypeDescriptor type, Runtime_array_map_mode mode)
 {
-	uint64T result = 0;
-	const charT* ptr = c_strPtr;
-	while (*ptr != 0) {
-		ptr++;
-		result++;
+	auto info = Runtime_get_array_info_for_type(type);
+	if (nullptr == info || !isTypePrimitive(type) || 0 == info->stride) {
+		Runtime_debug_printf("Runtime_array_new_mapped: type %d can't be mapped\n", (int)type);
+		return nullptr;
 	}
-	return result;
-}
 
+	uint64T mappedSize = 0;
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	auto view = Win32_map_file(path, &mappedSize, rtArrayMapReadWrite == mode, false, &fileHandle, &mappingHandle);
+	if (nullptr == view) {
+		return nullptr;
+	}
 
-struct Runtime_string_internal_data {
-	Runtime_array_handle strData;
-	uint64T hashval;
-};
+	auto header = (Runtime_mapped_array_header*)view;
+	bool valid = mappedSize >= sizeof(Runtime_mapped_array_header) &&
+		Runtime_mapped_array_magic == header->magic &&
+		Runtime_mapped_array_version == header->version &&
+		(uint32T)type == header->elementType &&
+		info->stride == header->stride &&
+		header->dataOffset >= sizeof(Runtime_mapped_array_header) &&
+		header->dataOffset <= mappedSize &&
+		header->count <= (mappedSize - header->dataOffset) / info->stride;
+
+	if (!valid) {
+		Runtime_debug_printf("Runtime_array_new_mapped: %s has a bad header\n", path);
+		Win32_unmap_file(view, fileHandle, mappingHandle);
+		return nullptr;
+	}
 
-#define RUNTIME_STRING_INTERNAL_DATA(self) (Runtime_string_internal_data*)((Runtime_string*)self)
+	return Runtime_array_new_mapped_struct(header, mappedSize, mode, info, fileHandle, mappingHandle);
+}
 
-Runtime_string_handle Runtime_string_new_empty()
+Runtime_array_handle Runtime_array_new_mapped_with_size(const char* path, uint64T size, Runtime_TypeDescriptor type)
 {
-	Runtime_string_handle result = nullptr;
-	auto memPtr = Runtime_alloc(sizeof(Runtime_string) + sizeof(Runtime_string_internal_data), typeString);
-	result = (Runtime_string_handle)memPtr;
-	Runtime_Memory_init(result, sizeof(Runtime_string) + sizeof(Runtime_string_internal_data));
+	auto info = Runtime_get_array_info_for_type(type);
+	if (nullptr == info || !isTypePrimitive(type) || 0 == info->stride) {
+		Runtime_debug_printf("Runtime_array_new_mapped_with_size: type %d can't be mapped\n", (int)type);
+		return nullptr;
+	}
+	if (size > (0xFFFFFFFFFFFFFFFFULL - RUNTIME_MAPPED_ARRAY_DATA_OFFSET) / info->stride) {
+		Runtime_debug_printf("Runtime_array_new_mapped_with_size: %I64u elements don't fit in a file\n", size);
+		return nullptr;
+	}
+
+	//data starts on a cache line boundary, 
+	//views are page aligned
+	uint64T mappedSize = RUNTIME_MAPPED_ARRAY_DATA_OFFSET + size * info->stride;
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+	auto view = Win32_map_file(path, &mappedSize, true, true, &fileHandle, &mappingHandle);
+	if (nullptr == view) {
+		return nullptr;
+	}
 
-	((Runtime_string*)result)->internalData = ((uint8T*)memPtr) + sizeof(Runtime_string);
+	//new file contents are already zeroed by the OS
+	auto header = (Runtime_mapped_array_header*)view;
+	header->magic = Runtime_mapped_array_magic;
+	header->version = Runtime_mapped_array_version;
+	header->elementType = (uint32T)type;
+	header->stride = (uint32T)info->stride;
+	header->count = size;
+	header->dataOffset = RUNTIME_MAPPED_ARRAY_DATA_OFFSET;
 
-	return result;
+	return Runtime_array_new_mapped_struct(header, mappedSize, rtArrayMapReadWrite, info, fileHandle, mappingHandle);
 }
 
-Runtime_string_handle Runtime_string_new(const charT* c_strPtr)
+bool Runtime_array_is_mapped(Runtime_array_handle self)
 {
-	
-	return Runtime_string_new_with_size(c_strPtr, Runtime_c_str_length(c_strPtr));
+	Runtime_array* selfArr = (Runtime_array*)self;
+
+	return nullptr != selfArr && rtArrayMapped == selfArr->flags;
 }
 
-Runtime_string_handle Runtime_string_new_with_size(const charT* c_strPtr, uint64T size)
+bool Runtime_array_flush(Runtime_array_handle self)
 {
-	Runtime_string_handle result = nullptr;
-
-	result = Runtime_string_new_empty();
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(result)->internalData;
+	if (!Runtime_array_is_mapped(self)) {
+		return true;
+	}
 
-	internalData->strData = Runtime_array_new(size+1, typeInteger8);
-	auto strSize = Runtime_array_size(internalData->strData);
-	charT* chPtr = nullptr;
-	for (uint64T i = 0; i < strSize-1; i++) {
-		chPtr = (charT*)Runtime_array_at(internalData->strData, i);
-		*chPtr = c_strPtr[i];
+	Runtime_mapped_array* internArr = RUNTIME_MAPPED_ARRAY(self);
+	if (rtArrayMapReadOnly == internArr->mode) {
+		return true;
 	}
-	chPtr = (charT*)Runtime_array_at(internalData->strData, strSize - 1);
-	*chPtr = 0;
 
-	return result;
+	return Win32_flush_mapped_file(internArr->header, internArr->mappedSize, internArr->fileHandle);
 }
 
-Runtime_string_handle Runtime_string_new_char_count(charT ch, uint64T count)
+
+
+//packed bit arrays
+
+void Runtime_bitarray_reserve_words(Runtime_bit_array* internArr, uint64T wordCount)
 {
-	Runtime_string_handle result = nullptr;
+	if ((wordCount << 6) <= internArr->capacity) {
+		return;
+	}
 
-	result = Runtime_string_new_empty();
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(result)->internalData;
+	auto newData = (uint64T*)Runtime_alloc(wordCount * sizeof(uint64T), typeBit1);
+	Runtime_Memory_init(newData, wordCount * sizeof(uint64T));
 
-	internalData->strData = Runtime_array_new(count + 1, typeInteger8);
-	auto strSize = Runtime_array_size(internalData->strData);
-	charT* chPtr = nullptr;
-	for (uint64T i = 0; i < strSize - 1; i++) {
-		chPtr = (charT*)Runtime_array_at(internalData->strData, i);
-		*chPtr = ch;
+	if (nullptr != internArr->data) {
+		Runtime_mem_cpy(internArr->data, newData, RUNTIME_BIT_ARRAY_WORDS(internArr->size) * sizeof(uint64T));
+		Runtime_free(internArr->data);
 	}
-	chPtr = (charT*)Runtime_array_at(internalData->strData, strSize - 1);
-	*chPtr = 0;
 
-	return result;
+	internArr->data = newData;
+	internArr->capacity = wordCount << 6;
 }
 
-Runtime_string_handle Runtime_string_new_copy(Runtime_string_handle rhs)
+//keeps the "bits past size are 0" invariant
+inline void Runtime_bitarray_mask_tail(Runtime_bit_array* internArr)
 {
-	Runtime_string_handle result = nullptr;
-	result = Runtime_string_new_empty();
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(result)->internalData;
+	auto tailBits = internArr->size & 63;
+	if (0 != tailBits) {
+		internArr->data[internArr->size >> 6] &= (1ULL << tailBits) - 1;
+	}
+}
 
-	Runtime_string_internal_data* rhsInternalData = RUNTIME_STRING_INTERNAL_DATA(rhs)->internalData;
+Runtime_array_handle Runtime_bitarray_new(uint64T bitCount)
+{
+	Runtime_array_handle result = Runtime_array_new_struct(rtArrayBits);
+	Runtime_array_init(result);
+
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(result);
+	internArr->infoPtr = Runtime_get_array_info_for_type(typeBit1);
 
-	internalData->strData = Runtime_array_new_copy(rhsInternalData->strData);
-	internalData->hashval = rhsInternalData->hashval;
+	if (bitCount > 0) {
+		Runtime_bitarray_reserve_words(internArr, RUNTIME_BIT_ARRAY_WORDS(bitCount));
+	}
+	internArr->size = bitCount;
 
 	return result;
 }
 
-void Runtime_string_delete(Runtime_string_handle self)
+bool Runtime_bitarray_get(Runtime_array_handle self, uint64T index)
 {
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
-	Runtime_array_delete(internalData->strData);
-	Runtime_free(self);
-}
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	RUNTIME_ASSERT(index < internArr->size);
 
-bool Runtime_string_empty(Runtime_string_handle self)
-{
-	return Runtime_string_size(self) == 0 ? true : false;
+	return ((internArr->data[index >> 6] >> (index & 63)) & 1) != 0;
 }
 
-uint64T Runtime_string_size(Runtime_string_handle self)
+void Runtime_bitarray_set(Runtime_array_handle self, uint64T index, bool val)
 {
-	if (nullptr == self) {
-		return 0;
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	RUNTIME_ASSERT(index < internArr->size);
+
+	uint64T mask = 1ULL << (index & 63);
+	if (val) {
+		internArr->data[index >> 6] |= mask;
+	}
+	else {
+		internArr->data[index >> 6] &= ~mask;
 	}
-	
-	return Runtime_array_size((RUNTIME_STRING_INTERNAL_DATA(self)->internalData)->strData);
 }
 
-uint64T Runtime_string_size_bytes(Runtime_string_handle self)
-{ 
-	uint64T result = 0;
-
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
-	
-	result = Runtime_array_size_bytes(internalData->strData);
+void Runtime_bitarray_flip(Runtime_array_handle self, uint64T index)
+{
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	RUNTIME_ASSERT(index < internArr->size);
 
-	return result;
+	internArr->data[index >> 6] ^= 1ULL << (index & 63);
 }
 
-uint64T Runtime_string_hash(Runtime_string_handle self)
+void Runtime_bitarray_set_all(Runtime_array_handle self, bool val)
 {
-	uint64T result = 0;
-	
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
-	if (0 == internalData->hashval) {
-		
-		auto chPtr = (byteT*)Runtime_array_at(internalData->strData, 0);
-		auto sz = Runtime_array_size_bytes(internalData->strData);
-		internalData->hashval = Runtime_hash_basic_bytes(chPtr, sz);
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	if (0 == internArr->size) {
+		return;
 	}
-	
-
 
-	return internalData->hashval;
+	memset(internArr->data, val ? 0xFF : 0, RUNTIME_BIT_ARRAY_WORDS(internArr->size) * sizeof(uint64T));
+	Runtime_bitarray_mask_tail(internArr);
 }
 
-void Runtime_string_clear(Runtime_string_handle self)
+void Runtime_bitarray_reserve(Runtime_array_handle self, uint64T bitCapacity)
 {
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
-	Runtime_array_clear(internalData->strData);
-	internalData->hashval = 0;
+	Runtime_bitarray_reserve_words(RUNTIME_BIT_ARRAY(self), RUNTIME_BIT_ARRAY_WORDS(bitCapacity));
 }
 
-void Runtime_string_assign(Runtime_string_handle self, charT* c_strPtr)
-{	
-	Runtime_string_assign_with_size(self, c_strPtr, Runtime_c_str_length(c_strPtr));
+void Runtime_bitarray_copy(Runtime_array_handle self, Runtime_array_handle src)
+{
+	if (rtArrayBits != ((Runtime_array*)src)->flags) {
+		Runtime_debug_printf("Can't copy between bit and non bit arrays");
+		return;
+	}
+	if (self == src) {
+		return;
+	}
+
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	Runtime_bit_array* srcArr = RUNTIME_BIT_ARRAY(src);
+
+	//resize to 0 zeroes the old words, the copy keeps bits past
+	//size 0 since the source's are
+	Runtime_bitarray_resize(self, 0);
+	Runtime_bitarray_reserve_words(internArr, RUNTIME_BIT_ARRAY_WORDS(srcArr->size));
+	if (0 != srcArr->size) {
+		Runtime_mem_cpy(srcArr->data, internArr->data, RUNTIME_BIT_ARRAY_WORDS(srcArr->size) * sizeof(uint64T));
+	}
+	internArr->size = srcArr->size;
 }
 
-void Runtime_string_assign_with_size(Runtime_string_handle self, charT* c_strPtr, uint64T size)
+void Runtime_bitarray_resize(Runtime_array_handle self, uint64T newBitCount)
 {
-	Runtime_string_clear(self);
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
-	internalData->strData = Runtime_array_new(size + 1, typeInteger8);
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
 
-	
-	Runtime_heap_array* arrayData = RUNTIME_HEAP_ARRAY(internalData->strData);
+	auto newWords = RUNTIME_BIT_ARRAY_WORDS(newBitCount);
+	if (newBitCount > internArr->capacity) {
+		auto growWords = RUNTIME_BIT_ARRAY_WORDS(internArr->capacity) * 2;
+		Runtime_bitarray_reserve_words(internArr, newWords > growWords ? newWords : growWords);
+	}
 
-	Runtime_mem_cpy(c_strPtr, arrayData->data, size * arrayData->infoPtr->stride);
+	if (newBitCount < internArr->size) {
+		//zero the dropped bits so growing again later reads 0's
+		auto oldWords = RUNTIME_BIT_ARRAY_WORDS(internArr->size);
+		internArr->size = newBitCount;
+		if (oldWords > newWords) {
+			memset(internArr->data + newWords, 0, (oldWords - newWords) * sizeof(uint64T));
+		}
+		if (newBitCount > 0) {
+			Runtime_bitarray_mask_tail(internArr);
+		}
+	}
+	else {
+		internArr->size = newBitCount;
+	}
+}
 
-	auto lastChPtr = (charT*)Runtime_array_at(internalData->strData, size);
-	*lastChPtr = 0;
+void Runtime_bitarray_append(Runtime_array_handle self, bool val)
+{
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	auto index = internArr->size;
 
+	Runtime_bitarray_resize(self, index + 1);
+	if (val) {
+		internArr->data[index >> 6] |= 1ULL << (index & 63);
+	}
 }
 
-void Runtime_string_assign_char_count(Runtime_string_handle self, charT ch, uint64T count)
+void Runtime_bitarray_insert(Runtime_array_handle self, uint64T index, bool val)
 {
-	Runtime_string_clear(self);
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
-	internalData->strData = Runtime_array_new(count + 1, typeInteger8);
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	auto size = internArr->size;
+	RUNTIME_ASSERT(index <= size);
+	if (index > size) {
+		return;
+	}
 
+	Runtime_bitarray_resize(self, size + 1);
 
-	Runtime_heap_array* arrayData = RUNTIME_HEAP_ARRAY(internalData->strData);
+	//shift [index, size) up a bit, a word at a time from the top
+	auto data = internArr->data;
+	uint64T first = index >> 6;
+	for (uint64T w = size >> 6; w > first; w--) {
+		data[w] = (data[w] << 1) | (data[w - 1] >> 63);
+	}
+	uint64T below = (1ULL << (index & 63)) - 1;
+	data[first] = (data[first] & below) | ((data[first] & ~below) << 1);
+	if (val) {
+		data[first] |= 1ULL << (index & 63);
+	}
+}
 
+void Runtime_bitarray_append_from(Runtime_array_handle self, Runtime_array_handle src)
+{
+	if (rtArrayBits != ((Runtime_array*)src)->flags) {
+		Runtime_debug_printf("Can't append from different types of arrays");
+		return;
+	}
 
-	auto strSize = Runtime_array_size(internalData->strData);
-	charT* chPtr = nullptr;
-	for (uint64T i = 0; i < strSize - 1; i++) {
-		chPtr = (charT*)Runtime_array_at(internalData->strData, i);
-		*chPtr = ch;
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	Runtime_bit_array* srcArr = RUNTIME_BIT_ARRAY(src);
+	auto offset = internArr->size;
+	auto srcWords = RUNTIME_BIT_ARRAY_WORDS(srcArr->size);
+	Runtime_bitarray_resize(self, offset + srcArr->size);
+
+	//top down, so appending an array to itself reads each word 
+	//before it's written. Bits past size are 0, whole words can be
+	//or'ed in
+	auto words = RUNTIME_BIT_ARRAY_WORDS(internArr->size);
+	auto shift = offset & 63;
+	for (uint64T w = srcWords; w > 0; w--) {
+		uint64T word = srcArr->data[w - 1];
+		uint64T dest = (offset >> 6) + w - 1;
+		if (0 != shift && dest + 1 < words) {
+			internArr->data[dest + 1] |= word >> (64 - shift);
+		}
+		internArr->data[dest] |= word << shift;
 	}
-	chPtr = (charT*)Runtime_array_at(internalData->strData, strSize - 1);
-	*chPtr = 0;
 }
 
-void Runtime_string_assign_copy(Runtime_string_handle self, Runtime_string_handle rhs)
+uint64T Runtime_bitarray_count(Runtime_array_handle self)
 {
-	Runtime_string_clear(self);
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
 
-	Runtime_string_internal_data* rhsInternalData = RUNTIME_STRING_INTERNAL_DATA(rhs)->internalData;
-	
-	internalData->strData = Runtime_array_new_copy(rhsInternalData->strData);
+	return Runtime_popcount_words(internArr->data, RUNTIME_BIT_ARRAY_WORDS(internArr->size));
 }
 
-charT Runtime_string_at(Runtime_string_handle self, uint64T index)
+uint64T Runtime_bitarray_rank(Runtime_array_handle self, uint64T index)
 {
-	charT result = 0;
-	if (!Runtime_string_empty(self)) {
-		auto valPtr = Runtime_array_at((RUNTIME_STRING_INTERNAL_DATA(self)->internalData)->strData, index);
-		result = *((charT*)valPtr);
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	if (index >= internArr->size) {
+		return Runtime_bitarray_count(self);
 	}
+
+	uint64T result = Runtime_popcount_words(internArr->data, index >> 6);
+	auto tailBits = index & 63;
+	if (0 != tailBits) {
+		result += Runtime_popcount64(internArr->data[index >> 6] & ((1ULL << tailBits) - 1));
+	}
+
 	return result;
 }
 
-void Runtime_string_set(Runtime_string_handle self, uint64T index, charT ch)
+uint64T Runtime_bitarray_find_next_set(Runtime_array_handle self, uint64T start)
 {
-	if (!Runtime_string_empty(self)) {
-		auto valPtr = (charT*) Runtime_array_at((RUNTIME_STRING_INTERNAL_DATA(self)->internalData)->strData, index);
-		*valPtr = ch;
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	if (start >= internArr->size) {
+		return Runtime_NoIndx;
 	}
-}
 
+	auto wordCount = RUNTIME_BIT_ARRAY_WORDS(internArr->size);
+	auto wordIdx = start >> 6;
+	unsigned long bit = 0;
 
-int32T Runtime_string_compare(Runtime_string_handle self, Runtime_string_handle rhs)
-{
-	int32T result = 0;
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
+	//rest of the first word
+	uint64T word = internArr->data[wordIdx] & (~0ULL << (start & 63));
+	if (_BitScanForward64(&bit, word)) {
+		return (wordIdx << 6) + bit;
+	}
+	wordIdx++;
 
-	Runtime_string_internal_data* rhsInternalData = RUNTIME_STRING_INTERNAL_DATA(rhs)->internalData;
+	//skip empty runs 2 words at a time
+	const __m128i zero = _mm_setzero_si128();
+	while (wordIdx + 2 <= wordCount) {
+		__m128i words = _mm_loadu_si128((const __m128i*)(internArr->data + wordIdx));
+		if (0xFFFF != _mm_movemask_epi8(_mm_cmpeq_epi8(words, zero))) {
+			break;
+		}
+		wordIdx += 2;
+	}
 
-	result = (int32T)Runtime_array_compare(internalData->strData, rhsInternalData->strData);
+	for (; wordIdx < wordCount; wordIdx++) {
+		if (_BitScanForward64(&bit, internArr->data[wordIdx])) {
+			return (wordIdx << 6) + bit;
+		}
+	}
 
-	return result;
+	return Runtime_NoIndx;
 }
 
 
-Runtime_string_handle Runtime_string_substr(Runtime_string_handle self, uint64T start, uint64T count)
-{
-	Runtime_string_handle result = nullptr;
+struct Runtime_bit_op_and {
+	static inline uint64T apply(uint64T a, uint64T b) { return a & b; }
+	static inline __m128i apply(__m128i a, __m128i b) { return _mm_and_si128(a, b); }
+#ifdef __AVX2__
+	static inline __m256i apply(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+#endif
+};
 
-	if (nullptr == self) {
-		return result;
-	}
+struct Runtime_bit_op_or {
+	static inline uint64T apply(uint64T a, uint64T b) { return a | b; }
+	static inline __m128i apply(__m128i a, __m128i b) { return _mm_or_si128(a, b); }
+#ifdef __AVX2__
+	static inline __m256i apply(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct Runtime_bit_op_xor {
+	static inline uint64T apply(uint64T a, uint64T b) { return a ^ b; }
+	static inline __m128i apply(__m128i a, __m128i b) { return _mm_xor_si128(a, b); }
+#ifdef __AVX2__
+	static inline __m256i apply(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+#endif
+};
 
-	Runtime_string_internal_data* internalData = RUNTIME_STRING_INTERNAL_DATA(self)->internalData;
+struct Runtime_bit_op_andnot {
+	static inline uint64T apply(uint64T a, uint64T b) { return a & ~b; }
+	//andnot intrinsics are ~first & second
+	static inline __m128i apply(__m128i a, __m128i b) { return _mm_andnot_si128(b, a); }
+#ifdef __AVX2__
+	static inline __m256i apply(__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); }
+#endif
+};
 
-	Runtime_heap_array* arrayData = RUNTIME_HEAP_ARRAY(internalData->strData);
 
-	if ((start >= arrayData->size) || ((start + count) >= arrayData->size)) {
-		return result;
+//dest[i] = dest[i] op src[i], 256 bits at a time with AVX2 builds,
+//128 bits otherwise (SSE2 is always there on x64)
+template<typename OpT>
+void Runtime_bitarray_apply_words(uint64T* dest, const uint64T* src, uint64T count)
+{
+	uint64T i = 0;
+#ifdef __AVX2__
+	for (; i + 4 <= count; i += 4) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(dest + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+		_mm256_storeu_si256((__m256i*)(dest + i), OpT::apply(a, b));
+	}
+#endif
+	for (; i + 2 <= count; i += 2) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(dest + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dest + i), OpT::apply(a, b));
+	}
+	for (; i < count; i++) {
+		dest[i] = OpT::apply(dest[i], src[i]);
 	}
+}
 
-	
+template<typename OpT>
+void Runtime_bitarray_apply(Runtime_array_handle self, Runtime_array_handle rhs, bool clearMissing)
+{
+	Runtime_bit_array* internArr = RUNTIME_BIT_ARRAY(self);
+	Runtime_bit_array* rhsInternArr = RUNTIME_BIT_ARRAY(rhs);
 
+	auto words = RUNTIME_BIT_ARRAY_WORDS(internArr->size);
+	auto rhsWords = RUNTIME_BIT_ARRAY_WORDS(rhsInternArr->size);
+	auto common = words < rhsWords ? words : rhsWords;
 
+	Runtime_bitarray_apply_words<OpT>(internArr->data, rhsInternArr->data, common);
 
-	return result;
+	//x & 0 == 0, everything else leaves x alone
+	if (clearMissing && words > common) {
+		memset(internArr->data + common, 0, (words - common) * sizeof(uint64T));
+	}
+
+	if (words > 0) {
+		Runtime_bitarray_mask_tail(internArr);
+	}
 }
 
+void Runtime_bitarray_and(Runtime_array_handle self, Runtime_array_handle rhs)
+{
+	Runtime_bitarray_apply<Runtime_bit_op_and>(self, rhs, true);
+}
 
-uint64T Runtime_string_find(Runtime_string_handle self, Runtime_string_handle searchStr)
+void Runtime_bitarray_or(Runtime_array_handle self, Runtime_array_handle rhs)
 {
-	return Runtime_NoIndx;
+	Runtime_bitarray_apply<Runtime_bit_op_or>(self, rhs, false);
 }
 
-charT* Runtime_string_get_cstr(Runtime_string_handle self)
+void Runtime_bitarray_xor(Runtime_array_handle self, Runtime_array_handle rhs)
 {
-	return (charT*)Runtime_array_at((RUNTIME_STRING_INTERNAL_DATA(self)->internalData)->strData, 0);
+	Runtime_bitarray_apply<Runtime_bit_op_xor>(self, rhs, false);
 }
 
+void Runtime_bitarray_andnot(Runtime_array_handle self, Runtime_array_handle rhs)
+{
+	Runtime_bitarray_apply<Runtime_bit_op_andnot>(self, rhs, false);
+}
 
-//strings end
+//array end
 //----------------------------------------------------------------------------
 
 
 
-bool Runtime_verify_heap_mem(void* mem)
+//----------------------------------------------------------------------------
+//strings
+
+//a string is a single allocation, the object followed by its
+//chars. Short strings, up to RUNTIME_STRING_SMALL_CAPACITY chars,
+//fit in the object's own inlineData, longer ones get an object 
+//with inlineData extended to fit. Only an assign that outgrows the
+//capacity moves the chars to a separate buffer. Chars are 0 
+//terminated, except in views, size doesn't count the 0.
+//A view (see Runtime_string_substr) points into the chars of its
+//parent, and keeps the parent alive through its refCount. Writing 
+//to a view first gives it its own copy of the chars. Writing to a 
+//parent with views moves the parent to new chars, the views keep 
+//the old ones. Chars in the object stay with the object, a separate 
+//buffer is handed to a holder string the views point at instead, 
+//made by the first substr.
+//String literals are Runtime_static_strings, constant data emitted 
+//by the compiler with this layout. They're immortal, never freed, 
+//written or refcounted
+
+#define RUNTIME_STRING_SMALL_CAPACITY	23
+
+//bit values live in runtime_string_flags.h, the compiler emits them
+//into string literals
+enum Runtime_string_flags {
+	//owned by the intern pool, see Runtime_string_intern
+	rtStringInterned = RUNTIME_STRING_FLAG_INTERNED,
+	rtStringView = RUNTIME_STRING_FLAG_VIEW,
+	//Runtime_string_is_utf8 has looked at the chars, and what it found
+	rtStringUtf8Checked = RUNTIME_STRING_FLAG_UTF8_CHECKED,
+	rtStringUtf8Valid = RUNTIME_STRING_FLAG_UTF8_VALID,
+	rtStringImmortal = RUNTIME_STRING_FLAG_IMMORTAL,
+	//the separate buffer belongs to the holder in parent, views of 
+	//the string share it
+	rtStringSharedBuffer = RUNTIME_STRING_FLAG_SHARED_BUFFER,
+};
+
+struct Runtime_string {
+	charT* data;
+	uint64T size;
+	uint64T capacity;
+	uint64T hashval;
+	uint32T flags;
+	//1 + the number of views, changed with interlocked ops since
+	//views of interned strings can be made from any thread
+	uint32T refCount;
+	union {
+		charT inlineData[RUNTIME_STRING_SMALL_CAPACITY + 1];
+		//views, and the holder for rtStringSharedBuffer
+		Runtime_string* parent;
+	};
+};
+
+#define RUNTIME_STRING(self) ((Runtime_string*)self)
+
+static_assert(sizeof(Runtime_static_string) == sizeof(Runtime_string), "Runtime_static_string must match Runtime_string");
+static_assert(offsetof(Runtime_static_string, chars) == offsetof(Runtime_string, inlineData), "Runtime_static_string must match Runtime_string");
+static_assert(Runtime_static_string_small_capacity == RUNTIME_STRING_SMALL_CAPACITY, "Runtime_static_string must match Runtime_string");
+static_assert(Runtime_static_string_flags == (rtStringImmortal | rtStringUtf8Checked) && Runtime_static_string_utf8_valid == rtStringUtf8Valid, 
+	"Runtime_static_string flags must match Runtime_string_flags");
+
+uint64T Runtime_c_str_length(const charT* c_strPtr)
 {
-	if (nullptr == mem) {
+	uint64T result = 0;
+	const charT* ptr = c_strPtr;
+	while (*ptr != 0) {
+		ptr++;
+		result++;
+	}
+	return result;
+}
+
+inline bool Runtime_string_is_inline(Runtime_string* str)
+{
+	return str->data == str->inlineData;
+}
+
+//empty string object with room for capacity chars
+Runtime_string* Runtime_string_alloc(uint64T capacity)
+{
+	capacity = capacity < RUNTIME_STRING_SMALL_CAPACITY ? RUNTIME_STRING_SMALL_CAPACITY : capacity;
+
+	auto result = (Runtime_string*)Runtime_alloc(sizeof(Runtime_string) + capacity - RUNTIME_STRING_SMALL_CAPACITY, typeString);
+	result->data = result->inlineData;
+	result->size = 0;
+	result->capacity = capacity;
+	result->hashval = 0;
+	result->flags = 0;
+	result->refCount = 1;
+	result->data[0] = 0;
+
+	return result;
+}
+
+inline void Runtime_string_retain(Runtime_string* str)
+{
+	if (0 == (str->flags & rtStringImmortal)) {
+		_InterlockedIncrement((volatile long*)&str->refCount);
+	}
+}
+
+//frees the string once it has no views left
+void Runtime_string_release(Runtime_string* str)
+{
+	if (0 != (str->flags & rtStringImmortal) || 0 != _InterlockedDecrement((volatile long*)&str->refCount)) {
+		return;
+	}
+	if (0 != (str->flags & rtStringSharedBuffer)) {
+		Runtime_string_release(str->parent);
+	}
+	else if (!Runtime_string_is_inline(str)) {
+		Runtime_free(str->data);
+	}
+	Runtime_free(str);
+}
+
+//what views of str (not a view itself) point at: str for chars in
+//the object, the holder of a separate buffer, made here the first 
+//time. nullptr if there's nowhere to keep a holder, the views are 
+//copies then
+Runtime_string* Runtime_string_view_owner(Runtime_string* str)
+{
+	if (Runtime_string_is_inline(str) || 0 != (str->flags & rtStringImmortal)) {
+		return str;
+	}
+	if (0 != (str->flags & rtStringSharedBuffer)) {
+		return str->parent;
+	}
+	//parent shares the space with inlineData, which views from 
+	//before the chars moved out may still be reading. Interned 
+	//strings are used from any thread, a holder can't be added safely
+	if (1 != str->refCount || 0 != (str->flags & rtStringInterned)) {
+		return nullptr;
+	}
+
+	auto holder = Runtime_string_alloc(0);
+	holder->data = str->data;
+	holder->size = str->size;
+	holder->capacity = str->capacity;
+
+	str->parent = holder;
+	str->flags |= rtStringSharedBuffer;
+	return holder;
+}
+
+//moves str's chars out from under its views into a buffer of its own
+void Runtime_string_detach(Runtime_string* str, bool keepChars)
+{
+	Runtime_string* holder = nullptr;
+	if (0 != (str->flags & rtStringSharedBuffer)) {
+		holder = str->parent;
+		str->flags &= ~rtStringSharedBuffer;
+		if (1 == holder->refCount) {
+			//no views left, the buffer comes back
+			Runtime_free(holder);
+			return;
+		}
+	}
+
+	auto buf = (charT*)Runtime_alloc(str->capacity + 1, typeUnknown);
+	uint64T size = keepChars ? str->size : 0;
+	Runtime_mem_cpy(str->data, buf, size);
+	buf[size] = 0;
+	str->data = buf;
+	str->size = size;
+
+	if (nullptr != holder) {
+		Runtime_string_release(holder);
+	}
+}
+
+//the view gets its own chars (or none if !keepChars) and lets go 
+//of the parent
+void Runtime_string_unshare(Runtime_string* str, bool keepChars)
+{
+	auto parent = str->parent;
+	auto chars = str->data;
+	uint64T size = keepChars ? str->size : 0;
+
+	str->flags &= ~rtStringView;
+	if (size <= RUNTIME_STRING_SMALL_CAPACITY) {
+		str->data = str->inlineData;
+		str->capacity = RUNTIME_STRING_SMALL_CAPACITY;
+	}
+	else {
+		str->data = (charT*)Runtime_alloc(size + 1, typeUnknown);
+		str->capacity = size;
+	}
+	Runtime_mem_cpy(chars, str->data, size);
+	str->data[size] = 0;
+	str->size = size;
+
+	Runtime_string_release(parent);
+}
+
+//before changing the chars. Interned strings and literals are 
+//shared and never change, false for those
+inline bool Runtime_string_prepare_write(Runtime_string* str, bool keepChars)
+{
+	if (0 != (str->flags & (rtStringInterned | rtStringImmortal))) {
+		Runtime_debug_printf("Can't change an interned or literal string\n");
 		return false;
 	}
 
-	uint8T* memPtr = (uint8T*)mem;
-	memPtr -= sizeof(Runtime_memory_info);
-	Runtime_memory_info* rtMemPtr = (Runtime_memory_info*)memPtr;
+	str->flags &= ~(rtStringUtf8Checked | rtStringUtf8Valid);
+	if (0 != (str->flags & rtStringView)) {
+		Runtime_string_unshare(str, keepChars);
+	}
+	else if (0 != (str->flags & rtStringSharedBuffer) || (1 != str->refCount && Runtime_string_is_inline(str))) {
+		Runtime_string_detach(str, keepChars);
+	}
+	return true;
+}
+
+//replaces the chars, the source may be the string's own chars.
+//False if the string can't be changed
+bool Runtime_string_set_chars(Runtime_string* str, const charT* c_strPtr, uint64T size)
+{
+	if (0 != (str->flags & rtStringView)) {
+		//the source may be the parent's chars
+		auto parent = str->parent;
+		Runtime_string_retain(parent);
+		Runtime_string_unshare(str, false);
+		Runtime_string_set_chars(str, c_strPtr, size);
+		Runtime_string_release(parent);
+		return true;
+	}
+	if (!Runtime_string_prepare_write(str, false)) {
+		return false;
+	}
+
+	if (size > str->capacity) {
+		auto buf = (charT*)Runtime_alloc(size + 1, typeUnknown);
+		Runtime_mem_cpy((void*)c_strPtr, buf, size);
+		if (!Runtime_string_is_inline(str)) {
+			Runtime_free(str->data);
+		}
+		str->data = buf;
+		str->capacity = size;
+	}
+	else {
+		Runtime_mem_cpy((void*)c_strPtr, str->data, size);
+	}
+
+	str->data[size] = 0;
+	str->size = size;
+	str->hashval = 0;
+	return true;
+}
+
+//room for at least capacity chars, keeping the chars. Grows at 
+//least 2x so a run of appends copies each char O(1) times
+void Runtime_string_grow(Runtime_string* str, uint64T capacity)
+{
+	if (capacity <= str->capacity) {
+		return;
+	}
+
+	uint64T newCapacity = str->capacity * 2;
+	if (newCapacity < capacity) {
+		newCapacity = capacity;
+	}
+
+	auto buf = (charT*)Runtime_alloc(newCapacity + 1, typeUnknown);
+	Runtime_mem_cpy(str->data, buf, str->size + 1);
+	if (!Runtime_string_is_inline(str)) {
+		Runtime_free(str->data);
+	}
+	str->data = buf;
+	str->capacity = newCapacity;
+}
+
+void Runtime_string_fill(Runtime_string* str, charT ch, uint64T count)
+{
+	if (!Runtime_string_prepare_write(str, false)) {
+		return;
+	}
+
+	if (count > str->capacity) {
+		if (!Runtime_string_is_inline(str)) {
+			Runtime_free(str->data);
+		}
+		str->data = (charT*)Runtime_alloc(count + 1, typeUnknown);
+		str->capacity = count;
+	}
+
+	for (uint64T i = 0; i < count; i++) {
+		str->data[i] = ch;
+	}
+	str->data[count] = 0;
+	str->size = count;
+	str->hashval = 0;
+}
+
+Runtime_string_handle Runtime_string_new_empty()
+{
+	return (Runtime_string_handle)Runtime_string_alloc(0);
+}
+
+Runtime_string_handle Runtime_string_new(const charT* c_strPtr)
+{
 	
-	if (mem != rtMemPtr->memPtr) {
-		Runtime_debug_printf("Runtime_verify_heap_mem failed!\n");
+	return Runtime_string_new_with_size(c_strPtr, Runtime_c_str_length(c_strPtr));
+}
+
+Runtime_string_handle Runtime_string_new_with_size(const charT* c_strPtr, uint64T size)
+{
+	auto result = Runtime_string_alloc(size);
+	Runtime_string_set_chars(result, c_strPtr, size);
+
+	return (Runtime_string_handle)result;
+}
+
+Runtime_string_handle Runtime_string_new_char_count(charT ch, uint64T count)
+{
+	auto result = Runtime_string_alloc(count);
+	Runtime_string_fill(result, ch, count);
+
+	return (Runtime_string_handle)result;
+}
+
+Runtime_string_handle Runtime_string_new_copy(Runtime_string_handle rhs)
+{
+	auto rhsStr = RUNTIME_STRING(rhs);
+	auto result = Runtime_string_alloc(rhsStr->size);
+	Runtime_string_set_chars(result, rhsStr->data, rhsStr->size);
+	result->hashval = rhsStr->hashval;
+	result->flags |= rhsStr->flags & (rtStringUtf8Checked | rtStringUtf8Valid);
+
+	return (Runtime_string_handle)result;
+}
+
+void Runtime_string_delete(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	if (0 != (str->flags & (rtStringInterned | rtStringImmortal))) {
+		//the intern pool frees it, literals live forever
+		return;
+	}
+	if (0 != (str->flags & rtStringView)) {
+		auto parent = str->parent;
+		Runtime_free(str);
+		Runtime_string_release(parent);
+		return;
 	}
+	Runtime_string_release(str);
+}
 
-	return rtMemPtr->memPtr == mem;
+bool Runtime_string_empty(Runtime_string_handle self)
+{
+	return Runtime_string_size(self) == 0 ? true : false;
 }
 
-void* Runtime_alloc(uint64T size, Runtime_TypeDescriptor type)
+uint64T Runtime_string_size(Runtime_string_handle self)
 {
-    void* result = nullptr;
-	uint64T adjustedSize = 0;
-	Runtime_memory_info memInfo;
+	if (nullptr == self) {
+		return 0;
+	}
 	
-	Runtime_memory_info_init(&memInfo);
+	return RUNTIME_STRING(self)->size;
+}
+
+uint64T Runtime_string_size_bytes(Runtime_string_handle self)
+{ 
+	return RUNTIME_STRING(self)->size * sizeof(charT);
+}
+
+uint64T Runtime_string_hash(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	if (0 == str->hashval) {
+		uint64T hash = Runtime_hash_basic_bytes((byteT*)str->data, str->size * sizeof(charT));
+		if (0 != (str->flags & rtStringImmortal)) {
+			//the compiler worked it out, it's only 0 for ""
+			return hash;
+		}
+		str->hashval = hash;
+	}
+
+	return str->hashval;
+}
+
+void Runtime_string_clear(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	if (!Runtime_string_prepare_write(str, false)) {
+		return;
+	}
+	str->size = 0;
+	str->data[0] = 0;
+	str->hashval = 0;
+}
+
+void Runtime_string_assign(Runtime_string_handle self, charT* c_strPtr)
+{	
+	Runtime_string_assign_with_size(self, c_strPtr, Runtime_c_str_length(c_strPtr));
+}
+
+void Runtime_string_assign_with_size(Runtime_string_handle self, charT* c_strPtr, uint64T size)
+{
+	Runtime_string_set_chars(RUNTIME_STRING(self), c_strPtr, size);
+}
+
+void Runtime_string_assign_char_count(Runtime_string_handle self, charT ch, uint64T count)
+{
+	Runtime_string_fill(RUNTIME_STRING(self), ch, count);
+}
+
+void Runtime_string_assign_copy(Runtime_string_handle self, Runtime_string_handle rhs)
+{
+	auto rhsStr = RUNTIME_STRING(rhs);
+	if (Runtime_string_set_chars(RUNTIME_STRING(self), rhsStr->data, rhsStr->size)) {
+		RUNTIME_STRING(self)->hashval = rhsStr->hashval;
+	}
+}
+
+void Runtime_string_append(Runtime_string_handle self, const charT* c_strPtr)
+{
+	Runtime_string_append_with_size(self, c_strPtr, Runtime_c_str_length(c_strPtr));
+}
+
+void Runtime_string_append_with_size(Runtime_string_handle self, const charT* c_strPtr, uint64T size)
+{
+	auto str = RUNTIME_STRING(self);
+	if (0 != (str->flags & rtStringView)) {
+		//the source may be the parent's chars
+		auto parent = str->parent;
+		Runtime_string_retain(parent);
+		Runtime_string_unshare(str, true);
+		Runtime_string_append_with_size(self, c_strPtr, size);
+		Runtime_string_release(parent);
+		return;
+	}
+	if (!Runtime_string_prepare_write(str, true)) {
+		return;
+	}
+
+	if (str->size + size > str->capacity) {
+		//appending (part of) itself, the chars move when it grows
+		bool own = c_strPtr >= str->data && c_strPtr <= str->data + str->size;
+		uint64T offset = own ? c_strPtr - str->data : 0;
+		Runtime_string_grow(str, str->size + size);
+		if (own) {
+			c_strPtr = str->data + offset;
+		}
+	}
+
+	Runtime_mem_cpy((void*)c_strPtr, str->data + str->size, size);
+	str->size += size;
+	str->data[str->size] = 0;
+	str->hashval = 0;
+}
+
+void Runtime_string_append_string(Runtime_string_handle self, Runtime_string_handle rhs)
+{
+	Runtime_string_append_with_size(self, RUNTIME_STRING(rhs)->data, RUNTIME_STRING(rhs)->size);
+}
+
+Runtime_string_handle Runtime_string_concat(Runtime_string_handle lhs, Runtime_string_handle rhs)
+{
+	auto lhsStr = RUNTIME_STRING(lhs);
+	auto rhsStr = RUNTIME_STRING(rhs);
+
+	auto result = Runtime_string_alloc(lhsStr->size + rhsStr->size);
+	Runtime_mem_cpy(lhsStr->data, result->data, lhsStr->size);
+	Runtime_mem_cpy(rhsStr->data, result->data + lhsStr->size, rhsStr->size);
+	result->size = lhsStr->size + rhsStr->size;
+	result->data[result->size] = 0;
+
+	return (Runtime_string_handle)result;
+}
+
+charT Runtime_string_at(Runtime_string_handle self, uint64T index)
+{
+	charT result = 0;
+	auto str = RUNTIME_STRING(self);
+	if (index < str->size) {
+		result = str->data[index];
+	}
+	return result;
+}
+
+void Runtime_string_set(Runtime_string_handle self, uint64T index, charT ch)
+{
+	auto str = RUNTIME_STRING(self);
+	if (index < str->size && Runtime_string_prepare_write(str, true)) {
+		str->data[index] = ch;
+		str->hashval = 0;
+	}
+}
+
+
+//cheaper than compare when only equality matters. Two different 
+//interned strings are never equal, and differing sizes or hashes
+//(if both are already known) rule out a match without looking at 
+//the chars
+bool Runtime_string_equals(Runtime_string_handle self, Runtime_string_handle rhs)
+{
+	auto str = RUNTIME_STRING(self);
+	auto rhsStr = RUNTIME_STRING(rhs);
+
+	if (str == rhsStr) {
+		return true;
+	}
+	if (0 != (str->flags & rhsStr->flags & rtStringInterned) || str->size != rhsStr->size) {
+		return false;
+	}
+	if (0 != str->hashval && 0 != rhsStr->hashval && str->hashval != rhsStr->hashval) {
+		return false;
+	}
+	return 0 == Runtime_mem_cmp(str->data, str->size * sizeof(charT), rhsStr->data, rhsStr->size * sizeof(charT));
+}
+
+int32T Runtime_string_compare(Runtime_string_handle self, Runtime_string_handle rhs)
+{
+	auto str = RUNTIME_STRING(self);
+	auto rhsStr = RUNTIME_STRING(rhs);
+
+	return (int32T)Runtime_mem_cmp(str->data, str->size * sizeof(charT), rhsStr->data, rhsStr->size * sizeof(charT));
+}
+
+
+Runtime_string_handle Runtime_string_substr(Runtime_string_handle self, uint64T start, uint64T count)
+{
+	Runtime_string_handle result = nullptr;
+
+	if (nullptr == self) {
+		return result;
+	}
+
+	auto str = RUNTIME_STRING(self);
+	if (start > str->size || count > str->size - start) {
+		return result;
+	}
+
+	//short ones fit in the object anyway
+	if (count <= RUNTIME_STRING_SMALL_CAPACITY) {
+		return Runtime_string_new_with_size(str->data + start, count);
+	}
+
+	//views point into the chars of the string owning them
+	auto owner = 0 != (str->flags & rtStringView) ? str->parent : Runtime_string_view_owner(str);
+	if (nullptr == owner) {
+		return Runtime_string_new_with_size(str->data + start, count);
+	}
+	Runtime_string_retain(owner);
+
+	auto view = Runtime_string_alloc(0);
+	view->data = str->data + start;
+	view->size = count;
+	view->capacity = count;
+	view->flags = rtStringView;
+	view->parent = owner;
+
+	return (Runtime_string_handle)view;
+}
+
+void Runtime_string_compact(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	if (0 != (str->flags & rtStringView)) {
+		Runtime_string_unshare(str, true);
+	}
+}
+
+bool Runtime_string_is_view(Runtime_string_handle self)
+{
+	return 0 != (RUNTIME_STRING(self)->flags & rtStringView);
+}
+
+bool Runtime_string_is_immortal(Runtime_string_handle self)
+{
+	return 0 != (RUNTIME_STRING(self)->flags & rtStringImmortal);
+}
+
+
+//first index of needle in hay, or Runtime_NoIndx. 16 positions at a 
+//time are filtered on needle's first and last char, only those
+//matching both are compared in full
+uint64T Runtime_chars_find(const charT* hay, uint64T haySize, const charT* needle, uint64T needleSize)
+{
+	if (0 == needleSize) {
+		return 0;
+	}
+	if (needleSize > haySize) {
+		return Runtime_NoIndx;
+	}
+
+	uint64T last = haySize - needleSize;
+	uint64T i = 0;
+
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i lastCh = _mm_set1_epi8(needle[needleSize - 1]);
+	for (; i + 16 <= last + 1; i += 16) {
+		__m128i firstEq = _mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i*)(hay + i)));
+		__m128i lastEq = _mm_cmpeq_epi8(lastCh, _mm_loadu_si128((const __m128i*)(hay + i + needleSize - 1)));
+		uint32T mask = (uint32T)_mm_movemask_epi8(_mm_and_si128(firstEq, lastEq));
+		while (0 != mask) {
+			unsigned long bit = 0;
+			_BitScanForward(&bit, mask);
+			if (needleSize <= 2 || 0 == Runtime_mem_cmp(hay + i + bit + 1, needleSize - 2, needle + 1, needleSize - 2)) {
+				return i + bit;
+			}
+			mask &= mask - 1;
+		}
+	}
+
+	for (; i <= last; i++) {
+		if (hay[i] == needle[0] && 0 == Runtime_mem_cmp(hay + i, needleSize, needle, needleSize)) {
+			return i;
+		}
+	}
+
+	return Runtime_NoIndx;
+}
+
+//last index of needle in hay, or Runtime_NoIndx. Same filter as 
+//Runtime_chars_find, walking backwards
+uint64T Runtime_chars_find_last(const charT* hay, uint64T haySize, const charT* needle, uint64T needleSize)
+{
+	if (needleSize > haySize) {
+		return Runtime_NoIndx;
+	}
+	if (0 == needleSize) {
+		return haySize;
+	}
+
+	//one past the last candidate
+	uint64T end = haySize - needleSize + 1;
+
+	const __m128i first = _mm_set1_epi8(needle[0]);
+	const __m128i lastCh = _mm_set1_epi8(needle[needleSize - 1]);
+	for (; end >= 16; end -= 16) {
+		uint64T i = end - 16;
+		__m128i firstEq = _mm_cmpeq_epi8(first, _mm_loadu_si128((const __m128i*)(hay + i)));
+		__m128i lastEq = _mm_cmpeq_epi8(lastCh, _mm_loadu_si128((const __m128i*)(hay + i + needleSize - 1)));
+		uint32T mask = (uint32T)_mm_movemask_epi8(_mm_and_si128(firstEq, lastEq));
+		while (0 != mask) {
+			unsigned long bit = 0;
+			_BitScanReverse(&bit, mask);
+			if (needleSize <= 2 || 0 == Runtime_mem_cmp(hay + i + bit + 1, needleSize - 2, needle + 1, needleSize - 2)) {
+				return i + bit;
+			}
+			mask &= ~(1u << bit);
+		}
+	}
+
+	while (end > 0) {
+		end--;
+		if (hay[end] == needle[0] && 0 == Runtime_mem_cmp(hay + end, needleSize, needle, needleSize)) {
+			return end;
+		}
+	}
+
+	return Runtime_NoIndx;
+}
+
+uint64T Runtime_string_find(Runtime_string_handle self, Runtime_string_handle searchStr)
+{
+	return Runtime_string_find_from(self, searchStr, 0);
+}
+
+uint64T Runtime_string_find_from(Runtime_string_handle self, Runtime_string_handle searchStr, uint64T start)
+{
+	auto str = RUNTIME_STRING(self);
+	auto search = RUNTIME_STRING(searchStr);
+	if (start > str->size) {
+		return Runtime_NoIndx;
+	}
+
+	uint64T result = Runtime_chars_find(str->data + start, str->size - start, search->data, search->size);
+	return Runtime_NoIndx == result ? result : result + start;
+}
+
+uint64T Runtime_string_find_last(Runtime_string_handle self, Runtime_string_handle searchStr)
+{
+	auto str = RUNTIME_STRING(self);
+	auto search = RUNTIME_STRING(searchStr);
+
+	return Runtime_chars_find_last(str->data, str->size, search->data, search->size);
+}
+
+uint64T Runtime_string_count(Runtime_string_handle self, Runtime_string_handle searchStr)
+{
+	auto str = RUNTIME_STRING(self);
+	auto search = RUNTIME_STRING(searchStr);
+	if (0 == search->size) {
+		return 0;
+	}
+
+	uint64T result = 0;
+	uint64T pos = 0;
+	while (pos + search->size <= str->size) {
+		uint64T found = Runtime_chars_find(str->data + pos, str->size - pos, search->data, search->size);
+		if (Runtime_NoIndx == found) {
+			break;
+		}
+		result++;
+		pos += found + search->size;
+	}
+
+	return result;
+}
+
+charT* Runtime_string_get_cstr(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	//a view is 0 terminated only if it ends where its parent does
+	if (0 != (str->flags & rtStringView) && 0 != str->data[str->size]) {
+		Runtime_string_unshare(str, true);
+	}
+	return str->data;
+}
+
+
+//strings end
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+//string builder
+
+struct Runtime_string_builder {
+	charT* data;
+	uint64T size;
+	uint64T capacity;
+};
+
+#define RUNTIME_STRING_BUILDER_MIN_CAPACITY	64
+
+void Runtime_string_builder_grow(Runtime_string_builder* builder, uint64T capacity)
+{
+	if (capacity <= builder->capacity) {
+		return;
+	}
+
+	uint64T newCapacity = builder->capacity * 2;
+	if (newCapacity < capacity) {
+		newCapacity = capacity;
+	}
+	if (newCapacity < RUNTIME_STRING_BUILDER_MIN_CAPACITY) {
+		newCapacity = RUNTIME_STRING_BUILDER_MIN_CAPACITY;
+	}
+
+	auto buf = (charT*)Runtime_alloc(newCapacity + 1, typeUnknown);
+	if (nullptr != builder->data) {
+		Runtime_mem_cpy(builder->data, buf, builder->size);
+		Runtime_free(builder->data);
+	}
+	builder->data = buf;
+	builder->capacity = newCapacity;
+}
+
+Runtime_string_builder_handle Runtime_string_builder_new(uint64T capacity)
+{
+	auto result = (Runtime_string_builder*)Runtime_alloc(sizeof(Runtime_string_builder), typeUnknown);
+	result->data = nullptr;
+	result->size = 0;
+	result->capacity = 0;
+	if (0 != capacity) {
+		Runtime_string_builder_grow(result, capacity);
+	}
+
+	return (Runtime_string_builder_handle)result;
+}
+
+void Runtime_string_builder_delete(Runtime_string_builder_handle self)
+{
+	auto builder = (Runtime_string_builder*)self;
+	if (nullptr != builder->data) {
+		Runtime_free(builder->data);
+	}
+	Runtime_free(builder);
+}
+
+uint64T Runtime_string_builder_size(Runtime_string_builder_handle self)
+{
+	return ((Runtime_string_builder*)self)->size;
+}
+
+void Runtime_string_builder_clear(Runtime_string_builder_handle self)
+{
+	((Runtime_string_builder*)self)->size = 0;
+}
+
+void Runtime_string_builder_append_with_size(Runtime_string_builder_handle self, const charT* c_strPtr, uint64T size)
+{
+	auto builder = (Runtime_string_builder*)self;
+	Runtime_string_builder_grow(builder, builder->size + size);
+	Runtime_mem_cpy((void*)c_strPtr, builder->data + builder->size, size);
+	builder->size += size;
+}
+
+void Runtime_string_builder_append(Runtime_string_builder_handle self, const charT* c_strPtr)
+{
+	Runtime_string_builder_append_with_size(self, c_strPtr, Runtime_c_str_length(c_strPtr));
+}
+
+void Runtime_string_builder_append_string(Runtime_string_builder_handle self, Runtime_string_handle str)
+{
+	Runtime_string_builder_append_with_size(self, RUNTIME_STRING(str)->data, RUNTIME_STRING(str)->size);
+}
+
+void Runtime_string_builder_append_char(Runtime_string_builder_handle self, charT ch)
+{
+	auto builder = (Runtime_string_builder*)self;
+	if (builder->size == builder->capacity) {
+		Runtime_string_builder_grow(builder, builder->size + 1);
+	}
+	builder->data[builder->size++] = ch;
+}
+
+void Runtime_string_builder_append_many(Runtime_string_builder_handle self, const Runtime_string_handle* strs, uint64T count)
+{
+	auto builder = (Runtime_string_builder*)self;
+
+	uint64T total = builder->size;
+	for (uint64T i = 0; i < count; i++) {
+		total += RUNTIME_STRING(strs[i])->size;
+	}
+	Runtime_string_builder_grow(builder, total);
+
+	for (uint64T i = 0; i < count; i++) {
+		auto str = RUNTIME_STRING(strs[i]);
+		Runtime_mem_cpy(str->data, builder->data + builder->size, str->size);
+		builder->size += str->size;
+	}
+}
+
+Runtime_string_handle Runtime_string_builder_to_string(Runtime_string_builder_handle self)
+{
+	auto builder = (Runtime_string_builder*)self;
+
+	if (builder->size <= RUNTIME_STRING_SMALL_CAPACITY) {
+		//fits inline, the builder keeps its buffer
+		auto result = (Runtime_string_handle)Runtime_string_new_with_size(builder->data, builder->size);
+		builder->size = 0;
+		return result;
+	}
+
+	//the string takes over the buffer, there's always room for the 0
+	auto result = Runtime_string_alloc(0);
+	result->data = builder->data;
+	result->data[builder->size] = 0;
+	result->size = builder->size;
+	result->capacity = builder->capacity;
+
+	builder->data = nullptr;
+	builder->size = 0;
+	builder->capacity = 0;
+
+	return (Runtime_string_handle)result;
+}
+
+//end of string builder
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//rope
+
+//a rope is a height balanced (AVL) tree, leaves hold up to 
+//RUNTIME_ROPE_LEAF_CAPACITY chars, inner nodes concatenate their 
+//two children. Concatenation joins the trees along a spine, and 
+//insert/erase split and rejoin, so all of them are O(log n) no 
+//matter how large the rope gets
+
+#define RUNTIME_ROPE_LEAF_CAPACITY	1000
+
+struct Runtime_rope_node {
+	Runtime_rope_node* left;
+	Runtime_rope_node* right;
+	uint64T size;
+	uint32T height;
+	//leaves only
+	charT chars[1];
+};
+
+struct Runtime_rope {
+	Runtime_rope_node* root;
+};
+
+#define RUNTIME_ROPE_IS_LEAF(node) (nullptr == (node)->left)
+
+inline uint32T Runtime_rope_height(Runtime_rope_node* node)
+{
+	return nullptr == node ? 0 : node->height;
+}
+
+Runtime_rope_node* Runtime_rope_leaf_new(const charT* c_strPtr, uint64T size)
+{
+	auto result = (Runtime_rope_node*)Runtime_alloc(sizeof(Runtime_rope_node) + RUNTIME_ROPE_LEAF_CAPACITY, typeUnknown);
+	result->left = nullptr;
+	result->right = nullptr;
+	result->size = size;
+	result->height = 1;
+	Runtime_mem_cpy((void*)c_strPtr, result->chars, size);
+
+	return result;
+}
+
+inline void Runtime_rope_update(Runtime_rope_node* node)
+{
+	uint32T leftHeight = node->left->height;
+	uint32T rightHeight = node->right->height;
+	node->size = node->left->size + node->right->size;
+	node->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+}
+
+Runtime_rope_node* Runtime_rope_concat_node(Runtime_rope_node* left, Runtime_rope_node* right)
+{
+	auto result = (Runtime_rope_node*)Runtime_alloc(sizeof(Runtime_rope_node), typeUnknown);
+	result->left = left;
+	result->right = right;
+	Runtime_rope_update(result);
+
+	return result;
+}
+
+void Runtime_rope_free_node(Runtime_rope_node* node)
+{
+	if (nullptr == node) {
+		return;
+	}
+	if (!RUNTIME_ROPE_IS_LEAF(node)) {
+		Runtime_rope_free_node(node->left);
+		Runtime_rope_free_node(node->right);
+	}
+	Runtime_free(node);
+}
+
+Runtime_rope_node* Runtime_rope_rotate_left(Runtime_rope_node* node)
+{
+	auto pivot = node->right;
+	node->right = pivot->left;
+	Runtime_rope_update(node);
+	pivot->left = node;
+	Runtime_rope_update(pivot);
+
+	return pivot;
+}
+
+Runtime_rope_node* Runtime_rope_rotate_right(Runtime_rope_node* node)
+{
+	auto pivot = node->left;
+	node->left = pivot->right;
+	Runtime_rope_update(node);
+	pivot->right = node;
+	Runtime_rope_update(pivot);
+
+	return pivot;
+}
+
+//left is more than 1 higher than right, walks down left's right spine
+Runtime_rope_node* Runtime_rope_join_right(Runtime_rope_node* left, Runtime_rope_node* right)
+{
+	auto inner = left->right;
+	if (Runtime_rope_height(inner) <= right->height + 1) {
+		auto joined = Runtime_rope_concat_node(inner, right);
+		left->right = joined;
+		if (joined->height <= left->left->height + 1) {
+			Runtime_rope_update(left);
+			return left;
+		}
+		left->right = Runtime_rope_rotate_right(joined);
+		return Runtime_rope_rotate_left(left);
+	}
+
+	left->right = Runtime_rope_join_right(inner, right);
+	Runtime_rope_update(left);
+	if (left->right->height <= left->left->height + 1) {
+		return left;
+	}
+	return Runtime_rope_rotate_left(left);
+}
+
+Runtime_rope_node* Runtime_rope_join_left(Runtime_rope_node* left, Runtime_rope_node* right)
+{
+	auto inner = right->left;
+	if (Runtime_rope_height(inner) <= left->height + 1) {
+		auto joined = Runtime_rope_concat_node(left, inner);
+		right->left = joined;
+		if (joined->height <= right->right->height + 1) {
+			Runtime_rope_update(right);
+			return right;
+		}
+		right->left = Runtime_rope_rotate_left(joined);
+		return Runtime_rope_rotate_right(right);
+	}
+
+	right->left = Runtime_rope_join_left(left, inner);
+	Runtime_rope_update(right);
+	if (right->left->height <= right->right->height + 1) {
+		return right;
+	}
+	return Runtime_rope_rotate_right(right);
+}
+
+//takes both trees
+Runtime_rope_node* Runtime_rope_join(Runtime_rope_node* left, Runtime_rope_node* right)
+{
+	if (nullptr == left) {
+		return right;
+	}
+	if (nullptr == right) {
+		return left;
+	}
+
+	//keeps the leaves from fragmenting into tiny pieces
+	if (RUNTIME_ROPE_IS_LEAF(left) && RUNTIME_ROPE_IS_LEAF(right) && left->size + right->size <= RUNTIME_ROPE_LEAF_CAPACITY) {
+		Runtime_mem_cpy(right->chars, left->chars + left->size, right->size);
+		left->size += right->size;
+		Runtime_free(right);
+		return left;
+	}
+
+	if (left->height > right->height + 1) {
+		return Runtime_rope_join_right(left, right);
+	}
+	if (right->height > left->height + 1) {
+		return Runtime_rope_join_left(left, right);
+	}
+	return Runtime_rope_concat_node(left, right);
+}
+
+//takes node, the first pos chars go to leftPtr, the rest to rightPtr
+void Runtime_rope_split(Runtime_rope_node* node, uint64T pos, Runtime_rope_node** leftPtr, Runtime_rope_node** rightPtr)
+{
+	if (nullptr == node) {
+		*leftPtr = nullptr;
+		*rightPtr = nullptr;
+		return;
+	}
+	if (0 == pos) {
+		*leftPtr = nullptr;
+		*rightPtr = node;
+		return;
+	}
+	if (pos >= node->size) {
+		*leftPtr = node;
+		*rightPtr = nullptr;
+		return;
+	}
+
+	if (RUNTIME_ROPE_IS_LEAF(node)) {
+		*rightPtr = Runtime_rope_leaf_new(node->chars + pos, node->size - pos);
+		node->size = pos;
+		*leftPtr = node;
+		return;
+	}
+
+	auto left = node->left;
+	auto right = node->right;
+	Runtime_free(node);
+
+	if (pos < left->size) {
+		Runtime_rope_node* splitRight = nullptr;
+		Runtime_rope_split(left, pos, leftPtr, &splitRight);
+		*rightPtr = Runtime_rope_join(splitRight, right);
+	}
+	else {
+		Runtime_rope_node* splitLeft = nullptr;
+		Runtime_rope_split(right, pos - left->size, &splitLeft, rightPtr);
+		*leftPtr = Runtime_rope_join(left, splitLeft);
+	}
+}
+
+//balanced tree of the chars
+Runtime_rope_node* Runtime_rope_build(const charT* c_strPtr, uint64T size)
+{
+	if (0 == size) {
+		return nullptr;
+	}
+	if (size <= RUNTIME_ROPE_LEAF_CAPACITY) {
+		return Runtime_rope_leaf_new(c_strPtr, size);
+	}
+
+	//halves on a leaf boundary so the leaves end up full
+	uint64T leafCount = (size + RUNTIME_ROPE_LEAF_CAPACITY - 1) / RUNTIME_ROPE_LEAF_CAPACITY;
+	uint64T half = (leafCount / 2) * RUNTIME_ROPE_LEAF_CAPACITY;
+	auto left = Runtime_rope_build(c_strPtr, half);
+	auto right = Runtime_rope_build(c_strPtr + half, size - half);
+
+	return Runtime_rope_join(left, right);
+}
+
+Runtime_rope_handle Runtime_rope_new()
+{
+	auto result = (Runtime_rope*)Runtime_alloc(sizeof(Runtime_rope), typeUnknown);
+	result->root = nullptr;
+
+	return (Runtime_rope_handle)result;
+}
+
+Runtime_rope_handle Runtime_rope_new_from_string(Runtime_string_handle str)
+{
+	auto result = (Runtime_rope*)Runtime_rope_new();
+	result->root = Runtime_rope_build(RUNTIME_STRING(str)->data, RUNTIME_STRING(str)->size);
+
+	return (Runtime_rope_handle)result;
+}
+
+void Runtime_rope_delete(Runtime_rope_handle self)
+{
+	Runtime_rope_free_node(((Runtime_rope*)self)->root);
+	Runtime_free(self);
+}
+
+uint64T Runtime_rope_size(Runtime_rope_handle self)
+{
+	auto root = ((Runtime_rope*)self)->root;
+	return nullptr == root ? 0 : root->size;
+}
+
+void Runtime_rope_append_with_size(Runtime_rope_handle self, const charT* c_strPtr, uint64T size)
+{
+	auto rope = (Runtime_rope*)self;
+	if (0 == size) {
+		return;
+	}
+
+	//small appends go into the last leaf if it has room
+	auto node = rope->root;
+	if (nullptr != node) {
+		while (!RUNTIME_ROPE_IS_LEAF(node)) {
+			node = node->right;
+		}
+		if (node->size + size <= RUNTIME_ROPE_LEAF_CAPACITY) {
+			Runtime_mem_cpy((void*)c_strPtr, node->chars + node->size, size);
+			for (node = rope->root; !RUNTIME_ROPE_IS_LEAF(node); node = node->right) {
+				node->size += size;
+			}
+			node->size += size;
+			return;
+		}
+	}
+
+	rope->root = Runtime_rope_join(rope->root, Runtime_rope_build(c_strPtr, size));
+}
+
+void Runtime_rope_append(Runtime_rope_handle self, const charT* c_strPtr)
+{
+	Runtime_rope_append_with_size(self, c_strPtr, Runtime_c_str_length(c_strPtr));
+}
+
+void Runtime_rope_append_string(Runtime_rope_handle self, Runtime_string_handle str)
+{
+	Runtime_rope_append_with_size(self, RUNTIME_STRING(str)->data, RUNTIME_STRING(str)->size);
+}
+
+void Runtime_rope_append_rope(Runtime_rope_handle self, Runtime_rope_handle rhs)
+{
+	auto rope = (Runtime_rope*)self;
+	auto rhsRope = (Runtime_rope*)rhs;
+
+	rope->root = Runtime_rope_join(rope->root, rhsRope->root);
+	Runtime_free(rhsRope);
+}
+
+void Runtime_rope_insert(Runtime_rope_handle self, uint64T index, const charT* c_strPtr, uint64T size)
+{
+	auto rope = (Runtime_rope*)self;
+	if (index > Runtime_rope_size(self)) {
+		index = Runtime_rope_size(self);
+	}
+
+	Runtime_rope_node* left = nullptr;
+	Runtime_rope_node* right = nullptr;
+	Runtime_rope_split(rope->root, index, &left, &right);
+	rope->root = Runtime_rope_join(Runtime_rope_join(left, Runtime_rope_build(c_strPtr, size)), right);
+}
+
+void Runtime_rope_erase(Runtime_rope_handle self, uint64T index, uint64T count)
+{
+	auto rope = (Runtime_rope*)self;
+	uint64T size = Runtime_rope_size(self);
+	if (index >= size) {
+		return;
+	}
+	if (count > size - index) {
+		count = size - index;
+	}
+
+	Runtime_rope_node* left = nullptr;
+	Runtime_rope_node* rest = nullptr;
+	Runtime_rope_node* erased = nullptr;
+	Runtime_rope_node* right = nullptr;
+	Runtime_rope_split(rope->root, index, &left, &rest);
+	Runtime_rope_split(rest, count, &erased, &right);
+	Runtime_rope_free_node(erased);
+	rope->root = Runtime_rope_join(left, right);
+}
+
+charT Runtime_rope_at(Runtime_rope_handle self, uint64T index)
+{
+	auto node = ((Runtime_rope*)self)->root;
+	if (nullptr == node || index >= node->size) {
+		return 0;
+	}
+
+	while (!RUNTIME_ROPE_IS_LEAF(node)) {
+		if (index < node->left->size) {
+			node = node->left;
+		}
+		else {
+			index -= node->left->size;
+			node = node->right;
+		}
+	}
+	return node->chars[index];
+}
+
+charT* Runtime_rope_copy_chars(Runtime_rope_node* node, charT* dest)
+{
+	if (nullptr == node) {
+		return dest;
+	}
+	if (RUNTIME_ROPE_IS_LEAF(node)) {
+		Runtime_mem_cpy(node->chars, dest, node->size);
+		return dest + node->size;
+	}
+	return Runtime_rope_copy_chars(node->right, Runtime_rope_copy_chars(node->left, dest));
+}
+
+Runtime_string_handle Runtime_rope_to_string(Runtime_rope_handle self)
+{
+	uint64T size = Runtime_rope_size(self);
+	auto result = Runtime_string_alloc(size);
+	Runtime_rope_copy_chars(((Runtime_rope*)self)->root, result->data);
+	result->size = size;
+	result->data[size] = 0;
+
+	return (Runtime_string_handle)result;
+}
+
+//end of rope
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//string matcher
+
+//Aho-Corasick, the trie of the patterns turned into a full DFA so 
+//each char of the text is a single table lookup, whatever the 
+//number of patterns
+
+#define RUNTIME_STRING_MATCHER_NO_PATTERN	0xFFFFFFFF
+
+struct Runtime_string_matcher {
+	uint32T stateCount;
+	uint32T patternCount;
+	//256 per state
+	uint32T* next;
+	//the longest pattern ending in a state, or NO_PATTERN
+	uint32T* patternOf;
+	//nearest state along the fail links that ends a pattern, 0 for none
+	uint32T* outLink;
+	//number of patterns ending in a state, including through outLink
+	uint64T* outCount;
+	uint64T* patternSizes;
+};
+
+Runtime_string_matcher_handle Runtime_string_matcher_new(const Runtime_string_handle* patterns, uint64T count)
+{
+	uint64T maxStates = 1;
+	for (uint64T i = 0; i < count; i++) {
+		maxStates += RUNTIME_STRING(patterns[i])->size;
+	}
+
+	auto result = (Runtime_string_matcher*)Runtime_alloc(sizeof(Runtime_string_matcher), typeUnknown);
+	result->patternCount = (uint32T)count;
+	result->next = (uint32T*)Runtime_alloc(sizeof(uint32T) * 256 * maxStates, typeUnknown);
+	result->patternOf = (uint32T*)Runtime_alloc(sizeof(uint32T) * maxStates, typeUnknown);
+	result->outLink = (uint32T*)Runtime_alloc(sizeof(uint32T) * maxStates, typeUnknown);
+	result->outCount = (uint64T*)Runtime_alloc(sizeof(uint64T) * maxStates, typeUnknown);
+	result->patternSizes = (uint64T*)Runtime_alloc(sizeof(uint64T) * (count + 1), typeUnknown);
+	Runtime_Memory_init(result->next, sizeof(uint32T) * 256 * maxStates);
+	Runtime_Memory_init(result->outLink, sizeof(uint32T) * maxStates);
+	Runtime_Memory_init(result->outCount, sizeof(uint64T) * maxStates);
+	for (uint64T i = 0; i < maxStates; i++) {
+		result->patternOf[i] = RUNTIME_STRING_MATCHER_NO_PATTERN;
+	}
+
+	//trie, 0 is the root, so a 0 transition means none yet
+	uint32T stateCount = 1;
+	for (uint64T i = 0; i < count; i++) {
+		auto pattern = RUNTIME_STRING(patterns[i]);
+		result->patternSizes[i] = pattern->size;
+		if (0 == pattern->size) {
+			continue;
+		}
+
+		uint32T state = 0;
+		for (uint64T k = 0; k < pattern->size; k++) {
+			uint32T* transition = &result->next[state * 256 + (uint8T)pattern->data[k]];
+			if (0 == *transition) {
+				*transition = stateCount++;
+			}
+			state = *transition;
+		}
+		//duplicates report the first
+		if (RUNTIME_STRING_MATCHER_NO_PATTERN == result->patternOf[state]) {
+			result->patternOf[state] = (uint32T)i;
+			result->outCount[state] = 1;
+		}
+	}
+	result->stateCount = stateCount;
+
+	//breadth first, a state's fail link is always done before the state.
+	//Missing transitions take the fail state's, which makes the DFA
+	auto fail = (uint32T*)Runtime_alloc(sizeof(uint32T) * stateCount, typeUnknown);
+	auto queue = (uint32T*)Runtime_alloc(sizeof(uint32T) * stateCount, typeUnknown);
+	uint32T queueHead = 0;
+	uint32T queueTail = 0;
+
+	for (uint32T ch = 0; ch < 256; ch++) {
+		uint32T child = result->next[ch];
+		if (0 != child) {
+			fail[child] = 0;
+			queue[queueTail++] = child;
+		}
+	}
+
+	while (queueHead < queueTail) {
+		uint32T state = queue[queueHead++];
+		uint32T failState = fail[state];
+
+		result->outLink[state] = RUNTIME_STRING_MATCHER_NO_PATTERN != result->patternOf[failState] ? failState : result->outLink[failState];
+		result->outCount[state] += result->outCount[failState];
+
+		for (uint32T ch = 0; ch < 256; ch++) {
+			uint32T* transition = &result->next[state * 256 + ch];
+			uint32T failNext = result->next[failState * 256 + ch];
+			if (0 != *transition) {
+				fail[*transition] = failNext;
+				queue[queueTail++] = *transition;
+			}
+			else {
+				*transition = failNext;
+			}
+		}
+	}
+
+	Runtime_free(queue);
+	Runtime_free(fail);
+
+	return (Runtime_string_matcher_handle)result;
+}
+
+void Runtime_string_matcher_delete(Runtime_string_matcher_handle self)
+{
+	auto matcher = (Runtime_string_matcher*)self;
+	Runtime_free(matcher->next);
+	Runtime_free(matcher->patternOf);
+	Runtime_free(matcher->outLink);
+	Runtime_free(matcher->outCount);
+	Runtime_free(matcher->patternSizes);
+	Runtime_free(matcher);
+}
+
+uint64T Runtime_string_matcher_find(Runtime_string_matcher_handle self, Runtime_string_handle text, uint64T start, uint64T* patternIdxPtr)
+{
+	auto matcher = (Runtime_string_matcher*)self;
+	auto str = RUNTIME_STRING(text);
+
+	uint32T state = 0;
+	for (uint64T i = start; i < str->size; i++) {
+		state = matcher->next[state * 256 + (uint8T)str->data[i]];
+		if (0 == matcher->outCount[state]) {
+			continue;
+		}
+
+		uint32T matched = RUNTIME_STRING_MATCHER_NO_PATTERN != matcher->patternOf[state] ? state : matcher->outLink[state];
+		uint32T patternIdx = matcher->patternOf[matched];
+		if (nullptr != patternIdxPtr) {
+			*patternIdxPtr = patternIdx;
+		}
+		return i + 1 - matcher->patternSizes[patternIdx];
+	}
+
+	return Runtime_NoIndx;
+}
+
+uint64T Runtime_string_matcher_count(Runtime_string_matcher_handle self, Runtime_string_handle text)
+{
+	auto matcher = (Runtime_string_matcher*)self;
+	auto str = RUNTIME_STRING(text);
+
+	uint64T result = 0;
+	uint32T state = 0;
+	for (uint64T i = 0; i < str->size; i++) {
+		state = matcher->next[state * 256 + (uint8T)str->data[i]];
+		result += matcher->outCount[state];
+	}
+
+	return result;
+}
+
+//end of string matcher
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//utf-8
+
+#define RUNTIME_UTF8_INVALID	0xFFFFFFFF
+
+//code point at bytes[*idxPtr], the index moves past it. 
+//RUNTIME_UTF8_INVALID for truncated or overlong sequences, 
+//surrogates and anything past 0x10FFFF
+inline uint32T Runtime_utf8_decode(const uint8T* bytes, uint64T size, uint64T* idxPtr)
+{
+	uint64T i = *idxPtr;
+	uint32T lead = bytes[i];
+	if (lead < 0x80) {
+		*idxPtr = i + 1;
+		return lead;
+	}
+
+	uint32T result = 0;
+	uint64T length = 0;
+	uint32T minimum = 0;
+	if (0xC0 == (lead & 0xE0)) {
+		result = lead & 0x1F;
+		length = 2;
+		minimum = 0x80;
+	}
+	else if (0xE0 == (lead & 0xF0)) {
+		result = lead & 0x0F;
+		length = 3;
+		minimum = 0x800;
+	}
+	else if (0xF0 == (lead & 0xF8)) {
+		result = lead & 0x07;
+		length = 4;
+		minimum = 0x10000;
+	}
+	else {
+		return RUNTIME_UTF8_INVALID;
+	}
+
+	if (length > size - i) {
+		return RUNTIME_UTF8_INVALID;
+	}
+	for (uint64T k = 1; k < length; k++) {
+		uint32T cont = bytes[i + k];
+		if (0x80 != (cont & 0xC0)) {
+			return RUNTIME_UTF8_INVALID;
+		}
+		result = (result << 6) | (cont & 0x3F);
+	}
+	if (result < minimum || result > 0x10FFFF || (result >= 0xD800 && result <= 0xDFFF)) {
+		return RUNTIME_UTF8_INVALID;
+	}
+
+	*idxPtr = i + length;
+	return result;
+}
+
+//bytes written to dest, 1 to 4
+inline uint64T Runtime_utf8_encode(uint32T codePoint, charT* dest)
+{
+	if (codePoint < 0x80) {
+		dest[0] = (charT)codePoint;
+		return 1;
+	}
+	if (codePoint < 0x800) {
+		dest[0] = (charT)(0xC0 | (codePoint >> 6));
+		dest[1] = (charT)(0x80 | (codePoint & 0x3F));
+		return 2;
+	}
+	if (codePoint < 0x10000) {
+		dest[0] = (charT)(0xE0 | (codePoint >> 12));
+		dest[1] = (charT)(0x80 | ((codePoint >> 6) & 0x3F));
+		dest[2] = (charT)(0x80 | (codePoint & 0x3F));
+		return 3;
+	}
+	dest[0] = (charT)(0xF0 | (codePoint >> 18));
+	dest[1] = (charT)(0x80 | ((codePoint >> 12) & 0x3F));
+	dest[2] = (charT)(0x80 | ((codePoint >> 6) & 0x3F));
+	dest[3] = (charT)(0x80 | (codePoint & 0x3F));
+	return 4;
+}
+
+bool Runtime_utf8_validate_scalar(const uint8T* bytes, uint64T size)
+{
+	uint64T i = 0;
+	while (i < size) {
+		if (RUNTIME_UTF8_INVALID == Runtime_utf8_decode(bytes, size, &i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//the lookup algorithm of Keiser and Lemire, "Validating UTF-8 In 
+//Less Than One Instruction Per Byte". Each pair of bytes is 
+//classified by 3 nibble lookups (the high and low nibble of the 
+//first byte and the high nibble of the second), the AND of the 3
+//is non zero for an invalid pair. 3 and 4 byte sequences add a 
+//check that the 2nd/3rd continuation bytes are where they belong
+enum Runtime_utf8_error_bits {
+	rtUtf8TooShort = 0x01,
+	rtUtf8TooLong = 0x02,
+	rtUtf8Overlong3 = 0x04,
+	rtUtf8TooLarge = 0x08,
+	rtUtf8Surrogate = 0x10,
+	rtUtf8Overlong2 = 0x20,
+	rtUtf8TooLarge1000 = 0x40,
+	rtUtf8Overlong4 = 0x40,
+	rtUtf8TwoConts = 0x80,
+	rtUtf8Carry = rtUtf8TooShort | rtUtf8TooLong | rtUtf8TwoConts,
+};
+
+struct Runtime_utf8_checker {
+	__m128i error;
+	__m128i prevInput;
+	__m128i prevIncomplete;
+};
+
+#define RUNTIME_UTF8_BYTE(v)	((char)(uint8T)(v))
+
+inline void Runtime_utf8_check_block(Runtime_utf8_checker* checker, __m128i input)
+{
+	if (0 == _mm_movemask_epi8(input)) {
+		//all ascii, only an unfinished sequence from before can be wrong
+		checker->error = _mm_or_si128(checker->error, checker->prevIncomplete);
+		checker->prevIncomplete = _mm_setzero_si128();
+		checker->prevInput = input;
+		return;
+	}
+
+	const __m128i byte1High = _mm_setr_epi8(
+		rtUtf8TooLong, rtUtf8TooLong, rtUtf8TooLong, rtUtf8TooLong,
+		rtUtf8TooLong, rtUtf8TooLong, rtUtf8TooLong, rtUtf8TooLong,
+		RUNTIME_UTF8_BYTE(rtUtf8TwoConts), RUNTIME_UTF8_BYTE(rtUtf8TwoConts), RUNTIME_UTF8_BYTE(rtUtf8TwoConts), RUNTIME_UTF8_BYTE(rtUtf8TwoConts),
+		rtUtf8TooShort | rtUtf8Overlong2,
+		rtUtf8TooShort,
+		rtUtf8TooShort | rtUtf8Overlong3 | rtUtf8Surrogate,
+		rtUtf8TooShort | rtUtf8TooLarge | rtUtf8TooLarge1000 | rtUtf8Overlong4);
+
+	const __m128i byte1Low = _mm_setr_epi8(
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8Overlong3 | rtUtf8Overlong2 | rtUtf8Overlong4),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8Overlong2),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000 | rtUtf8Surrogate),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000),
+		RUNTIME_UTF8_BYTE(rtUtf8Carry | rtUtf8TooLarge | rtUtf8TooLarge1000));
+
+	const __m128i byte2High = _mm_setr_epi8(
+		rtUtf8TooShort, rtUtf8TooShort, rtUtf8TooShort, rtUtf8TooShort,
+		rtUtf8TooShort, rtUtf8TooShort, rtUtf8TooShort, rtUtf8TooShort,
+		RUNTIME_UTF8_BYTE(rtUtf8TooLong | rtUtf8Overlong2 | rtUtf8TwoConts | rtUtf8Overlong3 | rtUtf8TooLarge1000 | rtUtf8Overlong4),
+		RUNTIME_UTF8_BYTE(rtUtf8TooLong | rtUtf8Overlong2 | rtUtf8TwoConts | rtUtf8Overlong3 | rtUtf8TooLarge),
+		RUNTIME_UTF8_BYTE(rtUtf8TooLong | rtUtf8Overlong2 | rtUtf8TwoConts | rtUtf8Surrogate | rtUtf8TooLarge),
+		RUNTIME_UTF8_BYTE(rtUtf8TooLong | rtUtf8Overlong2 | rtUtf8TwoConts | rtUtf8Surrogate | rtUtf8TooLarge),
+		rtUtf8TooShort, rtUtf8TooShort, rtUtf8TooShort, rtUtf8TooShort);
+
+	const __m128i nibbleMask = _mm_set1_epi8(0x0F);
+
+	__m128i prev1 = _mm_alignr_epi8(input, checker->prevInput, 15);
+	__m128i special = _mm_and_si128(
+		_mm_and_si128(
+			_mm_shuffle_epi8(byte1High, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibbleMask)),
+			_mm_shuffle_epi8(byte1Low, _mm_and_si128(prev1, nibbleMask))),
+		_mm_shuffle_epi8(byte2High, _mm_and_si128(_mm_srli_epi16(input, 4), nibbleMask)));
+
+	//bytes 2 or 3 after a 3/4 byte lead must be continuations, 
+	//two continuations in a row are only an error elsewhere
+	__m128i prev2 = _mm_alignr_epi8(input, checker->prevInput, 14);
+	__m128i prev3 = _mm_alignr_epi8(input, checker->prevInput, 13);
+	__m128i must23 = _mm_or_si128(
+		_mm_subs_epu8(prev2, _mm_set1_epi8(RUNTIME_UTF8_BYTE(0xE0 - 0x80))),
+		_mm_subs_epu8(prev3, _mm_set1_epi8(RUNTIME_UTF8_BYTE(0xF0 - 0x80))));
+	__m128i must23High = _mm_and_si128(must23, _mm_set1_epi8(RUNTIME_UTF8_BYTE(0x80)));
+
+	checker->error = _mm_or_si128(checker->error, _mm_xor_si128(must23High, special));
+
+	//a lead byte too close to the end of the block, its sequence 
+	//has to finish in the next one
+	const __m128i maxValue = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 
+		RUNTIME_UTF8_BYTE(0xF0 - 1), RUNTIME_UTF8_BYTE(0xE0 - 1), RUNTIME_UTF8_BYTE(0xC0 - 1));
+	checker->prevIncomplete = _mm_subs_epu8(input, maxValue);
+	checker->prevInput = input;
+}
+
+bool Runtime_utf8_validate_ssse3(const uint8T* bytes, uint64T size)
+{
+	Runtime_utf8_checker checker;
+	checker.error = _mm_setzero_si128();
+	checker.prevInput = _mm_setzero_si128();
+	checker.prevIncomplete = _mm_setzero_si128();
+
+	uint64T i = 0;
+	for (; i + 16 <= size; i += 16) {
+		Runtime_utf8_check_block(&checker, _mm_loadu_si128((const __m128i*)(bytes + i)));
+	}
+	if (i < size) {
+		uint8T tail[16];
+		Runtime_Memory_init(tail, sizeof(tail));
+		Runtime_mem_cpy((void*)(bytes + i), tail, size - i);
+		Runtime_utf8_check_block(&checker, _mm_loadu_si128((const __m128i*)tail));
+	}
+
+	__m128i error = _mm_or_si128(checker.error, checker.prevIncomplete);
+	return 0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128()));
+}
+
+bool Runtime_utf8_validate(const charT* bytes, uint64T size)
+{
+	if (Runtime_cpu_has(rtCpuSSSE3)) {
+		return Runtime_utf8_validate_ssse3((const uint8T*)bytes, size);
+	}
+	return Runtime_utf8_validate_scalar((const uint8T*)bytes, size);
+}
+
+uint64T Runtime_utf8_length(const charT* bytes, uint64T size)
+{
+	//every byte that isn't a continuation (0x80-0xBF, signed 
+	//-128 to -65) starts a code point
+	uint64T result = 0;
+	uint64T i = 0;
+	const __m128i lastCont = _mm_set1_epi8(-65);
+	for (; i + 16 <= size; i += 16) {
+		__m128i input = _mm_loadu_si128((const __m128i*)(bytes + i));
+		result += Runtime_popcount64((uint64T)_mm_movemask_epi8(_mm_cmpgt_epi8(input, lastCont)));
+	}
+	for (; i < size; i++) {
+		result += bytes[i] > -65 ? 1 : 0;
+	}
+
+	return result;
+}
+
+uint64T Runtime_utf8_to_utf16(const charT* src, uint64T size, uint16T* dest)
+{
+	auto bytes = (const uint8T*)src;
+	uint64T i = 0;
+	uint64T result = 0;
+
+	while (i < size) {
+		if (i + 16 <= size) {
+			__m128i input = _mm_loadu_si128((const __m128i*)(bytes + i));
+			if (0 == _mm_movemask_epi8(input)) {
+				_mm_storeu_si128((__m128i*)(dest + result), _mm_unpacklo_epi8(input, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*)(dest + result + 8), _mm_unpackhi_epi8(input, _mm_setzero_si128()));
+				i += 16;
+				result += 16;
+				continue;
+			}
+		}
+
+		uint32T codePoint = Runtime_utf8_decode(bytes, size, &i);
+		if (RUNTIME_UTF8_INVALID == codePoint) {
+			return Runtime_NoIndx;
+		}
+		if (codePoint >= 0x10000) {
+			codePoint -= 0x10000;
+			dest[result++] = (uint16T)(0xD800 + (codePoint >> 10));
+			dest[result++] = (uint16T)(0xDC00 + (codePoint & 0x3FF));
+		}
+		else {
+			dest[result++] = (uint16T)codePoint;
+		}
+	}
+
+	return result;
+}
+
+uint64T Runtime_utf8_to_utf32(const charT* src, uint64T size, uint32T* dest)
+{
+	auto bytes = (const uint8T*)src;
+	uint64T i = 0;
+	uint64T result = 0;
+
+	while (i < size) {
+		if (i + 16 <= size) {
+			__m128i input = _mm_loadu_si128((const __m128i*)(bytes + i));
+			if (0 == _mm_movemask_epi8(input)) {
+				__m128i lo = _mm_unpacklo_epi8(input, _mm_setzero_si128());
+				__m128i hi = _mm_unpackhi_epi8(input, _mm_setzero_si128());
+				_mm_storeu_si128((__m128i*)(dest + result), _mm_unpacklo_epi16(lo, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*)(dest + result + 4), _mm_unpackhi_epi16(lo, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*)(dest + result + 8), _mm_unpacklo_epi16(hi, _mm_setzero_si128()));
+				_mm_storeu_si128((__m128i*)(dest + result + 12), _mm_unpackhi_epi16(hi, _mm_setzero_si128()));
+				i += 16;
+				result += 16;
+				continue;
+			}
+		}
+
+		uint32T codePoint = Runtime_utf8_decode(bytes, size, &i);
+		if (RUNTIME_UTF8_INVALID == codePoint) {
+			return Runtime_NoIndx;
+		}
+		dest[result++] = codePoint;
+	}
+
+	return result;
+}
+
+uint64T Runtime_utf16_to_utf8(const uint16T* src, uint64T count, charT* dest)
+{
+	uint64T i = 0;
+	uint64T result = 0;
+
+	while (i < count) {
+		if (i + 8 <= count) {
+			__m128i input = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i high = _mm_and_si128(input, _mm_set1_epi16((short)0xFF80));
+			if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128()))) {
+				_mm_storel_epi64((__m128i*)(dest + result), _mm_packus_epi16(input, input));
+				i += 8;
+				result += 8;
+				continue;
+			}
+		}
+
+		uint32T codePoint = src[i++];
+		if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+			if (i == count || src[i] < 0xDC00 || src[i] > 0xDFFF) {
+				return Runtime_NoIndx;
+			}
+			codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (src[i++] - 0xDC00);
+		}
+		else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+			return Runtime_NoIndx;
+		}
+		result += Runtime_utf8_encode(codePoint, dest + result);
+	}
+
+	return result;
+}
+
+uint64T Runtime_utf32_to_utf8(const uint32T* src, uint64T count, charT* dest)
+{
+	uint64T i = 0;
+	uint64T result = 0;
+
+	while (i < count) {
+		if (i + 4 <= count) {
+			__m128i input = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i high = _mm_and_si128(input, _mm_set1_epi32(~0x7F));
+			if (0xFFFF == _mm_movemask_epi8(_mm_cmpeq_epi32(high, _mm_setzero_si128()))) {
+				__m128i packed = _mm_packus_epi16(_mm_packs_epi32(input, input), _mm_setzero_si128());
+				int32T chars = _mm_cvtsi128_si32(packed);
+				Runtime_mem_cpy(&chars, dest + result, 4);
+				i += 4;
+				result += 4;
+				continue;
+			}
+		}
+
+		uint32T codePoint = src[i++];
+		if (codePoint > 0x10FFFF || (codePoint >= 0xD800 && codePoint <= 0xDFFF)) {
+			return Runtime_NoIndx;
+		}
+		result += Runtime_utf8_encode(codePoint, dest + result);
+	}
+
+	return result;
+}
+
+bool Runtime_string_is_utf8(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	if (0 == (str->flags & rtStringUtf8Checked)) {
+		str->flags |= rtStringUtf8Checked;
+		if (Runtime_utf8_validate(str->data, str->size)) {
+			str->flags |= rtStringUtf8Valid;
+		}
+	}
+	return 0 != (str->flags & rtStringUtf8Valid);
+}
+
+uint64T Runtime_string_utf8_length(Runtime_string_handle self)
+{
+	return Runtime_utf8_length(RUNTIME_STRING(self)->data, RUNTIME_STRING(self)->size);
+}
+
+Runtime_string_handle Runtime_string_new_from_utf16(const uint16T* src, uint64T count)
+{
+	auto result = Runtime_string_alloc(count * 3);
+	uint64T size = Runtime_utf16_to_utf8(src, count, result->data);
+	if (Runtime_NoIndx == size) {
+		Runtime_string_delete(result);
+		return nullptr;
+	}
+
+	result->size = size;
+	result->data[size] = 0;
+	result->flags |= rtStringUtf8Checked | rtStringUtf8Valid;
+
+	return (Runtime_string_handle)result;
+}
+
+//end of utf-8
+//----------------------------------------------------------------------------
+
+
+//----------------------------------------------------------------------------
+//number conversion
+
+static const charT runtimeDigitPairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const uint64T runtimePowersOf10[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+	10000000000ULL, 100000000000ULL, 1000000000000ULL, 10000000000000ULL, 100000000000000ULL,
+	1000000000000000ULL, 10000000000000000ULL, 100000000000000000ULL, 1000000000000000000ULL,
+	10000000000000000000ULL
+};
+
+//the ones a double holds exactly
+static const double64T runtimeDoublePowersOf10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+inline uint32T Runtime_decimal_digit_count(uint64T value)
+{
+	//log10 estimated from the bit length, off by at most one
+	unsigned long bit = 0;
+	_BitScanReverse64(&bit, value | 1);
+	uint32T estimate = ((bit + 1) * 1233) >> 12;
+	return estimate + 1 - ((value | 1) < runtimePowersOf10[estimate] ? 1 : 0);
+}
+
+//writes the digits ending at end, two at a time
+inline void Runtime_write_digits(uint64T value, charT* end)
+{
+	while (value >= 100) {
+		uint64T quotient = value / 100;
+		uint32T pair = (uint32T)(value - quotient * 100) * 2;
+		value = quotient;
+		end -= 2;
+		end[0] = runtimeDigitPairs[pair];
+		end[1] = runtimeDigitPairs[pair + 1];
+	}
+	if (value >= 10) {
+		end -= 2;
+		end[0] = runtimeDigitPairs[value * 2];
+		end[1] = runtimeDigitPairs[value * 2 + 1];
+	}
+	else {
+		end[-1] = (charT)('0' + value);
+	}
+}
+
+uint64T Runtime_format_uint64(uint64T value, charT* dest)
+{
+	uint32T length = Runtime_decimal_digit_count(value);
+	Runtime_write_digits(value, dest + length);
+	dest[length] = 0;
+
+	return length;
+}
+
+uint64T Runtime_format_int64(int64T value, charT* dest)
+{
+	if (value < 0) {
+		dest[0] = '-';
+		return 1 + Runtime_format_uint64(0 - (uint64T)value, dest + 1);
+	}
+	return Runtime_format_uint64((uint64T)value, dest);
+}
+
+
+//Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and 
+//Accurately with Integers"), after Milo Yip's implementation.
+//The digits always read back as the same double, and are the 
+//shortest such in all but a few cases
+
+struct Runtime_diy_fp {
+	uint64T f;
+	int32T e;
+};
+
+#define RUNTIME_DOUBLE_HIDDEN_BIT	0x0010000000000000ULL
+#define RUNTIME_DOUBLE_FRACTION_MASK	0x000FFFFFFFFFFFFFULL
+#define RUNTIME_DOUBLE_EXPONENT_MASK	0x7FF0000000000000ULL
+
+//normalized 10^k for k = -348, -340, ..., 340
+static const Runtime_diy_fp runtimeCachedPowers[] = {
+	{ 0xfa8fd5a0081c0288ULL, -1220 }, { 0xbaaee17fa23ebf76ULL, -1193 }, { 0x8b16fb203055ac76ULL, -1166 },
+	{ 0xcf42894a5dce35eaULL, -1140 }, { 0x9a6bb0aa55653b2dULL, -1113 }, { 0xe61acf033d1a45dfULL, -1087 },
+	{ 0xab70fe17c79ac6caULL, -1060 }, { 0xff77b1fcbebcdc4fULL, -1034 }, { 0xbe5691ef416bd60cULL, -1007 },
+	{ 0x8dd01fad907ffc3cULL, -980 }, { 0xd3515c2831559a83ULL, -954 }, { 0x9d71ac8fada6c9b5ULL, -927 },
+	{ 0xea9c227723ee8bcbULL, -901 }, { 0xaecc49914078536dULL, -874 }, { 0x823c12795db6ce57ULL, -847 },
+	{ 0xc21094364dfb5637ULL, -821 }, { 0x9096ea6f3848984fULL, -794 }, { 0xd77485cb25823ac7ULL, -768 },
+	{ 0xa086cfcd97bf97f4ULL, -741 }, { 0xef340a98172aace5ULL, -715 }, { 0xb23867fb2a35b28eULL, -688 },
+	{ 0x84c8d4dfd2c63f3bULL, -661 }, { 0xc5dd44271ad3cdbaULL, -635 }, { 0x936b9fcebb25c996ULL, -608 },
+	{ 0xdbac6c247d62a584ULL, -582 }, { 0xa3ab66580d5fdaf6ULL, -555 }, { 0xf3e2f893dec3f126ULL, -529 },
+	{ 0xb5b5ada8aaff80b8ULL, -502 }, { 0x87625f056c7c4a8bULL, -475 }, { 0xc9bcff6034c13053ULL, -449 },
+	{ 0x964e858c91ba2655ULL, -422 }, { 0xdff9772470297ebdULL, -396 }, { 0xa6dfbd9fb8e5b88fULL, -369 },
+	{ 0xf8a95fcf88747d94ULL, -343 }, { 0xb94470938fa89bcfULL, -316 }, { 0x8a08f0f8bf0f156bULL, -289 },
+	{ 0xcdb02555653131b6ULL, -263 }, { 0x993fe2c6d07b7facULL, -236 }, { 0xe45c10c42a2b3b06ULL, -210 },
+	{ 0xaa242499697392d3ULL, -183 }, { 0xfd87b5f28300ca0eULL, -157 }, { 0xbce5086492111aebULL, -130 },
+	{ 0x8cbccc096f5088ccULL, -103 }, { 0xd1b71758e219652cULL, -77 }, { 0x9c40000000000000ULL, -50 },
+	{ 0xe8d4a51000000000ULL, -24 }, { 0xad78ebc5ac620000ULL, 3 }, { 0x813f3978f8940984ULL, 30 },
+	{ 0xc097ce7bc90715b3ULL, 56 }, { 0x8f7e32ce7bea5c70ULL, 83 }, { 0xd5d238a4abe98068ULL, 109 },
+	{ 0x9f4f2726179a2245ULL, 136 }, { 0xed63a231d4c4fb27ULL, 162 }, { 0xb0de65388cc8ada8ULL, 189 },
+	{ 0x83c7088e1aab65dbULL, 216 }, { 0xc45d1df942711d9aULL, 242 }, { 0x924d692ca61be758ULL, 269 },
+	{ 0xda01ee641a708deaULL, 295 }, { 0xa26da3999aef774aULL, 322 }, { 0xf209787bb47d6b85ULL, 348 },
+	{ 0xb454e4a179dd1877ULL, 375 }, { 0x865b86925b9bc5c2ULL, 402 }, { 0xc83553c5c8965d3dULL, 428 },
+	{ 0x952ab45cfa97a0b3ULL, 455 }, { 0xde469fbd99a05fe3ULL, 481 }, { 0xa59bc234db398c25ULL, 508 },
+	{ 0xf6c69a72a3989f5cULL, 534 }, { 0xb7dcbf5354e9beceULL, 561 }, { 0x88fcf317f22241e2ULL, 588 },
+	{ 0xcc20ce9bd35c78a5ULL, 614 }, { 0x98165af37b2153dfULL, 641 }, { 0xe2a0b5dc971f303aULL, 667 },
+	{ 0xa8d9d1535ce3b396ULL, 694 }, { 0xfb9b7cd9a4a7443cULL, 720 }, { 0xbb764c4ca7a44410ULL, 747 },
+	{ 0x8bab8eefb6409c1aULL, 774 }, { 0xd01fef10a657842cULL, 800 }, { 0x9b10a4e5e9913129ULL, 827 },
+	{ 0xe7109bfba19c0c9dULL, 853 }, { 0xac2820d9623bf429ULL, 880 }, { 0x80444b5e7aa7cf85ULL, 907 },
+	{ 0xbf21e44003acdd2dULL, 933 }, { 0x8e679c2f5e44ff8fULL, 960 }, { 0xd433179d9c8cb841ULL, 986 },
+	{ 0x9e19db92b4e31ba9ULL, 1013 }, { 0xeb96bf6ebadf77d9ULL, 1039 }, { 0xaf87023b9bf0ee6bULL, 1066 },
+};
+
+inline uint64T Runtime_double_bits(double64T value)
+{
+	uint64T result = 0;
+	Runtime_mem_cpy(&value, &result, sizeof(result));
+	return result;
+}
+
+inline double64T Runtime_double_from_bits(uint64T bits)
+{
+	double64T result = 0;
+	Runtime_mem_cpy(&bits, &result, sizeof(result));
+	return result;
+}
+
+//value = f * 2^e, f without the hidden bit for subnormals
+inline Runtime_diy_fp Runtime_diy_fp_from_bits(uint64T bits)
+{
+	Runtime_diy_fp result;
+	int32T biasedExponent = (int32T)((bits >> 52) & 0x7FF);
+	result.f = bits & RUNTIME_DOUBLE_FRACTION_MASK;
+	if (0 != biasedExponent) {
+		result.f += RUNTIME_DOUBLE_HIDDEN_BIT;
+		result.e = biasedExponent - 1075;
+	}
+	else {
+		result.e = -1074;
+	}
+	return result;
+}
+
+inline Runtime_diy_fp Runtime_diy_fp_multiply(Runtime_diy_fp lhs, Runtime_diy_fp rhs)
+{
+	const uint64T mask32 = 0xFFFFFFFFULL;
+	uint64T a = lhs.f >> 32;
+	uint64T b = lhs.f & mask32;
+	uint64T c = rhs.f >> 32;
+	uint64T d = rhs.f & mask32;
+	uint64T ac = a * c;
+	uint64T bc = b * c;
+	uint64T ad = a * d;
+	uint64T bd = b * d;
+	uint64T tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+	//round
+	tmp += 1ULL << 31;
+
+	Runtime_diy_fp result;
+	result.f = ac + (ad >> 32) + (bc >> 32) + (tmp >> 32);
+	result.e = lhs.e + rhs.e + 64;
+	return result;
+}
+
+inline Runtime_diy_fp Runtime_diy_fp_normalize(Runtime_diy_fp value)
+{
+	unsigned long bit = 0;
+	_BitScanReverse64(&bit, value.f);
+	uint32T shift = 63 - bit;
+	value.f <<= shift;
+	value.e -= shift;
+	return value;
+}
+
+//the boundaries halfway to the neighbouring doubles, normalized to the same exponent
+void Runtime_diy_fp_boundaries(Runtime_diy_fp value, Runtime_diy_fp* minusPtr, Runtime_diy_fp* plusPtr)
+{
+	Runtime_diy_fp plus;
+	plus.f = (value.f << 1) + 1;
+	plus.e = value.e - 1;
+	plus = Runtime_diy_fp_normalize(plus);
+
+	Runtime_diy_fp minus;
+	if (RUNTIME_DOUBLE_HIDDEN_BIT == value.f) {
+		//the double below is closer
+		minus.f = (value.f << 2) - 1;
+		minus.e = value.e - 2;
+	}
+	else {
+		minus.f = (value.f << 1) - 1;
+		minus.e = value.e - 1;
+	}
+	minus.f <<= minus.e - plus.e;
+	minus.e = plus.e;
+
+	*minusPtr = minus;
+	*plusPtr = plus;
+}
+
+//cached 10^-k so that the product's exponent lands in [-60, -32]
+inline Runtime_diy_fp Runtime_cached_power(int32T e, int32T* kPtr)
+{
+	double64T dk = (-61 - e) * 0.30102999566398114 + 347;
+	int32T k = (int32T)dk;
+	if (dk - k > 0.0) {
+		k++;
+	}
+
+	uint32T index = (uint32T)((k >> 3) + 1);
+	*kPtr = -(-348 + (int32T)index * 8);
+	return runtimeCachedPowers[index];
+}
+
+inline void Runtime_grisu_round(charT* buffer, int32T length, uint64T delta, uint64T rest, uint64T tenKappa, uint64T wpW)
+{
+	while (rest < wpW && delta - rest >= tenKappa && (rest + tenKappa < wpW || wpW - rest > rest + tenKappa - wpW)) {
+		buffer[length - 1]--;
+		rest += tenKappa;
+	}
+}
+
+void Runtime_grisu_digits(Runtime_diy_fp w, Runtime_diy_fp mp, uint64T delta, charT* buffer, int32T* lengthPtr, int32T* kPtr)
+{
+	Runtime_diy_fp one;
+	one.f = 1ULL << -mp.e;
+	one.e = mp.e;
+
+	uint64T wpW = mp.f - w.f;
+	uint32T p1 = (uint32T)(mp.f >> -one.e);
+	uint64T p2 = mp.f & (one.f - 1);
+	int32T kappa = (int32T)Runtime_decimal_digit_count(p1);
+	int32T length = 0;
+
+	while (kappa > 0) {
+		uint32T divisor = (uint32T)runtimePowersOf10[kappa - 1];
+		uint32T digit = p1 / divisor;
+		p1 %= divisor;
+		if (0 != digit || 0 != length) {
+			buffer[length++] = (charT)('0' + digit);
+		}
+		kappa--;
+
+		uint64T rest = ((uint64T)p1 << -one.e) + p2;
+		if (rest <= delta) {
+			*kPtr += kappa;
+			*lengthPtr = length;
+			Runtime_grisu_round(buffer, length, delta, rest, runtimePowersOf10[kappa] << -one.e, wpW);
+			return;
+		}
+	}
+
+	for (;;) {
+		p2 *= 10;
+		delta *= 10;
+		uint32T digit = (uint32T)(p2 >> -one.e);
+		if (0 != digit || 0 != length) {
+			buffer[length++] = (charT)('0' + digit);
+		}
+		p2 &= one.f - 1;
+		kappa--;
+
+		if (p2 < delta) {
+			*kPtr += kappa;
+			*lengthPtr = length;
+			int32T index = -kappa;
+			Runtime_grisu_round(buffer, length, delta, p2, one.f, wpW * (index < 20 ? runtimePowersOf10[index] : 0));
+			return;
+		}
+	}
+}
+
+//digits of a positive double in buffer, value = digits * 10^k
+void Runtime_grisu2(double64T value, charT* buffer, int32T* lengthPtr, int32T* kPtr)
+{
+	auto v = Runtime_diy_fp_from_bits(Runtime_double_bits(value));
+	Runtime_diy_fp minus;
+	Runtime_diy_fp plus;
+	Runtime_diy_fp_boundaries(v, &minus, &plus);
+
+	auto cached = Runtime_cached_power(plus.e, kPtr);
+	auto w = Runtime_diy_fp_multiply(Runtime_diy_fp_normalize(v), cached);
+	auto wp = Runtime_diy_fp_multiply(plus, cached);
+	auto wm = Runtime_diy_fp_multiply(minus, cached);
+	wm.f++;
+	wp.f--;
+
+	Runtime_grisu_digits(w, wp, wp.f - wm.f, buffer, lengthPtr, kPtr);
+}
+
+inline charT* Runtime_write_exponent(int32T exponent, charT* dest)
+{
+	if (exponent < 0) {
+		*dest++ = '-';
+		exponent = -exponent;
+	}
+	if (exponent >= 100) {
+		*dest++ = (charT)('0' + exponent / 100);
+		exponent %= 100;
+		*dest++ = runtimeDigitPairs[exponent * 2];
+		*dest++ = runtimeDigitPairs[exponent * 2 + 1];
+	}
+	else if (exponent >= 10) {
+		*dest++ = runtimeDigitPairs[exponent * 2];
+		*dest++ = runtimeDigitPairs[exponent * 2 + 1];
+	}
+	else {
+		*dest++ = (charT)('0' + exponent);
+	}
+	return dest;
+}
+
+//moves count chars from src to dest, dest after src
+inline void Runtime_chars_move_up(charT* src, charT* dest, int32T count)
+{
+	for (int32T i = count - 1; i >= 0; i--) {
+		dest[i] = src[i];
+	}
+}
+
+//the digits * 10^k as plain decimal (123.45, 0.00123, 12300000.0) 
+//for exponents from -6 to 21, scientific (1.2345e-7) otherwise
+charT* Runtime_format_decimal(charT* buffer, int32T length, int32T k)
+{
+	//10^(kk-1) <= value < 10^kk
+	int32T kk = length + k;
+
+	if (0 <= k && kk <= 21) {
+		for (int32T i = length; i < kk; i++) {
+			buffer[i] = '0';
+		}
+		buffer[kk] = '.';
+		buffer[kk + 1] = '0';
+		return buffer + kk + 2;
+	}
+	if (0 < kk && kk <= 21) {
+		Runtime_chars_move_up(buffer + kk, buffer + kk + 1, length - kk);
+		buffer[kk] = '.';
+		return buffer + length + 1;
+	}
+	if (-6 < kk && kk <= 0) {
+		int32T offset = 2 - kk;
+		Runtime_chars_move_up(buffer, buffer + offset, length);
+		buffer[0] = '0';
+		buffer[1] = '.';
+		for (int32T i = 2; i < offset; i++) {
+			buffer[i] = '0';
+		}
+		return buffer + length + offset;
+	}
+	if (1 == length) {
+		buffer[1] = 'e';
+		return Runtime_write_exponent(kk - 1, buffer + 2);
+	}
+	Runtime_chars_move_up(buffer + 1, buffer + 2, length - 1);
+	buffer[1] = '.';
+	buffer[length + 1] = 'e';
+	return Runtime_write_exponent(kk - 1, buffer + length + 2);
+}
+
+uint64T Runtime_format_double(double64T value, charT* dest)
+{
+	charT* ptr = dest;
+	uint64T bits = Runtime_double_bits(value);
+
+	if (0 != (bits >> 63)) {
+		*ptr++ = '-';
+		bits &= ~(1ULL << 63);
+	}
+
+	if (0x7FF0000000000000ULL == (bits & 0x7FF0000000000000ULL)) {
+		if (0 != (bits & RUNTIME_DOUBLE_FRACTION_MASK)) {
+			ptr = dest;
+			*ptr++ = 'n';
+			*ptr++ = 'a';
+			*ptr++ = 'n';
+		}
+		else {
+			*ptr++ = 'i';
+			*ptr++ = 'n';
+			*ptr++ = 'f';
+		}
+	}
+	else if (0 == bits) {
+		*ptr++ = '0';
+		*ptr++ = '.';
+		*ptr++ = '0';
+	}
+	else {
+		int32T length = 0;
+		int32T k = 0;
+		Runtime_grisu2(Runtime_double_from_bits(bits), ptr, &length, &k);
+		ptr = Runtime_format_decimal(ptr, length, k);
+	}
+
+	*ptr = 0;
+	return ptr - dest;
+}
+
+
+inline bool Runtime_is_digit(uint8T ch)
+{
+	return (uint8T)(ch - '0') < 10;
+}
+
+inline uint64T Runtime_load_8_chars(const uint8T* src)
+{
+	uint64T result = 0;
+	Runtime_mem_cpy((void*)src, &result, sizeof(result));
+	return result;
+}
+
+//8 ascii digits in a little endian word
+inline bool Runtime_swar_is_8_digits(uint64T chars)
+{
+	return 0x3333333333333333ULL == ((chars & 0xF0F0F0F0F0F0F0F0ULL) | (((chars + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4));
+}
+
+//combines neighbouring digits in 3 multiplies instead of 8
+inline uint32T Runtime_swar_parse_8_digits(uint64T chars)
+{
+	const uint64T mask = 0x000000FF000000FFULL;
+	//100 + (1000000 << 32) and 1 + (10000 << 32)
+	const uint64T mul1 = 0x000F424000000064ULL;
+	const uint64T mul2 = 0x0000271000000001ULL;
+
+	chars -= 0x3030303030303030ULL;
+	chars = (chars * 10) + (chars >> 8);
+	chars = (((chars & mask) * mul1) + (((chars >> 16) & mask) * mul2)) >> 32;
+	return (uint32T)chars;
+}
+
+uint64T Runtime_parse_int64(const charT* src, uint64T size, int64T* valuePtr)
+{
+	auto chars = (const uint8T*)src;
+	uint64T i = 0;
+	bool negative = false;
+	if (i < size && ('-' == chars[i] || '+' == chars[i])) {
+		negative = '-' == chars[i];
+		i++;
+	}
+
+	uint64T start = i;
+	uint64T value = 0;
+	//8 digits at a time while there's no risk of overflow
+	while (i + 8 <= size && i - start + 8 <= 18 && Runtime_swar_is_8_digits(Runtime_load_8_chars(chars + i))) {
+		value = value * 100000000 + Runtime_swar_parse_8_digits(Runtime_load_8_chars(chars + i));
+		i += 8;
+	}
+	for (; i < size && Runtime_is_digit(chars[i]); i++) {
+		uint64T digit = chars[i] - '0';
+		if (value > (0xFFFFFFFFFFFFFFFFULL - digit) / 10) {
+			return 0;
+		}
+		value = value * 10 + digit;
+	}
+
+	if (i == start || value > (negative ? 0x8000000000000000ULL : 0x7FFFFFFFFFFFFFFFULL)) {
+		return 0;
+	}
+
+	*valuePtr = negative ? (int64T)(0 - value) : (int64T)value;
+	return i;
+}
+
+
+//big integers for the cases a double can't decide alone
+#define RUNTIME_BIGNUM_LIMBS	160
+//digits beyond these can only break a tie, which a single 
+//non zero digit after them does as well
+#define RUNTIME_PARSE_MAX_DIGITS	768
+
+struct Runtime_bignum {
+	uint32T limbs[RUNTIME_BIGNUM_LIMBS];
+	uint32T count;
+};
+
+inline void Runtime_bignum_set(Runtime_bignum* num, uint64T value)
+{
+	num->count = 0;
+	while (0 != value) {
+		num->limbs[num->count++] = (uint32T)value;
+		value >>= 32;
+	}
+}
+
+void Runtime_bignum_mul_add(Runtime_bignum* num, uint32T multiplier, uint32T addend)
+{
+	uint64T carry = addend;
+	for (uint32T i = 0; i < num->count; i++) {
+		uint64T product = (uint64T)num->limbs[i] * multiplier + carry;
+		num->limbs[i] = (uint32T)product;
+		carry = product >> 32;
+	}
+	if (0 != carry) {
+		RUNTIME_ASSERT(num->count < RUNTIME_BIGNUM_LIMBS);
+		num->limbs[num->count++] = (uint32T)carry;
+	}
+}
+
+void Runtime_bignum_mul_pow5(Runtime_bignum* num, uint32T exponent)
+{
+	//5^13 is the largest that fits 32 bits
+	for (; exponent >= 13; exponent -= 13) {
+		Runtime_bignum_mul_add(num, 1220703125, 0);
+	}
+	uint32T rest = 1;
+	for (; exponent > 0; exponent--) {
+		rest *= 5;
+	}
+	Runtime_bignum_mul_add(num, rest, 0);
+}
+
+void Runtime_bignum_shift_left(Runtime_bignum* num, uint32T bits)
+{
+	if (0 == num->count) {
+		return;
+	}
+
+	uint32T limbShift = bits / 32;
+	uint32T bitShift = bits % 32;
+	RUNTIME_ASSERT(num->count + limbShift + 1 <= RUNTIME_BIGNUM_LIMBS);
+
+	num->limbs[num->count] = 0;
+	for (int32T i = (int32T)num->count; i >= 0; i--) {
+		uint32T limb = num->limbs[i] << bitShift;
+		if (0 != bitShift && i > 0) {
+			limb |= num->limbs[i - 1] >> (32 - bitShift);
+		}
+		num->limbs[i + limbShift] = limb;
+	}
+	for (uint32T i = 0; i < limbShift; i++) {
+		num->limbs[i] = 0;
+	}
+	num->count += limbShift + 1;
+	while (num->count > 0 && 0 == num->limbs[num->count - 1]) {
+		num->count--;
+	}
+}
+
+int32T Runtime_bignum_compare(const Runtime_bignum* lhs, const Runtime_bignum* rhs)
+{
+	if (lhs->count != rhs->count) {
+		return lhs->count < rhs->count ? -1 : 1;
+	}
+	for (int32T i = (int32T)lhs->count - 1; i >= 0; i--) {
+		if (lhs->limbs[i] != rhs->limbs[i]) {
+			return lhs->limbs[i] < rhs->limbs[i] ? -1 : 1;
+		}
+	}
+	return 0;
+}
+
+//digits * 10^exponent against the point halfway between the 
+//doubles lowBits and lowBits + 1
+int32T Runtime_compare_decimal_midpoint(const Runtime_bignum* digits, int32T exponent, uint64T lowBits)
+{
+	auto low = Runtime_diy_fp_from_bits(lowBits);
+	auto high = Runtime_diy_fp_from_bits(lowBits + 1);
+	int32T e = low.e < high.e ? low.e : high.e;
+	uint64T sum = (low.f << (low.e - e)) + (high.f << (high.e - e));
+
+	//digits * 5^exponent * 2^exponent against sum * 2^(e - 1)
+	Runtime_bignum lhs = *digits;
+	Runtime_bignum rhs;
+	Runtime_bignum_set(&rhs, sum);
+	if (exponent >= 0) {
+		Runtime_bignum_mul_pow5(&lhs, (uint32T)exponent);
+	}
+	else {
+		Runtime_bignum_mul_pow5(&rhs, (uint32T)-exponent);
+	}
+
+	int32T shift = (e - 1) - exponent;
+	if (shift > 0) {
+		Runtime_bignum_shift_left(&rhs, (uint32T)shift);
+	}
+	else {
+		Runtime_bignum_shift_left(&lhs, (uint32T)-shift);
+	}
+
+	return Runtime_bignum_compare(&lhs, &rhs);
+}
+
+//10^1 to 10^7, exact
+static const Runtime_diy_fp runtimeAdjustmentPowers[] = {
+	{ 0xa000000000000000ULL, -60 }, { 0xc800000000000000ULL, -57 }, { 0xfa00000000000000ULL, -54 },
+	{ 0x9c40000000000000ULL, -50 }, { 0xc350000000000000ULL, -47 }, { 0xf424000000000000ULL, -44 },
+	{ 0x9896800000000000ULL, -40 },
+};
+
+//the double nearest f * 2^e
+double64T Runtime_diy_fp_to_double(Runtime_diy_fp value)
+{
+	const int32T denormalExponent = -1074;
+	uint64T f = value.f;
+	int32T e = value.e;
+
+	while (f > RUNTIME_DOUBLE_HIDDEN_BIT + RUNTIME_DOUBLE_FRACTION_MASK) {
+		f >>= 1;
+		e++;
+	}
+	if (e >= 972) {
+		return Runtime_double_from_bits(0x7FF0000000000000ULL);
+	}
+	if (e < denormalExponent) {
+		return 0.0;
+	}
+	while (e > denormalExponent && 0 == (f & RUNTIME_DOUBLE_HIDDEN_BIT)) {
+		f <<= 1;
+		e--;
+	}
+
+	uint64T biasedExponent = (e == denormalExponent && 0 == (f & RUNTIME_DOUBLE_HIDDEN_BIT)) ? 0 : (uint64T)(e + 1075);
+	return Runtime_double_from_bits((f & RUNTIME_DOUBLE_FRACTION_MASK) | (biasedExponent << 52));
+}
+
+//mantissa * 10^exponent with 64 bit arithmetic and the cached 
+//powers, tracking the error in 1/8 ulps (as in double-conversion's
+//DiyFpStrtod). False if the error could flip the rounding, the 
+//result is then the right double or the one below it
+bool Runtime_decimal_to_double_fast(uint64T mantissa, int32T digitCount, int32T exponent, bool truncated, double64T* resultPtr)
+{
+	const uint64T denominatorLog = 3;
+	const uint64T denominator = 1 << denominatorLog;
+
+	Runtime_diy_fp input;
+	input.f = mantissa;
+	input.e = 0;
+	uint64T error = truncated ? denominator : 0;
+
+	int32T oldE = input.e;
+	input = Runtime_diy_fp_normalize(input);
+	error <<= oldE - input.e;
+
+	uint32T index = (uint32T)((exponent + 348) / 8);
+	int32T cachedExponent = -348 + (int32T)index * 8;
+	if (cachedExponent != exponent) {
+		int32T adjustment = exponent - cachedExponent;
+		input = Runtime_diy_fp_multiply(input, runtimeAdjustmentPowers[adjustment - 1]);
+		if (19 - digitCount < adjustment) {
+			//didn't fit in 64 bits
+			error += denominator / 2;
+		}
+	}
+
+	input = Runtime_diy_fp_multiply(input, runtimeCachedPowers[index]);
+	//the cached power's, the product's and a fixed half ulp
+	error += denominator / 2 + (0 == error ? 0 : 1) + denominator / 2;
+
+	oldE = input.e;
+	input = Runtime_diy_fp_normalize(input);
+	error <<= oldE - input.e;
+
+	//bits below the double's significand, fewer for denormals
+	int32T magnitude = 64 + input.e;
+	int32T significandSize = magnitude >= -1074 + 53 ? 53 : (magnitude <= -1074 ? 0 : magnitude + 1074);
+	int32T precisionBits = 64 - significandSize;
+	if (precisionBits + (int32T)denominatorLog >= 64) {
+		int32T shift = (precisionBits + (int32T)denominatorLog) - 64 + 1;
+		input.f >>= shift;
+		input.e += shift;
+		error = (error >> shift) + 1 + denominator;
+		precisionBits -= shift;
+	}
+
+	uint64T precisionMask = (1ULL << precisionBits) - 1;
+	uint64T lowBits = (input.f & precisionMask) * denominator;
+	uint64T halfWay = (1ULL << (precisionBits - 1)) * denominator;
+
+	Runtime_diy_fp rounded;
+	rounded.f = input.f >> precisionBits;
+	rounded.e = input.e + precisionBits;
+	if (lowBits >= halfWay + error) {
+		rounded.f++;
+	}
+
+	*resultPtr = Runtime_diy_fp_to_double(rounded);
+	return !(halfWay - error < lowBits && lowBits < halfWay + error);
+}
+
+//correctly rounded digits * 10^exponent, starting from an estimate
+//that's a few ulps off at most
+double64T Runtime_decimal_to_double_slow(const Runtime_bignum* digits, int32T exponent, double64T estimate)
+{
+	uint64T bits = Runtime_double_bits(estimate);
+	const uint64T infinityBits = 0x7FF0000000000000ULL;
+
+	for (;;) {
+		if (bits < infinityBits) {
+			int32T cmp = Runtime_compare_decimal_midpoint(digits, exponent, bits);
+			if (cmp > 0 || (0 == cmp && 0 != (bits & 1))) {
+				bits++;
+				continue;
+			}
+		}
+		if (bits > 0) {
+			int32T cmp = Runtime_compare_decimal_midpoint(digits, exponent, bits - 1);
+			if (cmp < 0 || (0 == cmp && 0 != (bits & 1))) {
+				bits--;
+				continue;
+			}
+		}
+		break;
+	}
+
+	return Runtime_double_from_bits(bits);
+}
+
+uint64T Runtime_parse_double(const charT* src, uint64T size, double64T* valuePtr)
+{
+	auto chars = (const uint8T*)src;
+	uint64T i = 0;
+	bool negative = false;
+	if (i < size && ('-' == chars[i] || '+' == chars[i])) {
+		negative = '-' == chars[i];
+		i++;
+	}
+
+	uint64T intStart = i;
+	while (i + 8 <= size && Runtime_swar_is_8_digits(Runtime_load_8_chars(chars + i))) {
+		i += 8;
+	}
+	while (i < size && Runtime_is_digit(chars[i])) {
+		i++;
+	}
+	uint64T intEnd = i;
+
+	uint64T fracStart = i;
+	uint64T fracEnd = i;
+	if (i < size && '.' == chars[i]) {
+		i++;
+		fracStart = i;
+		while (i + 8 <= size && Runtime_swar_is_8_digits(Runtime_load_8_chars(chars + i))) {
+			i += 8;
+		}
+		while (i < size && Runtime_is_digit(chars[i])) {
+			i++;
+		}
+		fracEnd = i;
+	}
+
+	if (intEnd == intStart && fracEnd == fracStart) {
+		return 0;
+	}
+
+	int64T explicitExponent = 0;
+	if (i < size && ('e' == chars[i] || 'E' == chars[i])) {
+		uint64T k = i + 1;
+		bool negativeExponent = false;
+		if (k < size && ('-' == chars[k] || '+' == chars[k])) {
+			negativeExponent = '-' == chars[k];
+			k++;
+		}
+		if (k < size && Runtime_is_digit(chars[k])) {
+			for (; k < size && Runtime_is_digit(chars[k]); k++) {
+				if (explicitExponent < 100000) {
+					explicitExponent = explicitExponent * 10 + (chars[k] - '0');
+				}
+			}
+			explicitExponent = negativeExponent ? -explicitExponent : explicitExponent;
+			i = k;
+		}
+	}
+
+	//the first 19 significant digits, value = mantissa * 10^exponent
+	uint64T mantissa = 0;
+	int64T significantCount = 0;
+	bool truncated = false;
+	int64T exponent = explicitExponent - (int64T)(fracEnd - fracStart);
+
+	uint64T pos = intStart;
+	while (pos < fracEnd) {
+		if (pos == intEnd) {
+			pos = fracStart;
+			continue;
+		}
+		uint64T partEnd = pos < intEnd ? intEnd : fracEnd;
+		if (0 != significantCount && significantCount + 8 <= 19 && pos + 8 <= partEnd) {
+			mantissa = mantissa * 100000000 + Runtime_swar_parse_8_digits(Runtime_load_8_chars(chars + pos));
+			significantCount += 8;
+			pos += 8;
+			continue;
+		}
+
+		uint32T digit = chars[pos] - '0';
+		if (0 != significantCount || 0 != digit) {
+			if (significantCount < 19) {
+				mantissa = mantissa * 10 + digit;
+			}
+			else {
+				truncated = true;
+			}
+			significantCount++;
+		}
+		pos++;
+	}
+
+	double64T result = 0;
+	if (0 == mantissa) {
+		result = 0;
+	}
+	else if (significantCount + exponent > 310) {
+		result = Runtime_double_from_bits(0x7FF0000000000000ULL);
+	}
+	else if (significantCount + exponent < -343) {
+		result = 0;
+	}
+	else if (!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+		//both exact, one rounding
+		result = exponent >= 0 ? (double64T)mantissa * runtimeDoublePowersOf10[exponent] : (double64T)mantissa / runtimeDoublePowersOf10[-exponent];
+	}
+	else {
+		int64T estimateExponent = exponent + (significantCount > 19 ? significantCount - 19 : 0);
+		int32T mantissaDigits = significantCount > 19 ? 19 : (int32T)significantCount;
+		double64T estimate = 0;
+		if (estimateExponent >= -348 && estimateExponent < 348) {
+			if (Runtime_decimal_to_double_fast(mantissa, mantissaDigits, (int32T)estimateExponent, truncated, &estimate)) {
+				*valuePtr = negative ? -estimate : estimate;
+				return i;
+			}
+		}
+		else {
+			estimate = (double64T)mantissa;
+			for (; estimateExponent > 22; estimateExponent -= 22) {
+				estimate *= 1e22;
+			}
+			for (; estimateExponent < -22; estimateExponent += 22) {
+				estimate /= 1e22;
+			}
+			estimate = estimateExponent >= 0 ? estimate * runtimeDoublePowersOf10[estimateExponent] : estimate / runtimeDoublePowersOf10[-estimateExponent];
+		}
+
+		//close to halfway between two doubles, decided with all the 
+		//digits, 9 at a time
+		Runtime_bignum digits;
+		Runtime_bignum_set(&digits, 0);
+		int64T used = 0;
+		uint32T chunk = 0;
+		uint32T chunkDigits = 0;
+		bool nonZeroRest = false;
+		int64T seen = 0;
+		for (pos = intStart; pos < fracEnd; pos++) {
+			if (pos == intEnd) {
+				pos = fracStart;
+				if (pos == fracEnd) {
+					break;
+				}
+			}
+			uint32T digit = chars[pos] - '0';
+			if (0 == seen && 0 == digit) {
+				continue;
+			}
+			seen++;
+			if (used == RUNTIME_PARSE_MAX_DIGITS) {
+				nonZeroRest |= 0 != digit;
+				continue;
+			}
+			chunk = chunk * 10 + digit;
+			used++;
+			if (9 == ++chunkDigits) {
+				Runtime_bignum_mul_add(&digits, 1000000000, chunk);
+				chunk = 0;
+				chunkDigits = 0;
+			}
+		}
+		if (nonZeroRest) {
+			chunk = chunk * 10 + 1;
+			chunkDigits++;
+			used++;
+		}
+		if (0 != chunkDigits) {
+			Runtime_bignum_mul_add(&digits, (uint32T)runtimePowersOf10[chunkDigits], chunk);
+		}
+
+		result = Runtime_decimal_to_double_slow(&digits, (int32T)(exponent + (significantCount - used)), estimate);
+	}
+
+	*valuePtr = negative ? -result : result;
+	return i;
+}
+
+Runtime_string_handle Runtime_int64_stringVal(int64T value)
+{
+	charT buffer[Runtime_number_buffer_size];
+	return Runtime_string_new_with_size(buffer, Runtime_format_int64(value, buffer));
+}
+
+Runtime_string_handle Runtime_uint64_stringVal(uint64T value)
+{
+	charT buffer[Runtime_number_buffer_size];
+	return Runtime_string_new_with_size(buffer, Runtime_format_uint64(value, buffer));
+}
+
+Runtime_string_handle Runtime_real64_stringVal(double64T value)
+{
+	charT buffer[Runtime_number_buffer_size];
+	return Runtime_string_new_with_size(buffer, Runtime_format_double(value, buffer));
+}
+
+inline uint64T Runtime_string_skip_spaces(Runtime_string* str)
+{
+	uint64T result = 0;
+	while (result < str->size && (' ' == str->data[result] || '\t' == str->data[result])) {
+		result++;
+	}
+	return result;
+}
+
+int64T Runtime_string_intVal(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	uint64T start = Runtime_string_skip_spaces(str);
+	int64T result = 0;
+	Runtime_parse_int64(str->data + start, str->size - start, &result);
+
+	return result;
+}
+
+double64T Runtime_string_realVal(Runtime_string_handle self)
+{
+	auto str = RUNTIME_STRING(self);
+	uint64T start = Runtime_string_skip_spaces(str);
+	double64T result = 0;
+	Runtime_parse_double(str->data + start, str->size - start, &result);
+
+	return result;
+}
+
+//end of number conversion
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//formatted output
+
+//stdout output is formatted straight into runtimeStdoutBuffer and 
+//written out per the flush policy. Runtime_snprintf uses the same 
+//formatter on a memory stream, which drops what doesn't fit
+#define RUNTIME_OUTPUT_BUFFER_SIZE	16384
+#define RUNTIME_OUTPUT_DEFAULT_FLUSH_SIZE	4096
+//%f of 1e308 is 309 digits before the point. Every double's exact 
+//value ends within 1074 decimals (2^-1074 is the smallest), past that
+//the digits are all 0 and are padded rather than computed
+#define RUNTIME_FORMAT_MAX_PRECISION	1074
+#define RUNTIME_FORMAT_MAX_DIGITS	(310 + RUNTIME_FORMAT_MAX_PRECISION)
+
+struct Runtime_output_stream {
+	charT* data;
+	uint32T size;
+	uint32T capacity;
+	//nullptr for a memory stream
+	void* handle;
+	uint32T policy;
+	uint32T flushSize;
+	bool lineEnded;
+	//what was put, for a memory stream more than it kept
+	uint64T total;
+};
+
+charT runtimeStdoutBuffer[RUNTIME_OUTPUT_BUFFER_SIZE];
+Runtime_output_stream runtimeStdout = { runtimeStdoutBuffer, 0, RUNTIME_OUTPUT_BUFFER_SIZE, nullptr, 
+	rtFlushLine, RUNTIME_OUTPUT_DEFAULT_FLUSH_SIZE, false, 0 };
+//a zeroed SRWLOCK is an initialized one, so printing works 
+//before Runtime_init
+void* runtimeStdoutLock = nullptr;
+
+struct Runtime_format_spec {
+	int32T width;
+	//-1 when not given
+	int32T precision;
+	bool leftAlign;
+	bool zeroPad;
+	bool plusSign;
+	bool spaceSign;
+	bool alternate;
+};
+
+enum Runtime_format_size {
+	rtFormatInt = 0,
+	rtFormatChar,
+	rtFormatShort,
+	rtFormatLong,
+	rtFormat64,
+	rtFormatPointerSize,
+};
+
+void Runtime_output_stream_flush(Runtime_output_stream* stream)
+{
+	if (nullptr != stream->handle && stream->size > 0) {
+		Win32_write_file(stream->handle, stream->data, stream->size);
+		stream->size = 0;
+	}
+	stream->lineEnded = false;
+}
+
+void Runtime_output_put(Runtime_output_stream* stream, const charT* chars, uint64T count)
+{
+	stream->total += count;
+	if (rtFlushLine == stream->policy && !stream->lineEnded) {
+		for (uint64T i = 0; i < count; i++) {
+			if ('\n' == chars[i]) {
+				stream->lineEnded = true;
+				break;
+			}
+		}
+	}
+
+	uint64T room = stream->capacity - stream->size;
+	if (count > room) {
+		if (nullptr == stream->handle) {
+			count = room;
+		}
+		else {
+			bool lineEnded = stream->lineEnded;
+			Runtime_output_stream_flush(stream);
+			stream->lineEnded = lineEnded;
+			if (count >= stream->capacity) {
+				Win32_write_file(stream->handle, chars, count);
+				return;
+			}
+		}
+	}
+
+	Runtime_mem_cpy((void*)chars, stream->data + stream->size, count);
+	stream->size += (uint32T)count;
+}
+
+inline void Runtime_output_put_char(Runtime_output_stream* stream, charT ch)
+{
+	if (stream->size < stream->capacity) {
+		stream->data[stream->size++] = ch;
+		stream->total++;
+		if ('\n' == ch && rtFlushLine == stream->policy) {
+			stream->lineEnded = true;
+		}
+		return;
+	}
+	Runtime_output_put(stream, &ch, 1);
+}
+
+void Runtime_output_put_repeat(Runtime_output_stream* stream, charT ch, int64T count)
+{
+	for (; count > 0; count--) {
+		Runtime_output_put_char(stream, ch);
+	}
+}
+
+//[spaces][prefix][zeros][body][spaces], zeros is the 
+//minimum from an integer precision, more for a 0 pad
+//innerZeros go into the body after its first innerAt chars
+void Runtime_output_put_field(Runtime_output_stream* stream, const Runtime_format_spec* spec, 
+	const charT* prefix, uint32T prefixLength, int64T zeros, const charT* body, uint64T bodyLength,
+	int64T innerZeros = 0, uint64T innerAt = 0)
+{
+	int64T padding = (int64T)spec->width - (int64T)(prefixLength + zeros + bodyLength + innerZeros);
+	if (padding > 0 && spec->zeroPad && !spec->leftAlign) {
+		zeros += padding;
+		padding = 0;
+	}
+
+	if (!spec->leftAlign) {
+		Runtime_output_put_repeat(stream, ' ', padding);
+	}
+	Runtime_output_put(stream, prefix, prefixLength);
+	Runtime_output_put_repeat(stream, '0', zeros);
+	if (innerZeros > 0) {
+		Runtime_output_put(stream, body, innerAt);
+		Runtime_output_put_repeat(stream, '0', innerZeros);
+		Runtime_output_put(stream, body + innerAt, bodyLength - innerAt);
+	}
+	else {
+		Runtime_output_put(stream, body, bodyLength);
+	}
+	if (spec->leftAlign) {
+		Runtime_output_put_repeat(stream, ' ', padding);
+	}
+}
+
+//lhs -= rhs, lhs >= rhs
+void Runtime_bignum_subtract(Runtime_bignum* lhs, const Runtime_bignum* rhs)
+{
+	int64T borrow = 0;
+	for (uint32T i = 0; i < lhs->count; i++) {
+		int64T diff = (int64T)lhs->limbs[i] - (i < rhs->count ? rhs->limbs[i] : 0) - borrow;
+		borrow = diff < 0 ? 1 : 0;
+		lhs->limbs[i] = (uint32T)diff;
+	}
+	while (lhs->count > 0 && 0 == lhs->limbs[lhs->count - 1]) {
+		lhs->count--;
+	}
+}
+
+//floor(log10(2^exponent)), exact for |exponent| < 1650
+inline int32T Runtime_floor_log10_pow2(int32T exponent)
+{
+	if (exponent >= 0) {
+		return (exponent * 78913) >> 18;
+	}
+	return -((-exponent * 78913) >> 18) - 1;
+}
+
+//floor(log10(value)) or one less, value > 0
+inline int32T Runtime_decimal_exponent_estimate(Runtime_diy_fp value)
+{
+	unsigned long bit = 0;
+	_BitScanReverse64(&bit, value.f);
+	return Runtime_floor_log10_pow2((int32T)bit + value.e);
+}
+
+//m * 10^scale * 2^e, exactly, when it fits 64 bits
+bool Runtime_scaled_integer_fast(Runtime_diy_fp value, int32T scale, uint64T* resultPtr)
+{
+	if (scale < 0 || scale > 19 || value.e <= -128) {
+		return false;
+	}
+
+	const uint64T mask32 = 0xFFFFFFFFULL;
+	uint64T pow10 = runtimePowersOf10[scale];
+	uint64T a = value.f >> 32;
+	uint64T b = value.f & mask32;
+	uint64T c = pow10 >> 32;
+	uint64T d = pow10 & mask32;
+	uint64T bd = b * d;
+	uint64T mid = (bd >> 32) + (a * d & mask32) + (b * c & mask32);
+	uint64T lo = (mid << 32) | (bd & mask32);
+	uint64T hi = a * c + (a * d >> 32) + (b * c >> 32) + (mid >> 32);
+
+	if (value.e >= 0) {
+		if (0 != hi || value.e >= 64 || (0 != value.e && 0 != (lo >> (64 - value.e)))) {
+			return false;
+		}
+		*resultPtr = lo << value.e;
+		return true;
+	}
+
+	uint32T shift = (uint32T)-value.e;
+	uint64T quotient = 0;
+	uint64T restHi = 0;
+	uint64T restLo = 0;
+	uint64T halfHi = 0;
+	uint64T halfLo = 0;
+	if (shift < 64) {
+		if (0 != (hi >> shift)) {
+			return false;
+		}
+		quotient = (lo >> shift) | (hi << (64 - shift));
+		restLo = lo & ((1ULL << shift) - 1);
+		halfLo = 1ULL << (shift - 1);
+	}
+	else {
+		uint32T hiShift = shift - 64;
+		quotient = hi >> hiShift;
+		restHi = 0 == hiShift ? 0 : hi & ((1ULL << hiShift) - 1);
+		restLo = lo;
+		if (0 == hiShift) {
+			halfLo = 1ULL << 63;
+		}
+		else {
+			halfHi = 1ULL << (hiShift - 1);
+		}
+	}
+	if (quotient >= (1ULL << 63)) {
+		return false;
+	}
+
+	//round half to even
+	if (restHi > halfHi || (restHi == halfHi && restLo > halfLo) || 
+		(restHi == halfHi && restLo == halfLo && 0 != (quotient & 1))) {
+		quotient++;
+	}
+	*resultPtr = quotient;
+	return true;
+}
+
+//the digits of value * 10^scale rounded to an integer (half to even),
+//value > 0. Returns the digit count, 0 if it rounds to 0
+uint32T Runtime_scaled_digits(double64T value, int32T scale, charT* digits)
+{
+	auto fp = Runtime_diy_fp_from_bits(Runtime_double_bits(value));
+
+	uint64T integer = 0;
+	if (Runtime_scaled_integer_fast(fp, scale, &integer)) {
+		if (0 == integer) {
+			return 0;
+		}
+		uint32T count = Runtime_decimal_digit_count(integer);
+		Runtime_write_digits(integer, digits + count);
+		return count;
+	}
+
+	//value * 10^scale = num / den
+	Runtime_bignum num;
+	Runtime_bignum den;
+	Runtime_bignum_set(&num, fp.f);
+	Runtime_bignum_set(&den, 1);
+	if (fp.e > 0) {
+		Runtime_bignum_shift_left(&num, fp.e);
+	}
+	else {
+		Runtime_bignum_shift_left(&den, -fp.e);
+	}
+	if (scale > 0) {
+		Runtime_bignum_mul_pow5(&num, scale);
+		Runtime_bignum_shift_left(&num, scale);
+	}
+	else if (scale < 0) {
+		Runtime_bignum_mul_pow5(&den, -scale);
+		Runtime_bignum_shift_left(&den, -scale);
+	}
+
+	//the quotient has count digits, or one less
+	int32T count = Runtime_decimal_exponent_estimate(fp) + scale + 2;
+	Runtime_bignum unit;
+	for (; count > 0; count--) {
+		unit = den;
+		Runtime_bignum_mul_pow5(&unit, count - 1);
+		Runtime_bignum_shift_left(&unit, count - 1);
+		if (Runtime_bignum_compare(&num, &unit) >= 0) {
+			break;
+		}
+	}
+
+	if (count <= 0) {
+		Runtime_bignum_shift_left(&num, 1);
+		if (Runtime_bignum_compare(&num, &den) > 0) {
+			digits[0] = '1';
+			return 1;
+		}
+		return 0;
+	}
+
+	for (int32T i = 0; i < count; i++) {
+		charT digit = '0';
+		while (Runtime_bignum_compare(&num, &unit) >= 0) {
+			Runtime_bignum_subtract(&num, &unit);
+			digit++;
+		}
+		digits[i] = digit;
+		if (i + 1 < count) {
+			Runtime_bignum_mul_add(&num, 10, 0);
+		}
+	}
+
+	Runtime_bignum_shift_left(&num, 1);
+	int32T cmp = Runtime_bignum_compare(&num, &unit);
+	if (cmp > 0 || (0 == cmp && 0 != ((digits[count - 1] - '0') & 1))) {
+		int32T i = count - 1;
+		for (; i >= 0 && '9' == digits[i]; i--) {
+			digits[i] = '0';
+		}
+		if (i >= 0) {
+			digits[i]++;
+		}
+		else {
+			digits[0] = '1';
+			digits[count++] = '0';
+		}
+	}
+	return (uint32T)count;
+}
+
+//digits is the integer value * 10^decimals
+uint32T Runtime_format_fixed_digits(const charT* digits, uint32T count, int32T decimals, bool point, charT* dest)
+{
+	charT* out = dest;
+	int32T intDigits = (int32T)count - decimals;
+	if (intDigits > 0) {
+		Runtime_mem_cpy((void*)digits, out, intDigits);
+		out += intDigits;
+	}
+	else {
+		*out++ = '0';
+	}
+
+	if (decimals > 0 || point) {
+		*out++ = '.';
+	}
+	for (int32T i = intDigits; i < 0; i++) {
+		*out++ = '0';
+	}
+	if (decimals > 0) {
+		int32T fracDigits = intDigits > 0 ? decimals : (int32T)count;
+		Runtime_mem_cpy((void*)(digits + count - fracDigits), out, fracDigits);
+		out += fracDigits;
+	}
+	return (uint32T)(out - dest);
+}
+
+uint32T Runtime_format_exponential_digits(const charT* digits, uint32T count, int32T exponent, bool point, bool upper, charT* dest)
+{
+	charT* out = dest;
+	*out++ = digits[0];
+	if (count > 1 || point) {
+		*out++ = '.';
+	}
+	Runtime_mem_cpy((void*)(digits + 1), out, count - 1);
+	out += count - 1;
+
+	*out++ = upper ? 'E' : 'e';
+	*out++ = exponent < 0 ? '-' : '+';
+	uint32T magnitude = exponent < 0 ? -exponent : exponent;
+	uint32T length = magnitude < 10 ? 2 : Runtime_decimal_digit_count(magnitude);
+	Runtime_write_digits(magnitude, out + length);
+	if (magnitude < 10) {
+		out[0] = '0';
+	}
+	out += length;
+	return (uint32T)(out - dest);
+}
+
+//without the trailing zeros of the fraction, and the point if they 
+//were all of it, %g does it unless #
+uint32T Runtime_trim_fraction(charT* text, uint32T length, uint32T end)
+{
+	uint32T point = 0;
+	for (; point < end && '.' != text[point]; point++) {
+	}
+	if (point == end) {
+		return length;
+	}
+
+	uint32T last = end;
+	while (last > point + 1 && '0' == text[last - 1]) {
+		last--;
+	}
+	if (last == point + 1) {
+		last = point;
+	}
+	for (uint32T i = end; i < length; i++) {
+		text[last + i - end] = text[i];
+	}
+	return length - (end - last);
+}
+
+//%f %e %g of a finite value >= 0, dest holds RUNTIME_FORMAT_MAX_DIGITS + 8
+uint32T Runtime_format_real(double64T value, charT conversion, int32T precision, bool alternate, charT* dest)
+{
+	charT digits[RUNTIME_FORMAT_MAX_DIGITS];
+	bool upper = conversion < 'a';
+	charT lower = conversion | 0x20;
+	if ('f' == lower) {
+		uint32T count = 0.0 == value ? 0 : Runtime_scaled_digits(value, precision, digits);
+		return Runtime_format_fixed_digits(digits, count, precision, alternate, dest);
+	}
+
+	int32T significant = 'e' == lower ? precision + 1 : (0 == precision ? 1 : precision);
+	int32T exponent = 0;
+	uint32T count = significant;
+	if (0.0 == value) {
+		for (int32T i = 0; i < significant; i++) {
+			digits[i] = '0';
+		}
+	}
+	else {
+		exponent = Runtime_decimal_exponent_estimate(Runtime_diy_fp_from_bits(Runtime_double_bits(value)));
+		count = Runtime_scaled_digits(value, significant - 1 - exponent, digits);
+		//the estimate was one short, or rounding carried into another digit
+		while (count > (uint32T)significant) {
+			exponent++;
+			count = Runtime_scaled_digits(value, significant - 1 - exponent, digits);
+		}
+	}
+
+	if ('e' == lower) {
+		return Runtime_format_exponential_digits(digits, count, exponent, alternate, upper, dest);
+	}
+
+	uint32T length = 0;
+	uint32T end = 0;
+	if (exponent >= -4 && exponent < significant) {
+		length = Runtime_format_fixed_digits(digits, count, significant - 1 - exponent, alternate, dest);
+		end = length;
+	}
+	else {
+		length = Runtime_format_exponential_digits(digits, count, exponent, alternate, upper, dest);
+		end = length;
+		while ('e' != (dest[end - 1] | 0x20)) {
+			end--;
+		}
+		end--;
+	}
+	return alternate ? length : Runtime_trim_fraction(dest, length, end);
+}
+
+void Runtime_output_format(Runtime_output_stream* stream, const char* fmtStr, va_list argList)
+{
+	static const charT lowerHex[] = "0123456789abcdef";
+	static const charT upperHex[] = "0123456789ABCDEF";
+	charT body[RUNTIME_FORMAT_MAX_DIGITS + 8];
+
+	const charT* ch = (const charT*)fmtStr;
+	while (0 != *ch) {
+		const charT* run = ch;
+		while (0 != *ch && '%' != *ch) {
+			ch++;
+		}
+		if (ch > run) {
+			Runtime_output_put(stream, run, ch - run);
+		}
+		if (0 == *ch) {
+			break;
+		}
+
+		const charT* specStart = ch++;
+		Runtime_format_spec spec = {};
+		spec.precision = -1;
+
+		for (bool flags = true; flags; ) {
+			switch (*ch) {
+				case '-': {
+					spec.leftAlign = true;
+					ch++;
+				}break;
+
+				case '0': {
+					spec.zeroPad = true;
+					ch++;
+				}break;
+
+				case '+': {
+					spec.plusSign = true;
+					ch++;
+				}break;
+
+				case ' ': {
+					spec.spaceSign = true;
+					ch++;
+				}break;
+
+				case '#': {
+					spec.alternate = true;
+					ch++;
+				}break;
+
+				default: {
+					flags = false;
+				}break;
+			}
+		}
+
+		if ('*' == *ch) {
+			spec.width = va_arg(argList, int);
+			if (spec.width < 0) {
+				spec.leftAlign = true;
+				spec.width = -spec.width;
+			}
+			ch++;
+		}
+		else {
+			for (; Runtime_is_digit(*ch); ch++) {
+				spec.width = spec.width * 10 + (*ch - '0');
+			}
+		}
+
+		if ('.' == *ch) {
+			ch++;
+			spec.precision = 0;
+			if ('*' == *ch) {
+				spec.precision = va_arg(argList, int);
+				ch++;
+			}
+			else {
+				for (; Runtime_is_digit(*ch); ch++) {
+					spec.precision = spec.precision * 10 + (*ch - '0');
+				}
+			}
+		}
+
+		Runtime_format_size size = rtFormatInt;
+		switch (*ch) {
+			case 'h': {
+				size = 'h' == ch[1] ? rtFormatChar : rtFormatShort;
+				ch += 'h' == ch[1] ? 2 : 1;
+			}break;
+
+			case 'l': {
+				size = 'l' == ch[1] ? rtFormat64 : rtFormatLong;
+				ch += 'l' == ch[1] ? 2 : 1;
+			}break;
+
+			case 'I': {
+				if ('6' == ch[1] && '4' == ch[2]) {
+					size = rtFormat64;
+					ch += 3;
+				}
+				else if ('3' == ch[1] && '2' == ch[2]) {
+					size = rtFormatInt;
+					ch += 3;
+				}
+				else {
+					size = rtFormatPointerSize;
+					ch++;
+				}
+			}break;
+
+			case 'z': case 'j': case 't': {
+				size = rtFormatPointerSize;
+				ch++;
+			}break;
+
+			case 'L': {
+				ch++;
+			}break;
+
+			default: {
+			}break;
+		}
+
+		charT conversion = *ch;
+		switch (conversion) {
+			case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': {
+				bool isSigned = 'd' == conversion || 'i' == conversion;
+				uint64T value = 0;
+				bool negative = false;
+				if (isSigned) {
+					int64T signedValue = 0;
+					switch (size) {
+						case rtFormatChar: { signedValue = (int8T)va_arg(argList, int); }break;
+						case rtFormatShort: { signedValue = (int16T)va_arg(argList, int); }break;
+						case rtFormatLong: { signedValue = va_arg(argList, long); }break;
+						case rtFormat64: { signedValue = va_arg(argList, int64T); }break;
+						case rtFormatPointerSize: { signedValue = (int64T)va_arg(argList, size_t); }break;
+						default: { signedValue = va_arg(argList, int); }break;
+					}
+					negative = signedValue < 0;
+					value = negative ? 0 - (uint64T)signedValue : (uint64T)signedValue;
+				}
+				else {
+					switch (size) {
+						case rtFormatChar: { value = (uint8T)va_arg(argList, unsigned int); }break;
+						case rtFormatShort: { value = (uint16T)va_arg(argList, unsigned int); }break;
+						case rtFormatLong: { value = va_arg(argList, unsigned long); }break;
+						case rtFormat64: { value = va_arg(argList, uint64T); }break;
+						case rtFormatPointerSize: { value = va_arg(argList, size_t); }break;
+						default: { value = va_arg(argList, unsigned int); }break;
+					}
+				}
+
+				charT* end = body + sizeof(body);
+				charT* digits = end;
+				if ('x' == conversion || 'X' == conversion) {
+					const charT* hex = 'x' == conversion ? lowerHex : upperHex;
+					for (uint64T rest = value; 0 != rest; rest >>= 4) {
+						*--digits = hex[rest & 15];
+					}
+				}
+				else if ('o' == conversion) {
+					for (uint64T rest = value; 0 != rest; rest >>= 3) {
+						*--digits = (charT)('0' + (rest & 7));
+					}
+				}
+				else if (0 != value) {
+					digits -= Runtime_decimal_digit_count(value);
+					Runtime_write_digits(value, end);
+				}
+				//a 0 precision prints nothing for 0
+				if (digits == end && 0 != spec.precision) {
+					*--digits = '0';
+				}
+
+				charT prefix[2];
+				uint32T prefixLength = 0;
+				if (negative) {
+					prefix[prefixLength++] = '-';
+				}
+				else if (isSigned && spec.plusSign) {
+					prefix[prefixLength++] = '+';
+				}
+				else if (isSigned && spec.spaceSign) {
+					prefix[prefixLength++] = ' ';
+				}
+				else if (spec.alternate && 0 != value && ('x' == conversion || 'X' == conversion)) {
+					prefix[prefixLength++] = '0';
+					prefix[prefixLength++] = conversion;
+				}
+				else if (spec.alternate && 'o' == conversion && (digits == end || '0' != *digits)) {
+					*--digits = '0';
+				}
+
+				int64T zeros = 0;
+				if (spec.precision >= 0) {
+					zeros = spec.precision - (end - digits);
+					spec.zeroPad = false;
+				}
+				Runtime_output_put_field(stream, &spec, prefix, prefixLength, zeros > 0 ? zeros : 0, digits, end - digits);
+			}break;
+
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': {
+				double64T value = va_arg(argList, double64T);
+				uint64T bits = Runtime_double_bits(value);
+
+				charT prefix[1];
+				uint32T prefixLength = 0;
+				if (0 != (bits >> 63)) {
+					prefix[prefixLength++] = '-';
+				}
+				else if (spec.plusSign) {
+					prefix[prefixLength++] = '+';
+				}
+				else if (spec.spaceSign) {
+					prefix[prefixLength++] = ' ';
+				}
+
+				uint64T length = 0;
+				int64T extraZeros = 0;
+				uint64T extraAt = 0;
+				if (RUNTIME_DOUBLE_EXPONENT_MASK == (bits & RUNTIME_DOUBLE_EXPONENT_MASK)) {
+					bool isNan = 0 != (bits & RUNTIME_DOUBLE_FRACTION_MASK);
+					const char* text = conversion < 'a' ? (isNan ? "NAN" : "INF") : (isNan ? "nan" : "inf");
+					Runtime_mem_cpy((void*)text, body, 3);
+					length = 3;
+					spec.zeroPad = false;
+				}
+				else {
+					int32T precision = spec.precision < 0 ? 6 : spec.precision;
+					if (precision > RUNTIME_FORMAT_MAX_PRECISION) {
+						//%g drops trailing 0's unless #
+						if ('g' != (conversion | 0x20) || spec.alternate) {
+							extraZeros = precision - RUNTIME_FORMAT_MAX_PRECISION;
+						}
+						precision = RUNTIME_FORMAT_MAX_PRECISION;
+					}
+					length = Runtime_format_real(value < 0 ? -value : value, conversion, precision, spec.alternate, body);
+					//the padding goes in front of any exponent
+					while (extraAt < length && 'e' != (body[extraAt] | 0x20)) {
+						extraAt++;
+					}
+				}
+				Runtime_output_put_field(stream, &spec, prefix, prefixLength, 0, body, length, extraZeros, extraAt);
+			}break;
+
+			case 'c': {
+				body[0] = (charT)va_arg(argList, int);
+				spec.zeroPad = false;
+				Runtime_output_put_field(stream, &spec, nullptr, 0, 0, body, 1);
+			}break;
+
+			case 's': {
+				auto str = (const charT*)va_arg(argList, const char*);
+				if (nullptr == str) {
+					str = (const charT*)"(null)";
+				}
+				uint64T length = 0;
+				while ((spec.precision < 0 || length < (uint64T)spec.precision) && 0 != str[length]) {
+					length++;
+				}
+				spec.zeroPad = false;
+				Runtime_output_put_field(stream, &spec, nullptr, 0, 0, str, length);
+			}break;
+
+			case 'p': {
+				//all the digits, upper case, as wsprintf does
+				auto value = (uint64T)va_arg(argList, void*);
+				uint32T digitCount = sizeof(void*) * 2;
+				for (uint32T i = 0; i < digitCount; i++) {
+					body[digitCount - 1 - i] = upperHex[(value >> (i * 4)) & 15];
+				}
+				spec.zeroPad = false;
+				Runtime_output_put_field(stream, &spec, nullptr, 0, 0, body, digitCount);
+			}break;
+
+			case '%': {
+				Runtime_output_put_char(stream, '%');
+			}break;
+
+			default: {
+				//not a conversion, print it as is
+				if (0 == conversion) {
+					Runtime_output_put(stream, specStart, ch - specStart);
+					return;
+				}
+				Runtime_output_put(stream, specStart, ch + 1 - specStart);
+			}break;
+		}
+		ch++;
+	}
+}
+
+inline void Runtime_output_stdout_begin()
+{
+	Win32_lock_acquire(&runtimeStdoutLock);
+	if (nullptr == runtimeStdout.handle) {
+		bool isConsole = false;
+		runtimeStdout.handle = Win32_stdout_handle(&isConsole);
+	}
+}
+
+inline void Runtime_output_stdout_end()
+{
+	//unbuffered outside Runtime_init/Runtime_terminate, nothing 
+	//would flush it
+	if (nullptr == runtimeInstancePtr || runtimeStdout.lineEnded || 
+		(rtFlushSize == runtimeStdout.policy && runtimeStdout.size >= runtimeStdout.flushSize)) {
+		Runtime_output_stream_flush(&runtimeStdout);
+	}
+	Win32_lock_release(&runtimeStdoutLock);
+}
+
+void Runtime_output_init()
+{
+	Win32_lock_acquire(&runtimeStdoutLock);
+	bool isConsole = false;
+	runtimeStdout.handle = Win32_stdout_handle(&isConsole);
+	runtimeStdout.policy = isConsole ? rtFlushLine : rtFlushSize;
+	runtimeStdout.flushSize = RUNTIME_OUTPUT_DEFAULT_FLUSH_SIZE;
+	Win32_lock_release(&runtimeStdoutLock);
+}
+
+void Runtime_output_set_flush_policy(Runtime_flush_policy policy)
+{
+	Runtime_output_stdout_begin();
+	runtimeStdout.policy = policy;
+	runtimeStdout.lineEnded = false;
+	Runtime_output_stdout_end();
+}
+
+Runtime_flush_policy Runtime_output_flush_policy()
+{
+	return (Runtime_flush_policy)runtimeStdout.policy;
+}
+
+void Runtime_output_set_flush_size(uint32T size)
+{
+	Runtime_output_stdout_begin();
+	runtimeStdout.flushSize = size < RUNTIME_OUTPUT_BUFFER_SIZE ? size : RUNTIME_OUTPUT_BUFFER_SIZE;
+	Runtime_output_stdout_end();
+}
+
+void Runtime_output_flush()
+{
+	Runtime_output_stdout_begin();
+	Runtime_output_stream_flush(&runtimeStdout);
+	Win32_lock_release(&runtimeStdoutLock);
+}
+
+void Runtime_output_write(const charT* data, uint64T size)
+{
+	Runtime_output_stdout_begin();
+	Runtime_output_put(&runtimeStdout, data, size);
+	Runtime_output_stdout_end();
+}
+
+void Runtime_printf_arglist(const char* fmtStr, va_list argList)
+{
+	Runtime_output_stdout_begin();
+	Runtime_output_format(&runtimeStdout, fmtStr, argList);
+	Runtime_output_stdout_end();
+}
+
+void Runtime_printf(const char* fmtStr, ...)
+{
+	va_list argList;
+	va_start(argList, fmtStr);
+
+	Runtime_printf_arglist(fmtStr, argList);
+
+	va_end(argList);
+}
+
+uint64T Runtime_snprintf_arglist(charT* buffer, uint64T bufferSize, const char* fmtStr, va_list argList)
+{
+	Runtime_output_stream stream = {};
+	stream.data = buffer;
+	stream.capacity = bufferSize > 0xFFFFFFFFULL ? 0xFFFFFFFF : (bufferSize > 0 ? (uint32T)(bufferSize - 1) : 0);
+	stream.policy = rtFlushExplicit;
+
+	Runtime_output_format(&stream, fmtStr, argList);
+	if (bufferSize > 0) {
+		buffer[stream.size] = 0;
+	}
+	return stream.total;
+}
+
+uint64T Runtime_snprintf(charT* buffer, uint64T bufferSize, const char* fmtStr, ...)
+{
+	va_list argList;
+	va_start(argList, fmtStr);
+
+	uint64T result = Runtime_snprintf_arglist(buffer, bufferSize, fmtStr, argList);
+
+	va_end(argList);
+	return result;
+}
+
+void Runtime_debug_printf(const char* fmtStr, ...)
+{
+#ifdef SCRATCH_RUNTIME_DEBUG
+	char buffer[1024] = "DEBUG ";
+	va_list argList;
+	va_start(argList, fmtStr);
+
+	uint64T length = 6 + Runtime_snprintf_arglist((charT*)buffer + 6, sizeof(buffer) - 6, fmtStr, argList);
+
+	va_end(argList);
+
+	Runtime_output_write((const charT*)buffer, length < sizeof(buffer) ? length : sizeof(buffer) - 1);
+	Win32_debug_output(buffer);
+#endif
+}
+
+//end of formatted output
+//----------------------------------------------------------------------------
+
+
+
+bool Runtime_verify_heap_mem(void* mem)
+{
+	if (nullptr == mem) {
+		return false;
+	}
+
+	uint8T* memPtr = (uint8T*)mem;
+	memPtr -= sizeof(Runtime_memory_info);
+	Runtime_memory_info* rtMemPtr = (Runtime_memory_info*)memPtr;
+	
+	if (mem != rtMemPtr->memPtr) {
+		Runtime_debug_printf("Runtime_verify_heap_mem failed!\n");
+	}
+
+	return rtMemPtr->memPtr == mem;
+}
+
+void* Runtime_alloc(uint64T size, Runtime_TypeDescriptor type)
+{
+    void* result = nullptr;
+	uint64T adjustedSize = 0;
+	Runtime_memory_info memInfo;
+	
+	Runtime_memory_info_init(&memInfo);
+
+
+	memInfo.size = size;
+	memInfo.type = type;
+
+	switch (type) {
+		case typeRecord: {
+
+		}break;
+
+		case typeClass: {
+
+		}break;
+
+		case typeArray: {
+			adjustedSize = size;
+		}break;
+
+
+		default: {
+			adjustedSize = size;
+		}break;
+	}
+
+
+	adjustedSize += sizeof(Runtime_memory_info);
+
+	void* mem = Win32_Runtime_alloc(adjustedSize);
+
+	//Runtime_debug_printf("Win32_Runtime_alloc: %d, mem: %p\n", (int)adjustedSize, mem);
+
+	Runtime_memory_info* allocatedMem = (Runtime_memory_info*)mem;
+	*allocatedMem = memInfo;
+	uint8T* memPtr = (uint8T * )mem;
+	allocatedMem->memPtr = (void*)(memPtr + sizeof(Runtime_memory_info));
+
+	result = allocatedMem->memPtr;
+
+	//concurrent hashtables allocate from several threads
+	_InterlockedExchangeAdd64((volatile int64T*)&totalBytesHeapAllocated, (int64T)adjustedSize);
+
+	//Runtime_debug_printf("Runtime_alloc: %d, mem: %p\n", (int)allocatedMem->size, allocatedMem->memPtr);
+
+	//Runtime_debug_printf("tot: %I64u\n", totalBytesHeapAllocated);
+
+    return result;
+}
+
+void Runtime_free(void* mem)
+{
+	if (!Runtime_verify_heap_mem(mem)) {		
+		return;
+	}
+
+	uint8T* memPtr = (uint8T*)mem;
+	memPtr -= sizeof(Runtime_memory_info);
+
+	Runtime_memory_info* allocatedMem = (Runtime_memory_info*)memPtr;
+	//Runtime_debug_printf("Runtime_free: %d, Runtime_memory_info: %p, %p\n", (int)allocatedMem->size, allocatedMem, mem);
+
+	_InterlockedExchangeAdd64((volatile int64T*)&totalBytesHeapAllocated, -(int64T)(allocatedMem->size + sizeof(Runtime_memory_info)));
+
+	Win32_Runtime_free(allocatedMem);
+}
+
+Runtime_memory_info_handle Runtime_RuntimeMemory_get_from_heap_ptr(void* mem)
+{
+	if (nullptr == mem) {
+		return nullptr;
+	}
+
+	Runtime_memory_info* result = nullptr;
+	uint8T* memPtr = (uint8T*)mem;
+	memPtr -= sizeof(Runtime_memory_info);
+	result = (Runtime_memory_info*)memPtr;
+
+	if (result->memPtr != mem) {
+		// this mem ptr is not something we created!
+		result = nullptr;
+	}
+
+	return result;
+}
+
+uint64T Runtime_RuntimeMemory_get_size(void* mem)
+{	
+	if (nullptr == mem) {
+		return 0;
+	}
+	auto tmp = (Runtime_memory_info*) Runtime_RuntimeMemory_get_from_heap_ptr(mem);
+	if (nullptr == tmp) {
+		return 0;
+	}
+		
+	return tmp->size;
+}
+
+Runtime_TypeDescriptor Runtime_RuntimeMemory_get_type(void* mem)
+{
+	if (nullptr == mem) {
+		return typeNilPtr;
+	}
+
+	auto tmp = (Runtime_memory_info*) Runtime_RuntimeMemory_get_from_heap_ptr(mem);
+	if (nullptr == tmp) {
+		return typeUnmanagedPtr;
+	}
+
+	return tmp->type;
+}
+
+
+//----------------------------------------------------------------------------
+//hashtable
+//open addressing, swiss table style. Each slot has a control
+//byte, either empty, deleted (tombstone) or the low 7 bits of 
+//the key's hash. Lookups load 16 control bytes at a time and 
+//compare them against the hash bits with SSE2, so only slots 
+//that very likely match have their key looked at. Keys and 
+//values live inline in the slot array, nothing is allocated
+//per element.
+//Insertion ordered tables keep keys and values in a dense
+//entry array instead, in insertion order, and the slots only
+//hold an index into it.
+//Tables start out as a small map, up to 8 entries stored in 
+//order right after the object with no table allocated. Lookups 
+//compare 32 bits of the hash against all 8 entries at once. The 
+//9th key switches the table over to the full layout.
+
+#define RUNTIME_HASHTABLE_NO_INDEX  uint64T (-1)
+#define RUTNIME_HASHTABLE_DEF_CAPCITY_GROW	2.0
+#define RUTNIME_HASHTABLE_DEF_MAX_USAGE		0.875
+
+#define RUNTIME_HASHTABLE_GROUP_WIDTH	16
+#define RUNTIME_HASHTABLE_MIN_CAPACITY	16
+
+//tables at least this big resize incrementally, below 
+//that a full rehash is cheap enough to do in one go
+#define RUNTIME_HASHTABLE_INCREMENTAL_MIN_CAPACITY	4096
+//groups moved to the new table per insert/erase while resizing
+#define RUNTIME_HASHTABLE_MIGRATE_GROUPS	4
+
+#define RUNTIME_HASHTABLE_SMALL_CAPACITY	8
+
+//hashes never have the top bit set, ordered tables use it
+//to flag erased entries
+#define RUNTIME_HASHTABLE_HASH_MASK		0x7FFFFFFFFFFFFFFFULL
+#define RUNTIME_HASHTABLE_ENTRY_ERASED	0x8000000000000000ULL
+
+enum Runtime_hashtable_ctrl {
+	rtHashCtrlEmpty = -128, //0x80
+	rtHashCtrlDeleted = -2, //0xFE
+	//anything 0..127 is a full slot holding the h2 bits of the hash
+};
+
+
+//control bytes + slots for one table. capacity is a power of 2,
+//ctrl has capacity + RUNTIME_HASHTABLE_GROUP_WIDTH bytes, the 
+//last group mirrors the first so a group can be loaded from 
+//any position without wrapping
+struct Runtime_hashtable_block {
+	int8T* ctrl;
+	uint8T* slots;
+	uint64T capacity;
+	uint64T stride;
+};
+
+struct Runtime_hashtable_object {
+	Runtime_hashtable_block table;
+
+	uint64T size;
+	//inserts left before the table has to grow, tombstones
+	//count against this
+	uint64T growthLeft;
+
+	double capacityGrowthFactor;
+	double maxUsageFactor;
+
+	//incremental resize. While oldTable.ctrl is set both tables
+	//are live, lookups check table first then oldTable, and each
+	//insert/erase moves a few groups starting at migratePos over.
+	//Moved slots are left as tombstones in oldTable
+	Runtime_hashtable_block oldTable;
+	uint64T migratePos;
+	bool incrementalResize;
+
+	//times the table moved to a bigger (or smaller) block
+	uint32T resizeCount;
+
+	//insertion ordered mode, entries are [key][value][hash]
+	//entryStride apart. Erased entries stay in place, flagged
+	//in the hash, until there are enough of them to compact
+	bool ordered;
+	uint8T* entries;
+	uint64T entryCount;
+	uint64T entryCapacity;
+	uint64T erasedCount;
+
+	//small map mode, size entries at smallEntries (which points 
+	//just past the object), smallTags has the low 32 bits of 
+	//each entry's hash
+	bool small;
+	uint32T smallTags[RUNTIME_HASHTABLE_SMALL_CAPACITY];
+	uint8T* smallEntries;
+
+	Runtime_hashtable_info* infoPtr;
+
+	//Runtime_Instance::liveHashtables, only while liveListed
+	bool liveListed;
+	Runtime_hashtable_object* liveNext;
+	Runtime_hashtable_object* livePrev;
+};
+
+
+
+inline uint64T Runtime_hash_mix64(uint64T x)
+{
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
+inline bool Runtime_type_is_handle(Runtime_TypeDescriptor type)
+{
+	return typeString == type || typeArray == type || typeDictionary == type || typeSet == type;
+}
+
+
+uint64T Runtime_hashtable_hash_key(Runtime_hashtable_info* info, void* key) 
+{
+	uint64T result = 0;
+	
+	switch (info->keyType) {
+		case typeBit1: case typeBool:
+		case typeInteger8: case typeUInteger8: {
+			result = Runtime_hash_mix64(*(uint8T*)key);
+		}break;
+
+		case typeInteger16: case typeUInteger16: {
+			result = Runtime_hash_mix64(*(uint16T*)key);
+		}break;
+
+		case typeInteger32: case typeUInteger32: {
+			result = Runtime_hash_mix64(*(uint32T*)key);
+		}break;
+
+		case typeInteger64: case typeUInteger64: {
+			result = Runtime_hash_mix64(*(uint64T*)key);
+		}break;
+
+		case typeInteger128: case typeUInteger128: {
+			auto k = (uint128T*)key;
+			result = Runtime_hash_mix64(k->lo ^ Runtime_hash_mix64(k->hi));
+		}break;
+		
+		case typeDouble32: case typeDouble64: {
+			auto keyBytes = (uint8T*)key;
+			result = Runtime_hash_mix64(Runtime_hash_basic_bytes(keyBytes, info->keyStride));
+
+		}break;
+
+		case typeString:{
+			auto str = (Runtime_string_handle)key;
+			result = Runtime_hash_mix64(Runtime_string_hash(str));
+
+		}break;
+
+		default: {
+			if (Runtime_is_user_type(info->keyType)) {
+				auto hashVal = (nullptr != info->keyTypeInfo->hash) ? 
+									info->keyTypeInfo->hash(key) : 
+									Runtime_hash_basic_bytes((uint8T*)key, info->keyTypeInfo->size);
+				result = Runtime_hash_mix64(hashVal);
+			}
+			else {
+				RUNTIME_ASSERT(false);
+			}
+		} break;
+	}
+
+	return result & RUNTIME_HASHTABLE_HASH_MASK;
+}
+
+
+//keyRef is what the slot refers to, i.e. the handle for 
+//string keys, a pointer into the slot for anything else
+bool Runtime_hashtable_key_equals(Runtime_hashtable_info* info, void* keyRef, void* key)
+{
+	if (keyRef == key) {
+		return true;
+	}
+
+	switch (info->keyType) {
+		case typeBit1: case typeBool:
+		case typeInteger8: case typeUInteger8: {
+			return *(uint8T*)keyRef == *(uint8T*)key;
+		}break;
+
+		case typeInteger16: case typeUInteger16: {
+			return *(uint16T*)keyRef == *(uint16T*)key;
+		}break;
+
+		case typeInteger32: case typeUInteger32: {
+			return *(uint32T*)keyRef == *(uint32T*)key;
+		}break;
+
+		case typeInteger64: case typeUInteger64: {
+			return *(uint64T*)keyRef == *(uint64T*)key;
+		}break;
+
+		case typeString: {
+			return Runtime_string_equals((Runtime_string_handle)keyRef, (Runtime_string_handle)key);
+		}break;
+
+		default: {
+			if (nullptr != info->keyTypeInfo->equals) {
+				return info->keyTypeInfo->equals(keyRef, key);
+			}
+		} break;
+	}
+
+	return 0 == Runtime_mem_cmp(keyRef, info->keyStride, key, info->keyStride);
+}
+
+
+inline uint8T* Runtime_hashtable_slot(Runtime_hashtable_block* block, uint64T idx)
+{
+	return block->slots + idx * block->stride;
+}
+
+inline void* Runtime_hashtable_slot_key_ref(Runtime_hashtable_info* info, uint8T* slot)
+{
+	return Runtime_type_is_handle(info->keyType) ? *(void**)slot : (void*)slot;
+}
+
+inline void* Runtime_hashtable_slot_val_ref(Runtime_hashtable_info* info, uint8T* slot)
+{
+	auto valPtr = slot + info->valOffset;
+	return Runtime_type_is_handle(info->valueType) ? *(void**)valPtr : (void*)valPtr;
+}
+
+
+inline uint8T* Runtime_hashtable_entry(Runtime_hashtable_object* hashTable, uint64T entryIdx)
+{
+	return hashTable->entries + entryIdx * hashTable->infoPtr->entryStride;
+}
+
+inline uint64T* Runtime_hashtable_entry_hash(Runtime_hashtable_info* info, uint8T* entry)
+{
+	return (uint64T*)(entry + info->slotStride);
+}
+
+//key/value data for a slot, stored in the slot itself or
+//for ordered tables in the entry the slot points to
+inline uint8T* Runtime_hashtable_slot_data(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* block, uint64T idx)
+{
+	auto slot = Runtime_hashtable_slot(block, idx);
+	return hashTable->ordered ? Runtime_hashtable_entry(hashTable, *(uint64T*)slot) : slot;
+}
+
+inline uint64T Runtime_hashtable_slot_hash(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* block, uint64T idx)
+{
+	auto info = hashTable->infoPtr;
+	auto data = Runtime_hashtable_slot_data(hashTable, block, idx);
+
+	if (hashTable->ordered) {
+		return *Runtime_hashtable_entry_hash(info, data);
+	}
+	return Runtime_hashtable_hash_key(info, Runtime_hashtable_slot_key_ref(info, data));
+}
+
+//src is the handle for handle types, which is stored as is
+void Runtime_hashtable_value_assign(Runtime_TypeDescriptor type, Runtime_type_info* typeInfo, uint64T stride, uint8T* dest, void* src)
+{
+	if (Runtime_type_is_handle(type)) {
+		*(void**)dest = src;
+	}
+	else if (nullptr != typeInfo->copy) {
+		typeInfo->copy(dest, src);
+	}
+	else {
+		Runtime_mem_cpy(src, dest, stride);
+	}
+}
+
+void Runtime_hashtable_slot_assign(Runtime_hashtable_info* info, uint8T* slot, void* key, void* val)
+{
+	Runtime_hashtable_value_assign(info->keyType, info->keyTypeInfo, info->keyStride, slot, key);
+	Runtime_hashtable_value_assign(info->valueType, info->valTypeInfo, info->valStride, slot + info->valOffset, val);
+}
+
+Runtime_hashtable_handle Runtime_hashtable_new_copy(Runtime_hashtable_handle rhs);
+
+//handles get a deep copy for a new owner, anything else is 
+//returned as is, value_assign copies it
+void* Runtime_hashtable_value_dup(Runtime_TypeDescriptor type, void* val)
+{
+	switch (type) {
+		case typeString: {
+			return Runtime_string_new_copy((Runtime_string_handle)val);
+		} break;
+
+		case typeArray: {
+			return Runtime_array_new_copy((Runtime_array_handle)val);
+		} break;
+
+		case typeDictionary: {
+			return Runtime_hashtable_new_copy((Runtime_hashtable_handle)val);
+		} break;
+
+		case typeSet: {
+			return Runtime_set_new_copy((Runtime_set_handle)val);
+		} break;
+
+		default: {
+		} break;
+	}
+
+	return val;
+}
+
+void Runtime_hashtable_destroy_value(Runtime_TypeDescriptor type, Runtime_type_info* typeInfo, void* data)
+{
+	switch (type) {
+		case typeString: {
+			//just a pointer, need to free up the string object
+			Runtime_string_delete(*(Runtime_string_handle*)data);
+		} break;
+
+		case typeArray: {
+			Runtime_array_delete(*(Runtime_array_handle*)data);
+		} break;
+
+		case typeDictionary: {
+			Runtime_dictionary_delete(*(Runtime_dictionary_handle*)data);
+		} break;
+
+		case typeSet: {
+			Runtime_set_delete(*(Runtime_set_handle*)data);
+		} break;
+
+		default: {
+			//data embedded in the slot, user types may need to clean up
+			if (nullptr != typeInfo->destroy) {
+				typeInfo->destroy(data);
+			}
+		} break;
+	}
+}
+
+void Runtime_hashtable_slot_destroy(Runtime_hashtable_info* info, uint8T* slot)
+{
+	Runtime_hashtable_destroy_value(info->keyType, info->keyTypeInfo, slot);
+	Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, slot + info->valOffset);
+}
+
+
+
+//group matching, bit i of the result is set if ctrl[pos + i] matches
+inline uint32T Runtime_hashtable_group_match(const int8T* ctrl, int8T h2)
+{
+	__m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+	return (uint32T)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+}
+
+inline uint32T Runtime_hashtable_group_match_empty(const int8T* ctrl)
+{
+	return Runtime_hashtable_group_match(ctrl, (int8T)rtHashCtrlEmpty);
+}
+
+//empty and deleted both have the high bit set, full slots don't
+inline uint32T Runtime_hashtable_group_match_empty_or_deleted(const int8T* ctrl)
+{
+	__m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+	return (uint32T)_mm_movemask_epi8(group);
+}
+
+inline uint32T Runtime_hashtable_lowest_bit(uint32T mask)
+{
+	unsigned long idx = 0;
+	_BitScanForward(&idx, mask);
+	return idx;
+}
+
+inline uint64T Runtime_hashtable_h1(uint64T hash)
+{
+	return hash >> 7;
+}
+
+inline int8T Runtime_hashtable_h2(uint64T hash)
+{
+	return (int8T)(hash & 0x7F);
+}
+
+inline uint64T Runtime_hashtable_max_load(uint64T capacity, double maxUsageFactor)
+{
+	uint64T result = ((double)capacity) * maxUsageFactor;
+	//always keep at least one empty slot so probing terminates
+	return result >= capacity ? capacity - 1 : result;
+}
+
+inline void Runtime_hashtable_set_ctrl(Runtime_hashtable_block* block, uint64T idx, int8T h)
+{
+	block->ctrl[idx] = h;
+	if (idx < RUNTIME_HASHTABLE_GROUP_WIDTH) {
+		block->ctrl[block->capacity + idx] = h;
+	}
+}
+
+
+//probes for key, returns the slot index or RUNTIME_HASHTABLE_NO_INDEX
+//probe sequence is triangular over groups, which visits every 
+//group once for a power of 2 capacity
+template<typename KeyEqT>
+uint64T Runtime_hashtable_block_find(Runtime_hashtable_block* block, uint64T hash, const KeyEqT& keyEquals)
+{
+	if (0 == block->capacity) {
+		return RUNTIME_HASHTABLE_NO_INDEX;
+	}
+
+	uint64T mask = block->capacity - 1;
+	uint64T pos = Runtime_hashtable_h1(hash) & mask;
+	int8T h2 = Runtime_hashtable_h2(hash);
+	uint64T step = 0;
+
+	while (true) {
+		const int8T* group = block->ctrl + pos;
+		uint32T match = Runtime_hashtable_group_match(group, h2);
+		while (0 != match) {
+			uint64T idx = (pos + Runtime_hashtable_lowest_bit(match)) & mask;
+			if (keyEquals(idx)) {
+				return idx;
+			}
+			match &= match - 1;
+		}
+
+		if (0 != Runtime_hashtable_group_match_empty(group)) {
+			return RUNTIME_HASHTABLE_NO_INDEX;
+		}
+
+		step += RUNTIME_HASHTABLE_GROUP_WIDTH;
+		if (step > block->capacity) {
+			//every group visited
+			return RUNTIME_HASHTABLE_NO_INDEX;
+		}
+		pos = (pos + step) & mask;
+	}
+}
+
+//first empty or deleted slot on the probe sequence for hash
+uint64T Runtime_hashtable_block_find_insert_pos(Runtime_hashtable_block* block, uint64T hash)
+{
+	uint64T mask = block->capacity - 1;
+	uint64T pos = Runtime_hashtable_h1(hash) & mask;
+	uint64T step = 0;
+
+	while (true) {
+		uint32T match = Runtime_hashtable_group_match_empty_or_deleted(block->ctrl + pos);
+		if (0 != match) {
+			return (pos + Runtime_hashtable_lowest_bit(match)) & mask;
+		}
+
+		step += RUNTIME_HASHTABLE_GROUP_WIDTH;
+		pos = (pos + step) & mask;
+	}
+}
+
+
+struct Runtime_hashtable_key_matcher {
+	Runtime_hashtable_object* hashTable;
+	Runtime_hashtable_block* block;
+	void* key;
+
+	inline bool operator()(uint64T idx) const {
+		auto info = hashTable->infoPtr;
+		auto data = Runtime_hashtable_slot_data(hashTable, block, idx);
+		return Runtime_hashtable_key_equals(info, Runtime_hashtable_slot_key_ref(info, data), key);
+	}
+};
+
+inline uint64T Runtime_hashtable_block_find_key(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* block, uint64T hash, void* key)
+{
+	Runtime_hashtable_key_matcher matcher = { hashTable, block, key };
+	return Runtime_hashtable_block_find(block, hash, matcher);
+}
+
+
+//ctrl size is always a multiple of the group width, fill a
+//group at a time, the byte at a time memset is too slow for 
+//big tables
+void Runtime_hashtable_ctrl_reset(Runtime_hashtable_block* block)
+{
+	__m128i empty = _mm_set1_epi8((int8T)rtHashCtrlEmpty);
+	uint64T ctrlSize = block->capacity + RUNTIME_HASHTABLE_GROUP_WIDTH;
+
+	for (uint64T pos = 0; pos < ctrlSize; pos += RUNTIME_HASHTABLE_GROUP_WIDTH) {
+		_mm_storeu_si128((__m128i*)(block->ctrl + pos), empty);
+	}
+}
+
+void Runtime_hashtable_block_alloc(Runtime_hashtable_block* block, uint64T capacity, uint64T stride)
+{
+	RUNTIME_ASSERT(0 == (capacity & (capacity - 1)));
+	RUNTIME_ASSERT(capacity >= RUNTIME_HASHTABLE_MIN_CAPACITY);
+
+	//ctrl bytes and slots share one allocation, 
+	//slots start 16 byte aligned
+	uint64T ctrlSize = capacity + RUNTIME_HASHTABLE_GROUP_WIDTH;
+	uint64T slotsSize = capacity * stride;
+
+	auto mem = (uint8T*)Runtime_alloc(ctrlSize + slotsSize, typeUnknown);
+
+	block->ctrl = (int8T*)mem;
+	block->slots = mem + ctrlSize;
+	block->capacity = capacity;
+	block->stride = stride;
+
+	Runtime_hashtable_ctrl_reset(block);
+}
+
+void Runtime_hashtable_block_free(Runtime_hashtable_block* block)
+{
+	if (nullptr != block->ctrl) {
+		Runtime_free(block->ctrl);
+	}
+	block->ctrl = nullptr;
+	block->slots = nullptr;
+	block->capacity = 0;
+	block->stride = 0;
+}
+
+//calls func(slotIndex) for every full slot
+template<typename FuncT>
+void Runtime_hashtable_block_for_each(Runtime_hashtable_block* block, const FuncT& func)
+{
+	for (uint64T pos = 0; pos < block->capacity; pos += RUNTIME_HASHTABLE_GROUP_WIDTH) {
+		uint32T full = (~Runtime_hashtable_group_match_empty_or_deleted(block->ctrl + pos)) & 0xFFFF;
+		while (0 != full) {
+			func(pos + Runtime_hashtable_lowest_bit(full));
+			full &= full - 1;
+		}
+	}
+}
+
+//moves the slot at srcIdx into dest. Slots are moved bitwise,
+//nothing is copied or destroyed
+inline void Runtime_hashtable_block_move_slot(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* src, uint64T srcIdx, Runtime_hashtable_block* dest)
+{
+	auto hash = Runtime_hashtable_slot_hash(hashTable, src, srcIdx);
+	auto destIdx = Runtime_hashtable_block_find_insert_pos(dest, hash);
+
+	Runtime_hashtable_set_ctrl(dest, destIdx, Runtime_hashtable_h2(hash));
+	Runtime_mem_cpy(Runtime_hashtable_slot(src, srcIdx), Runtime_hashtable_slot(dest, destIdx), dest->stride);
+}
+
+//moves every entry of src into dest, dest must be empty
+//and big enough
+void Runtime_hashtable_block_move_all(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* src, Runtime_hashtable_block* dest)
+{
+	Runtime_hashtable_block_for_each(src, [hashTable, src, dest](uint64T idx) {
+		Runtime_hashtable_block_move_slot(hashTable, src, idx, dest);
+	});
+}
+
+
+uint64T Runtime_hashtable_round_capacity(uint64T capacity)
+{
+	uint64T result = RUNTIME_HASHTABLE_MIN_CAPACITY;
+	while (result < capacity) {
+		result <<= 1;
+	}
+	return result;
+}
+
+//ordered tables only store the entry index in the slot
+inline uint64T Runtime_hashtable_slot_stride(Runtime_hashtable_object* hashTable)
+{
+	return hashTable->ordered ? sizeof(uint64T) : hashTable->infoPtr->slotStride;
+}
+
+
+inline bool Runtime_hashtable_is_migrating(Runtime_hashtable_object* hashTable)
+{
+	return nullptr != hashTable->oldTable.ctrl;
+}
+
+//moves up to groupCount groups of the old table into the live
+//one, frees the old table once everything has been moved
+void Runtime_hashtable_migrate(Runtime_hashtable_object* hashTable, uint64T groupCount)
+{
+	if (!Runtime_hashtable_is_migrating(hashTable)) {
+		return;
+	}
+
+	auto src = &hashTable->oldTable;
+	auto dest = &hashTable->table;
+
+	uint64T end = src->capacity;
+	if ((src->capacity - hashTable->migratePos) / RUNTIME_HASHTABLE_GROUP_WIDTH > groupCount) {
+		end = hashTable->migratePos + groupCount * RUNTIME_HASHTABLE_GROUP_WIDTH;
+	}
+
+	for (uint64T pos = hashTable->migratePos; pos < end; pos += RUNTIME_HASHTABLE_GROUP_WIDTH) {
+		uint32T full = (~Runtime_hashtable_group_match_empty_or_deleted(src->ctrl + pos)) & 0xFFFF;
+		while (0 != full) {
+			uint64T idx = pos + Runtime_hashtable_lowest_bit(full);
+
+			Runtime_hashtable_block_move_slot(hashTable, src, idx, dest);
+			Runtime_hashtable_set_ctrl(src, idx, (int8T)rtHashCtrlDeleted);
+
+			full &= full - 1;
+		}
+	}
+
+	hashTable->migratePos = end;
+	if (end >= src->capacity) {
+		Runtime_hashtable_block_free(src);
+		hashTable->migratePos = 0;
+	}
+}
+
+inline void Runtime_hashtable_migrate_all(Runtime_hashtable_object* hashTable)
+{
+	Runtime_hashtable_migrate(hashTable, RUNTIME_HASHTABLE_NO_INDEX);
+}
+
+//switches to a new table of newCapacity slots, entries
+//are moved over by later calls to Runtime_hashtable_migrate
+void Runtime_hashtable_start_resize(Runtime_hashtable_object* hashTable, uint64T newCapacity)
+{
+	RUNTIME_ASSERT(!Runtime_hashtable_is_migrating(hashTable));
+
+	hashTable->oldTable = hashTable->table;
+	hashTable->migratePos = 0;
+
+	Runtime_hashtable_block_alloc(&hashTable->table, newCapacity, Runtime_hashtable_slot_stride(hashTable));
+	hashTable->resizeCount++;
+	//everything still in the old table will need a slot
+	hashTable->growthLeft = Runtime_hashtable_max_load(newCapacity, hashTable->maxUsageFactor) - hashTable->size;
+}
+
+//rebuilds the table with newCapacity slots, also drops tombstones
+void Runtime_hashtable_rehash(Runtime_hashtable_object* hashTable, uint64T newCapacity)
+{
+	Runtime_hashtable_migrate_all(hashTable);
+
+	Runtime_hashtable_block newTable;
+	Runtime_hashtable_block_alloc(&newTable, newCapacity, Runtime_hashtable_slot_stride(hashTable));
+
+	Runtime_hashtable_block_move_all(hashTable, &hashTable->table, &newTable);
+	Runtime_hashtable_block_free(&hashTable->table);
+
+	hashTable->table = newTable;
+	hashTable->growthLeft = Runtime_hashtable_max_load(newCapacity, hashTable->maxUsageFactor) - hashTable->size;
+	hashTable->resizeCount++;
+}
+
+//called when growthLeft hits 0
+void Runtime_hashtable_grow(Runtime_hashtable_object* hashTable)
+{
+	//only happens if the growth factor is too small for a resize
+	//to finish before the new table fills up
+	Runtime_hashtable_migrate_all(hashTable);
+
+	auto capacity = hashTable->table.capacity;
+	auto maxLoad = Runtime_hashtable_max_load(capacity, hashTable->maxUsageFactor);
+
+	//mostly tombstones, rebuild at the same size
+	uint64T newCapacity = capacity;
+
+	if (hashTable->size > maxLoad / 2) {
+		double growBy = hashTable->capacityGrowthFactor > 1.0 ? hashTable->capacityGrowthFactor : RUTNIME_HASHTABLE_DEF_CAPCITY_GROW;
+		newCapacity = Runtime_hashtable_round_capacity((uint64T)((double)capacity * growBy));
+		if (newCapacity <= capacity) {
+			newCapacity = capacity * 2;
+		}
+	}
+
+	if (hashTable->incrementalResize && capacity >= RUNTIME_HASHTABLE_INCREMENTAL_MIN_CAPACITY) {
+		Runtime_hashtable_start_resize(hashTable, newCapacity);
+	}
+	else {
+		Runtime_hashtable_rehash(hashTable, newCapacity);
+	}
+}
+
+//ordered tables, entry array management
+
+void Runtime_hashtable_entries_reserve(Runtime_hashtable_object* hashTable, uint64T count)
+{
+	if (count <= hashTable->entryCapacity) {
+		return;
+	}
+
+	auto entryStride = hashTable->infoPtr->entryStride;
+	uint64T newCapacity = hashTable->entryCapacity < RUNTIME_HASHTABLE_MIN_CAPACITY ? RUNTIME_HASHTABLE_MIN_CAPACITY : hashTable->entryCapacity * 2;
+	while (newCapacity < count) {
+		newCapacity *= 2;
+	}
+
+	auto newEntries = (uint8T*)Runtime_alloc(newCapacity * entryStride, typeUnknown);
+	if (nullptr != hashTable->entries) {
+		Runtime_mem_cpy(hashTable->entries, newEntries, hashTable->entryCount * entryStride);
+		Runtime_free(hashTable->entries);
+	}
+
+	hashTable->entries = newEntries;
+	hashTable->entryCapacity = newCapacity;
+}
+
+//drops erased entries, keeping the order of the rest, and
+//rebuilds the table slots to point at the new positions
+void Runtime_hashtable_entries_compact(Runtime_hashtable_object* hashTable)
+{
+	Runtime_hashtable_migrate_all(hashTable);
+
+	auto info = hashTable->infoPtr;
+	auto block = &hashTable->table;
+	uint64T live = 0;
+
+	Runtime_hashtable_ctrl_reset(block);
+
+	for (uint64T e = 0; e < hashTable->entryCount; e++) {
+		auto entry = Runtime_hashtable_entry(hashTable, e);
+		auto hash = *Runtime_hashtable_entry_hash(info, entry);
+		if (0 != (hash & RUNTIME_HASHTABLE_ENTRY_ERASED)) {
+			continue;
+		}
+
+		if (live != e) {
+			Runtime_mem_cpy(entry, Runtime_hashtable_entry(hashTable, live), info->entryStride);
+		}
+
+		auto idx = Runtime_hashtable_block_find_insert_pos(block, hash);
+		Runtime_hashtable_set_ctrl(block, idx, Runtime_hashtable_h2(hash));
+		*(uint64T*)Runtime_hashtable_slot(block, idx) = live;
+
+		live++;
+	}
+
+	RUNTIME_ASSERT(live == hashTable->size);
+
+	hashTable->entryCount = live;
+	hashTable->erasedCount = 0;
+	hashTable->growthLeft = Runtime_hashtable_max_load(block->capacity, hashTable->maxUsageFactor) - live;
+}
+
+
+//small map
+
+inline uint8T* Runtime_hashtable_small_entry(Runtime_hashtable_object* hashTable, uint64T idx)
+{
+	return hashTable->smallEntries + idx * hashTable->infoPtr->slotStride;
+}
+
+//bit i set if smallTags[i] == tag
+inline uint32T Runtime_hashtable_small_match(Runtime_hashtable_object* hashTable, uint32T tag)
+{
+	__m128i needle = _mm_set1_epi32((int32T)tag);
+	__m128i lo = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)hashTable->smallTags), needle);
+	__m128i hi = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(hashTable->smallTags + 4)), needle);
+
+	uint32T result = (uint32T)_mm_movemask_ps(_mm_castsi128_ps(lo)) | ((uint32T)_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+	return result & ((1u << hashTable->size) - 1);
+}
+
+uint64T Runtime_hashtable_small_find(Runtime_hashtable_object* hashTable, uint64T hash, void* key)
+{
+	auto info = hashTable->infoPtr;
+	uint32T match = Runtime_hashtable_small_match(hashTable, (uint32T)hash);
+
+	while (0 != match) {
+		uint64T idx = Runtime_hashtable_lowest_bit(match);
+		auto entry = Runtime_hashtable_small_entry(hashTable, idx);
+		if (Runtime_hashtable_key_equals(info, Runtime_hashtable_slot_key_ref(info, entry), key)) {
+			return idx;
+		}
+		match &= match - 1;
+	}
+
+	return RUNTIME_HASHTABLE_NO_INDEX;
+}
+
+//moves the small map entries into a full table of capacity slots,
+//keeping their order for ordered tables
+void Runtime_hashtable_small_to_table(Runtime_hashtable_object* hashTable, uint64T capacity)
+{
+	RUNTIME_ASSERT(hashTable->small);
+
+	auto info = hashTable->infoPtr;
+	auto block = &hashTable->table;
+
+	Runtime_hashtable_block_alloc(block, capacity, Runtime_hashtable_slot_stride(hashTable));
+	if (hashTable->ordered) {
+		Runtime_hashtable_entries_reserve(hashTable, hashTable->size);
+	}
+
+	for (uint64T i = 0; i < hashTable->size; i++) {
+		auto data = Runtime_hashtable_small_entry(hashTable, i);
+		auto hash = Runtime_hashtable_hash_key(info, Runtime_hashtable_slot_key_ref(info, data));
+		auto idx = Runtime_hashtable_block_find_insert_pos(block, hash);
+		Runtime_hashtable_set_ctrl(block, idx, Runtime_hashtable_h2(hash));
+
+		if (hashTable->ordered) {
+			auto entry = Runtime_hashtable_entry(hashTable, i);
+			Runtime_mem_cpy(data, entry, info->slotStride);
+			*Runtime_hashtable_entry_hash(info, entry) = hash;
+			*(uint64T*)Runtime_hashtable_slot(block, idx) = i;
+		}
+		else {
+			Runtime_mem_cpy(data, Runtime_hashtable_slot(block, idx), info->slotStride);
+		}
+	}
+
+	hashTable->entryCount = hashTable->ordered ? hashTable->size : 0;
+	hashTable->growthLeft = Runtime_hashtable_max_load(capacity, hashTable->maxUsageFactor) - hashTable->size;
+	hashTable->small = false;
+	//sizing an empty table isn't a resize
+	if (0 != hashTable->size) {
+		hashTable->resizeCount++;
+	}
+}
+
+
+//finds the key/value data for key in either table, 
+//blockPtr/idxPtr are set to the slot it was found in
+uint8T* Runtime_hashtable_find_slot(Runtime_hashtable_object* hashTable, uint64T hash, void* key, Runtime_hashtable_block** blockPtr, uint64T* idxPtr)
+{
+	if (hashTable->small) {
+		auto idx = Runtime_hashtable_small_find(hashTable, hash, key);
+		if (RUNTIME_HASHTABLE_NO_INDEX == idx) {
+			return nullptr;
+		}
+		if (nullptr != blockPtr) {
+			*blockPtr = nullptr;
+			*idxPtr = idx;
+		}
+		return Runtime_hashtable_small_entry(hashTable, idx);
+	}
+
+	auto block = &hashTable->table;
+	auto idx = Runtime_hashtable_block_find_key(hashTable, block, hash, key);
+
+	if (RUNTIME_HASHTABLE_NO_INDEX == idx && Runtime_hashtable_is_migrating(hashTable)) {
+		block = &hashTable->oldTable;
+		idx = Runtime_hashtable_block_find_key(hashTable, block, hash, key);
+	}
+
+	if (RUNTIME_HASHTABLE_NO_INDEX == idx) {
+		return nullptr;
+	}
+
+	if (nullptr != blockPtr) {
+		*blockPtr = block;
+		*idxPtr = idx;
+	}
+	return Runtime_hashtable_slot_data(hashTable, block, idx);
+}
+
+
+Runtime_hashtable_info* Runtime_get_hashtable_info_for_type(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+{
+	auto keySlot = Runtime_type_slot(keyType);
+	auto valSlot = Runtime_type_slot(valType);
+	if (RUNTIME_NO_TYPE_SLOT == keySlot || RUNTIME_NO_TYPE_SLOT == valSlot) {
+		return nullptr;
+	}
+
+	auto row = runtimeInstancePtr->hashtableInfoRows[keySlot];
+	if (nullptr == row) {
+		row = (Runtime_hashtable_info*)Runtime_alloc(sizeof(Runtime_hashtable_info) * runtimeInstancePtr->typeSlotCapacity, typeUnknown);
+		Runtime_Memory_init(row, sizeof(Runtime_hashtable_info) * runtimeInstancePtr->typeSlotCapacity);
+
+		for (uint32T v = 0; v < runtimeInstancePtr->arrayInfoListSize; v++) {
+			Runtime_hashtable_info_init(&row[v], keySlot, v);
+		}
+		runtimeInstancePtr->hashtableInfoRows[keySlot] = row;
+	}
+
+	return &row[valSlot];
+}
+
+
+Runtime_hashtable_handle Runtime_hashtable_new_with_info(uint64T initialSize, Runtime_hashtable_info* hashTableInfo, bool ordered)
+{
+	Runtime_hashtable_object* result = nullptr;
+
+	//small map entries live right after the object, so
+	//a table with a few entries is a single allocation
+	uint64T objectSize = (sizeof(Runtime_hashtable_object) + 15) & ~15;
+	uint64T allocSize = objectSize + RUNTIME_HASHTABLE_SMALL_CAPACITY * hashTableInfo->slotStride;
+
+	auto memPtr = Runtime_alloc(allocSize, typeDictionary);
+	result = (Runtime_hashtable_object*)memPtr;
+	Runtime_Memory_init(result, sizeof(Runtime_hashtable_object));
+	
+	result->size = 0;
+	result->infoPtr = hashTableInfo;
+	result->capacityGrowthFactor = RUTNIME_HASHTABLE_DEF_CAPCITY_GROW;
+	result->maxUsageFactor = RUTNIME_HASHTABLE_DEF_MAX_USAGE;
+	result->incrementalResize = true;
+	result->ordered = ordered;
+	result->small = true;
+	result->smallEntries = (uint8T*)memPtr + objectSize;
+
+	if (initialSize > RUNTIME_HASHTABLE_SMALL_CAPACITY) {
+		Runtime_hashtable_small_to_table(result, Runtime_hashtable_round_capacity(initialSize));
+	}
+
+	//stats are opt in, don't make every create take the lock
+	if (0 != runtimeInstancePtr->hashtableStatsDumpCount) {
+		Win32_lock_acquire(&runtimeInstancePtr->hashtableStatsLock);
+		result->liveListed = true;
+		result->liveNext = runtimeInstancePtr->liveHashtables;
+		if (nullptr != result->liveNext) {
+			result->liveNext->livePrev = result;
+		}
+		runtimeInstancePtr->liveHashtables = result;
+		Win32_lock_release(&runtimeInstancePtr->hashtableStatsLock);
+	}
+
+	return (Runtime_hashtable_handle)result;
+}
+
+Runtime_hashtable_handle Runtime_hashtable_new_struct(uint64T initialSize, Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType, bool ordered)
+{
+	auto hashTableInfo = Runtime_get_hashtable_info_for_type(keyType, valType);
+	RUNTIME_ASSERT(nullptr != hashTableInfo);
+
+	return Runtime_hashtable_new_with_info(initialSize, hashTableInfo, ordered);
+}
+
+
+#define DEFAULT_HASHTABLE_CAPACITY  RUNTIME_HASHTABLE_SMALL_CAPACITY
+
+Runtime_hashtable_handle Runtime_hashtable_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+{
+	Runtime_hashtable_handle result = Runtime_hashtable_new_struct(DEFAULT_HASHTABLE_CAPACITY, keyType, valType, false);
+
+	return result;
+}
+
+Runtime_hashtable_handle Runtime_hashtable_new_ordered(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+{
+	Runtime_hashtable_handle result = Runtime_hashtable_new_struct(DEFAULT_HASHTABLE_CAPACITY, keyType, valType, true);
+
+	return result;
+}
+
+void Runtime_hashtable_stats_record(Runtime_hashtable_handle self);
+
+void Runtime_hashtable_delete(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;	
+
+	if (0 != runtimeInstancePtr->hashtableStatsDumpCount) {
+		Runtime_hashtable_stats_record(self);
+	}
+
+	if (hashTable->liveListed) {
+		Win32_lock_acquire(&runtimeInstancePtr->hashtableStatsLock);
+		if (nullptr != hashTable->livePrev) {
+			hashTable->livePrev->liveNext = hashTable->liveNext;
+		}
+		else {
+			runtimeInstancePtr->liveHashtables = hashTable->liveNext;
+		}
+		if (nullptr != hashTable->liveNext) {
+			hashTable->liveNext->livePrev = hashTable->livePrev;
+		}
+		Win32_lock_release(&runtimeInstancePtr->hashtableStatsLock);
+	}
+
+	Runtime_hashtable_clear(self);
+
+	Runtime_hashtable_block_free(&hashTable->table);
+	if (nullptr != hashTable->entries) {
+		Runtime_free(hashTable->entries);
+	}
+	Runtime_free(self);
+}
+
+
+bool Runtime_hashtable_empty(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	
+	return 0 == hashTable->size;
+}
+
+uint64T Runtime_hashtable_size(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+
+	return hashTable->size;
+}
+
+uint64T Runtime_hashtable_capacity(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	return hashTable->small ? RUNTIME_HASHTABLE_SMALL_CAPACITY : hashTable->table.capacity;
+}
+
+bool Runtime_hashtable_is_ordered(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	return hashTable->ordered;
+}
+
+bool Runtime_hashtable_incremental_resize(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	return hashTable->incrementalResize;
+}
+
+void Runtime_hashtable_set_incremental_resize(Runtime_hashtable_handle self, bool val)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	hashTable->incrementalResize = val;
+	if (!val) {
+		Runtime_hashtable_migrate_all(hashTable);
+	}
+}
+
+double Runtime_hashtable_max_usage_factor(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	return hashTable->maxUsageFactor;
+}
+
+void Runtime_hashtable_set_max_usage_factor(Runtime_hashtable_handle self, double val)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	RUNTIME_ASSERT(val > 0.0 && val <= 1.0);
+
+	hashTable->maxUsageFactor = val;
+
+	//rebuild so growthLeft is exact for the new factor
+	if (!hashTable->small) {
+		Runtime_hashtable_set_capacity(self, hashTable->table.capacity);
+	}
+}
+
+double Runtime_hashtable_capacity_grow_by(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	return hashTable->capacityGrowthFactor;
+}
+
+void Runtime_hashtable_set_capacity_grow_by(Runtime_hashtable_handle self, double val)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	hashTable->capacityGrowthFactor = val;
+}
+
+
+//capacity is rounded up to a power of 2 that can hold
+//the current entries under the max usage factor
+void Runtime_hashtable_set_capacity(Runtime_hashtable_handle self, uint64T capacity)
+{
+	RUNTIME_ASSERT(capacity!=0);
+	RUNTIME_ASSERT(nullptr != self);
+
+	auto hashTable = (Runtime_hashtable_object*)self;
+
+	if (hashTable->small && capacity <= RUNTIME_HASHTABLE_SMALL_CAPACITY) {
+		return;
+	}
+
+	auto newCapacity = Runtime_hashtable_round_capacity(capacity);
+	while (Runtime_hashtable_max_load(newCapacity, hashTable->maxUsageFactor) <= hashTable->size) {
+		newCapacity <<= 1;
+	}
+
+	if (hashTable->small) {
+		Runtime_hashtable_small_to_table(hashTable, newCapacity);
+	}
+	else {
+		Runtime_hashtable_rehash(hashTable, newCapacity);
+	}
+}
+
+void Runtime_hashtable_clear(Runtime_hashtable_handle self)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto info = hashTable->infoPtr;
+	auto block = &hashTable->table;
+	auto oldBlock = &hashTable->oldTable;
+
+	if (hashTable->small) {
+		for (uint64T i = 0; i < hashTable->size; i++) {
+			Runtime_hashtable_slot_destroy(info, Runtime_hashtable_small_entry(hashTable, i));
+		}
+		hashTable->size = 0;
+		return;
+	}
+
+	if (hashTable->ordered) {
+		for (uint64T e = 0; e < hashTable->entryCount; e++) {
+			auto entry = Runtime_hashtable_entry(hashTable, e);
+			if (0 == (*Runtime_hashtable_entry_hash(info, entry) & RUNTIME_HASHTABLE_ENTRY_ERASED)) {
+				Runtime_hashtable_slot_destroy(info, entry);
+			}
+		}
+		hashTable->entryCount = 0;
+		hashTable->erasedCount = 0;
+	}
+	else {
+		Runtime_hashtable_block_for_each(block, [info, block](uint64T idx) {
+			Runtime_hashtable_slot_destroy(info, Runtime_hashtable_slot(block, idx));
+		});
+
+		if (Runtime_hashtable_is_migrating(hashTable)) {
+			Runtime_hashtable_block_for_each(oldBlock, [info, oldBlock](uint64T idx) {
+				Runtime_hashtable_slot_destroy(info, Runtime_hashtable_slot(oldBlock, idx));
+			});
+		}
+	}
+
+	if (Runtime_hashtable_is_migrating(hashTable)) {
+		Runtime_hashtable_block_free(oldBlock);
+		hashTable->migratePos = 0;
+	}
+
+	Runtime_hashtable_ctrl_reset(block);
+
+	hashTable->size = 0;
+	hashTable->growthLeft = Runtime_hashtable_max_load(block->capacity, hashTable->maxUsageFactor);
+}
+
+//makes room for a key that isn't in the table yet, growing or
+//leaving small map mode if needed. Returns where the key/value
+//data goes, the caller fills it in
+uint8T* Runtime_hashtable_claim_slot(Runtime_hashtable_object* hashTable, uint64T hash)
+{
+	auto info = hashTable->infoPtr;
+
+	if (hashTable->small) {
+		if (hashTable->size < RUNTIME_HASHTABLE_SMALL_CAPACITY) {
+			hashTable->smallTags[hashTable->size] = (uint32T)hash;
+			return Runtime_hashtable_small_entry(hashTable, hashTable->size++);
+		}
+
+		Runtime_hashtable_small_to_table(hashTable, RUNTIME_HASHTABLE_SMALL_CAPACITY * 2);
+	}
+
+	auto idx = Runtime_hashtable_block_find_insert_pos(&hashTable->table, hash);
+
+	//reusing a tombstone doesn't use up growth
+	if (0 == hashTable->growthLeft && rtHashCtrlDeleted != hashTable->table.ctrl[idx]) {
+		Runtime_hashtable_grow(hashTable);
+		idx = Runtime_hashtable_block_find_insert_pos(&hashTable->table, hash);
+	}
+
+	if (rtHashCtrlEmpty == hashTable->table.ctrl[idx]) {
+		hashTable->growthLeft--;
+	}
+
+	Runtime_hashtable_set_ctrl(&hashTable->table, idx, Runtime_hashtable_h2(hash));
+
+	auto slot = Runtime_hashtable_slot(&hashTable->table, idx);
+	if (hashTable->ordered) {
+		Runtime_hashtable_entries_reserve(hashTable, hashTable->entryCount + 1);
+
+		auto entryIdx = hashTable->entryCount++;
+		*(uint64T*)slot = entryIdx;
+
+		slot = Runtime_hashtable_entry(hashTable, entryIdx);
+		*Runtime_hashtable_entry_hash(info, slot) = hash;
+	}
+
+	hashTable->size++;
+	return slot;
+}
+
+
+//inserting an existing key replaces both the key and the value, the 
+//old ones are destroyed. The table owns string/array/dictionary 
+//keys and values passed in. Ordered tables keep a replaced key in 
+//its original position
+void Runtime_hashtable_insert_hashed(Runtime_hashtable_object* hashTable, uint64T hash, void* key, void* val)
+{
+	auto info = hashTable->infoPtr;
+
+	Runtime_hashtable_migrate(hashTable, RUNTIME_HASHTABLE_MIGRATE_GROUPS);
+
+	auto slot = Runtime_hashtable_find_slot(hashTable, hash, key, nullptr, nullptr);
+
+	if (nullptr != slot) {
+		if (Runtime_hashtable_slot_key_ref(info, slot) != key) {
+			Runtime_hashtable_destroy_value(info->keyType, info->keyTypeInfo, slot);
+		}
+		if (Runtime_hashtable_slot_val_ref(info, slot) != val) {
+			Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, slot + info->valOffset);
+		}
+		Runtime_hashtable_slot_assign(info, slot, key, val);
+		return;
+	}
+
+	Runtime_hashtable_slot_assign(info, Runtime_hashtable_claim_slot(hashTable, hash), key, val);
+}
+
+void Runtime_hashtable_insert(Runtime_hashtable_handle self, void* key, void* val)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+
+	if (nullptr != hashTable->infoPtr->typedInsert) {
+		hashTable->infoPtr->typedInsert(self, key, val);
+		return;
+	}
+
+	Runtime_hashtable_insert_hashed(hashTable, Runtime_hashtable_hash_key(hashTable->infoPtr, key), key, val);
+}
+
+
+inline uint32T Runtime_hashtable_leading_zeros16(uint32T mask)
+{
+	unsigned long idx = 0;
+	_BitScanReverse(&idx, mask);
+	return 15 - idx;
+}
+
+//marks a slot as free. If no probe sequence can have passed 
+//through the slot while it was full (there's an empty slot
+//within a group width on both sides) it can go back to empty,
+//otherwise it has to be a tombstone
+void Runtime_hashtable_block_erase_at(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* block, uint64T idx)
+{
+	uint64T mask = block->capacity - 1;
+	uint64T idxBefore = (idx - RUNTIME_HASHTABLE_GROUP_WIDTH) & mask;
+
+	uint32T emptyAfter = Runtime_hashtable_group_match_empty(block->ctrl + idx);
+	uint32T emptyBefore = Runtime_hashtable_group_match_empty(block->ctrl + idxBefore);
+
+	bool wasNeverFull = 0 != emptyBefore && 0 != emptyAfter &&
+		(Runtime_hashtable_lowest_bit(emptyAfter) + Runtime_hashtable_leading_zeros16(emptyBefore)) < RUNTIME_HASHTABLE_GROUP_WIDTH;
+
+	Runtime_hashtable_set_ctrl(block, idx, wasNeverFull ? (int8T)rtHashCtrlEmpty : (int8T)rtHashCtrlDeleted);
+	if (wasNeverFull) {
+		hashTable->growthLeft++;
+	}
+}
+
+void Runtime_hashtable_erase_hashed(Runtime_hashtable_object* hashTable, uint64T hash, void* key)
+{
+	auto info = hashTable->infoPtr;
+
+	Runtime_hashtable_migrate(hashTable, RUNTIME_HASHTABLE_MIGRATE_GROUPS);
+
+	Runtime_hashtable_block* block = nullptr;
+	uint64T idx = 0;
+	auto slot = Runtime_hashtable_find_slot(hashTable, hash, key, &block, &idx);
+	if (nullptr == slot) {
+		return;
+	}
+
+	Runtime_hashtable_slot_destroy(info, slot);
+
+	if (hashTable->small) {
+		//keep the entries packed and in order
+		for (uint64T i = idx + 1; i < hashTable->size; i++) {
+			hashTable->smallTags[i - 1] = hashTable->smallTags[i];
+		}
+		Runtime_mem_cpy(Runtime_hashtable_small_entry(hashTable, idx + 1), slot, (hashTable->size - idx - 1) * info->slotStride);
+		hashTable->size--;
+		return;
+	}
+
+	if (block == &hashTable->table) {
+		Runtime_hashtable_block_erase_at(hashTable, block, idx);
+	}
+	else {
+		//old table is going away, no need to track growth
+		Runtime_hashtable_set_ctrl(block, idx, (int8T)rtHashCtrlDeleted);
+	}
+
+	hashTable->size--;
+
+	if (hashTable->ordered) {
+		*Runtime_hashtable_entry_hash(info, slot) |= RUNTIME_HASHTABLE_ENTRY_ERASED;
+		hashTable->erasedCount++;
+
+		if (hashTable->erasedCount > RUNTIME_HASHTABLE_MIN_CAPACITY && hashTable->erasedCount > hashTable->size) {
+			Runtime_hashtable_entries_compact(hashTable);
+		}
+	}
+}
+
+void Runtime_hashtable_erase(Runtime_hashtable_handle self, void* key)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+
+	Runtime_hashtable_erase_hashed(hashTable, Runtime_hashtable_hash_key(hashTable->infoPtr, key), key);
+}
+
+void* Runtime_hashtable_at(Runtime_hashtable_handle self, void* key)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto info = hashTable->infoPtr;
+
+	if (nullptr != info->typedAt) {
+		return info->typedAt(self, key);
+	}
+
+	//no migration here, so pointers returned by at() stay
+	//valid until the next insert/erase
+	auto hash = Runtime_hashtable_hash_key(info, key);
+	auto slot = Runtime_hashtable_find_slot(hashTable, hash, key, nullptr, nullptr);
+	if (nullptr == slot) {
+		return nullptr;
+	}
+
+	return Runtime_hashtable_slot_val_ref(info, slot);
+}
+
+
+//typed tables. Key/value pairs the compiler uses a lot get their 
+//own instantiation of insert/at, with the key hash/compare/store 
+//and the value store inlined, no type switches, strides or copy
+//hooks. Values are plain 4 or 8 byte data, which always starts 8
+//bytes into the slot for these key types. The generic insert/at 
+//forward to these through the info when the pair has one
+
+#define RUNTIME_HASHTABLE_TYPED_VAL_OFFSET	8
+
+struct Runtime_hashtable_int32_key {
+	typedef int32T KeyT;
+
+	static inline KeyT load(void* key) { return *(KeyT*)key; }
+	static inline uint64T hash(KeyT key) { return Runtime_hash_mix64((uint32T)key) & RUNTIME_HASHTABLE_HASH_MASK; }
+	static inline bool equals(uint8T* data, KeyT key) { return *(KeyT*)data == key; }
+	static inline void store(uint8T* data, KeyT key) { *(KeyT*)data = key; }
+	static inline void replace(uint8T* data, KeyT key) {}
+};
+
+struct Runtime_hashtable_int64_key {
+	typedef int64T KeyT;
+
+	static inline KeyT load(void* key) { return *(KeyT*)key; }
+	static inline uint64T hash(KeyT key) { return Runtime_hash_mix64((uint64T)key) & RUNTIME_HASHTABLE_HASH_MASK; }
+	static inline bool equals(uint8T* data, KeyT key) { return *(KeyT*)data == key; }
+	static inline void store(uint8T* data, KeyT key) { *(KeyT*)data = key; }
+	static inline void replace(uint8T* data, KeyT key) {}
+};
+
+//the table owns the string, replacing a key with an equal
+//string frees the old one, same as the generic insert
+struct Runtime_hashtable_string_key {
+	typedef Runtime_string_handle KeyT;
+
+	static inline KeyT load(void* key) { return (KeyT)key; }
+	static inline uint64T hash(KeyT key) { return Runtime_hash_mix64(Runtime_string_hash(key)) & RUNTIME_HASHTABLE_HASH_MASK; }
+	static inline bool equals(uint8T* data, KeyT key) { return Runtime_string_equals(*(KeyT*)data, key); }
+	static inline void store(uint8T* data, KeyT key) { *(KeyT*)data = key; }
+	static inline void replace(uint8T* data, KeyT key) {
+		if (*(KeyT*)data != key) {
+			Runtime_string_delete(*(KeyT*)data);
+			*(KeyT*)data = key;
+		}
+	}
+};
+
+
+template<typename KeyTraitsT>
+uint8T* Runtime_hashtable_typed_find(Runtime_hashtable_object* hashTable, uint64T hash, typename KeyTraitsT::KeyT key)
+{
+	if (hashTable->small) {
+		uint32T match = Runtime_hashtable_small_match(hashTable, (uint32T)hash);
+		while (0 != match) {
+			auto entry = Runtime_hashtable_small_entry(hashTable, Runtime_hashtable_lowest_bit(match));
+			if (KeyTraitsT::equals(entry, key)) {
+				return entry;
+			}
+			match &= match - 1;
+		}
+		return nullptr;
+	}
+
+	auto block = &hashTable->table;
+	auto matcher = [&](uint64T idx) { return KeyTraitsT::equals(Runtime_hashtable_slot_data(hashTable, block, idx), key); };
+	auto idx = Runtime_hashtable_block_find(block, hash, matcher);
+
+	if (RUNTIME_HASHTABLE_NO_INDEX == idx && Runtime_hashtable_is_migrating(hashTable)) {
+		block = &hashTable->oldTable;
+		idx = Runtime_hashtable_block_find(block, hash, matcher);
+	}
+
+	return RUNTIME_HASHTABLE_NO_INDEX == idx ? nullptr : Runtime_hashtable_slot_data(hashTable, block, idx);
+}
+
+inline void Runtime_hashtable_typed_check(Runtime_hashtable_object* hashTable, uint64T valSize)
+{
+#ifdef SCRATCH_RUNTIME_DEBUG
+	RUNTIME_ASSERT(RUNTIME_HASHTABLE_TYPED_VAL_OFFSET == hashTable->infoPtr->valOffset);
+	RUNTIME_ASSERT(valSize == hashTable->infoPtr->valStride);
+#endif
+}
+
+template<typename KeyTraitsT, typename ValT>
+void Runtime_hashtable_typed_insert(Runtime_hashtable_handle self, typename KeyTraitsT::KeyT key, ValT val)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	Runtime_hashtable_typed_check(hashTable, sizeof(ValT));
+
+	Runtime_hashtable_migrate(hashTable, RUNTIME_HASHTABLE_MIGRATE_GROUPS);
+
+	auto hash = KeyTraitsT::hash(key);
+	auto data = Runtime_hashtable_typed_find<KeyTraitsT>(hashTable, hash, key);
+	if (nullptr != data) {
+		KeyTraitsT::replace(data, key);
+	}
+	else {
+		data = Runtime_hashtable_claim_slot(hashTable, hash);
+		KeyTraitsT::store(data, key);
+	}
+
+	*(ValT*)(data + RUNTIME_HASHTABLE_TYPED_VAL_OFFSET) = val;
+}
+
+template<typename KeyTraitsT, typename ValT>
+ValT* Runtime_hashtable_typed_at(Runtime_hashtable_handle self, typename KeyTraitsT::KeyT key)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	Runtime_hashtable_typed_check(hashTable, sizeof(ValT));
+
+	auto data = Runtime_hashtable_typed_find<KeyTraitsT>(hashTable, KeyTraitsT::hash(key), key);
+	return nullptr == data ? nullptr : (ValT*)(data + RUNTIME_HASHTABLE_TYPED_VAL_OFFSET);
+}
+
+//adapters for the generic insert/at, key/val point at the 
+//data, or are the handle for string keys
+template<typename KeyTraitsT, typename ValT>
+void Runtime_hashtable_typed_insert_generic(Runtime_hashtable_handle self, void* key, void* val)
+{
+	Runtime_hashtable_typed_insert<KeyTraitsT, ValT>(self, KeyTraitsT::load(key), *(ValT*)val);
+}
+
+template<typename KeyTraitsT, typename ValT>
+void* Runtime_hashtable_typed_at_generic(Runtime_hashtable_handle self, void* key)
+{
+	return Runtime_hashtable_typed_at<KeyTraitsT, ValT>(self, KeyTraitsT::load(key));
+}
+
+template<typename KeyTraitsT>
+void Runtime_hashtable_info_select_typed_val(Runtime_hashtable_info* htInfo)
+{
+	switch (htInfo->valueType) {
+		case typeInteger32: case typeUInteger32: case typeDouble32: {
+			htInfo->typedInsert = Runtime_hashtable_typed_insert_generic<KeyTraitsT, uint32T>;
+			htInfo->typedAt = Runtime_hashtable_typed_at_generic<KeyTraitsT, uint32T>;
+		}break;
+
+		case typeInteger64: case typeUInteger64: case typeDouble64: {
+			htInfo->typedInsert = Runtime_hashtable_typed_insert_generic<KeyTraitsT, uint64T>;
+			htInfo->typedAt = Runtime_hashtable_typed_at_generic<KeyTraitsT, uint64T>;
+		}break;
+
+		default: {
+		}break;
+	}
+}
+
+void Runtime_hashtable_info_select_typed(Runtime_hashtable_info* htInfo)
+{
+	htInfo->typedInsert = nullptr;
+	htInfo->typedAt = nullptr;
+
+	switch (htInfo->keyType) {
+		case typeInteger32: case typeUInteger32: {
+			Runtime_hashtable_info_select_typed_val<Runtime_hashtable_int32_key>(htInfo);
+		}break;
+
+		case typeInteger64: case typeUInteger64: {
+			Runtime_hashtable_info_select_typed_val<Runtime_hashtable_int64_key>(htInfo);
+		}break;
+
+		case typeString: {
+			Runtime_hashtable_info_select_typed_val<Runtime_hashtable_string_key>(htInfo);
+		}break;
+
+		default: {
+		}break;
+	}
+}
+
+
+#define RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(suffix, KeyTraitsT, ValT) \
+	void Runtime_hashtable_insert_##suffix(Runtime_hashtable_handle self, KeyTraitsT::KeyT key, ValT val) \
+	{ \
+		Runtime_hashtable_typed_insert<KeyTraitsT, ValT>(self, key, val); \
+	} \
+	ValT* Runtime_hashtable_at_##suffix(Runtime_hashtable_handle self, KeyTraitsT::KeyT key) \
+	{ \
+		return Runtime_hashtable_typed_at<KeyTraitsT, ValT>(self, key); \
+	}
+
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(i32_i32, Runtime_hashtable_int32_key, int32T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(i32_i64, Runtime_hashtable_int32_key, int64T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(i32_f64, Runtime_hashtable_int32_key, double64T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(i64_i32, Runtime_hashtable_int64_key, int32T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(i64_i64, Runtime_hashtable_int64_key, int64T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(i64_f64, Runtime_hashtable_int64_key, double64T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(str_i32, Runtime_hashtable_string_key, int32T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(str_i64, Runtime_hashtable_string_key, int64T)
+RUNTIME_HASHTABLE_TYPED_ENTRY_POINTS(str_f64, Runtime_hashtable_string_key, double64T)
+
+
+
+//batches. All keys of a group are hashed and the control bytes and 
+//slots they land on prefetched before any of them is probed, so the 
+//cache misses for different keys overlap instead of being paid one
+//after the other.
+//Only the first probe group of each key is prefetched (its control 
+//bytes and the line of its first slot). Keys that probe further, or 
+//whose slot is past that line, still miss one at a time. Below the 
+//max usage factor most keys are found in the first group, so the 
+//extra lines aren't worth the bandwidth
+
+#define RUNTIME_HASHTABLE_BATCH_SIZE	16
+
+//keys/vals are laid out like array elements of the type, 
+//handle types are stored as the handle itself
+inline void* Runtime_hashtable_batch_item(Runtime_TypeDescriptor type, uint64T stride, void* items, uint64T idx)
+{
+	if (Runtime_type_is_handle(type)) {
+		return ((void**)items)[idx];
+	}
+	return (uint8T*)items + idx * stride;
+}
+
+inline void Runtime_hashtable_prefetch(Runtime_hashtable_block* block, uint64T hash)
+{
+	if (nullptr == block->ctrl) {
+		//small map
+		return;
+	}
+
+	uint64T pos = Runtime_hashtable_h1(hash) & (block->capacity - 1);
+
+	_mm_prefetch((const char*)(block->ctrl + pos), _MM_HINT_T0);
+	_mm_prefetch((const char*)Runtime_hashtable_slot(block, pos), _MM_HINT_T0);
+}
+
+//keys not moved over yet by an incremental resize are in oldTable
+inline void Runtime_hashtable_prefetch_key(Runtime_hashtable_object* hashTable, uint64T hash)
+{
+	Runtime_hashtable_prefetch(&hashTable->table, hash);
+	Runtime_hashtable_prefetch(&hashTable->oldTable, hash);
+}
+
+void Runtime_hashtable_insert_batch(Runtime_hashtable_handle self, void* keys, void* vals, uint64T count)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto info = hashTable->infoPtr;
+	uint64T hashes[RUNTIME_HASHTABLE_BATCH_SIZE];
+
+	for (uint64T start = 0; start < count; start += RUNTIME_HASHTABLE_BATCH_SIZE) {
+		uint64T groupSize = (count - start) < RUNTIME_HASHTABLE_BATCH_SIZE ? (count - start) : RUNTIME_HASHTABLE_BATCH_SIZE;
+
+		for (uint64T i = 0; i < groupSize; i++) {
+			auto key = Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, start + i);
+			hashes[i] = Runtime_hashtable_hash_key(info, key);
+			Runtime_hashtable_prefetch_key(hashTable, hashes[i]);
+		}
+
+		for (uint64T i = 0; i < groupSize; i++) {
+			auto key = Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, start + i);
+			auto val = Runtime_hashtable_batch_item(info->valueType, info->valStride, vals, start + i);
+			Runtime_hashtable_insert_hashed(hashTable, hashes[i], key, val);
+		}
+	}
+}
+
+void Runtime_hashtable_at_batch(Runtime_hashtable_handle self, void* keys, void** results, uint64T count)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto info = hashTable->infoPtr;
+	uint64T hashes[RUNTIME_HASHTABLE_BATCH_SIZE];
+
+	for (uint64T start = 0; start < count; start += RUNTIME_HASHTABLE_BATCH_SIZE) {
+		uint64T groupSize = (count - start) < RUNTIME_HASHTABLE_BATCH_SIZE ? (count - start) : RUNTIME_HASHTABLE_BATCH_SIZE;
+
+		for (uint64T i = 0; i < groupSize; i++) {
+			auto key = Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, start + i);
+			hashes[i] = Runtime_hashtable_hash_key(info, key);
+			Runtime_hashtable_prefetch_key(hashTable, hashes[i]);
+		}
+
+		for (uint64T i = 0; i < groupSize; i++) {
+			auto key = Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, start + i);
+			auto slot = Runtime_hashtable_find_slot(hashTable, hashes[i], key, nullptr, nullptr);
+			results[start + i] = (nullptr != slot) ? Runtime_hashtable_slot_val_ref(info, slot) : nullptr;
+		}
+	}
+}
+
+
+//iteration. pos is an entry index for ordered tables, for 
+//the others a slot index into the live table followed by 
+//the old table while a resize is going on
+
+//first full slot at or after pos, RUNTIME_HASHTABLE_NO_INDEX if none
+uint64T Runtime_hashtable_block_next_full(Runtime_hashtable_block* block, uint64T pos)
+{
+	while (pos < block->capacity) {
+		uint32T full = (~Runtime_hashtable_group_match_empty_or_deleted(block->ctrl + pos)) & 0xFFFF;
+		uint64T remaining = block->capacity - pos;
+		if (remaining < RUNTIME_HASHTABLE_GROUP_WIDTH) {
+			//skip the mirrored bytes
+			full &= (1u << remaining) - 1;
+		}
+
+		if (0 != full) {
+			return pos + Runtime_hashtable_lowest_bit(full);
+		}
+		pos += RUNTIME_HASHTABLE_GROUP_WIDTH;
+	}
+
+	return RUNTIME_HASHTABLE_NO_INDEX;
+}
+
+void Runtime_hashtable_iter_init(Runtime_hashtable_handle self, Runtime_hashtable_iter* iter)
+{
+	iter->table = self;
+	iter->pos = 0;
+	iter->key = nullptr;
+	iter->value = nullptr;
+}
+
+bool Runtime_hashtable_iter_next(Runtime_hashtable_iter* iter)
+{
+	auto hashTable = (Runtime_hashtable_object*)iter->table;
+	auto info = hashTable->infoPtr;
+	uint8T* data = nullptr;
+
+	if (hashTable->small) {
+		if (iter->pos < hashTable->size) {
+			data = Runtime_hashtable_small_entry(hashTable, iter->pos++);
+		}
+	}
+	else if (hashTable->ordered) {
+		while (iter->pos < hashTable->entryCount) {
+			auto entry = Runtime_hashtable_entry(hashTable, iter->pos++);
+			if (0 == (*Runtime_hashtable_entry_hash(info, entry) & RUNTIME_HASHTABLE_ENTRY_ERASED)) {
+				data = entry;
+				break;
+			}
+		}
+	}
+	else {
+		auto block = &hashTable->table;
+		auto blockStart = 0ULL;
+		auto idx = Runtime_hashtable_block_next_full(block, iter->pos);
+
+		if (RUNTIME_HASHTABLE_NO_INDEX == idx && Runtime_hashtable_is_migrating(hashTable)) {
+			blockStart = block->capacity;
+			block = &hashTable->oldTable;
+			idx = Runtime_hashtable_block_next_full(block, iter->pos > blockStart ? iter->pos - blockStart : 0);
+		}
+
+		if (RUNTIME_HASHTABLE_NO_INDEX != idx) {
+			data = Runtime_hashtable_slot(block, idx);
+			iter->pos = blockStart + idx + 1;
+		}
+		else {
+			iter->pos = RUNTIME_HASHTABLE_NO_INDEX;
+		}
+	}
+
+	if (nullptr == data) {
+		iter->key = nullptr;
+		iter->value = nullptr;
+		return false;
+	}
+
+	iter->key = Runtime_hashtable_slot_key_ref(info, data);
+	iter->value = Runtime_hashtable_slot_val_ref(info, data);
+	return true;
+}
+
+void* Runtime_hashtable_iter_key(Runtime_hashtable_iter* iter)
+{
+	return iter->key;
+}
+
+void* Runtime_hashtable_iter_value(Runtime_hashtable_iter* iter)
+{
+	return iter->value;
+}
+
+//a deep copy, nested handles included, same ordering as rhs
+Runtime_hashtable_handle Runtime_hashtable_new_copy(Runtime_hashtable_handle rhs)
+{
+	auto rhsTable = (Runtime_hashtable_object*)rhs;
+	auto info = rhsTable->infoPtr;
+	auto result = (Runtime_hashtable_object*)Runtime_hashtable_new_with_info(rhsTable->size, info, rhsTable->ordered);
+
+	Runtime_hashtable_iter iter;
+	Runtime_hashtable_iter_init(rhs, &iter);
+	while (Runtime_hashtable_iter_next(&iter)) {
+		Runtime_hashtable_insert_hashed(result, Runtime_hashtable_hash_key(info, iter.key), 
+			Runtime_hashtable_value_dup(info->keyType, iter.key), Runtime_hashtable_value_dup(info->valueType, iter.value));
+	}
+	return (Runtime_hashtable_handle)result;
+}
+
+
+//stats
+
+#define RUNTIME_HASHTABLE_STATS_DUMP_MAX	64
+
+//groups visited on the probe sequence for hash before reaching 
+//the group that holds idx
+uint64T Runtime_hashtable_probe_length(Runtime_hashtable_block* block, uint64T hash, uint64T idx)
+{
+	uint64T mask = block->capacity - 1;
+	uint64T pos = Runtime_hashtable_h1(hash) & mask;
+	uint64T step = 0;
+	uint64T result = 1;
+
+	while (((idx - pos) & mask) >= RUNTIME_HASHTABLE_GROUP_WIDTH) {
+		step += RUNTIME_HASHTABLE_GROUP_WIDTH;
+		pos = (pos + step) & mask;
+		result++;
+	}
+	return result;
+}
+
+void Runtime_hashtable_block_stats(Runtime_hashtable_object* hashTable, Runtime_hashtable_block* block, Runtime_hashtable_stats* stats, uint64T* probeTotal)
+{
+	if (nullptr == block->ctrl) {
+		return;
+	}
+
+	Runtime_hashtable_block_for_each(block, [&](uint64T idx) {
+		auto probes = Runtime_hashtable_probe_length(block, Runtime_hashtable_slot_hash(hashTable, block, idx), idx);
+		*probeTotal += probes;
+		if (probes > stats->maxProbeLength) {
+			stats->maxProbeLength = probes;
+		}
+	});
+
+	for (uint64T i = 0; i < block->capacity; i++) {
+		if (rtHashCtrlDeleted == block->ctrl[i]) {
+			stats->tombstones++;
+		}
+	}
+
+	uint64T slotBytes = block->capacity * block->stride;
+	uint64T ctrlBytes = block->capacity + RUNTIME_HASHTABLE_GROUP_WIDTH;
+	if (hashTable->ordered) {
+		stats->tableBytes += ctrlBytes + slotBytes;
+	}
+	else {
+		stats->tableBytes += ctrlBytes;
+		stats->entryBytes += slotBytes;
+	}
+}
+
+void Runtime_hashtable_get_stats(Runtime_hashtable_handle self, Runtime_hashtable_stats* stats)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto info = hashTable->infoPtr;
+
+	Runtime_Memory_init(stats, sizeof(Runtime_hashtable_stats));
+	stats->keyType = info->keyType;
+	stats->valueType = info->valueType;
+	stats->size = hashTable->size;
+	stats->capacity = Runtime_hashtable_capacity(self);
+	stats->loadFactor = (double)stats->size / (double)stats->capacity;
+	stats->resizeCount = hashTable->resizeCount;
+
+	if (hashTable->small) {
+		stats->maxProbeLength = 0 == hashTable->size ? 0 : 1;
+		stats->avgProbeLength = stats->maxProbeLength;
+		stats->entryBytes = RUNTIME_HASHTABLE_SMALL_CAPACITY * info->slotStride;
+		return;
+	}
+
+	uint64T probeTotal = 0;
+	Runtime_hashtable_block_stats(hashTable, &hashTable->table, stats, &probeTotal);
+	Runtime_hashtable_block_stats(hashTable, &hashTable->oldTable, stats, &probeTotal);
+
+	if (0 != hashTable->size) {
+		stats->avgProbeLength = (double)probeTotal / (double)hashTable->size;
+	}
+	if (hashTable->ordered) {
+		stats->entryBytes = hashTable->entryCapacity * info->entryStride;
+	}
+}
+
+void Runtime_hashtable_set_stats_dump(uint32T count)
+{
+	Win32_lock_acquire(&runtimeInstancePtr->hashtableStatsLock);
+
+	count = count > RUNTIME_HASHTABLE_STATS_DUMP_MAX ? RUNTIME_HASHTABLE_STATS_DUMP_MAX : count;
+	if (0 != count && nullptr == runtimeInstancePtr->hashtableStats) {
+		runtimeInstancePtr->hashtableStats = (Runtime_hashtable_stats*)Runtime_alloc(sizeof(Runtime_hashtable_stats) * RUNTIME_HASHTABLE_STATS_DUMP_MAX, typeUnknown);
+	}
+	runtimeInstancePtr->hashtableStatsDumpCount = count;
+	if (runtimeInstancePtr->hashtableStatsCount > count) {
+		runtimeInstancePtr->hashtableStatsCount = count;
+	}
+
+	Win32_lock_release(&runtimeInstancePtr->hashtableStatsLock);
+}
+
+//keeps the stats if the table is one of the largest seen so far
+void Runtime_hashtable_stats_record(Runtime_hashtable_handle self)
+{
+	Runtime_hashtable_stats stats;
+	Runtime_hashtable_get_stats(self, &stats);
+
+	Win32_lock_acquire(&runtimeInstancePtr->hashtableStatsLock);
+
+	auto list = runtimeInstancePtr->hashtableStats;
+	uint32T count = runtimeInstancePtr->hashtableStatsCount;
+	uint32T maxCount = runtimeInstancePtr->hashtableStatsDumpCount;
+
+	uint32T pos = count;
+	while (pos > 0 && list[pos - 1].size < stats.size) {
+		pos--;
+	}
+
+	if (pos < maxCount) {
+		uint32T last = count < maxCount ? count : maxCount - 1;
+		for (uint32T i = last; i > pos; i--) {
+			list[i] = list[i - 1];
+		}
+		list[pos] = stats;
+		runtimeInstancePtr->hashtableStatsCount = last + 1;
+	}
+
+	Win32_lock_release(&runtimeInstancePtr->hashtableStatsLock);
+}
+
+//called from Runtime_terminate, no other thread is running. Tables
+//created while the dump was on and never deleted are ranked along 
+//with the deleted ones
+void Runtime_hashtable_stats_dump()
+{
+	if (nullptr == runtimeInstancePtr->hashtableStats) {
+		return;
+	}
+
+	if (0 != runtimeInstancePtr->hashtableStatsDumpCount) {
+		for (auto live = runtimeInstancePtr->liveHashtables; nullptr != live; live = live->liveNext) {
+			Runtime_hashtable_stats_record((Runtime_hashtable_handle)live);
+		}
+	}
+
+	Runtime_printf("hashtable stats, %u largest tables\n", runtimeInstancePtr->hashtableStatsCount);
+	for (uint32T i = 0; i < runtimeInstancePtr->hashtableStatsCount; i++) {
+		auto stats = &runtimeInstancePtr->hashtableStats[i];
+
+		Runtime_printf("  key %u val %u: size %I64u capacity %I64u load %.3f tombstones %I64u\n", 
+			stats->keyType, stats->valueType, stats->size, stats->capacity, stats->loadFactor, stats->tombstones);
+		Runtime_printf("    probes max %I64u avg %.3f, resizes %u, entry bytes %I64u, table bytes %I64u\n",
+			stats->maxProbeLength, stats->avgProbeLength, stats->resizeCount, stats->entryBytes, stats->tableBytes);
+	}
+
+	Runtime_free(runtimeInstancePtr->hashtableStats);
+	runtimeInstancePtr->hashtableStats = nullptr;
+}
+
+
+//end of hashtable
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//dictionary
+
+Runtime_dictionary_handle Runtime_dictionary_new(Runtime_TypeDescriptor valType)
+{
+	Runtime_dictionary_handle result = nullptr;
+
+
+	result = Runtime_hashtable_new(typeString, valType);
+
+
+	return result;
+}
+
+Runtime_dictionary_handle Runtime_dictionary_new_ordered(Runtime_TypeDescriptor valType)
+{
+	return Runtime_hashtable_new_ordered(typeString, valType);
+}
+
+void Runtime_dictionary_delete(Runtime_dictionary_handle self)
+{
+	Runtime_hashtable_delete(self);
+}
+
+
+bool Runtime_dictionary_empty(Runtime_dictionary_handle self)
+{
+	return Runtime_hashtable_empty(self);
+}
+
+uint64T Runtime_dictionary_size(Runtime_dictionary_handle self)
+{
+	return Runtime_hashtable_size(self);
+}
+
+uint64T Runtime_dictionary_capacity(Runtime_dictionary_handle self)
+{
+	return Runtime_hashtable_capacity(self);
+}
+
+void Runtime_dictionary_set_capacity(Runtime_dictionary_handle self, uint64T capacity)
+{
+	Runtime_hashtable_set_capacity(self, capacity);
+}
+
+void Runtime_dictionary_clear(Runtime_dictionary_handle self)
+{
+	Runtime_hashtable_clear(self);
+}
+
+void Runtime_dictionary_insert(Runtime_dictionary_handle self, Runtime_string_handle key, void* val)
+{
+	Runtime_hashtable_insert(self, key, val);
+}
+
+void Runtime_dictionary_erase(Runtime_dictionary_handle self, Runtime_string_handle key)
+{
+	Runtime_hashtable_erase(self, key);
+}
+
+
+
+//[] access
+void* Runtime_dictionary_at(Runtime_dictionary_handle self, Runtime_string_handle key)
+{	
+	return Runtime_hashtable_at(self, key);
+}
+
+
+//lookups by chars. The key is a stand in string on the stack,
+//same as the intern lookups, with the hash already filled in so
+//the table never hashes the chars again
+inline void Runtime_dictionary_key_init(Runtime_string* key, const charT* keyPtr, uint64T size, uint64T hash)
+{
+	key->data = (charT*)keyPtr;
+	key->size = size;
+	key->capacity = size;
+	key->hashval = hash;
+	key->flags = 0;
+	key->refCount = 1;
+}
+
+uint64T Runtime_dictionary_hash_bytes(const charT* keyPtr, uint64T size)
+{
+	return Runtime_hash_basic_bytes((byteT*)keyPtr, size * sizeof(charT));
+}
+
+void* Runtime_dictionary_at_hashed(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, uint64T hash)
+{
+	Runtime_string key;
+	Runtime_dictionary_key_init(&key, keyPtr, size, hash);
+	return Runtime_hashtable_at(self, &key);
+}
+
+void* Runtime_dictionary_at_bytes(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size)
+{
+	return Runtime_dictionary_at_hashed(self, keyPtr, size, Runtime_dictionary_hash_bytes(keyPtr, size));
+}
+
+//one probe: an existing key keeps its string and only the value 
+//is replaced, a new key gets a string in the slot claimed for it
+void Runtime_dictionary_insert_hashed(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, uint64T hash, void* val)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto info = hashTable->infoPtr;
+
+	Runtime_hashtable_migrate(hashTable, RUNTIME_HASHTABLE_MIGRATE_GROUPS);
+
+	Runtime_string key;
+	Runtime_dictionary_key_init(&key, keyPtr, size, hash);
+	uint64T tableHash = Runtime_hashtable_hash_key(info, &key);
+
+	auto slot = Runtime_hashtable_find_slot(hashTable, tableHash, &key, nullptr, nullptr);
+	if (nullptr != slot) {
+		if (Runtime_hashtable_slot_val_ref(info, slot) != val) {
+			Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, slot + info->valOffset);
+		}
+		Runtime_hashtable_value_assign(info->valueType, info->valTypeInfo, info->valStride, slot + info->valOffset, val);
+		return;
+	}
+
+	auto keyHandle = Runtime_string_new_with_size(keyPtr, size);
+	RUNTIME_STRING(keyHandle)->hashval = hash;
+	Runtime_hashtable_slot_assign(info, Runtime_hashtable_claim_slot(hashTable, tableHash), keyHandle, val);
+}
+
+void Runtime_dictionary_insert_bytes(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, void* val)
+{
+	Runtime_dictionary_insert_hashed(self, keyPtr, size, Runtime_dictionary_hash_bytes(keyPtr, size), val);
+}
+
+void Runtime_dictionary_erase_hashed(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, uint64T hash)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+
+	Runtime_string key;
+	Runtime_dictionary_key_init(&key, keyPtr, size, hash);
+	Runtime_hashtable_erase_hashed(hashTable, Runtime_hashtable_hash_key(hashTable->infoPtr, &key), &key);
+}
+
+void Runtime_dictionary_erase_bytes(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size)
+{
+	Runtime_dictionary_erase_hashed(self, keyPtr, size, Runtime_dictionary_hash_bytes(keyPtr, size));
+}
+
+void Runtime_dictionary_iter_init(Runtime_dictionary_handle self, Runtime_dictionary_iter* iter)
+{
+	Runtime_hashtable_iter_init(self, iter);
+}
+
+bool Runtime_dictionary_iter_next(Runtime_dictionary_iter* iter)
+{
+	return Runtime_hashtable_iter_next(iter);
+}
+
+Runtime_string_handle Runtime_dictionary_iter_key(Runtime_dictionary_iter* iter)
+{
+	return (Runtime_string_handle)Runtime_hashtable_iter_key(iter);
+}
+
+void* Runtime_dictionary_iter_value(Runtime_dictionary_iter* iter)
+{
+	return Runtime_hashtable_iter_value(iter);
+}
+
+
+
+
+
+//end of dictionary
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//set
+//a hashtable whose info has a zero sized value, everything 
+//but the bulk operations forwards to the hashtable
+
+Runtime_set_handle Runtime_set_new_struct(Runtime_TypeDescriptor keyType, uint64T initialSize, bool ordered)
+{
+	auto keySlot = Runtime_type_slot(keyType);
+	RUNTIME_ASSERT(RUNTIME_NO_TYPE_SLOT != keySlot);
+
+	return Runtime_hashtable_new_with_info(initialSize, &runtimeInstancePtr->setInfoList[keySlot], ordered);
+}
+
+Runtime_set_handle Runtime_set_new(Runtime_TypeDescriptor keyType)
+{
+	return Runtime_set_new_struct(keyType, DEFAULT_HASHTABLE_CAPACITY, false);
+}
+
+Runtime_set_handle Runtime_set_new_ordered(Runtime_TypeDescriptor keyType)
+{
+	return Runtime_set_new_struct(keyType, DEFAULT_HASHTABLE_CAPACITY, true);
+}
+
+void Runtime_set_delete(Runtime_set_handle self)
+{
+	Runtime_hashtable_delete(self);
+}
+
+bool Runtime_set_empty(Runtime_set_handle self)
+{
+	return Runtime_hashtable_empty(self);
+}
+
+uint64T Runtime_set_size(Runtime_set_handle self)
+{
+	return Runtime_hashtable_size(self);
+}
+
+uint64T Runtime_set_capacity(Runtime_set_handle self)
+{
+	return Runtime_hashtable_capacity(self);
+}
+
+void Runtime_set_set_capacity(Runtime_set_handle self, uint64T capacity)
+{
+	Runtime_hashtable_set_capacity(self, capacity);
+}
+
+void Runtime_set_clear(Runtime_set_handle self)
+{
+	Runtime_hashtable_clear(self);
+}
+
+bool Runtime_set_insert(Runtime_set_handle self, void* key)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto size = hashTable->size;
+
+	Runtime_hashtable_insert(self, key, nullptr);
+	return size != hashTable->size;
+}
+
+bool Runtime_set_erase(Runtime_set_handle self, void* key)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto size = hashTable->size;
+
+	Runtime_hashtable_erase(self, key);
+	return size != hashTable->size;
+}
+
+bool Runtime_set_contains(Runtime_set_handle self, void* key)
+{
+	auto hashTable = (Runtime_hashtable_object*)self;
+	auto hash = Runtime_hashtable_hash_key(hashTable->infoPtr, key);
+
+	return nullptr != Runtime_hashtable_find_slot(hashTable, hash, key, nullptr, nullptr);
+}
+
+//adds a key from another set, strings need their own copy, 
+//anything else is copied into the slot
+void Runtime_set_insert_copy(Runtime_hashtable_object* hashTable, uint64T hash, void* key)
+{
+	if (typeString == hashTable->infoPtr->keyType) {
+		key = Runtime_string_new_copy((Runtime_string_handle)key);
+	}
+	Runtime_hashtable_insert_hashed(hashTable, hash, key, nullptr);
+}
+
+//a new set like self (same key type and ordering) with room for capacity keys
+inline Runtime_hashtable_object* Runtime_set_new_like(Runtime_hashtable_object* self, uint64T capacity)
+{
+	return (Runtime_hashtable_object*)Runtime_hashtable_new_with_info(capacity, self->infoPtr, self->ordered);
+}
+
+//calls func(key, hash) for each key of the set
+template<typename FuncT>
+void Runtime_set_for_each(Runtime_hashtable_object* hashTable, const FuncT& func)
+{
+	auto info = hashTable->infoPtr;
+
+	Runtime_hashtable_iter iter;
+	Runtime_hashtable_iter_init(hashTable, &iter);
+	while (Runtime_hashtable_iter_next(&iter)) {
+		func(iter.key, Runtime_hashtable_hash_key(info, iter.key));
+	}
+}
+
+Runtime_set_handle Runtime_set_new_copy(Runtime_set_handle rhs)
+{
+	auto rhsSet = (Runtime_hashtable_object*)rhs;
+	auto result = Runtime_set_new_like(rhsSet, rhsSet->size);
+
+	Runtime_set_for_each(rhsSet, [&](void* key, uint64T hash) {
+		Runtime_set_insert_copy(result, hash, key);
+	});
+	return result;
+}
+
+Runtime_set_handle Runtime_set_union(Runtime_set_handle self, Runtime_set_handle rhs)
+{
+	auto lhsSet = (Runtime_hashtable_object*)self;
+	auto rhsSet = (Runtime_hashtable_object*)rhs;
+	RUNTIME_ASSERT(lhsSet->infoPtr == rhsSet->infoPtr);
+
+	//copy the bigger one, then add what's missing from the smaller
+	auto bigger = lhsSet->size >= rhsSet->size ? lhsSet : rhsSet;
+	auto smaller = bigger == lhsSet ? rhsSet : lhsSet;
+
+	auto result = Runtime_set_new_like(lhsSet, bigger->size + smaller->size);
+	Runtime_set_for_each(bigger, [&](void* key, uint64T hash) {
+		Runtime_set_insert_copy(result, hash, key);
+	});
+	Runtime_set_for_each(smaller, [&](void* key, uint64T hash) {
+		if (nullptr == Runtime_hashtable_find_slot(bigger, hash, key, nullptr, nullptr)) {
+			Runtime_set_insert_copy(result, hash, key);
+		}
+	});
+	return result;
+}
+
+Runtime_set_handle Runtime_set_intersection(Runtime_set_handle self, Runtime_set_handle rhs)
+{
+	auto lhsSet = (Runtime_hashtable_object*)self;
+	auto rhsSet = (Runtime_hashtable_object*)rhs;
+	RUNTIME_ASSERT(lhsSet->infoPtr == rhsSet->infoPtr);
+
+	auto bigger = lhsSet->size >= rhsSet->size ? lhsSet : rhsSet;
+	auto smaller = bigger == lhsSet ? rhsSet : lhsSet;
+
+	auto result = Runtime_set_new_like(lhsSet, smaller->size);
+	Runtime_set_for_each(smaller, [&](void* key, uint64T hash) {
+		if (nullptr != Runtime_hashtable_find_slot(bigger, hash, key, nullptr, nullptr)) {
+			Runtime_set_insert_copy(result, hash, key);
+		}
+	});
+	return result;
+}
+
+Runtime_set_handle Runtime_set_difference(Runtime_set_handle self, Runtime_set_handle rhs)
+{
+	auto lhsSet = (Runtime_hashtable_object*)self;
+	auto rhsSet = (Runtime_hashtable_object*)rhs;
+	RUNTIME_ASSERT(lhsSet->infoPtr == rhsSet->infoPtr);
+
+	if (lhsSet->size <= rhsSet->size) {
+		auto result = Runtime_set_new_like(lhsSet, lhsSet->size);
+		Runtime_set_for_each(lhsSet, [&](void* key, uint64T hash) {
+			if (nullptr == Runtime_hashtable_find_slot(rhsSet, hash, key, nullptr, nullptr)) {
+				Runtime_set_insert_copy(result, hash, key);
+			}
+		});
+		return result;
+	}
+
+	//rhs is the smaller one, copy self and take rhs's keys out
+	auto result = (Runtime_hashtable_object*)Runtime_set_new_copy(self);
+	Runtime_set_for_each(rhsSet, [&](void* key, uint64T hash) {
+		Runtime_hashtable_erase(result, key);
+	});
+	return result;
+}
+
+void Runtime_set_iter_init(Runtime_set_handle self, Runtime_set_iter* iter)
+{
+	Runtime_hashtable_iter_init(self, iter);
+}
+
+bool Runtime_set_iter_next(Runtime_set_iter* iter)
+{
+	return Runtime_hashtable_iter_next(iter);
+}
+
+void* Runtime_set_iter_key(Runtime_set_iter* iter)
+{
+	return Runtime_hashtable_iter_key(iter);
+}
+
+//end of set
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//string interning
+
+#define RUNTIME_STRING_INTERN_CACHE_SIZE	1024
+
+void Runtime_string_intern_init()
+{
+	Win32_lock_init(&runtimeInstancePtr->internLock);
+	runtimeInstancePtr->internPool = Runtime_set_new(typeString);
+
+	uint64T cacheSize = sizeof(Runtime_string_handle) * RUNTIME_STRING_INTERN_CACHE_SIZE;
+	runtimeInstancePtr->internCache = (Runtime_string_handle volatile*)Runtime_alloc(cacheSize, typeUnknown);
+	Runtime_Memory_init((void*)runtimeInstancePtr->internCache, cacheSize);
+}
+
+void Runtime_string_intern_terminate()
+{
+	//the strings stop being interned so the set can delete them
+	Runtime_set_iter iter;
+	Runtime_set_iter_init(runtimeInstancePtr->internPool, &iter);
+	while (Runtime_set_iter_next(&iter)) {
+		RUNTIME_STRING(Runtime_set_iter_key(&iter))->flags &= ~rtStringInterned;
+	}
+
+	Runtime_set_delete(runtimeInstancePtr->internPool);
+	Runtime_free((void*)runtimeInstancePtr->internCache);
+}
+
+Runtime_string_handle Runtime_string_intern_with_size(const charT* c_strPtr, uint64T size)
+{
+	//stand in for the lookups, nothing is copied
+	Runtime_string key;
+	key.data = (charT*)c_strPtr;
+	key.size = size;
+	key.capacity = size;
+	key.hashval = 0;
+	key.flags = 0;
+	key.refCount = 1;
+	auto hash = Runtime_string_hash(&key);
+
+	//interned strings are never freed before terminate, so
+	//whatever is in the cache can be looked at without the lock
+	auto cacheSlot = &runtimeInstancePtr->internCache[hash & (RUNTIME_STRING_INTERN_CACHE_SIZE - 1)];
+	auto cached = *cacheSlot;
+	if (nullptr != cached && Runtime_string_equals(cached, &key)) {
+		return cached;
+	}
+
+	Win32_lock_acquire(&runtimeInstancePtr->internLock);
+
+	auto pool = (Runtime_hashtable_object*)runtimeInstancePtr->internPool;
+	auto slot = Runtime_hashtable_find_slot(pool, Runtime_hashtable_hash_key(pool->infoPtr, &key), &key, nullptr, nullptr);
+
+	Runtime_string* result = nullptr;
+	if (nullptr != slot) {
+		result = *(Runtime_string**)slot;
+	}
+	else {
+		result = (Runtime_string*)Runtime_string_new_with_size(c_strPtr, size);
+		result->hashval = hash;
+		result->flags |= rtStringInterned;
+		Runtime_set_insert(pool, result);
+	}
+
+	Win32_lock_release(&runtimeInstancePtr->internLock);
+
+	*cacheSlot = result;
+	return result;
+}
+
+Runtime_string_handle Runtime_string_intern_cstr(const charT* c_strPtr)
+{
+	return Runtime_string_intern_with_size(c_strPtr, Runtime_c_str_length(c_strPtr));
+}
+
+Runtime_string_handle Runtime_string_intern(Runtime_string_handle str)
+{
+	if (Runtime_string_is_interned(str)) {
+		return str;
+	}
+	return Runtime_string_intern_with_size(RUNTIME_STRING(str)->data, RUNTIME_STRING(str)->size);
+}
+
+bool Runtime_string_is_interned(Runtime_string_handle self)
+{
+	return 0 != (RUNTIME_STRING(self)->flags & rtStringInterned);
+}
+
+//end of string interning
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//persistent map
+//hash array mapped trie. Each level uses 5 bits of the hash to pick 
+//one of 32 children, branches only store the children that exist, 
+//found with a bitmap + popcount. Nodes are never changed once built,
+//an update copies the nodes from the root down to the key and shares
+//the rest, nodes are reference counted across all the maps using
+//them. Keys whose (63 bit) hashes are equal share a collision node
+
+#define RUNTIME_PMAP_BITS	5
+#define RUNTIME_PMAP_MASK	31
+
+enum Runtime_pmap_node_kind {
+	rtPmapBranch = 0,
+	rtPmapLeaf,
+	rtPmapCollision,
+};
+
+//branches and collisions are followed by count child pointers,
+//leaves by the key/value slot, at the slot's alignment (nodes
+//themselves are only 16 byte aligned)
+struct Runtime_pmap_node {
+	volatile int64T refCount;
+	uint32T kind;
+	uint32T count;
+	//bitmap of children for branches, the key hash otherwise
+	uint64T bits;
+};
+
+struct Runtime_persistent_map_object {
+	Runtime_pmap_node* root;
+	uint64T size;
+	Runtime_hashtable_info* infoPtr;
+};
+
+
+inline Runtime_pmap_node** Runtime_pmap_children(Runtime_pmap_node* node)
+{
+	return (Runtime_pmap_node**)(node + 1);
+}
+
+inline uint64T Runtime_pmap_leaf_data_offset(Runtime_hashtable_info* info)
+{
+	return (sizeof(Runtime_pmap_node) + info->slotAlign - 1) & ~(info->slotAlign - 1);
+}
+
+inline uint8T* Runtime_pmap_leaf_data(Runtime_hashtable_info* info, Runtime_pmap_node* node)
+{
+	return (uint8T*)node + Runtime_pmap_leaf_data_offset(info);
+}
+
+Runtime_pmap_node* Runtime_pmap_node_new(uint32T kind, uint32T count, uint64T bits, uint64T dataSize)
+{
+	auto result = (Runtime_pmap_node*)Runtime_alloc(sizeof(Runtime_pmap_node) + dataSize, typeUnknown);
+	result->refCount = 1;
+	result->kind = kind;
+	result->count = count;
+	result->bits = bits;
+	return result;
+}
+
+inline Runtime_pmap_node* Runtime_pmap_retain(Runtime_pmap_node* node)
+{
+	_InterlockedIncrement64(&node->refCount);
+	return node;
+}
+
+void Runtime_pmap_release(Runtime_hashtable_info* info, Runtime_pmap_node* node)
+{
+	if (nullptr == node || 0 != _InterlockedDecrement64(&node->refCount)) {
+		return;
+	}
+
+	if (rtPmapLeaf == node->kind) {
+		Runtime_hashtable_slot_destroy(info, Runtime_pmap_leaf_data(info, node));
+	}
+	else {
+		auto children = Runtime_pmap_children(node);
+		for (uint32T i = 0; i < node->count; i++) {
+			Runtime_pmap_release(info, children[i]);
+		}
+	}
+	Runtime_free(node);
+}
+
+Runtime_pmap_node* Runtime_pmap_leaf_new(Runtime_hashtable_info* info, uint64T hash, void* key, void* val)
+{
+	auto result = Runtime_pmap_node_new(rtPmapLeaf, 0, hash, Runtime_pmap_leaf_data_offset(info) - sizeof(Runtime_pmap_node) + info->slotStride);
+	Runtime_hashtable_slot_assign(info, Runtime_pmap_leaf_data(info, result), key, val);
+	return result;
+}
+
+inline bool Runtime_pmap_leaf_matches(Runtime_hashtable_info* info, Runtime_pmap_node* leaf, uint64T hash, void* key)
+{
+	return leaf->bits == hash && Runtime_hashtable_key_equals(info, Runtime_hashtable_slot_key_ref(info, Runtime_pmap_leaf_data(info, leaf)), key);
+}
+
+//copy of a branch/collision with room for count children, 
+//the caller fills them in
+inline Runtime_pmap_node* Runtime_pmap_node_new_with_children(uint32T kind, uint32T count, uint64T bits)
+{
+	return Runtime_pmap_node_new(kind, count, bits, count * sizeof(Runtime_pmap_node*));
+}
+
+inline uint32T Runtime_pmap_child_pos(uint64T bitmap, uint64T bit)
+{
+	return (uint32T)Runtime_popcount64(bitmap & (bit - 1));
+}
+
+//smallest subtree holding two nodes with different hashes, takes 
+//over the references to both
+Runtime_pmap_node* Runtime_pmap_make_pair(uint32T shift, Runtime_pmap_node* a, Runtime_pmap_node* b)
+{
+	uint64T idxA = (a->bits >> shift) & RUNTIME_PMAP_MASK;
+	uint64T idxB = (b->bits >> shift) & RUNTIME_PMAP_MASK;
+
+	if (idxA == idxB) {
+		auto result = Runtime_pmap_node_new_with_children(rtPmapBranch, 1, 1ULL << idxA);
+		Runtime_pmap_children(result)[0] = Runtime_pmap_make_pair(shift + RUNTIME_PMAP_BITS, a, b);
+		return result;
+	}
+
+	auto result = Runtime_pmap_node_new_with_children(rtPmapBranch, 2, (1ULL << idxA) | (1ULL << idxB));
+	Runtime_pmap_children(result)[0] = idxA < idxB ? a : b;
+	Runtime_pmap_children(result)[1] = idxA < idxB ? b : a;
+	return result;
+}
+
+//returns a copy of node with key set, *added is set if the key is new
+Runtime_pmap_node* Runtime_pmap_insert(Runtime_hashtable_info* info, Runtime_pmap_node* node, uint32T shift, uint64T hash, void* key, void* val, bool* added)
+{
+	if (nullptr == node) {
+		*added = true;
+		return Runtime_pmap_leaf_new(info, hash, key, val);
+	}
+
+	switch (node->kind) {
+		case rtPmapLeaf: {
+			if (Runtime_pmap_leaf_matches(info, node, hash, key)) {
+				*added = false;
+				return Runtime_pmap_leaf_new(info, hash, key, val);
+			}
+
+			*added = true;
+			auto leaf = Runtime_pmap_leaf_new(info, hash, key, val);
+			if (node->bits != hash) {
+				return Runtime_pmap_make_pair(shift, Runtime_pmap_retain(node), leaf);
+			}
+
+			auto result = Runtime_pmap_node_new_with_children(rtPmapCollision, 2, hash);
+			Runtime_pmap_children(result)[0] = Runtime_pmap_retain(node);
+			Runtime_pmap_children(result)[1] = leaf;
+			return result;
+		}break;
+
+		case rtPmapCollision: {
+			if (node->bits != hash) {
+				*added = true;
+				return Runtime_pmap_make_pair(shift, Runtime_pmap_retain(node), Runtime_pmap_leaf_new(info, hash, key, val));
+			}
+
+			auto children = Runtime_pmap_children(node);
+			uint32T found = node->count;
+			for (uint32T i = 0; i < node->count; i++) {
+				if (Runtime_pmap_leaf_matches(info, children[i], hash, key)) {
+					found = i;
+					break;
+				}
+			}
+
+			*added = found == node->count;
+			uint32T count = *added ? node->count + 1 : node->count;
+			auto result = Runtime_pmap_node_new_with_children(rtPmapCollision, count, hash);
+			auto resultChildren = Runtime_pmap_children(result);
+			for (uint32T i = 0; i < node->count; i++) {
+				if (i != found) {
+					resultChildren[i] = Runtime_pmap_retain(children[i]);
+				}
+			}
+			resultChildren[found] = Runtime_pmap_leaf_new(info, hash, key, val);
+			return result;
+		}break;
+
+		default: {
+		}break;
+	}
+
+	uint64T bit = 1ULL << ((hash >> shift) & RUNTIME_PMAP_MASK);
+	uint32T pos = Runtime_pmap_child_pos(node->bits, bit);
+	auto children = Runtime_pmap_children(node);
+
+	if (0 != (node->bits & bit)) {
+		auto child = Runtime_pmap_insert(info, children[pos], shift + RUNTIME_PMAP_BITS, hash, key, val, added);
+
+		auto result = Runtime_pmap_node_new_with_children(rtPmapBranch, node->count, node->bits);
+		auto resultChildren = Runtime_pmap_children(result);
+		for (uint32T i = 0; i < node->count; i++) {
+			resultChildren[i] = i == pos ? child : Runtime_pmap_retain(children[i]);
+		}
+		return result;
+	}
+
+	*added = true;
+	auto result = Runtime_pmap_node_new_with_children(rtPmapBranch, node->count + 1, node->bits | bit);
+	auto resultChildren = Runtime_pmap_children(result);
+	for (uint32T i = 0; i < pos; i++) {
+		resultChildren[i] = Runtime_pmap_retain(children[i]);
+	}
+	resultChildren[pos] = Runtime_pmap_leaf_new(info, hash, key, val);
+	for (uint32T i = pos; i < node->count; i++) {
+		resultChildren[i + 1] = Runtime_pmap_retain(children[i]);
+	}
+	return result;
+}
+
+//returns a new reference to node without key, nullptr if that 
+//leaves it empty. Branches left with a single leaf/collision are 
+//replaced by it, so the trie stays as shallow as it can be
+Runtime_pmap_node* Runtime_pmap_erase(Runtime_hashtable_info* info, Runtime_pmap_node* node, uint32T shift, uint64T hash, void* key, bool* removed)
+{
+	switch (node->kind) {
+		case rtPmapLeaf: {
+			*removed = Runtime_pmap_leaf_matches(info, node, hash, key);
+			return *removed ? nullptr : Runtime_pmap_retain(node);
+		}break;
+
+		case rtPmapCollision: {
+			auto children = Runtime_pmap_children(node);
+			uint32T found = node->count;
+			for (uint32T i = 0; node->bits == hash && i < node->count; i++) {
+				if (Runtime_pmap_leaf_matches(info, children[i], hash, key)) {
+					found = i;
+					break;
+				}
+			}
+
+			*removed = found != node->count;
+			if (!*removed) {
+				return Runtime_pmap_retain(node);
+			}
+			if (2 == node->count) {
+				return Runtime_pmap_retain(children[1 - found]);
+			}
+
+			auto result = Runtime_pmap_node_new_with_children(rtPmapCollision, node->count - 1, hash);
+			auto resultChildren = Runtime_pmap_children(result);
+			for (uint32T i = 0, j = 0; i < node->count; i++) {
+				if (i != found) {
+					resultChildren[j++] = Runtime_pmap_retain(children[i]);
+				}
+			}
+			return result;
+		}break;
+
+		default: {
+		}break;
+	}
+
+	uint64T bit = 1ULL << ((hash >> shift) & RUNTIME_PMAP_MASK);
+	if (0 == (node->bits & bit)) {
+		*removed = false;
+		return Runtime_pmap_retain(node);
+	}
+
+	uint32T pos = Runtime_pmap_child_pos(node->bits, bit);
+	auto children = Runtime_pmap_children(node);
+	auto child = Runtime_pmap_erase(info, children[pos], shift + RUNTIME_PMAP_BITS, hash, key, removed);
+	if (!*removed) {
+		Runtime_pmap_release(info, child);
+		return Runtime_pmap_retain(node);
+	}
+
+	if (nullptr == child) {
+		if (1 == node->count) {
+			return nullptr;
+		}
+		if (2 == node->count && rtPmapBranch != children[1 - pos]->kind) {
+			return Runtime_pmap_retain(children[1 - pos]);
+		}
+
+		auto result = Runtime_pmap_node_new_with_children(rtPmapBranch, node->count - 1, node->bits & ~bit);
+		auto resultChildren = Runtime_pmap_children(result);
+		for (uint32T i = 0, j = 0; i < node->count; i++) {
+			if (i != pos) {
+				resultChildren[j++] = Runtime_pmap_retain(children[i]);
+			}
+		}
+		return result;
+	}
+
+	if (1 == node->count && rtPmapBranch != child->kind) {
+		return child;
+	}
+
+	auto result = Runtime_pmap_node_new_with_children(rtPmapBranch, node->count, node->bits);
+	auto resultChildren = Runtime_pmap_children(result);
+	for (uint32T i = 0; i < node->count; i++) {
+		resultChildren[i] = i == pos ? child : Runtime_pmap_retain(children[i]);
+	}
+	return result;
+}
+
+Runtime_pmap_node* Runtime_pmap_find(Runtime_hashtable_info* info, Runtime_pmap_node* node, uint64T hash, void* key)
+{
+	uint32T shift = 0;
+
+	while (nullptr != node) {
+		switch (node->kind) {
+			case rtPmapLeaf: {
+				return Runtime_pmap_leaf_matches(info, node, hash, key) ? node : nullptr;
+			}break;
+
+			case rtPmapCollision: {
+				auto children = Runtime_pmap_children(node);
+				for (uint32T i = 0; node->bits == hash && i < node->count; i++) {
+					if (Runtime_pmap_leaf_matches(info, children[i], hash, key)) {
+						return children[i];
+					}
+				}
+				return nullptr;
+			}break;
+
+			default: {
+				uint64T bit = 1ULL << ((hash >> shift) & RUNTIME_PMAP_MASK);
+				if (0 == (node->bits & bit)) {
+					return nullptr;
+				}
+				node = Runtime_pmap_children(node)[Runtime_pmap_child_pos(node->bits, bit)];
+				shift += RUNTIME_PMAP_BITS;
+			}break;
+		}
+	}
+
+	return nullptr;
+}
+
+
+Runtime_persistent_map_object* Runtime_persistent_map_new_with_root(Runtime_hashtable_info* info, Runtime_pmap_node* root, uint64T size)
+{
+	auto result = (Runtime_persistent_map_object*)Runtime_alloc(sizeof(Runtime_persistent_map_object), typeDictionary);
+	result->root = root;
+	result->size = size;
+	result->infoPtr = info;
+	return result;
+}
+
+Runtime_persistent_map_handle Runtime_persistent_map_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+{
+	auto info = Runtime_get_hashtable_info_for_type(keyType, valType);
+	RUNTIME_ASSERT(nullptr != info);
+
+	return Runtime_persistent_map_new_with_root(info, nullptr, 0);
+}
+
+Runtime_persistent_map_handle Runtime_persistent_map_copy(Runtime_persistent_map_handle self)
+{
+	auto map = (Runtime_persistent_map_object*)self;
+	auto root = nullptr == map->root ? nullptr : Runtime_pmap_retain(map->root);
+
+	return Runtime_persistent_map_new_with_root(map->infoPtr, root, map->size);
+}
+
+void Runtime_persistent_map_delete(Runtime_persistent_map_handle self)
+{
+	auto map = (Runtime_persistent_map_object*)self;
+
+	Runtime_pmap_release(map->infoPtr, map->root);
+	Runtime_free(map);
+}
+
+bool Runtime_persistent_map_empty(Runtime_persistent_map_handle self)
+{
+	return 0 == ((Runtime_persistent_map_object*)self)->size;
+}
+
+uint64T Runtime_persistent_map_size(Runtime_persistent_map_handle self)
+{
+	return ((Runtime_persistent_map_object*)self)->size;
+}
+
+Runtime_persistent_map_handle Runtime_persistent_map_insert(Runtime_persistent_map_handle self, void* key, void* val)
+{
+	auto map = (Runtime_persistent_map_object*)self;
+	auto info = map->infoPtr;
+
+	bool added = false;
+	auto root = Runtime_pmap_insert(info, map->root, 0, Runtime_hashtable_hash_key(info, key), key, val, &added);
+
+	return Runtime_persistent_map_new_with_root(info, root, added ? map->size + 1 : map->size);
+}
+
+Runtime_persistent_map_handle Runtime_persistent_map_erase(Runtime_persistent_map_handle self, void* key)
+{
+	auto map = (Runtime_persistent_map_object*)self;
+	auto info = map->infoPtr;
+
+	if (nullptr == map->root) {
+		return Runtime_persistent_map_copy(self);
+	}
+
+	bool removed = false;
+	auto root = Runtime_pmap_erase(info, map->root, 0, Runtime_hashtable_hash_key(info, key), key, &removed);
+
+	return Runtime_persistent_map_new_with_root(info, root, removed ? map->size - 1 : map->size);
+}
+
+void* Runtime_persistent_map_at(Runtime_persistent_map_handle self, void* key)
+{
+	auto map = (Runtime_persistent_map_object*)self;
+	auto info = map->infoPtr;
+
+	auto leaf = Runtime_pmap_find(info, map->root, Runtime_hashtable_hash_key(info, key), key);
+	if (nullptr == leaf) {
+		return nullptr;
+	}
+	return Runtime_hashtable_slot_val_ref(info, Runtime_pmap_leaf_data(info, leaf));
+}
+
+//end of persistent map
+//----------------------------------------------------------------------------
+
+
+
+//----------------------------------------------------------------------------
+//ordered map
+//plain B-tree (not B+), every node holds entries, internal nodes also
+//have count + 1 children, so each key lives in exactly one place. A
+//node's keys are packed together ahead of its values, the binary 
+//search only reads keys. The min degree t is picked per map so a 
+//full node's keys are around RUNTIME_BTREE_NODE_KEY_BYTES, nodes other 
+//than the root hold t - 1 to 2t - 1 entries. Inserts split full nodes
+//on the way down and erases top up thin ones on the way down, so 
+//neither has to walk back up
+
+#define RUNTIME_BTREE_NODE_KEY_BYTES	512
+#define RUNTIME_BTREE_MIN_DEGREE_MIN	4
+#define RUNTIME_BTREE_MIN_DEGREE_MAX	64
+//keys start 16 byte aligned
+#define RUNTIME_BTREE_KEYS_OFFSET		16
+
+//followed by the keys, the values and for internal nodes the children
+struct Runtime_btree_node {
+	uint32T count;
+	uint32T leaf;
+};
+
+struct Runtime_ordered_map_object {
+	Runtime_btree_node* root;
+	uint64T size;
+	Runtime_hashtable_info* infoPtr;
+
+	uint32T minDegree;
+	uint32T maxKeys;
+	uint64T valsOffset;
+	uint64T childrenOffset;
+
+	//index of the first key in a node that isn't before key, found
+	//is set if it's equal. Numbers get an inlined compare
+	uint32T (*find)(Runtime_ordered_map_object* map, Runtime_btree_node* node, void* key, bool* found);
+};
+
+
+inline uint8T* Runtime_btree_key(Runtime_ordered_map_object* map, Runtime_btree_node* node, uint32T idx)
+{
+	return (uint8T*)node + RUNTIME_BTREE_KEYS_OFFSET + idx * map->infoPtr->keyStride;
+}
+
+inline uint8T* Runtime_btree_val(Runtime_ordered_map_object* map, Runtime_btree_node* node, uint32T idx)
+{
+	return (uint8T*)node + map->valsOffset + idx * map->infoPtr->valStride;
+}
+
+inline Runtime_btree_node** Runtime_btree_children(Runtime_ordered_map_object* map, Runtime_btree_node* node)
+{
+	return (Runtime_btree_node**)((uint8T*)node + map->childrenOffset);
+}
+
+//the handle for handle types, a pointer to the data otherwise
+inline void* Runtime_btree_ref(Runtime_TypeDescriptor type, uint8T* data)
+{
+	return Runtime_type_is_handle(type) ? *(void**)data : (void*)data;
+}
+
+inline void* Runtime_btree_key_ref(Runtime_ordered_map_object* map, Runtime_btree_node* node, uint32T idx)
+{
+	return Runtime_btree_ref(map->infoPtr->keyType, Runtime_btree_key(map, node, idx));
+}
+
+inline void* Runtime_btree_val_ref(Runtime_ordered_map_object* map, Runtime_btree_node* node, uint32T idx)
+{
+	return Runtime_btree_ref(map->infoPtr->valueType, Runtime_btree_val(map, node, idx));
+}
+
+
+template<typename T>
+inline int32T Runtime_btree_compare_values(T lhs, T rhs)
+{
+	return lhs < rhs ? -1 : (rhs < lhs ? 1 : 0);
+}
+
+//< 0, 0 or > 0 as keyRef is before, the same as or after key,
+//both are what Runtime_btree_ref gives for a key
+int32T Runtime_ordered_map_key_compare(Runtime_hashtable_info* info, void* keyRef, void* key)
+{
+	if (keyRef == key) {
+		return 0;
+	}
+
+	switch (info->keyType) {
+		case typeBit1: case typeBool: case typeUInteger8: {
+			return Runtime_btree_compare_values(*(uint8T*)keyRef, *(uint8T*)key);
+		}break;
+
+		case typeInteger8: {
+			return Runtime_btree_compare_values(*(int8T*)keyRef, *(int8T*)key);
+		}break;
+
+		case typeInteger16: {
+			return Runtime_btree_compare_values(*(int16T*)keyRef, *(int16T*)key);
+		}break;
+
+		case typeUInteger16: {
+			return Runtime_btree_compare_values(*(uint16T*)keyRef, *(uint16T*)key);
+		}break;
+
+		case typeInteger32: {
+			return Runtime_btree_compare_values(*(int32T*)keyRef, *(int32T*)key);
+		}break;
+
+		case typeUInteger32: {
+			return Runtime_btree_compare_values(*(uint32T*)keyRef, *(uint32T*)key);
+		}break;
+
+		case typeInteger64: {
+			return Runtime_btree_compare_values(*(int64T*)keyRef, *(int64T*)key);
+		}break;
+
+		case typeUInteger64: {
+			return Runtime_btree_compare_values(*(uint64T*)keyRef, *(uint64T*)key);
+		}break;
+
+		case typeInteger128: case typeUInteger128: {
+			auto lhs = (uint128T*)keyRef;
+			auto rhs = (uint128T*)key;
+			if (lhs->hi != rhs->hi) {
+				return typeInteger128 == info->keyType ? 
+							Runtime_btree_compare_values((int64T)lhs->hi, (int64T)rhs->hi) :
+							Runtime_btree_compare_values(lhs->hi, rhs->hi);
+			}
+			return Runtime_btree_compare_values(lhs->lo, rhs->lo);
+		}break;
+
+		case typeDouble32: {
+			return Runtime_btree_compare_values(*(float32T*)keyRef, *(float32T*)key);
+		}break;
+
+		case typeDouble64: {
+			return Runtime_btree_compare_values(*(double64T*)keyRef, *(double64T*)key);
+		}break;
+
+		case typeString: {
+			//bytes first, a prefix goes before the longer string
+			auto lhs = RUNTIME_STRING(keyRef);
+			auto rhs = RUNTIME_STRING(key);
+			uint64T common = (lhs->size < rhs->size ? lhs->size : rhs->size) * sizeof(charT);
+			int32T result = Runtime_mem_cmp(lhs->data, common, rhs->data, common);
+			return 0 != result ? result : Runtime_btree_compare_values(lhs->size, rhs->size);
+		}break;
+
+		default: {
+			if (nullptr != info->keyTypeInfo->compare) {
+				return info->keyTypeInfo->compare(keyRef, key);
+			}
+		} break;
+	}
+
+	return Runtime_mem_cmp(keyRef, info->keyTypeInfo->size, key, info->keyTypeInfo->size);
+}
+
+//any key type, through Runtime_ordered_map_key_compare
+uint32T Runtime_btree_node_find(Runtime_ordered_map_object* map, Runtime_btree_node* node, void* key, bool* found)
+{
+	uint32T lo = 0;
+	uint32T hi = node->count;
+	*found = false;
+
+	while (lo < hi) {
+		uint32T mid = (lo + hi) / 2;
+		int32T cmp = Runtime_ordered_map_key_compare(map->infoPtr, Runtime_btree_key_ref(map, node, mid), key);
+		if (cmp < 0) {
+			lo = mid + 1;
+		}
+		else {
+			*found = 0 == cmp;
+			if (*found) {
+				return mid;
+			}
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
 
+//halves the range without branching on the compares, which are
+//a coin toss for the CPU's predictor
+template<typename KeyT>
+uint32T Runtime_btree_node_find_typed(Runtime_ordered_map_object* map, Runtime_btree_node* node, void* key, bool* found)
+{
+	auto keys = (KeyT*)Runtime_btree_key(map, node, 0);
+	KeyT k = *(KeyT*)key;
+	uint32T count = node->count;
 
-	memInfo.size = size;
-	memInfo.type = type;
+	if (0 == count) {
+		*found = false;
+		return 0;
+	}
 
-	switch (type) {
-		case typeRecord: {
+	//the keys of a full node span a few cache lines, asking for them
+	//all up front overlaps the misses instead of taking them one by
+	//one as the search hops between lines
+	for (uint64T offset = 0; offset < count * sizeof(KeyT); offset += 64) {
+		_mm_prefetch((const char*)keys + offset, _MM_HINT_T0);
+	}
 
+	const KeyT* base = keys;
+	while (count > 1) {
+		uint32T half = count / 2;
+		base += (uint32T)(base[half - 1] < k) * half;
+		count -= half;
+	}
+	base += (uint32T)(*base < k);
+
+	uint32T result = (uint32T)(base - keys);
+	*found = result < node->count && !(k < *base);
+	return result;
+}
+
+void Runtime_btree_select_find(Runtime_ordered_map_object* map)
+{
+	switch (map->infoPtr->keyType) {
+		case typeInteger32: {
+			map->find = Runtime_btree_node_find_typed<int32T>;
 		}break;
 
-		case typeClass: {
+		case typeUInteger32: {
+			map->find = Runtime_btree_node_find_typed<uint32T>;
+		}break;
 
+		case typeInteger64: {
+			map->find = Runtime_btree_node_find_typed<int64T>;
 		}break;
 
-		case typeArray: {
-			adjustedSize = size;
+		case typeUInteger64: {
+			map->find = Runtime_btree_node_find_typed<uint64T>;
 		}break;
 
+		case typeDouble64: {
+			map->find = Runtime_btree_node_find_typed<double64T>;
+		}break;
 
 		default: {
-			adjustedSize = size;
+			map->find = Runtime_btree_node_find;
 		}break;
 	}
+}
 
 
-	adjustedSize += sizeof(Runtime_memory_info);
-
-	void* mem = Win32_Runtime_alloc(adjustedSize);
+Runtime_btree_node* Runtime_btree_node_new(Runtime_ordered_map_object* map, bool leaf)
+{
+	uint64T size = leaf ? map->childrenOffset : map->childrenOffset + (map->maxKeys + 1) * sizeof(Runtime_btree_node*);
+	auto result = (Runtime_btree_node*)Runtime_alloc(size, typeUnknown);
+	result->count = 0;
+	result->leaf = leaf ? 1 : 0;
+	return result;
+}
 
-	//Runtime_debug_printf("Win32_Runtime_alloc: %d, mem: %p\n", (int)adjustedSize, mem);
+void Runtime_btree_node_delete(Runtime_ordered_map_object* map, Runtime_btree_node* node)
+{
+	auto info = map->infoPtr;
 
-	Runtime_memory_info* allocatedMem = (Runtime_memory_info*)mem;
-	*allocatedMem = memInfo;
-	uint8T* memPtr = (uint8T * )mem;
-	allocatedMem->memPtr = (void*)(memPtr + sizeof(Runtime_memory_info));
+	for (uint32T i = 0; i < node->count; i++) {
+		Runtime_hashtable_destroy_value(info->keyType, info->keyTypeInfo, Runtime_btree_key(map, node, i));
+		Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, Runtime_btree_val(map, node, i));
+	}
+	if (!node->leaf) {
+		auto children = Runtime_btree_children(map, node);
+		for (uint32T i = 0; i <= node->count; i++) {
+			Runtime_btree_node_delete(map, children[i]);
+		}
+	}
+	Runtime_free(node);
+}
 
-	result = allocatedMem->memPtr;
+inline void Runtime_btree_entry_assign(Runtime_ordered_map_object* map, Runtime_btree_node* node, uint32T idx, void* key, void* val)
+{
+	auto info = map->infoPtr;
+	Runtime_hashtable_value_assign(info->keyType, info->keyTypeInfo, info->keyStride, Runtime_btree_key(map, node, idx), key);
+	Runtime_hashtable_value_assign(info->valueType, info->valTypeInfo, info->valStride, Runtime_btree_val(map, node, idx), val);
+}
 
-	totalBytesHeapAllocated += adjustedSize;
+//either direction, the ranges can overlap. Keys/values are usually
+//whole words, those move a word at a time
+void Runtime_btree_move_bytes(uint8T* src, uint8T* dest, uint64T size)
+{
+	bool down = dest <= src;
+
+	if (0 == ((size | (uint64T)src | (uint64T)dest) & 7)) {
+		auto srcWords = (uint64T*)src;
+		auto destWords = (uint64T*)dest;
+		uint64T count = size / sizeof(uint64T);
+		if (down) {
+			for (uint64T i = 0; i < count; i++) {
+				destWords[i] = srcWords[i];
+			}
+		}
+		else {
+			for (uint64T i = count; i > 0; i--) {
+				destWords[i - 1] = srcWords[i - 1];
+			}
+		}
+		return;
+	}
 
-	//Runtime_debug_printf("Runtime_alloc: %d, mem: %p\n", (int)allocatedMem->size, allocatedMem->memPtr);
+	if (down) {
+		Runtime_mem_cpy(src, dest, size);
+		return;
+	}
+	for (uint64T i = size; i > 0; i--) {
+		dest[i - 1] = src[i - 1];
+	}
+}
 
-	//Runtime_debug_printf("tot: %I64u\n", totalBytesHeapAllocated);
+//entries are moved as bytes, whoever owns them doesn't change
+void Runtime_btree_move_entries(Runtime_ordered_map_object* map, Runtime_btree_node* src, uint32T srcIdx, Runtime_btree_node* dest, uint32T destIdx, uint32T count)
+{
+	auto info = map->infoPtr;
+	Runtime_btree_move_bytes(Runtime_btree_key(map, src, srcIdx), Runtime_btree_key(map, dest, destIdx), count * info->keyStride);
+	Runtime_btree_move_bytes(Runtime_btree_val(map, src, srcIdx), Runtime_btree_val(map, dest, destIdx), count * info->valStride);
+}
 
-    return result;
+void Runtime_btree_move_children(Runtime_ordered_map_object* map, Runtime_btree_node* src, uint32T srcIdx, Runtime_btree_node* dest, uint32T destIdx, uint32T count)
+{
+	Runtime_btree_move_bytes((uint8T*)(Runtime_btree_children(map, src) + srcIdx), (uint8T*)(Runtime_btree_children(map, dest) + destIdx), count * sizeof(Runtime_btree_node*));
 }
 
-void Runtime_free(void* mem)
+
+//splits parent's full child idx in two around its middle entry, 
+//which moves up into parent at idx
+void Runtime_btree_split_child(Runtime_ordered_map_object* map, Runtime_btree_node* parent, uint32T idx)
 {
-	if (!Runtime_verify_heap_mem(mem)) {		
-		return;
-	}
+	uint32T t = map->minDegree;
+	auto child = Runtime_btree_children(map, parent)[idx];
+	auto sibling = Runtime_btree_node_new(map, child->leaf);
 
-	uint8T* memPtr = (uint8T*)mem;
-	memPtr -= sizeof(Runtime_memory_info);
+	Runtime_btree_move_entries(map, child, t, sibling, 0, t - 1);
+	if (!child->leaf) {
+		Runtime_btree_move_children(map, child, t, sibling, 0, t);
+	}
+	sibling->count = t - 1;
+	child->count = t - 1;
+
+	Runtime_btree_move_entries(map, parent, idx, parent, idx + 1, parent->count - idx);
+	Runtime_btree_move_children(map, parent, idx + 1, parent, idx + 2, parent->count - idx);
+	Runtime_btree_move_entries(map, child, t - 1, parent, idx, 1);
+	Runtime_btree_children(map, parent)[idx + 1] = sibling;
+	parent->count++;
+}
 
-	Runtime_memory_info* allocatedMem = (Runtime_memory_info*)memPtr;
-	//Runtime_debug_printf("Runtime_free: %d, Runtime_memory_info: %p, %p\n", (int)allocatedMem->size, allocatedMem, mem);
+//child idx, idx's entry in parent and child idx + 1 become child idx
+void Runtime_btree_merge_children(Runtime_ordered_map_object* map, Runtime_btree_node* parent, uint32T idx)
+{
+	auto children = Runtime_btree_children(map, parent);
+	auto left = children[idx];
+	auto right = children[idx + 1];
+
+	Runtime_btree_move_entries(map, parent, idx, left, left->count, 1);
+	Runtime_btree_move_entries(map, right, 0, left, left->count + 1, right->count);
+	if (!left->leaf) {
+		Runtime_btree_move_children(map, right, 0, left, left->count + 1, right->count + 1);
+	}
+	left->count += right->count + 1;
 
-	totalBytesHeapAllocated -= allocatedMem->size + sizeof(Runtime_memory_info);
+	Runtime_btree_move_entries(map, parent, idx + 1, parent, idx, parent->count - idx - 1);
+	Runtime_btree_move_children(map, parent, idx + 2, parent, idx + 1, parent->count - idx - 1);
+	parent->count--;
 
-	Win32_Runtime_free(allocatedMem);
+	Runtime_free(right);
 }
 
-Runtime_memory_info_handle Runtime_RuntimeMemory_get_from_heap_ptr(void* mem)
+//makes sure parent's child idx has at least t entries before going 
+//down into it, borrowing from a sibling through parent or merging 
+//with one. Returns the index the child ends up at
+uint32T Runtime_btree_fill_child(Runtime_ordered_map_object* map, Runtime_btree_node* parent, uint32T idx)
 {
-	if (nullptr == mem) {
-		return nullptr;
+	uint32T t = map->minDegree;
+	auto children = Runtime_btree_children(map, parent);
+	auto child = children[idx];
+
+	if (child->count >= t) {
+		return idx;
 	}
 
-	Runtime_memory_info* result = nullptr;
-	uint8T* memPtr = (uint8T*)mem;
-	memPtr -= sizeof(Runtime_memory_info);
-	result = (Runtime_memory_info*)memPtr;
+	if (idx > 0 && children[idx - 1]->count >= t) {
+		auto left = children[idx - 1];
+		Runtime_btree_move_entries(map, child, 0, child, 1, child->count);
+		Runtime_btree_move_entries(map, parent, idx - 1, child, 0, 1);
+		Runtime_btree_move_entries(map, left, left->count - 1, parent, idx - 1, 1);
+		if (!child->leaf) {
+			Runtime_btree_move_children(map, child, 0, child, 1, child->count + 1);
+			Runtime_btree_children(map, child)[0] = Runtime_btree_children(map, left)[left->count];
+		}
+		child->count++;
+		left->count--;
+		return idx;
+	}
 
-	if (result->memPtr != mem) {
-		// this mem ptr is not something we created!
-		result = nullptr;
+	if (idx < parent->count && children[idx + 1]->count >= t) {
+		auto right = children[idx + 1];
+		Runtime_btree_move_entries(map, parent, idx, child, child->count, 1);
+		Runtime_btree_move_entries(map, right, 0, parent, idx, 1);
+		if (!child->leaf) {
+			Runtime_btree_children(map, child)[child->count + 1] = Runtime_btree_children(map, right)[0];
+			Runtime_btree_move_children(map, right, 1, right, 0, right->count);
+		}
+		Runtime_btree_move_entries(map, right, 1, right, 0, right->count - 1);
+		child->count++;
+		right->count--;
+		return idx;
 	}
 
-	return result;
+	if (idx < parent->count) {
+		Runtime_btree_merge_children(map, parent, idx);
+		return idx;
+	}
+
+	Runtime_btree_merge_children(map, parent, idx - 1);
+	return idx - 1;
 }
 
-uint64T Runtime_RuntimeMemory_get_size(void* mem)
-{	
-	if (nullptr == mem) {
-		return 0;
+//moves the first or last entry under node into dest's entry destIdx
+void Runtime_btree_take_edge(Runtime_ordered_map_object* map, Runtime_btree_node* node, bool last, Runtime_btree_node* dest, uint32T destIdx)
+{
+	while (!node->leaf) {
+		uint32T idx = Runtime_btree_fill_child(map, node, last ? node->count : 0);
+		node = Runtime_btree_children(map, node)[idx];
 	}
-	auto tmp = (Runtime_memory_info*) Runtime_RuntimeMemory_get_from_heap_ptr(mem);
-	if (nullptr == tmp) {
-		return 0;
+
+	if (last) {
+		Runtime_btree_move_entries(map, node, node->count - 1, dest, destIdx, 1);
 	}
-		
-	return tmp->size;
+	else {
+		Runtime_btree_move_entries(map, node, 0, dest, destIdx, 1);
+		Runtime_btree_move_entries(map, node, 1, node, 0, node->count - 1);
+	}
+	node->count--;
 }
 
-Runtime_TypeDescriptor Runtime_RuntimeMemory_get_type(void* mem)
+//removes node's entry idx, which has already been destroyed. The
+//neighbouring entry from whichever side can spare one fills the 
+//hole, otherwise the two sides merge around it and it moves down
+void Runtime_btree_erase_hole(Runtime_ordered_map_object* map, Runtime_btree_node* node, uint32T idx)
 {
-	if (nullptr == mem) {
-		return typeNilPtr;
-	}
+	uint32T t = map->minDegree;
 
-	auto tmp = (Runtime_memory_info*) Runtime_RuntimeMemory_get_from_heap_ptr(mem);
-	if (nullptr == tmp) {
-		return typeUnmanagedPtr;
+	while (!node->leaf) {
+		auto children = Runtime_btree_children(map, node);
+		if (children[idx]->count >= t) {
+			Runtime_btree_take_edge(map, children[idx], true, node, idx);
+			return;
+		}
+		if (children[idx + 1]->count >= t) {
+			Runtime_btree_take_edge(map, children[idx + 1], false, node, idx);
+			return;
+		}
+
+		auto left = children[idx];
+		Runtime_btree_merge_children(map, node, idx);
+		node = left;
+		idx = t - 1;
 	}
 
-	return tmp->type;
+	Runtime_btree_move_entries(map, node, idx + 1, node, idx, node->count - idx - 1);
+	node->count--;
 }
 
 
-//----------------------------------------------------------------------------
-//hashtable
+//builds a subtree height levels deep over entries [first, first + count),
+//capacities[h] is the most entries a tree h levels deep holds
+Runtime_btree_node* Runtime_btree_build(Runtime_ordered_map_object* map, void* keys, void* vals, uint64T first, uint64T count, uint32T height, const uint64T* capacities)
+{
+	auto info = map->infoPtr;
+	auto node = Runtime_btree_node_new(map, 1 == height);
 
-#define RUNTIME_HASHTABLE_NO_INDEX  uint64T (-1)
-#define RUTNIME_HASHTABLE_DEF_CAPCITY_GROW	1.5
-#define RUTNIME_HASHTABLE_DEF_MAX_USAGE		0.75
-
-struct Runtime_hash_pair {
-	void* keyPtr;
-	void* valPtr;
-	Runtime_hash_pair* next;
-	Runtime_hash_pair* prev;
-};
+	auto assignFrom = [&](uint32T idx, uint64T srcIdx) {
+		Runtime_btree_entry_assign(map, node, idx,
+			Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, srcIdx),
+			Runtime_hashtable_batch_item(info->valueType, info->valStride, vals, srcIdx));
+	};
 
-typedef Runtime_hash_pair** Runtime_hash_table_data_array;
+	if (1 == height) {
+		for (uint64T i = 0; i < count; i++) {
+			assignFrom((uint32T)i, first + i);
+		}
+		node->count = (uint32T)count;
+		return node;
+	}
 
-struct Runtime_hashtable_object {
-	Runtime_hash_table_data_array tableData;
+	//as few children as will hold them, shared out evenly. That
+	//always leaves each child more than it needs for its height
+	uint64T childCapacity = capacities[height - 1];
+	uint64T childCount = (count + childCapacity + 1) / (childCapacity + 1);
+	RUNTIME_ASSERT(childCount >= 2 && childCount <= map->maxKeys + 1);
 
-	uint64T size;
-	uint64T capacity;
+	uint64T perChild = (count - (childCount - 1)) / childCount;
+	uint64T extra = (count - (childCount - 1)) % childCount;
 
-	double capacityGrowthFactor;
-	double maxUsageFactor;
+	auto children = Runtime_btree_children(map, node);
+	uint64T pos = first;
+	for (uint64T c = 0; c < childCount; c++) {
+		uint64T n = perChild + (c < extra ? 1 : 0);
+		children[c] = Runtime_btree_build(map, keys, vals, pos, n, height - 1, capacities);
+		pos += n;
 
-	Runtime_hashtable_info* infoPtr;
-};
+		if (c + 1 < childCount) {
+			assignFrom((uint32T)c, pos++);
+		}
+	}
+	node->count = (uint32T)(childCount - 1);
 
+	return node;
+}
 
 
+//positions at the first entry under node, the last for reverse
+void Runtime_btree_iter_descend(Runtime_ordered_map_iter* iter, Runtime_btree_node* node)
+{
+	auto map = (Runtime_ordered_map_object*)iter->map;
+
+	while (true) {
+		auto d = iter->depth++;
+		RUNTIME_ASSERT(iter->depth <= Runtime_ordered_map_max_depth);
+		iter->nodes[d] = node;
+		if (node->leaf) {
+			iter->idx[d] = iter->reverse ? (int32T)node->count - 1 : 0;
+			return;
+		}
+		iter->idx[d] = iter->reverse ? (int32T)node->count : 0;
+		node = Runtime_btree_children(map, node)[iter->idx[d]];
+	}
+}
 
+//nodes above the top of the path hold the index of the child the
+//path goes through. Going forward, the entry with that index comes
+//next once the child is done, in reverse the one before it
+void Runtime_btree_iter_settle(Runtime_ordered_map_iter* iter)
+{
+	while (0 != iter->depth) {
+		auto d = iter->depth - 1;
+		auto node = (Runtime_btree_node*)iter->nodes[d];
+		if (iter->idx[d] >= 0 && iter->idx[d] < (int32T)node->count) {
+			return;
+		}
 
-uint64T Runtime_hashtable_hash_index(Runtime_hashtable_info* info, uint64T tableSize, void* key) {
-	uint64T result = RUNTIME_HASHTABLE_NO_INDEX;
-	
-	switch (info->keyType) {
-		case typeBit1: case typeBool:
-		case typeInteger8: case typeUInteger8:
-		case typeInteger16: case typeUInteger16:
-		case typeInteger32: case typeUInteger32:
-		case typeInteger64: case typeUInteger64:
-		case typeInteger128: case typeUInteger128: {
-			auto keyBytes = (uint8T*)key;
-			result = Runtime_hash_basic_bytes(keyBytes, info->keyStride) % tableSize;
+		iter->depth--;
+		if (0 != iter->depth && iter->reverse) {
+			iter->idx[iter->depth - 1]--;
+		}
+	}
+}
 
-		}break;
-		
-		case typeDouble32: case typeDouble64: {
-			auto keyBytes = (uint8T*)key;
-			result = Runtime_hash_basic_bytes(keyBytes, info->keyStride) % tableSize;
+void Runtime_btree_iter_advance(Runtime_ordered_map_iter* iter)
+{
+	auto map = (Runtime_ordered_map_object*)iter->map;
+	auto d = iter->depth - 1;
+	auto node = (Runtime_btree_node*)iter->nodes[d];
+
+	if (!node->leaf) {
+		//the entries between this one and the next are in the child 
+		//after it (before it in reverse)
+		if (!iter->reverse) {
+			iter->idx[d]++;
+		}
+		Runtime_btree_iter_descend(iter, Runtime_btree_children(map, node)[iter->idx[d]]);
+		return;
+	}
 
-		}break;
+	iter->idx[d] += iter->reverse ? -1 : 1;
+	Runtime_btree_iter_settle(iter);
+}
 
-		case typeString:{
-			auto str = (Runtime_string_handle)key;
-			auto hashVal = Runtime_string_hash(str);
-			result = hashVal % tableSize;
+void Runtime_btree_iter_reset(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, bool reverse)
+{
+	iter->map = self;
+	iter->depth = 0;
+	iter->reverse = reverse;
+	iter->started = false;
+	iter->endKey = nullptr;
+	iter->key = nullptr;
+	iter->value = nullptr;
+}
 
-		}break;
+//positions at the first key >= key, or > key if after is set
+void Runtime_btree_iter_seek(Runtime_ordered_map_iter* iter, void* key, bool after)
+{
+	auto map = (Runtime_ordered_map_object*)iter->map;
+	auto node = map->root;
 
-		default: {
-			
-		} break;
-	}
+	while (nullptr != node) {
+		bool found = false;
+		uint32T idx = map->find(map, node, key, &found);
 
-	RUNTIME_ASSERT(RUNTIME_HASHTABLE_NO_INDEX != result);
+		auto d = iter->depth++;
+		RUNTIME_ASSERT(iter->depth <= Runtime_ordered_map_max_depth);
+		iter->nodes[d] = node;
+		iter->idx[d] = (int32T)idx;
 
-	return result;
+		if (found) {
+			if (after) {
+				Runtime_btree_iter_advance(iter);
+			}
+			return;
+		}
+		if (node->leaf) {
+			break;
+		}
+		node = Runtime_btree_children(map, node)[idx];
+	}
+
+	Runtime_btree_iter_settle(iter);
 }
 
 
-Runtime_hash_pair* Runtime_hash_pair_new(Runtime_hashtable_info* info)
+Runtime_ordered_map_handle Runtime_ordered_map_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
 {
-	Runtime_hash_pair* result = nullptr;
-	//need a better way, this is probably absurdly inefficient
-	result = (Runtime_hash_pair*)Runtime_alloc(sizeof(Runtime_hash_pair) + info->keyStride + info->valStride, typeUnknown);
-	result->keyPtr = nullptr;
-	result->valPtr = nullptr;
-	result->next = nullptr;
-	result->prev = nullptr;
+	auto info = Runtime_get_hashtable_info_for_type(keyType, valType);
+	RUNTIME_ASSERT(nullptr != info);
+	RUNTIME_ASSERT(typeString == keyType || !Runtime_type_is_handle(keyType));
 
+	auto result = (Runtime_ordered_map_object*)Runtime_alloc(sizeof(Runtime_ordered_map_object), typeDictionary);
+	result->root = nullptr;
+	result->size = 0;
+	result->infoPtr = info;
+
+	uint64T t = RUNTIME_BTREE_NODE_KEY_BYTES / (2 * info->keyStride);
+	t = t < RUNTIME_BTREE_MIN_DEGREE_MIN ? RUNTIME_BTREE_MIN_DEGREE_MIN : t;
+	t = t > RUNTIME_BTREE_MIN_DEGREE_MAX ? RUNTIME_BTREE_MIN_DEGREE_MAX : t;
+	result->minDegree = (uint32T)t;
+	result->maxKeys = (uint32T)(2 * t - 1);
+
+	uint64T valAlign = info->valTypeInfo->alignment > 8 ? info->valTypeInfo->alignment : 8;
+	result->valsOffset = (RUNTIME_BTREE_KEYS_OFFSET + result->maxKeys * info->keyStride + valAlign - 1) & ~(valAlign - 1);
+	result->childrenOffset = (result->valsOffset + result->maxKeys * info->valStride + 7) & ~7ULL;
+	Runtime_btree_select_find(result);
 
 	return result;
 }
 
-void Runtime_hash_pair_free_data(Runtime_hash_pair* self, Runtime_hashtable_info* info)
+Runtime_ordered_map_handle Runtime_ordered_map_new_from_sorted(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType, void* keys, void* vals, uint64T count)
 {
-	switch (info->keyType) {
-		case typeString: {
-			//just a pointer, need to free up the string object
-			Runtime_string_handle strPtr = self->keyPtr;
-			Runtime_string_delete(strPtr);
-		} break;
-
-		case typeClass: {
-			//just a pointer, need to free up the class object
-			//Runtime_string_handle strPtr = self->keyPtr;
-			//Runtime_string_delete(strPtr);
-		} break;
-
-		case typeArray: {
-			//just a pointer, need to free up the class object
-			Runtime_array_handle arrPtr = self->keyPtr;
-			Runtime_array_delete(arrPtr);
-		} break;
+	auto result = (Runtime_ordered_map_object*)Runtime_ordered_map_new(keyType, valType);
+	if (0 == count) {
+		return result;
+	}
 
-		default: {
-			//no-op, data embedded in allocation
-		} break;
+	auto info = result->infoPtr;
+#ifdef SCRATCH_RUNTIME_DEBUG
+	for (uint64T i = 1; i < count; i++) {
+		RUNTIME_ASSERT(Runtime_ordered_map_key_compare(info,
+			Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, i - 1),
+			Runtime_hashtable_batch_item(info->keyType, info->keyStride, keys, i)) < 0);
 	}
+#endif
 
-	switch (info->valueType) {
-	case typeString: {
-		//just a pointer, need to free up the string object
-		Runtime_string_handle strPtr = self->valPtr;
-		Runtime_string_delete(strPtr);
-	} break;
+	//the shallowest tree that holds count entries
+	uint64T capacities[Runtime_ordered_map_max_depth + 1];
+	uint32T height = 1;
+	capacities[1] = result->maxKeys;
+	while (capacities[height] < count) {
+		uint64T fanout = result->maxKeys + 1;
+		capacities[height + 1] = capacities[height] >= ~0ULL / fanout ? ~0ULL : (capacities[height] + 1) * fanout - 1;
+		height++;
+	}
 
-	case typeClass: {
-		//just a pointer, need to free up the class object
-		//Runtime_string_handle strPtr = self->keyPtr;
-		//Runtime_string_delete(strPtr);
-	} break;
+	result->root = Runtime_btree_build(result, keys, vals, 0, count, height, capacities);
+	result->size = count;
 
-	case typeArray: {
-		//just a pointer, need to free up the class object
-		Runtime_array_handle arrPtr = self->valPtr;
-		Runtime_array_delete(arrPtr);
-	} break;
+	return result;
+}
 
-	case typeDictionary: {
-		//just a pointer, need to free up the class object
-		Runtime_dictionary_handle dictPtr = self->valPtr;
-		Runtime_dictionary_delete(dictPtr);
-	} break;
+void Runtime_ordered_map_clear(Runtime_ordered_map_handle self)
+{
+	auto map = (Runtime_ordered_map_object*)self;
 
-	default: {
-		//no-op, data embedded in allocation
-	} break;
+	if (nullptr != map->root) {
+		Runtime_btree_node_delete(map, map->root);
 	}
+	map->root = nullptr;
+	map->size = 0;
+}
 
+void Runtime_ordered_map_delete(Runtime_ordered_map_handle self)
+{
+	Runtime_ordered_map_clear(self);
 	Runtime_free(self);
 }
 
-void Runtime_hash_pair_free(Runtime_hash_pair* self, Runtime_hashtable_info* info)
+bool Runtime_ordered_map_empty(Runtime_ordered_map_handle self)
 {
-	if (nullptr == self) {
-		return;
+	return 0 == ((Runtime_ordered_map_object*)self)->size;
+}
+
+uint64T Runtime_ordered_map_size(Runtime_ordered_map_handle self)
+{
+	return ((Runtime_ordered_map_object*)self)->size;
+}
+
+void Runtime_ordered_map_insert(Runtime_ordered_map_handle self, void* key, void* val)
+{
+	auto map = (Runtime_ordered_map_object*)self;
+	auto info = map->infoPtr;
+
+	if (nullptr == map->root) {
+		map->root = Runtime_btree_node_new(map, true);
 	}
+	else if (map->root->count == map->maxKeys) {
+		auto root = Runtime_btree_node_new(map, false);
+		Runtime_btree_children(map, root)[0] = map->root;
+		map->root = root;
+		Runtime_btree_split_child(map, root, 0);
+	}
+
+	auto node = map->root;
+	while (true) {
+		bool found = false;
+		uint32T idx = map->find(map, node, key, &found);
 
-	auto nextP = self->next;
+		if (!found && !node->leaf && Runtime_btree_children(map, node)[idx]->count == map->maxKeys) {
+			Runtime_btree_split_child(map, node, idx);
+			int32T cmp = Runtime_ordered_map_key_compare(info, Runtime_btree_key_ref(map, node, idx), key);
+			found = 0 == cmp;
+			idx += cmp < 0 ? 1 : 0;
+		}
 
-	Runtime_hash_pair_free_data(self, info);
+		if (found) {
+			//same as Runtime_hashtable_insert, the old key/value go
+			if (Runtime_btree_key_ref(map, node, idx) != key) {
+				Runtime_hashtable_destroy_value(info->keyType, info->keyTypeInfo, Runtime_btree_key(map, node, idx));
+			}
+			if (Runtime_btree_val_ref(map, node, idx) != val) {
+				Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, Runtime_btree_val(map, node, idx));
+			}
+			Runtime_btree_entry_assign(map, node, idx, key, val);
+			return;
+		}
 
+		if (node->leaf) {
+			Runtime_btree_move_entries(map, node, idx, node, idx + 1, node->count - idx);
+			Runtime_btree_entry_assign(map, node, idx, key, val);
+			node->count++;
+			map->size++;
+			return;
+		}
 
-	Runtime_hash_pair_free(nextP, info);
+		node = Runtime_btree_children(map, node)[idx];
+	}
 }
 
-void Runtime_hash_pair_assign(Runtime_hash_pair* pair, Runtime_hashtable_info* info, void* key, void* val)
+bool Runtime_ordered_map_erase(Runtime_ordered_map_handle self, void* key)
 {
-	if (nullptr == pair->keyPtr) {
-		auto pairPtr = (uint8T*)pair;
-		pair->keyPtr = (void*)(pairPtr + sizeof(Runtime_hash_pair));
-	}
-	if (nullptr == pair->valPtr) {
-		auto pairPtr = (uint8T*)pair;
-		pair->valPtr = (void*)(pairPtr + sizeof(Runtime_hash_pair) + info->keyStride);
-	}	
-	
-	switch (info->keyType) {
-		case typeString: {
-			pair->keyPtr = (Runtime_string_handle)key;
-		}break;
-
-		case typeArray: {
-			pair->keyPtr = (Runtime_array_handle)key;
-		}break;
+	auto map = (Runtime_ordered_map_object*)self;
+	auto info = map->infoPtr;
+	bool result = false;
+
+	auto node = map->root;
+	while (nullptr != node) {
+		bool found = false;
+		uint32T idx = map->find(map, node, key, &found);
+
+		if (found) {
+			Runtime_hashtable_destroy_value(info->keyType, info->keyTypeInfo, Runtime_btree_key(map, node, idx));
+			Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, Runtime_btree_val(map, node, idx));
+			Runtime_btree_erase_hole(map, node, idx);
+			map->size--;
+			result = true;
+			break;
+		}
 
-		case typeDictionary: {
-			pair->keyPtr = (Runtime_dictionary_handle)key;
-		}break;
+		if (node->leaf) {
+			break;
+		}
 
-		default: {
-			Runtime_mem_cpy(key, pair->keyPtr, info->keyStride);
-		}break;
+		idx = Runtime_btree_fill_child(map, node, idx);
+		node = Runtime_btree_children(map, node)[idx];
 	}
 
-	switch (info->valueType) {
-		case typeString: {
-			pair->valPtr = (Runtime_string_handle)val;
-		}break;
-
-		case typeArray: {
-			pair->valPtr = (Runtime_array_handle)val;
-		}break;
+	//a root emptied by a merge hands over to its only child
+	auto root = map->root;
+	if (nullptr != root && 0 == root->count) {
+		map->root = root->leaf ? nullptr : Runtime_btree_children(map, root)[0];
+		Runtime_free(root);
+	}
 
-		case typeDictionary: {
-			pair->valPtr = (Runtime_dictionary_handle)val;
-		}break;
+	return result;
+}
 
-		default: {
-			Runtime_mem_cpy(val, pair->valPtr, info->valStride);
-		}break;
+void* Runtime_ordered_map_at(Runtime_ordered_map_handle self, void* key)
+{
+	auto map = (Runtime_ordered_map_object*)self;
+
+	auto node = map->root;
+	while (nullptr != node) {
+		bool found = false;
+		uint32T idx = map->find(map, node, key, &found);
+		if (found) {
+			return Runtime_btree_val_ref(map, node, idx);
+		}
+		if (node->leaf) {
+			break;
+		}
+		node = Runtime_btree_children(map, node)[idx];
 	}
-	
+
+	return nullptr;
 }
 
 
-bool Runtime_hash_pair_equals(Runtime_hash_pair* pair, Runtime_hashtable_info* info, void* key) 
-{	
-	auto res = Runtime_mem_cmp(pair->keyPtr, info->keyStride, key, info->keyStride);
-	if (res == 0) {
-		return true;
+void Runtime_ordered_map_iter_init(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter)
+{
+	Runtime_btree_iter_reset(self, iter, false);
+	auto root = ((Runtime_ordered_map_object*)self)->root;
+	if (nullptr != root) {
+		Runtime_btree_iter_descend(iter, root);
 	}
-	return false;
 }
 
-Runtime_hash_pair* Runtime_hash_pair_find(Runtime_hash_pair* pair, Runtime_hashtable_info* info, void* key)
+void Runtime_ordered_map_iter_init_reverse(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter)
 {
-	Runtime_hash_pair* result = nullptr;
-	auto np = pair->next;
-	while (np != nullptr) {
-
-		if (Runtime_hash_pair_equals(np, info, key)) {
-			return np;
-		}
+	Runtime_btree_iter_reset(self, iter, true);
+	auto root = ((Runtime_ordered_map_object*)self)->root;
+	if (nullptr != root) {
+		Runtime_btree_iter_descend(iter, root);
+	}
+}
 
-		np = np->next;
-	}
-	return nullptr;
+void Runtime_ordered_map_lower_bound(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, void* key)
+{
+	Runtime_btree_iter_reset(self, iter, false);
+	Runtime_btree_iter_seek(iter, key, false);
 }
 
+void Runtime_ordered_map_upper_bound(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, void* key)
+{
+	Runtime_btree_iter_reset(self, iter, false);
+	Runtime_btree_iter_seek(iter, key, true);
+}
 
-Runtime_hashtable_info* Runtime_get_hashtable_info_for_type(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+void Runtime_ordered_map_range(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, void* low, void* high)
 {
-	Runtime_hashtable_info* result = nullptr;
-	for (uint32T k = 0; k < runtimeInstancePtr->arrayInfoListSize; k++) {
-		for (uint32T v = 0; v < runtimeInstancePtr->arrayInfoListSize; v++) {
-			Runtime_hashtable_info* info = &runtimeInstancePtr->hashtableInfoList[k * runtimeInstancePtr->arrayInfoListSize + v];
-			if (info->keyType == keyType && info->valueType == valType) {
-				result = info;
-				break;
-			}
-		}
+	if (nullptr != low) {
+		Runtime_ordered_map_lower_bound(self, iter, low);
 	}
-
-	return result;
+	else {
+		Runtime_ordered_map_iter_init(self, iter);
+	}
+	iter->endKey = high;
 }
 
-Runtime_hashtable_handle Runtime_hashtable_new_struct(uint64T initialSize, Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+bool Runtime_ordered_map_iter_next(Runtime_ordered_map_iter* iter)
 {
-	Runtime_hashtable_object* result = nullptr;
+	auto map = (Runtime_ordered_map_object*)iter->map;
 
-	auto hashTableInfo = Runtime_get_hashtable_info_for_type(keyType, valType);
+	//init leaves the path on the first entry
+	if (iter->started && 0 != iter->depth) {
+		Runtime_btree_iter_advance(iter);
+	}
+	iter->started = true;
 
-	auto memPtr = Runtime_alloc(sizeof(Runtime_hashtable_object), typeDictionary);
-	result = (Runtime_hashtable_object*)memPtr;
-	
-	uint64T allocSz = initialSize * (sizeof(Runtime_hash_pair*));// );
-	result->tableData =  (Runtime_hash_pair**) Runtime_alloc(allocSz, typeUnknown);
-	
-	for (uint64T i = 0; i < initialSize;i++) {
-		result->tableData[i] = nullptr;
+	if (0 == iter->depth) {
+		return false;
 	}
 
-	result->capacity = initialSize;
-	result->size = 0;
-	result->infoPtr = hashTableInfo;
-	result->capacityGrowthFactor = RUTNIME_HASHTABLE_DEF_CAPCITY_GROW;
-	result->maxUsageFactor = RUTNIME_HASHTABLE_DEF_MAX_USAGE;
+	auto d = iter->depth - 1;
+	auto node = (Runtime_btree_node*)iter->nodes[d];
+	auto key = Runtime_btree_key_ref(map, node, (uint32T)iter->idx[d]);
+	if (nullptr != iter->endKey && Runtime_ordered_map_key_compare(map->infoPtr, key, iter->endKey) >= 0) {
+		iter->depth = 0;
+		return false;
+	}
 
-	return (Runtime_hashtable_handle)result;
+	iter->key = key;
+	iter->value = Runtime_btree_val_ref(map, node, (uint32T)iter->idx[d]);
+	return true;
 }
 
-
-#define DEFAULT_HASHTABLE_CAPACITY  10
-
-Runtime_hashtable_handle Runtime_hashtable_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
+void* Runtime_ordered_map_iter_key(Runtime_ordered_map_iter* iter)
 {
-	Runtime_hashtable_handle result = Runtime_hashtable_new_struct(DEFAULT_HASHTABLE_CAPACITY, keyType, valType);
-	auto hashTable = (Runtime_hashtable_object*)result;
-
-	return result;
+	return iter->key;
 }
 
-void Runtime_hashtable_delete(Runtime_hashtable_handle self)
+void* Runtime_ordered_map_iter_value(Runtime_ordered_map_iter* iter)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;	
+	return iter->value;
+}
 
-	Runtime_hashtable_clear(self);
+//end of ordered map
+//----------------------------------------------------------------------------
 
-	Runtime_free(hashTable->tableData);
-	Runtime_free(self);
-}
 
 
-bool Runtime_hashtable_empty(Runtime_hashtable_handle self)
-{
-	auto hashTable = (Runtime_hashtable_object*)self;
-	
-	return 0 == hashTable->size;
-}
+//----------------------------------------------------------------------------
+//static dictionary
 
-uint64T Runtime_hashtable_size(Runtime_hashtable_handle self)
+const void* Runtime_static_dictionary_find(const Runtime_static_dictionary* self, uint64T hash, const charT* key, uint64T size)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
+	if (0 == self->size) {
+		return nullptr;
+	}
 
-	return hashTable->size;
-}
+	auto seed = self->seeds[Runtime_static_dictionary_bucket(hash, self->bucketCount)];
+	auto entry = &self->entries[Runtime_static_dictionary_slot(hash, seed, self->size)];
 
-uint64T Runtime_hashtable_capacity(Runtime_hashtable_handle self)
-{
-	auto hashTable = (Runtime_hashtable_object*)self;
-	return hashTable->capacity;
+	if (entry->keySize != size || (0 != size && 0 != Runtime_mem_cmp((void*)entry->key, size, (void*)key, size))) {
+		return nullptr;
+	}
+	return entry->value;
 }
 
-double Runtime_hashtable_max_usage_factor(Runtime_hashtable_handle self)
+uint64T Runtime_static_dictionary_size(const Runtime_static_dictionary* self)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
-	return hashTable->maxUsageFactor;
+	return self->size;
 }
 
-void Runtime_hashtable_set_max_usage_factor(Runtime_hashtable_handle self, double val)
+uint64T Runtime_static_dictionary_hash(const charT* key, uint64T size)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
-	hashTable->maxUsageFactor = val;
+	return Runtime_hash_basic_bytes((uint8T*)key, size);
 }
 
-double Runtime_hashtable_capacity_grow_by(Runtime_hashtable_handle self)
+const void* Runtime_static_dictionary_at(const Runtime_static_dictionary* self, Runtime_string_handle key)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
-	return hashTable->capacityGrowthFactor;
+	//same hash, and it's cached in the string
+	return Runtime_static_dictionary_find(self, Runtime_string_hash(key), Runtime_string_get_cstr(key), Runtime_string_size(key));
 }
 
-void Runtime_hashtable_set_capacity_grow_by(Runtime_hashtable_handle self, double val)
+const void* Runtime_static_dictionary_at_bytes(const Runtime_static_dictionary* self, const charT* key, uint64T size)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
-	hashTable->capacityGrowthFactor = val;
+	return Runtime_static_dictionary_find(self, Runtime_static_dictionary_hash(key, size), key, size);
 }
 
+//end of static dictionary
+//----------------------------------------------------------------------------
 
-void Runtime_hashtable_rebuild_hashes(
-	Runtime_hash_table_data_array oldTableData, 
-	Runtime_hash_table_data_array newTableData, 
-	uint64T oldCapacity, 
-	uint64T newCapacity,
-	Runtime_hashtable_info* info)
-{
-	for (uint64T i = 0; i < oldCapacity; i++) {
 
-		auto pair = oldTableData[i];
 
+//----------------------------------------------------------------------------
+//concurrent hashtable
+//linear probing over an array of node pointers. Nodes are 
+//immutable once published, an update swaps in a new node and an
+//erase swaps in a tombstone, so readers never take a lock, they 
+//just walk whatever table/nodes they loaded. Writers lock the 
+//stripe picked by the key's hash (so one key is only ever written
+//by one thread at a time) and claim empty or tombstone slots with 
+//a CAS since keys from other stripes can probe into the same run 
+//of slots. 
+//Resizing takes every stripe, readers carry on with the old table.
+//Replaced nodes and tables are freed once no reader that could 
+//have seen them is still running (epoch based reclamation)
+
+#define RUNTIME_CACHE_LINE_SIZE	64
+#define RUNTIME_CONCURRENT_STRIPES		64
+#define RUNTIME_CONCURRENT_READER_SLOTS	32
+#define RUNTIME_CONCURRENT_MIN_CAPACITY	64
+#define RUNTIME_CONCURRENT_MAX_USAGE	0.75
+//retired objects allowed to pile up before trying to free them
+#define RUNTIME_CONCURRENT_RETIRE_BATCH	64
+
+#define RUNTIME_CONCURRENT_TOMBSTONE	((void*)1)
+
+enum Runtime_concurrent_retired_kind {
+	rtRetiredNode = 0,
+	rtRetiredTable,
+};
 
+enum Runtime_concurrent_keep_flags {
+	rtKeepNone = 0,
+	//key/value handle now belongs to the replacing node
+	rtKeepKey = 0x01,
+	rtKeepValue = 0x02,
+};
 
-		if (nullptr != pair) {
+struct Runtime_concurrent_retired {
+	Runtime_concurrent_retired* next;
+	uint32T kind;
+	uint32T keepFlags;
+};
 
-			auto np = pair;
-			while (nullptr != np) {
-				auto idx = Runtime_hashtable_hash_index(info, newCapacity, np->keyPtr);
-				auto nextP = np->next;
+//key/value data follows the header, 16 byte aligned
+struct Runtime_concurrent_node {
+	Runtime_concurrent_retired retired;
+	uint64T hash;
+};
 
-				auto existingPair = newTableData[idx];
-				if (nullptr != existingPair) {
-					auto np2 = existingPair;
-					while (nullptr != np2) {
-						existingPair = np2;
-						np2 = np2->next;
-					}
-					np->next = nullptr;
-					existingPair->next = np;
-				}
-				else {
-					np->next = nullptr;
-					newTableData[idx] = np;
-				}
+#define RUNTIME_CONCURRENT_NODE_HEADER			((sizeof(Runtime_concurrent_node) + 15) & ~15)
+#define RUNTIME_CONCURRENT_NODE_DATA(node)		(((uint8T*)node) + RUNTIME_CONCURRENT_NODE_HEADER)
 
-				np = nextP;
-			}
-		}
-	}
-}
+struct Runtime_concurrent_table {
+	Runtime_concurrent_retired retired;
+	uint64T capacity;
+	void* volatile slots[1];
+};
 
-void Runtime_hashtable_set_capacity(Runtime_hashtable_handle self, uint64T capacity)
-{
-	RUNTIME_ASSERT(capacity!=0);
-	RUNTIME_ASSERT(nullptr != self);
+//SRWLOCK is pointer sized, padded out so stripes
+//don't share cache lines
+struct Runtime_concurrent_lock {
+	void* lock;
+	uint8T pad[RUNTIME_CACHE_LINE_SIZE - sizeof(void*)];
+};
 
-	auto hashTable = (Runtime_hashtable_object*)self;
-	auto oldCapacity = hashTable->capacity;
-	hashTable->capacity = capacity;
+//readers count themselves in the slot picked by thread id,
+//one counter per epoch parity
+struct Runtime_concurrent_reader_slot {
+	volatile int64T active[2];
+	uint8T pad[RUNTIME_CACHE_LINE_SIZE - 2 * sizeof(int64T)];
+};
+
+struct Runtime_concurrent_hashtable_object {
+	Runtime_concurrent_table* volatile table;
+	volatile int64T size;
+	//full + tombstone slots. Inserts reuse tombstones on their probe
+	//path, the rest are dropped by a resize
+	volatile int64T used;
+	double maxUsageFactor;
 
-	//Runtime_debug_printf("Runtime_hashtable_insert new cap: %I64u, size: %I64u\n", hashTable->capacity, hashTable->size);
-	uint64T allocSz = hashTable->capacity * (sizeof(Runtime_hash_pair*));
-	auto newTableData = (Runtime_hash_pair**)Runtime_alloc(allocSz, typeUnknown);
-	Runtime_Memory_init(newTableData, allocSz);
+	Runtime_hashtable_info* infoPtr;
 
-	Runtime_hashtable_rebuild_hashes(hashTable->tableData, newTableData, oldCapacity, hashTable->capacity, hashTable->infoPtr);
+	volatile int64T epoch;
+	Runtime_concurrent_lock retireLock;
+	//objects retired while epoch had the given parity
+	Runtime_concurrent_retired* retired[2];
+	uint64T retiredCount;
 
-	Runtime_free(hashTable->tableData);
+	Runtime_concurrent_reader_slot readers[RUNTIME_CONCURRENT_READER_SLOTS];
+	Runtime_concurrent_lock stripes[RUNTIME_CONCURRENT_STRIPES];
+};
 
-	hashTable->tableData = newTableData;
-}
 
-void Runtime_hashtable_clear(Runtime_hashtable_handle self)
+inline uint64T Runtime_concurrent_max_load(Runtime_concurrent_hashtable_object* concTable, uint64T capacity)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
+	return (uint64T)((double)capacity * concTable->maxUsageFactor);
+}
 
-	for (uint64T i = 0; i < hashTable->capacity; i++) {
-		auto pair = hashTable->tableData[i];
-		if (nullptr != pair) {
-			Runtime_hash_pair_free(pair, hashTable->infoPtr);
-		}
+Runtime_concurrent_table* Runtime_concurrent_table_new(uint64T capacity)
+{
+	uint64T sz = sizeof(Runtime_concurrent_table) + (capacity - 1) * sizeof(void*);
+	auto result = (Runtime_concurrent_table*)Runtime_alloc(sz, typeUnknown);
+	Runtime_Memory_init(result, sz);
 
-		hashTable->tableData[i] = nullptr;
-	}
-	hashTable->size = 0;
+	result->retired.kind = rtRetiredTable;
+	result->capacity = capacity;
+	return result;
 }
 
-void Runtime_hashtable_insert(Runtime_hashtable_handle self, void* key, void* val)
+Runtime_concurrent_node* Runtime_concurrent_node_new(Runtime_hashtable_info* info, uint64T hash, void* key, void* val)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
+	uint64T sz = RUNTIME_CONCURRENT_NODE_HEADER + info->slotStride;
+	auto result = (Runtime_concurrent_node*)Runtime_alloc(sz, typeUnknown);
 
-	uint64T tableMaxCap = ((double)hashTable->capacity) * hashTable->maxUsageFactor;
-	if (hashTable->size >= tableMaxCap) {		
-		Runtime_hashtable_set_capacity(self, (double)hashTable->capacity * hashTable->capacityGrowthFactor);
-	}
+	result->retired.next = nullptr;
+	result->retired.kind = rtRetiredNode;
+	result->retired.keepFlags = rtKeepNone;
+	result->hash = hash;
+	Runtime_hashtable_slot_assign(info, RUNTIME_CONCURRENT_NODE_DATA(result), key, val);
 
+	return result;
+}
 
-	auto idx = Runtime_hashtable_hash_index(hashTable->infoPtr, hashTable->capacity, key);
-	
-	auto pair = hashTable->tableData[idx];
+void Runtime_concurrent_free_retired(Runtime_concurrent_hashtable_object* concTable, Runtime_concurrent_retired* item)
+{
+	auto info = concTable->infoPtr;
 
-	if (pair == nullptr) {
-		//first time
-		pair = Runtime_hash_pair_new(hashTable->infoPtr);
-		hashTable->tableData[idx] = pair;		
-	}
-	else {
-		//find next
-		auto np = pair;
-		while (nullptr != np) {
-			pair = np;
-			np = np->next;
+	if (rtRetiredNode == item->kind) {
+		auto data = RUNTIME_CONCURRENT_NODE_DATA(item);
+		if (0 == (item->keepFlags & rtKeepKey)) {
+			Runtime_hashtable_destroy_value(info->keyType, info->keyTypeInfo, data);
+		}
+		if (0 == (item->keepFlags & rtKeepValue)) {
+			Runtime_hashtable_destroy_value(info->valueType, info->valTypeInfo, data + info->valOffset);
 		}
-		auto newPair = Runtime_hash_pair_new(hashTable->infoPtr);
-		pair->next = newPair;
-		pair = newPair;
 	}
 
-
-	Runtime_hash_pair_assign(pair, hashTable->infoPtr, key, val);
-
-	hashTable->size++;
+	Runtime_free(item);
 }
 
-void Runtime_hashtable_erase(Runtime_hashtable_handle self, void* key)
+void Runtime_concurrent_free_list(Runtime_concurrent_hashtable_object* concTable, Runtime_concurrent_retired* list)
 {
-	auto hashTable = (Runtime_hashtable_object*)self;
-	auto idx = Runtime_hashtable_hash_index(hashTable->infoPtr, hashTable->capacity, key);
-	
-	auto pair = hashTable->tableData[idx];
-	if (nullptr != pair) {
+	while (nullptr != list) {
+		auto next = list->next;
+		Runtime_concurrent_free_retired(concTable, list);
+		list = next;
+	}
+}
 
-		auto nextP = pair->next;
 
-		hashTable->tableData[idx] = nextP;
+//readers
 
-		Runtime_hash_pair_free(pair, hashTable->infoPtr);
+inline uint32T Runtime_concurrent_reader_slot_index()
+{
+	return Win32_current_thread_id() % RUNTIME_CONCURRENT_READER_SLOTS;
+}
 
-		hashTable->size--;
+int64T Runtime_concurrent_enter(Runtime_concurrent_hashtable_object* concTable, uint32T slotIdx)
+{
+	auto slot = &concTable->readers[slotIdx];
+
+	while (true) {
+		int64T epoch = concTable->epoch;
+		_InterlockedIncrement64(&slot->active[epoch & 1]);
+		//if the epoch moved on in between, a writer may not have
+		//seen us, go again with the new one
+		if (epoch == concTable->epoch) {
+			return epoch;
+		}
+		_InterlockedDecrement64(&slot->active[epoch & 1]);
 	}
-	
 }
 
-void* Runtime_hashtable_at(Runtime_hashtable_handle self, void* key)
+inline void Runtime_concurrent_leave(Runtime_concurrent_hashtable_object* concTable, uint32T slotIdx, int64T epoch)
 {
-	void* result = nullptr;
-	auto hashTable = (Runtime_hashtable_object*)self;
-	auto idx = Runtime_hashtable_hash_index(hashTable->infoPtr, hashTable->capacity, key);
+	_InterlockedDecrement64(&concTable->readers[slotIdx].active[epoch & 1]);
+}
 
-	auto pair = hashTable->tableData[idx];
-	if (nullptr != pair) {
-		if (nullptr != pair->next) {
-			pair = Runtime_hash_pair_find(pair, hashTable->infoPtr, key);
-		}
 
+//writers, called with retireLock held. The epoch can go from e to
+//e+1 once every reader from e-1 has left, anything retired during
+//e-1 can't be reached by anyone at that point
+bool Runtime_concurrent_try_advance(Runtime_concurrent_hashtable_object* concTable)
+{
+	int64T epoch = concTable->epoch;
+	int64T prevParity = (epoch - 1) & 1;
 
-		if (nullptr != pair) {
-			result = pair->valPtr;
+	for (uint32T i = 0; i < RUNTIME_CONCURRENT_READER_SLOTS; i++) {
+		if (0 != concTable->readers[i].active[prevParity]) {
+			return false;
 		}
 	}
-	
 
-	return result;
+	auto freeList = concTable->retired[prevParity];
+	concTable->retired[prevParity] = nullptr;
+	_InterlockedExchange64(&concTable->epoch, epoch + 1);
 
+	while (nullptr != freeList) {
+		auto next = freeList->next;
+		Runtime_concurrent_free_retired(concTable, freeList);
+		concTable->retiredCount--;
+		freeList = next;
+	}
+
+	return true;
 }
 
+void Runtime_concurrent_retire(Runtime_concurrent_hashtable_object* concTable, Runtime_concurrent_retired* item)
+{
+	Win32_lock_acquire(&concTable->retireLock.lock);
 
-//end of hashtable
-//----------------------------------------------------------------------------
+	auto parity = concTable->epoch & 1;
+	item->next = concTable->retired[parity];
+	concTable->retired[parity] = item;
+	concTable->retiredCount++;
 
+	if (concTable->retiredCount >= RUNTIME_CONCURRENT_RETIRE_BATCH) {
+		Runtime_concurrent_try_advance(concTable);
+	}
 
+	Win32_lock_release(&concTable->retireLock.lock);
+}
 
-//----------------------------------------------------------------------------
-//dictionary
 
-Runtime_dictionary_handle Runtime_dictionary_new(Runtime_TypeDescriptor valType)
+//probes table for key, returns the node and its slot index, or nullptr
+Runtime_concurrent_node* Runtime_concurrent_table_find(Runtime_hashtable_info* info, Runtime_concurrent_table* table, uint64T hash, void* key, uint64T* idxPtr)
 {
-	Runtime_dictionary_handle result = nullptr;
+	uint64T mask = table->capacity - 1;
+	uint64T idx = hash & mask;
 
+	for (uint64T n = 0; n < table->capacity; n++) {
+		auto ptr = table->slots[idx];
+		if (nullptr == ptr) {
+			break;
+		}
 
-	result = Runtime_hashtable_new(typeString, valType);
+		if (RUNTIME_CONCURRENT_TOMBSTONE != ptr) {
+			auto node = (Runtime_concurrent_node*)ptr;
+			if (node->hash == hash && 
+				Runtime_hashtable_key_equals(info, Runtime_hashtable_slot_key_ref(info, RUNTIME_CONCURRENT_NODE_DATA(node)), key)) {
+				*idxPtr = idx;
+				return node;
+			}
+		}
 
+		idx = (idx + 1) & mask;
+	}
 
-	return result;
+	return nullptr;
 }
 
-void Runtime_dictionary_delete(Runtime_dictionary_handle self)
+inline Runtime_concurrent_lock* Runtime_concurrent_stripe(Runtime_concurrent_hashtable_object* concTable, uint64T hash)
 {
-	Runtime_hashtable_delete(self);
+	//top bits, the low ones pick the slot
+	return &concTable->stripes[(hash >> 48) & (RUNTIME_CONCURRENT_STRIPES - 1)];
 }
 
-
-bool Runtime_dictionary_empty(Runtime_dictionary_handle self)
+//takes every stripe so no writer is active, readers keep
+//going on the old table until it's retired
+void Runtime_concurrent_resize(Runtime_concurrent_hashtable_object* concTable, Runtime_concurrent_table* seenTable)
 {
-	return Runtime_hashtable_empty(self);
+	for (uint32T i = 0; i < RUNTIME_CONCURRENT_STRIPES; i++) {
+		Win32_lock_acquire(&concTable->stripes[i].lock);
+	}
+
+	auto table = concTable->table;
+	//someone else already resized
+	if (table == seenTable) {
+		uint64T newCapacity = RUNTIME_CONCURRENT_MIN_CAPACITY;
+		while (Runtime_concurrent_max_load(concTable, newCapacity) < (uint64T)concTable->size * 2) {
+			newCapacity <<= 1;
+		}
+
+		auto newTable = Runtime_concurrent_table_new(newCapacity);
+		uint64T mask = newCapacity - 1;
+		for (uint64T i = 0; i < table->capacity; i++) {
+			auto ptr = table->slots[i];
+			if (nullptr == ptr || RUNTIME_CONCURRENT_TOMBSTONE == ptr) {
+				continue;
+			}
+
+			uint64T idx = ((Runtime_concurrent_node*)ptr)->hash & mask;
+			while (nullptr != newTable->slots[idx]) {
+				idx = (idx + 1) & mask;
+			}
+			newTable->slots[idx] = ptr;
+		}
+
+		concTable->used = concTable->size;
+		_InterlockedExchangePointer((void* volatile*)&concTable->table, newTable);
+
+		Runtime_concurrent_retire(concTable, &table->retired);
+	}
+
+	for (uint32T i = RUNTIME_CONCURRENT_STRIPES; i > 0; i--) {
+		Win32_lock_release(&concTable->stripes[i - 1].lock);
+	}
 }
 
-uint64T Runtime_dictionary_size(Runtime_dictionary_handle self)
+
+Runtime_concurrent_hashtable_handle Runtime_concurrent_hashtable_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType)
 {
-	return Runtime_hashtable_size(self);
+	auto hashTableInfo = Runtime_get_hashtable_info_for_type(keyType, valType);
+	RUNTIME_ASSERT(nullptr != hashTableInfo);
+
+	auto result = (Runtime_concurrent_hashtable_object*)Runtime_alloc(sizeof(Runtime_concurrent_hashtable_object), typeDictionary);
+	Runtime_Memory_init(result, sizeof(Runtime_concurrent_hashtable_object));
+
+	result->infoPtr = hashTableInfo;
+	result->maxUsageFactor = RUNTIME_CONCURRENT_MAX_USAGE;
+	result->table = Runtime_concurrent_table_new(RUNTIME_CONCURRENT_MIN_CAPACITY);
+
+	Win32_lock_init(&result->retireLock.lock);
+	for (uint32T i = 0; i < RUNTIME_CONCURRENT_STRIPES; i++) {
+		Win32_lock_init(&result->stripes[i].lock);
+	}
+
+	return (Runtime_concurrent_hashtable_handle)result;
 }
 
-uint64T Runtime_dictionary_capacity(Runtime_dictionary_handle self)
+//no other thread may be using the table
+void Runtime_concurrent_hashtable_delete(Runtime_concurrent_hashtable_handle self)
 {
-	return Runtime_hashtable_capacity(self);
+	auto concTable = (Runtime_concurrent_hashtable_object*)self;
+	auto table = concTable->table;
+
+	for (uint64T i = 0; i < table->capacity; i++) {
+		auto ptr = table->slots[i];
+		if (nullptr != ptr && RUNTIME_CONCURRENT_TOMBSTONE != ptr) {
+			Runtime_concurrent_free_retired(concTable, (Runtime_concurrent_retired*)ptr);
+		}
+	}
+	Runtime_free(table);
+
+	Runtime_concurrent_free_list(concTable, concTable->retired[0]);
+	Runtime_concurrent_free_list(concTable, concTable->retired[1]);
+
+	Runtime_free(concTable);
 }
 
-void Runtime_dictionary_set_capacity(Runtime_dictionary_handle self, uint64T capacity)
+uint64T Runtime_concurrent_hashtable_size(Runtime_concurrent_hashtable_handle self)
 {
-	Runtime_hashtable_set_capacity(self, capacity);
+	auto concTable = (Runtime_concurrent_hashtable_object*)self;
+	return (uint64T)concTable->size;
 }
 
-void Runtime_dictionary_clear(Runtime_dictionary_handle self)
+uint64T Runtime_concurrent_hashtable_capacity(Runtime_concurrent_hashtable_handle self)
 {
-	Runtime_hashtable_clear(self);
+	auto concTable = (Runtime_concurrent_hashtable_object*)self;
+	return concTable->table->capacity;
 }
 
-void Runtime_dictionary_insert(Runtime_dictionary_handle self, Runtime_string_handle key, void* val)
+void Runtime_concurrent_hashtable_insert(Runtime_concurrent_hashtable_handle self, void* key, void* val)
 {
-	Runtime_hashtable_insert(self, key, val);
+	auto concTable = (Runtime_concurrent_hashtable_object*)self;
+	auto info = concTable->infoPtr;
+
+	auto hash = Runtime_hashtable_hash_key(info, key);
+	auto stripe = Runtime_concurrent_stripe(concTable, hash);
+	auto newNode = Runtime_concurrent_node_new(info, hash, key, val);
+
+	while (true) {
+		Win32_lock_acquire(&stripe->lock);
+
+		//can't change while we hold a stripe
+		auto table = concTable->table;
+		uint64T idx = 0;
+		auto oldNode = Runtime_concurrent_table_find(info, table, hash, key, &idx);
+
+		if (nullptr != oldNode) {
+			auto oldData = RUNTIME_CONCURRENT_NODE_DATA(oldNode);
+			if (Runtime_hashtable_slot_key_ref(info, oldData) == key) {
+				oldNode->retired.keepFlags |= rtKeepKey;
+			}
+			if (Runtime_hashtable_slot_val_ref(info, oldData) == val) {
+				oldNode->retired.keepFlags |= rtKeepValue;
+			}
+
+			_InterlockedExchangePointer(&table->slots[idx], newNode);
+			Win32_lock_release(&stripe->lock);
+
+			Runtime_concurrent_retire(concTable, &oldNode->retired);
+			return;
+		}
+
+		//a tombstone is already counted in used, only taking an
+		//empty slot needs room under the max load
+		bool placed = false;
+		bool reused = false;
+		bool roomForNew = (uint64T)concTable->used < Runtime_concurrent_max_load(concTable, table->capacity);
+		uint64T mask = table->capacity - 1;
+		idx = hash & mask;
+		for (uint64T n = 0; n < table->capacity && !placed; n++) {
+			auto ptr = table->slots[idx];
+			if (RUNTIME_CONCURRENT_TOMBSTONE == ptr) {
+				reused = placed = RUNTIME_CONCURRENT_TOMBSTONE == _InterlockedCompareExchangePointer(&table->slots[idx], newNode, RUNTIME_CONCURRENT_TOMBSTONE);
+			}
+			else if (nullptr == ptr) {
+				if (!roomForNew) {
+					break;
+				}
+				placed = nullptr == _InterlockedCompareExchangePointer(&table->slots[idx], newNode, nullptr);
+			}
+			idx = (idx + 1) & mask;
+		}
+
+		if (placed) {
+			if (!reused) {
+				_InterlockedIncrement64(&concTable->used);
+			}
+			_InterlockedIncrement64(&concTable->size);
+			Win32_lock_release(&stripe->lock);
+			return;
+		}
+
+		Win32_lock_release(&stripe->lock);
+		Runtime_concurrent_resize(concTable, table);
+	}
 }
 
-void Runtime_dictionary_erase(Runtime_dictionary_handle self, Runtime_string_handle key)
+bool Runtime_concurrent_hashtable_erase(Runtime_concurrent_hashtable_handle self, void* key)
 {
-	Runtime_hashtable_erase(self, key);
-}
+	auto concTable = (Runtime_concurrent_hashtable_object*)self;
+	auto info = concTable->infoPtr;
 
+	auto hash = Runtime_hashtable_hash_key(info, key);
+	auto stripe = Runtime_concurrent_stripe(concTable, hash);
 
+	Win32_lock_acquire(&stripe->lock);
 
-//[] access
-void* Runtime_dictionary_at(Runtime_dictionary_handle self, Runtime_string_handle key)
-{	
-	return Runtime_hashtable_at(self, key);
+	auto table = concTable->table;
+	uint64T idx = 0;
+	auto node = Runtime_concurrent_table_find(info, table, hash, key, &idx);
+	if (nullptr != node) {
+		_InterlockedExchangePointer(&table->slots[idx], RUNTIME_CONCURRENT_TOMBSTONE);
+		_InterlockedDecrement64(&concTable->size);
+	}
+
+	Win32_lock_release(&stripe->lock);
+
+	if (nullptr == node) {
+		return false;
+	}
+
+	Runtime_concurrent_retire(concTable, &node->retired);
+	return true;
 }
 
+//copies the value out while the node is guaranteed to be alive.
+//Once we leave the epoch a writer can free the node's value, so 
+//handle values are deep copied and user types go through their
+//copy hook, the caller owns what lands in valOut
+bool Runtime_concurrent_hashtable_get(Runtime_concurrent_hashtable_handle self, void* key, void* valOut)
+{
+	auto concTable = (Runtime_concurrent_hashtable_object*)self;
+	auto info = concTable->infoPtr;
+
+	auto hash = Runtime_hashtable_hash_key(info, key);
+	auto readerSlot = Runtime_concurrent_reader_slot_index();
+	auto epoch = Runtime_concurrent_enter(concTable, readerSlot);
+
+	uint64T idx = 0;
+	auto node = Runtime_concurrent_table_find(info, concTable->table, hash, key, &idx);
+	if (nullptr != node && nullptr != valOut) {
+		auto valRef = Runtime_hashtable_slot_val_ref(info, RUNTIME_CONCURRENT_NODE_DATA(node));
+		Runtime_hashtable_value_assign(info->valueType, info->valTypeInfo, info->valStride, (uint8T*)valOut, 
+			Runtime_hashtable_value_dup(info->valueType, valRef));
+	}
+
+	Runtime_concurrent_leave(concTable, readerSlot, epoch);
+
+	return nullptr != node;
+}
 
+bool Runtime_concurrent_hashtable_contains(Runtime_concurrent_hashtable_handle self, void* key)
+{
+	return Runtime_concurrent_hashtable_get(self, key, nullptr);
+}
 
 
 
-//end of dictionary
+//end of concurrent hashtable
 //----------------------------------------------------------------------------
 
 
+
 int32T Runtime_init()
 {
 	int result = 0;
+	Runtime_output_init();
 	Runtime_debug_printf("Runtime_init\n");
 
 	totalBytesHeapAllocated = 0;
 
+	runtimeCpuFeatures = Runtime_detect_cpu_features();
+
 	runtimeInstancePtr = (Runtime_Instance*) Runtime_alloc( sizeof(Runtime_Instance), typeUnknown);
 	
 	
@@ -2289,42 +10353,47 @@ int32T Runtime_init()
 										typeString,
 										typeArray,
 										typeDictionary,
-										typeMessage };
+										typeMessage,
+										typeSet };
 
 	uint32T typeCount = sizeof(types) / sizeof(types[0]);
-	
-	runtimeInstancePtr->initialArrayInfoSize = typeCount;
-	runtimeInstancePtr->arrayInfoList = (Runtime_array_info*)Runtime_alloc(sizeof(Runtime_array_info) * runtimeInstancePtr->initialArrayInfoSize, typeUnknown);
-	runtimeInstancePtr->arrayInfoListSize = runtimeInstancePtr->initialArrayInfoSize;
 
+	Runtime_Memory_init(runtimeInstancePtr, sizeof(Runtime_Instance));
+	for (uint32T i = 0; i < RUNTIME_BUILTIN_TYPE_TABLE_SIZE; i++) {
+		runtimeInstancePtr->builtinTypeSlots[i] = RUNTIME_NO_TYPE_SLOT;
+	}
+
+	runtimeInstancePtr->builtinTypeCount = typeCount;
+	runtimeInstancePtr->typeSlotCapacity = typeCount + Runtime_max_user_types;
 	
-	runtimeInstancePtr->initialHashtableInfoSize = typeCount * typeCount;
-	runtimeInstancePtr->hashtableInfoList = (Runtime_hashtable_info*)Runtime_alloc(sizeof(Runtime_hashtable_info) * runtimeInstancePtr->initialHashtableInfoSize, typeUnknown);
-	runtimeInstancePtr->hashtableInfoListSize = runtimeInstancePtr->initialHashtableInfoSize;
+	runtimeInstancePtr->initialArrayInfoSize = typeCount;
+	runtimeInstancePtr->arrayInfoList = (Runtime_array_info*)Runtime_alloc(sizeof(Runtime_array_info) * runtimeInstancePtr->typeSlotCapacity, typeUnknown);
+	runtimeInstancePtr->arrayInfoListSize = 0;
 
+	runtimeInstancePtr->typeInfoList = (Runtime_type_info*)Runtime_alloc(sizeof(Runtime_type_info) * runtimeInstancePtr->typeSlotCapacity, typeUnknown);
 
-	for (uint32T i = 0; i < runtimeInstancePtr->arrayInfoListSize;i++) {
-		Runtime_array_info* arrInfo = &runtimeInstancePtr->arrayInfoList[i];
-		Runtime_Memory_init(arrInfo, sizeof(Runtime_array_info));
-		arrInfo->elementType = types[i];
-		arrInfo->stride = Runtime_calc_stride_for_type(arrInfo->elementType);		
-	}
+	runtimeInstancePtr->hashtableInfoRows = (Runtime_hashtable_info**)Runtime_alloc(sizeof(Runtime_hashtable_info*) * runtimeInstancePtr->typeSlotCapacity, typeUnknown);
+	Runtime_Memory_init(runtimeInstancePtr->hashtableInfoRows, sizeof(Runtime_hashtable_info*) * runtimeInstancePtr->typeSlotCapacity);
 
+	runtimeInstancePtr->setInfoList = (Runtime_hashtable_info*)Runtime_alloc(sizeof(Runtime_hashtable_info) * runtimeInstancePtr->typeSlotCapacity, typeUnknown);
 
+	Win32_lock_init(&runtimeInstancePtr->hashtableStatsLock);
 
-	for (uint32T k = 0; k < typeCount; k++) {
-		for (uint32T v = 0; v < typeCount; v++) {
-			Runtime_hashtable_info* htInfo = &runtimeInstancePtr->hashtableInfoList[k* typeCount + v];
-			Runtime_Memory_init(htInfo, sizeof(Runtime_hashtable_info));
 
+	for (uint32T i = 0; i < typeCount;i++) {
+		Runtime_type_info typeInfo;
+		Runtime_Memory_init(&typeInfo, sizeof(Runtime_type_info));
+		typeInfo.type = types[i];
+		typeInfo.baseType = types[i];
+		typeInfo.size = Runtime_calc_stride_for_type(types[i]);
+		typeInfo.alignment = typeInfo.size > 16 ? 16 : typeInfo.size;
 
-			htInfo->keyType = types[k];
-			htInfo->valueType = types[v];
-			htInfo->keyStride = Runtime_calc_stride_for_type(htInfo->keyType);
-			htInfo->valStride = Runtime_calc_stride_for_type(htInfo->valueType);
-		}
+		runtimeInstancePtr->builtinTypeSlots[types[i]] = (uint16T)i;
+		Runtime_type_slot_init(i, &typeInfo);
 	}
 
+	Runtime_string_intern_init();
+
 	return 1;
 }
 
@@ -2449,8 +10518,19 @@ void Runtime_terminate()
 {
 	Runtime_debug_printf("Runtime_terminate\n");
 
+	//before the stats dump, deleting the pool records stats too
+	Runtime_string_intern_terminate();
+	Runtime_hashtable_stats_dump();
+
+	for (uint32T k = 0; k < runtimeInstancePtr->typeSlotCapacity; k++) {
+		if (nullptr != runtimeInstancePtr->hashtableInfoRows[k]) {
+			Runtime_free(runtimeInstancePtr->hashtableInfoRows[k]);
+		}
+	}
+	Runtime_free(runtimeInstancePtr->hashtableInfoRows);
+	Runtime_free(runtimeInstancePtr->setInfoList);
+	Runtime_free(runtimeInstancePtr->typeInfoList);
 	Runtime_free(runtimeInstancePtr->arrayInfoList);
-	Runtime_free(runtimeInstancePtr->hashtableInfoList);
 	Runtime_free(runtimeInstancePtr);
 	runtimeInstancePtr = nullptr;
 
@@ -2458,4 +10538,5 @@ void Runtime_terminate()
 	Runtime_debug_printf("bytes leftover : %I64u\n", totalBytesHeapAllocated);
 
 	Runtime_debug_printf("Runtime_terminate finished\n");
+	Runtime_output_flush();
 }
\ No newline at end of file
@@ -19,6 +19,8 @@
 #pragma message("Scratch Runtime Lib in RELEASE mode")
 #endif //SCRATCH_RUNTIME_DEBUG
 
+#include "runtime_string_flags.h"
+
 
 #ifdef __cplusplus
 extern "C" {
@@ -60,8 +62,13 @@ extern "C" {
 		typeArray,
 		typeDictionary,
 		typeMessage,
+		typeSet,
 		typeNilPtr=0xDEAD,
 		typeUnmanagedPtr = 0xBEEF,
+
+		//records/classes registered at runtime with
+		//Runtime_register_type get typeUserTypeBase + N
+		typeUserTypeBase = 0x10000,
 	};
 
 
@@ -238,6 +245,54 @@ extern "C" {
 
 
 
+	//----------------------------------------------------------------------------
+	//type registry
+	//every type a container can hold has an entry here, built-in
+	//types are registered by Runtime_init, records and classes
+	//are registered by the compiled program so containers can
+	//hold them by value
+
+	typedef void (*Runtime_type_copy_func)(void* dest, const void* src);
+	typedef void (*Runtime_type_destroy_func)(void* obj);
+	typedef uint64T (*Runtime_type_hash_func)(const void* obj);
+	typedef bool (*Runtime_type_equals_func)(const void* lhs, const void* rhs);
+	//< 0, 0 or > 0 as lhs is before, the same as or after rhs
+	typedef int32T (*Runtime_type_compare_func)(const void* lhs, const void* rhs);
+
+	struct Runtime_type_info {
+		//the registered type, filled in by Runtime_register_type
+		Runtime_TypeDescriptor type;
+		//typeRecord or typeClass for user types
+		Runtime_TypeDescriptor baseType;
+
+		uint64T size;
+		uint64T alignment;
+
+		//all hooks are optional. Without copy/destroy the
+		//bytes are copied and nothing is destroyed, without
+		//hash/equals/compare the bytes are hashed/compared
+		Runtime_type_copy_func copy;
+		Runtime_type_destroy_func destroy;
+		Runtime_type_hash_func hash;
+		Runtime_type_equals_func equals;
+		//orders keys of ordered maps
+		Runtime_type_compare_func compare;
+
+		const char* name;
+	};
+
+	constexpr uint32T Runtime_max_user_types = 256;
+
+	//returns the new type descriptor, or typeUnknown if the
+	//registry is full or the size/alignment are invalid
+	//(alignment must be a power of 2, no bigger than 16)
+	Runtime_TypeDescriptor Runtime_register_type(const Runtime_type_info* info);
+
+	const Runtime_type_info* Runtime_get_type_info(Runtime_TypeDescriptor type);
+
+
+
+
 	//----------------------------------------------------------------------------
 	//arrays
 
@@ -306,6 +361,84 @@ extern "C" {
 
 	Runtime_array_cmp_result Runtime_array_compare(Runtime_array_handle self, Runtime_array_handle rhs);
 
+
+	//file backed arrays
+	//the file is mapped directly as the array's storage,
+	//nothing is read/copied up front. Only primitive element
+	//types are allowed. The file starts with a
+	//Runtime_mapped_array_header, the elements start at
+	//dataOffset bytes into the file
+	enum Runtime_array_map_mode {
+		rtArrayMapReadOnly = 0,
+		rtArrayMapReadWrite = 1,
+	};
+
+	constexpr uint32T Runtime_mapped_array_magic = 0x41524353; //"SCRA"
+	constexpr uint32T Runtime_mapped_array_version = 1;
+
+	struct Runtime_mapped_array_header {
+		uint32T magic;
+		uint32T version;
+		uint32T elementType; //Runtime_TypeDescriptor
+		uint32T stride;
+		uint64T count;
+		uint64T dataOffset;
+	};
+
+	//maps an existing file, returns nullptr if the file can't be
+	//mapped or its header doesn't match type
+	Runtime_array_handle Runtime_array_new_mapped(const char* path, Runtime_TypeDescriptor type, Runtime_array_map_mode mode);
+
+	//creates (or truncates) the file at path, sized for size elements,
+	//and maps it read/write
+	Runtime_array_handle Runtime_array_new_mapped_with_size(const char* path, uint64T size, Runtime_TypeDescriptor type);
+
+	bool Runtime_array_is_mapped(Runtime_array_handle self);
+
+	//writes dirty pages of a read/write mapped array back to disk
+	//no-op for any other kind of array
+	bool Runtime_array_flush(Runtime_array_handle self);
+
+
+	//packed bit arrays
+	//arrays of typeBit1 store 64 bits per uint64T word.
+	//Runtime_array_new(size, typeBit1) creates one of these,
+	//Runtime_array_size() is the number of bits, and
+	//Runtime_array_at()/Runtime_array_data() point at the
+	//words, not individual bits
+	Runtime_array_handle Runtime_bitarray_new(uint64T bitCount);
+
+	bool Runtime_bitarray_get(Runtime_array_handle self, uint64T index);
+	void Runtime_bitarray_set(Runtime_array_handle self, uint64T index, bool val);
+	void Runtime_bitarray_flip(Runtime_array_handle self, uint64T index);
+	void Runtime_bitarray_set_all(Runtime_array_handle self, bool val);
+
+	//Runtime_array_reserve/resize/copy come here for bit arrays,
+	//capacities are in bits
+	void Runtime_bitarray_reserve(Runtime_array_handle self, uint64T bitCapacity);
+	void Runtime_bitarray_resize(Runtime_array_handle self, uint64T newBitCount);
+	void Runtime_bitarray_copy(Runtime_array_handle self, Runtime_array_handle src);
+	void Runtime_bitarray_append(Runtime_array_handle self, bool val);
+	//Runtime_array_insert/append/append_from come here for bit 
+	//arrays, newElement points at a bool
+	void Runtime_bitarray_insert(Runtime_array_handle self, uint64T index, bool val);
+	void Runtime_bitarray_append_from(Runtime_array_handle self, Runtime_array_handle src);
+
+	//number of set bits
+	uint64T Runtime_bitarray_count(Runtime_array_handle self);
+	//number of set bits in [0, index)
+	uint64T Runtime_bitarray_rank(Runtime_array_handle self, uint64T index);
+	//index of the first set bit at or after start, or Runtime_NoIndx
+	uint64T Runtime_bitarray_find_next_set(Runtime_array_handle self, uint64T start);
+
+	//bulk ops, self = self op rhs. If rhs is shorter than self,
+	//the missing bits of rhs are treated as 0
+	void Runtime_bitarray_and(Runtime_array_handle self, Runtime_array_handle rhs);
+	void Runtime_bitarray_or(Runtime_array_handle self, Runtime_array_handle rhs);
+	void Runtime_bitarray_xor(Runtime_array_handle self, Runtime_array_handle rhs);
+	//self = self & ~rhs
+	void Runtime_bitarray_andnot(Runtime_array_handle self, Runtime_array_handle rhs);
+
 	//----------------------------------------------------------------------------
 
 
@@ -313,6 +446,10 @@ extern "C" {
 	//----------------------------------------------------------------------------
 	//hashtable
 	//any key, any value
+	//open addressing, capacity is always a power of 2.
+	//string/array/dictionary keys and values are owned 
+	//by the table once inserted, at() returns the handle
+	//for those, a pointer to the stored value otherwise
 	typedef void* Runtime_hashtable_handle;
 
 	
@@ -320,11 +457,14 @@ extern "C" {
 
 
 	Runtime_hashtable_handle Runtime_hashtable_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType);
+	//iterates in insertion order
+	Runtime_hashtable_handle Runtime_hashtable_new_ordered(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType);
 	void Runtime_hashtable_delete(Runtime_hashtable_handle self);
 
 
 	bool Runtime_hashtable_empty(Runtime_hashtable_handle self);
 	uint64T Runtime_hashtable_size(Runtime_hashtable_handle self);
+	bool Runtime_hashtable_is_ordered(Runtime_hashtable_handle self);
 	
 	uint64T Runtime_hashtable_capacity(Runtime_hashtable_handle self);
 	void Runtime_hashtable_set_capacity(Runtime_hashtable_handle self, uint64T capacity);
@@ -335,6 +475,11 @@ extern "C" {
 	double Runtime_hashtable_capacity_grow_by(Runtime_hashtable_handle self);
 	void Runtime_hashtable_set_capacity_grow_by(Runtime_hashtable_handle self, double val);
 
+	//on by default. Large tables grow by moving a few groups 
+	//of entries per insert/erase instead of all at once
+	bool Runtime_hashtable_incremental_resize(Runtime_hashtable_handle self);
+	void Runtime_hashtable_set_incremental_resize(Runtime_hashtable_handle self, bool val);
+
 
 	void Runtime_hashtable_clear(Runtime_hashtable_handle self);	
 
@@ -345,6 +490,91 @@ extern "C" {
 
 	//[] access
 	void* Runtime_hashtable_at(Runtime_hashtable_handle self, void* key);
+
+	//same as calling insert/at for each key in turn, but faster 
+	//for big tables. keys/vals hold count elements laid out like 
+	//array data of the key/value type, results[i] gets what at() 
+	//would return for the i'th key
+	void Runtime_hashtable_insert_batch(Runtime_hashtable_handle self, void* keys, void* vals, uint64T count);
+	void Runtime_hashtable_at_batch(Runtime_hashtable_handle self, void* keys, void** results, uint64T count);
+
+	//insert/at for a specific key/value pair, faster than the
+	//generic calls. The table has to have been created with 
+	//matching types (signed or unsigned, string keys are the 
+	//string handle). Generic insert/at use these internally 
+	//when the table's types have one
+	void Runtime_hashtable_insert_i32_i32(Runtime_hashtable_handle self, int32T key, int32T val);
+	int32T* Runtime_hashtable_at_i32_i32(Runtime_hashtable_handle self, int32T key);
+	void Runtime_hashtable_insert_i32_i64(Runtime_hashtable_handle self, int32T key, int64T val);
+	int64T* Runtime_hashtable_at_i32_i64(Runtime_hashtable_handle self, int32T key);
+	void Runtime_hashtable_insert_i32_f64(Runtime_hashtable_handle self, int32T key, double64T val);
+	double64T* Runtime_hashtable_at_i32_f64(Runtime_hashtable_handle self, int32T key);
+
+	void Runtime_hashtable_insert_i64_i32(Runtime_hashtable_handle self, int64T key, int32T val);
+	int32T* Runtime_hashtable_at_i64_i32(Runtime_hashtable_handle self, int64T key);
+	void Runtime_hashtable_insert_i64_i64(Runtime_hashtable_handle self, int64T key, int64T val);
+	int64T* Runtime_hashtable_at_i64_i64(Runtime_hashtable_handle self, int64T key);
+	void Runtime_hashtable_insert_i64_f64(Runtime_hashtable_handle self, int64T key, double64T val);
+	double64T* Runtime_hashtable_at_i64_f64(Runtime_hashtable_handle self, int64T key);
+
+	void Runtime_hashtable_insert_str_i32(Runtime_hashtable_handle self, void* key, int32T val);
+	int32T* Runtime_hashtable_at_str_i32(Runtime_hashtable_handle self, void* key);
+	void Runtime_hashtable_insert_str_i64(Runtime_hashtable_handle self, void* key, int64T val);
+	int64T* Runtime_hashtable_at_str_i64(Runtime_hashtable_handle self, void* key);
+	void Runtime_hashtable_insert_str_f64(Runtime_hashtable_handle self, void* key, double64T val);
+	double64T* Runtime_hashtable_at_str_f64(Runtime_hashtable_handle self, void* key);
+
+
+	//iteration, key/value are what at() would return for the entry. 
+	//Any insert/erase invalidates the iterator
+	//	Runtime_hashtable_iter it;
+	//	Runtime_hashtable_iter_init(ht, &it);
+	//	while (Runtime_hashtable_iter_next(&it)) { ... }
+	struct Runtime_hashtable_iter {
+		Runtime_hashtable_handle table;
+		uint64T pos;
+		void* key;
+		void* value;
+	};
+
+	void Runtime_hashtable_iter_init(Runtime_hashtable_handle self, Runtime_hashtable_iter* iter);
+	bool Runtime_hashtable_iter_next(Runtime_hashtable_iter* iter);
+	void* Runtime_hashtable_iter_key(Runtime_hashtable_iter* iter);
+	void* Runtime_hashtable_iter_value(Runtime_hashtable_iter* iter);
+
+
+	//diagnostics, for tuning max_usage_factor/capacity_grow_by
+	struct Runtime_hashtable_stats {
+		Runtime_TypeDescriptor keyType;
+		Runtime_TypeDescriptor valueType;
+
+		uint64T size;
+		uint64T capacity;
+		double loadFactor;
+		//slots holding a deleted key, they still cost probes
+		uint64T tombstones;
+
+		//groups of 16 slots looked at to find a key, 1 if it's
+		//in the group its hash points to
+		uint64T maxProbeLength;
+		double avgProbeLength;
+
+		uint32T resizeCount;
+
+		//key/value data (the slots, or the entry array for ordered
+		//tables) vs everything else, control bytes and for ordered
+		//tables the slots that index the entries
+		uint64T entryBytes;
+		uint64T tableBytes;
+	};
+
+	void Runtime_hashtable_get_stats(Runtime_hashtable_handle self, Runtime_hashtable_stats* stats);
+
+	//process wide, call after Runtime_init. While count isn't 0 the
+	//stats of every table are taken when it's deleted, and the count 
+	//largest are printed by Runtime_terminate, which also takes the
+	//stats of the tables created since and still alive then. At most 64
+	void Runtime_hashtable_set_stats_dump(uint32T count);
 	
 	//----------------------------------------------------------------------------
 
@@ -352,6 +582,7 @@ extern "C" {
 
 	//----------------------------------------------------------------------------
 	//strings
+	//chars are always 0 terminated, sizes don't count the 0
 	typedef int8T charT;
 	
 
@@ -381,14 +612,244 @@ extern "C" {
 	charT Runtime_string_at(Runtime_string_handle self, uint64T index);
 	void Runtime_string_set(Runtime_string_handle self, uint64T index, charT ch);
 
+	//grows the capacity geometrically, repeated appends are amortized O(1) per char
+	void Runtime_string_append(Runtime_string_handle self, const charT* c_strPtr);
+	void Runtime_string_append_with_size(Runtime_string_handle self, const charT* c_strPtr, uint64T size);
+	void Runtime_string_append_string(Runtime_string_handle self, Runtime_string_handle rhs);
+	//new string, lhs + rhs
+	Runtime_string_handle Runtime_string_concat(Runtime_string_handle lhs, Runtime_string_handle rhs);
+
 	int32T Runtime_string_compare(Runtime_string_handle self, Runtime_string_handle rhs);
 
+	//a substring longer than 23 chars is a view sharing self's chars,
+	//nothing is copied, shorter ones are copied into the new string.
+	//A view keeps the chars it was made from alive, self can still be
+	//changed or deleted, changing it moves it to new chars. Changing 
+	//a view copies its chars first, as does get_cstr if the view 
+	//doesn't reach the end of its parent. Returns null if out of range
 	Runtime_string_handle Runtime_string_substr(Runtime_string_handle self, uint64T start, uint64T count);
+	//a view gets its own copy of its chars and lets go of the 
+	//parent, so a small view doesn't keep a huge parent alive
+	void Runtime_string_compact(Runtime_string_handle self);
+	bool Runtime_string_is_view(Runtime_string_handle self);
+
+	//string literals. The compiler emits each one as constant data 
+	//laid out as a Runtime_static_string, size and hash filled in, data 
+	//pointing at its own chars. They're immortal: delete does nothing, 
+	//the runtime never writes to them, and changing one does nothing.
+	//A pointer to one is a Runtime_string_handle, no allocation or copy
+	constexpr uint32T Runtime_static_string_small_capacity = 23;
+	//immortal, utf-8 checked
+	constexpr uint32T Runtime_static_string_flags = RUNTIME_STRING_FLAGS_STATIC;
+	//or'd in when the chars are valid utf-8
+	constexpr uint32T Runtime_static_string_utf8_valid = RUNTIME_STRING_FLAG_UTF8_VALID;
+
+	struct Runtime_static_string {
+		const charT* data;
+		uint64T size;
+		//size, or Runtime_static_string_small_capacity if that's bigger
+		uint64T capacity;
+		//Runtime_string_hash of the chars
+		uint64T hashval;
+		uint32T flags;
+		uint32T refCount;
+		//0 terminated and padded to capacity + 1, longer literals 
+		//carry on past the end of the struct
+		charT chars[Runtime_static_string_small_capacity + 1];
+	};
 
+	bool Runtime_string_is_immortal(Runtime_string_handle self);
+
+	//indexes of searchStr in self, or Runtime_NoIndx
 	uint64T Runtime_string_find(Runtime_string_handle self, Runtime_string_handle searchStr);
+	uint64T Runtime_string_find_from(Runtime_string_handle self, Runtime_string_handle searchStr, uint64T start);
+	uint64T Runtime_string_find_last(Runtime_string_handle self, Runtime_string_handle searchStr);
+	//non overlapping occurrences
+	uint64T Runtime_string_count(Runtime_string_handle self, Runtime_string_handle searchStr);
 
 	charT* Runtime_string_get_cstr(Runtime_string_handle self);
 
+	//same as compare() == 0, faster
+	bool Runtime_string_equals(Runtime_string_handle self, Runtime_string_handle rhs);
+
+	//canonical string with the same chars. Equal strings intern to 
+	//the same handle, so interned strings can be compared by pointer,
+	//and their hash is already computed. Hashtables/dictionaries with
+	//interned keys skip the char compares. Interned strings belong 
+	//to the runtime and live until Runtime_terminate, changing or 
+	//deleting one does nothing. Any thread can intern
+	Runtime_string_handle Runtime_string_intern(Runtime_string_handle str);
+	Runtime_string_handle Runtime_string_intern_cstr(const charT* c_strPtr);
+	Runtime_string_handle Runtime_string_intern_with_size(const charT* c_strPtr, uint64T size);
+	bool Runtime_string_is_interned(Runtime_string_handle self);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//string builder
+	//collects chars into one growing buffer, to_string hands the buffer 
+	//to the new string without copying (short strings are copied inline)
+	//and leaves the builder empty, ready for reuse
+	typedef void* Runtime_string_builder_handle;
+
+	Runtime_string_builder_handle Runtime_string_builder_new(uint64T capacity);
+	void Runtime_string_builder_delete(Runtime_string_builder_handle self);
+
+	uint64T Runtime_string_builder_size(Runtime_string_builder_handle self);
+	void Runtime_string_builder_clear(Runtime_string_builder_handle self);
+
+	void Runtime_string_builder_append(Runtime_string_builder_handle self, const charT* c_strPtr);
+	void Runtime_string_builder_append_with_size(Runtime_string_builder_handle self, const charT* c_strPtr, uint64T size);
+	void Runtime_string_builder_append_string(Runtime_string_builder_handle self, Runtime_string_handle str);
+	void Runtime_string_builder_append_char(Runtime_string_builder_handle self, charT ch);
+	//grows once for all of them
+	void Runtime_string_builder_append_many(Runtime_string_builder_handle self, const Runtime_string_handle* strs, uint64T count);
+
+	Runtime_string_handle Runtime_string_builder_to_string(Runtime_string_builder_handle self);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//rope
+	//for very large strings, append/insert/erase and joining 
+	//two ropes are O(log n)
+	typedef void* Runtime_rope_handle;
+
+	Runtime_rope_handle Runtime_rope_new();
+	Runtime_rope_handle Runtime_rope_new_from_string(Runtime_string_handle str);
+	void Runtime_rope_delete(Runtime_rope_handle self);
+
+	uint64T Runtime_rope_size(Runtime_rope_handle self);
+	charT Runtime_rope_at(Runtime_rope_handle self, uint64T index);
+
+	void Runtime_rope_append(Runtime_rope_handle self, const charT* c_strPtr);
+	void Runtime_rope_append_with_size(Runtime_rope_handle self, const charT* c_strPtr, uint64T size);
+	void Runtime_rope_append_string(Runtime_rope_handle self, Runtime_string_handle str);
+	//takes rhs, which is no longer valid afterwards
+	void Runtime_rope_append_rope(Runtime_rope_handle self, Runtime_rope_handle rhs);
+	//index past the end appends
+	void Runtime_rope_insert(Runtime_rope_handle self, uint64T index, const charT* c_strPtr, uint64T size);
+	void Runtime_rope_erase(Runtime_rope_handle self, uint64T index, uint64T count);
+
+	Runtime_string_handle Runtime_rope_to_string(Runtime_rope_handle self);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//string matcher
+	//searches for many patterns in one pass over the text, the cost 
+	//per char doesn't depend on the number of patterns. The patterns 
+	//are only read by new
+	typedef void* Runtime_string_matcher_handle;
+
+	Runtime_string_matcher_handle Runtime_string_matcher_new(const Runtime_string_handle* patterns, uint64T count);
+	void Runtime_string_matcher_delete(Runtime_string_matcher_handle self);
+
+	//start index of the match that ends first, looking at the 
+	//text from start on, or Runtime_NoIndx. patternIdxPtr (may be null)
+	//gets the index of the pattern, the longest if several end there
+	uint64T Runtime_string_matcher_find(Runtime_string_matcher_handle self, Runtime_string_handle text, uint64T start, uint64T* patternIdxPtr);
+	//all occurrences of all patterns, overlapping ones included
+	uint64T Runtime_string_matcher_count(Runtime_string_matcher_handle self, Runtime_string_handle text);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//utf-8
+	//strings hold bytes, these treat them as utf-8. Invalid means 
+	//truncated or overlong sequences, surrogates or code points 
+	//past 0x10FFFF
+
+	bool Runtime_utf8_validate(const charT* bytes, uint64T size);
+	//code points, the bytes are assumed valid
+	uint64T Runtime_utf8_length(const charT* bytes, uint64T size);
+
+	//return the units written to dest, or Runtime_NoIndx for invalid
+	//input. dest needs room for: utf8 to utf16/utf32 size units, 
+	//utf16 to utf8 3 * count bytes, utf32 to utf8 4 * count bytes
+	uint64T Runtime_utf8_to_utf16(const charT* src, uint64T size, uint16T* dest);
+	uint64T Runtime_utf8_to_utf32(const charT* src, uint64T size, uint32T* dest);
+	uint64T Runtime_utf16_to_utf8(const uint16T* src, uint64T count, charT* dest);
+	uint64T Runtime_utf32_to_utf8(const uint32T* src, uint64T count, charT* dest);
+
+	//the result is kept with the string until its chars change
+	bool Runtime_string_is_utf8(Runtime_string_handle self);
+	uint64T Runtime_string_utf8_length(Runtime_string_handle self);
+	//null for invalid utf16
+	Runtime_string_handle Runtime_string_new_from_utf16(const uint16T* src, uint64T count);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//number conversion
+
+	//room for any formatted number, 0 included
+	constexpr uint32T Runtime_number_buffer_size = 32;
+
+	//return the chars written, dest is 0 terminated
+	uint64T Runtime_format_int64(int64T value, charT* dest);
+	uint64T Runtime_format_uint64(uint64T value, charT* dest);
+	//the shortest digits that read back as the same double: 
+	//plain decimal (0.25, 1500.0) for exponents from -6 to 21, 
+	//scientific (1.5e-7) otherwise, nan and inf
+	uint64T Runtime_format_double(double64T value, charT* dest);
+
+	//return the chars read, 0 if src doesn't start with a number 
+	//(or an int64 would overflow). Doubles are correctly rounded
+	uint64T Runtime_parse_int64(const charT* src, uint64T size, int64T* valuePtr);
+	uint64T Runtime_parse_double(const charT* src, uint64T size, double64T* valuePtr);
+
+	//the conversion messages, 4 stringVal, "345.78" intVal, 
+	//"345.78" realVal. intVal/realVal read the number at the start 
+	//of the string (after spaces), 0 if there's none
+	Runtime_string_handle Runtime_int64_stringVal(int64T value);
+	Runtime_string_handle Runtime_uint64_stringVal(uint64T value);
+	Runtime_string_handle Runtime_real64_stringVal(double64T value);
+	int64T Runtime_string_intVal(Runtime_string_handle self);
+	double64T Runtime_string_realVal(Runtime_string_handle self);
+
+	//----------------------------------------------------------------------------
+
+
+	//----------------------------------------------------------------------------
+	//formatted output
+	//Runtime_printf formats into a buffer in front of stdout, written
+	//out per the flush policy, and always by Runtime_terminate and 
+	//Runtime_error. Format strings take the flags - + space # 0, width 
+	//and precision (or *), the sizes h hh l ll I I32 I64 z j t and 
+	//the conversions d i u x X o c s p f F e E g G %. Reals print their
+	//exact binary value, digits past 1074 decimals are always 0
+
+	enum Runtime_flush_policy {
+		//after a print with a newline in it, the default for a console
+		rtFlushLine = 0,
+		//once the flush size is buffered, the default when redirected
+		rtFlushSize,
+		//on Runtime_output_flush, or when the buffer is full
+		rtFlushExplicit,
+	};
+
+	void Runtime_output_set_flush_policy(Runtime_flush_policy policy);
+	Runtime_flush_policy Runtime_output_flush_policy();
+	//for rtFlushSize, at most the 16K buffer, 4K by default
+	void Runtime_output_set_flush_size(uint32T size);
+	void Runtime_output_flush();
+	void Runtime_output_write(const charT* data, uint64T size);
+
+	//formats into buffer, 0 terminated and cut to fit. Returns the 
+	//length the whole output has
+	uint64T Runtime_snprintf(charT* buffer, uint64T bufferSize, const char* fmtStr, ...);
+
 	//----------------------------------------------------------------------------
 
 
@@ -399,6 +860,7 @@ extern "C" {
 	typedef void* Runtime_dictionary_handle;	
 
 	Runtime_dictionary_handle Runtime_dictionary_new(Runtime_TypeDescriptor valType);
+	Runtime_dictionary_handle Runtime_dictionary_new_ordered(Runtime_TypeDescriptor valType);
 	void Runtime_dictionary_delete(Runtime_dictionary_handle self);
 
 
@@ -415,9 +877,236 @@ extern "C" {
 
 	//[] access
 	void* Runtime_dictionary_at(Runtime_dictionary_handle self, Runtime_string_handle key);
+
+	//lookups straight from chars, e.g. a token in a parse buffer, 
+	//without making a string for the key. size is in chars. The
+	//hash is Runtime_dictionary_hash_bytes, the same value as 
+	//Runtime_string_hash, so a key hashed once can be looked up in
+	//several dictionaries. insert copies the chars only when the key
+	//isn't there yet, an existing key only gets the new value
+	uint64T Runtime_dictionary_hash_bytes(const charT* keyPtr, uint64T size);
+	void* Runtime_dictionary_at_bytes(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size);
+	void* Runtime_dictionary_at_hashed(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, uint64T hash);
+	void Runtime_dictionary_insert_bytes(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, void* val);
+	void Runtime_dictionary_insert_hashed(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, uint64T hash, void* val);
+	void Runtime_dictionary_erase_bytes(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size);
+	void Runtime_dictionary_erase_hashed(Runtime_dictionary_handle self, const charT* keyPtr, uint64T size, uint64T hash);
+
+	typedef Runtime_hashtable_iter Runtime_dictionary_iter;
+
+	void Runtime_dictionary_iter_init(Runtime_dictionary_handle self, Runtime_dictionary_iter* iter);
+	bool Runtime_dictionary_iter_next(Runtime_dictionary_iter* iter);
+	Runtime_string_handle Runtime_dictionary_iter_key(Runtime_dictionary_iter* iter);
+	void* Runtime_dictionary_iter_value(Runtime_dictionary_iter* iter);
 	
 
 
+	//----------------------------------------------------------------------------
+	//set
+	//any key type, stored like a hashtable with no value. Same
+	//key ownership rules as Runtime_hashtable
+	typedef void* Runtime_set_handle;
+
+	Runtime_set_handle Runtime_set_new(Runtime_TypeDescriptor keyType);
+	//iterates in insertion order
+	Runtime_set_handle Runtime_set_new_ordered(Runtime_TypeDescriptor keyType);
+	Runtime_set_handle Runtime_set_new_copy(Runtime_set_handle rhs);
+	void Runtime_set_delete(Runtime_set_handle self);
+
+	bool Runtime_set_empty(Runtime_set_handle self);
+	uint64T Runtime_set_size(Runtime_set_handle self);
+	uint64T Runtime_set_capacity(Runtime_set_handle self);
+	void Runtime_set_set_capacity(Runtime_set_handle self, uint64T capacity);
+	void Runtime_set_clear(Runtime_set_handle self);
+
+	//false if the key was already there
+	bool Runtime_set_insert(Runtime_set_handle self, void* key);
+	//false if the key wasn't there
+	bool Runtime_set_erase(Runtime_set_handle self, void* key);
+	bool Runtime_set_contains(Runtime_set_handle self, void* key);
+
+	//new sets, with their own copies of the keys. Both sets 
+	//need the same key type. These walk the smaller set and
+	//look its keys up in the bigger one where they can
+	Runtime_set_handle Runtime_set_union(Runtime_set_handle self, Runtime_set_handle rhs);
+	Runtime_set_handle Runtime_set_intersection(Runtime_set_handle self, Runtime_set_handle rhs);
+	//keys in self that aren't in rhs
+	Runtime_set_handle Runtime_set_difference(Runtime_set_handle self, Runtime_set_handle rhs);
+
+	typedef Runtime_hashtable_iter Runtime_set_iter;
+
+	void Runtime_set_iter_init(Runtime_set_handle self, Runtime_set_iter* iter);
+	bool Runtime_set_iter_next(Runtime_set_iter* iter);
+	void* Runtime_set_iter_key(Runtime_set_iter* iter);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//persistent map
+	//immutable hash map, insert/erase leave the map alone and return 
+	//a new one that shares everything but the path to the changed key, 
+	//O(log32 n). copy is O(1), a snapshot. Maps can be read from any 
+	//number of threads, each map handle has to be deleted. The map 
+	//takes ownership of string/array/dictionary keys and values 
+	//passed in, those have to be new ones, not ones another map 
+	//holds. at() returns the same as Runtime_hashtable_at
+	typedef void* Runtime_persistent_map_handle;
+
+	Runtime_persistent_map_handle Runtime_persistent_map_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType);
+	Runtime_persistent_map_handle Runtime_persistent_map_copy(Runtime_persistent_map_handle self);
+	void Runtime_persistent_map_delete(Runtime_persistent_map_handle self);
+
+	bool Runtime_persistent_map_empty(Runtime_persistent_map_handle self);
+	uint64T Runtime_persistent_map_size(Runtime_persistent_map_handle self);
+
+	Runtime_persistent_map_handle Runtime_persistent_map_insert(Runtime_persistent_map_handle self, void* key, void* val);
+	Runtime_persistent_map_handle Runtime_persistent_map_erase(Runtime_persistent_map_handle self, void* key);
+
+	void* Runtime_persistent_map_at(Runtime_persistent_map_handle self, void* key);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//ordered map
+	//any key/value types, kept in key order: numbers by value, strings
+	//by their bytes (utf-8 by code point), user types by their compare
+	//hook or bytewise. Array/dictionary/set keys have no order and can't
+	//be used. A B-tree with wide nodes, lookups are O(log n) and touch
+	//few cache lines. Same key/value ownership rules as Runtime_hashtable,
+	//at() returns the same
+	typedef void* Runtime_ordered_map_handle;
+
+	Runtime_ordered_map_handle Runtime_ordered_map_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType);
+	//builds the tree directly with packed nodes, much faster than 
+	//inserting one at a time. keys/vals hold count elements laid out
+	//like array data of the key/value type, keys strictly ascending.
+	//The map takes the keys/values as insert would
+	Runtime_ordered_map_handle Runtime_ordered_map_new_from_sorted(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType, void* keys, void* vals, uint64T count);
+	void Runtime_ordered_map_delete(Runtime_ordered_map_handle self);
+
+	bool Runtime_ordered_map_empty(Runtime_ordered_map_handle self);
+	uint64T Runtime_ordered_map_size(Runtime_ordered_map_handle self);
+	void Runtime_ordered_map_clear(Runtime_ordered_map_handle self);
+
+	//inserting an existing key replaces both the key and the value
+	void Runtime_ordered_map_insert(Runtime_ordered_map_handle self, void* key, void* val);
+	//false if the key wasn't there
+	bool Runtime_ordered_map_erase(Runtime_ordered_map_handle self, void* key);
+	void* Runtime_ordered_map_at(Runtime_ordered_map_handle self, void* key);
+
+	//deep enough for any map that fits in memory
+	constexpr uint32T Runtime_ordered_map_max_depth = 32;
+
+	//the path from the root to the current entry. key/value are what
+	//at() would return for the entry. The map can't be changed while
+	//it's being iterated
+	struct Runtime_ordered_map_iter {
+		Runtime_ordered_map_handle map;
+		void* nodes[Runtime_ordered_map_max_depth];
+		int32T idx[Runtime_ordered_map_max_depth];
+		uint32T depth;
+		bool reverse;
+		bool started;
+		//iteration stops at the first key >= endKey, nullptr for no end
+		void* endKey;
+		void* key;
+		void* value;
+	};
+
+	//every entry, ascending/descending
+	void Runtime_ordered_map_iter_init(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter);
+	void Runtime_ordered_map_iter_init_reverse(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter);
+	//ascending from the first key >= key / > key
+	void Runtime_ordered_map_lower_bound(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, void* key);
+	void Runtime_ordered_map_upper_bound(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, void* key);
+	//ascending over keys in [low, high), either can be nullptr for no 
+	//bound. high has to stay valid until the iteration is done
+	void Runtime_ordered_map_range(Runtime_ordered_map_handle self, Runtime_ordered_map_iter* iter, void* low, void* high);
+	bool Runtime_ordered_map_iter_next(Runtime_ordered_map_iter* iter);
+	void* Runtime_ordered_map_iter_key(Runtime_ordered_map_iter* iter);
+	void* Runtime_ordered_map_iter_value(Runtime_ordered_map_iter* iter);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//static dictionary
+	//read only string keyed table, emitted by the compiler as constant
+	//data for dictionaries built only from literal keys. The keys have 
+	//a minimal perfect hash: the key's hash picks a bucket, the bucket's
+	//seed picks the entry, so a lookup is one hash and one compare, and
+	//there's nothing to build at startup
+	struct Runtime_static_dictionary_entry {
+		const charT* key;
+		uint64T keySize;
+		//points at the value data
+		const void* value;
+	};
+
+	struct Runtime_static_dictionary {
+		uint64T size;
+		uint64T bucketCount;
+		const uint32T* seeds;
+		const Runtime_static_dictionary_entry* entries;
+	};
+
+	//whatever builds the table has to place keys with exactly these, 
+	//hash is Runtime_static_dictionary_hash of the key's characters,
+	//the same value Runtime_string_hash gives for them
+	uint64T Runtime_static_dictionary_hash(const charT* key, uint64T size);
+
+	inline uint64T Runtime_static_dictionary_bucket(uint64T hash, uint64T bucketCount) {
+		hash = (hash ^ (hash >> 33)) * 0xff51afd7ed558ccdULL;
+		return (hash ^ (hash >> 33)) % bucketCount;
+	}
+
+	inline uint64T Runtime_static_dictionary_slot(uint64T hash, uint32T seed, uint64T size) {
+		hash += ((uint64T)seed + 1) * 0x9e3779b97f4a7c15ULL;
+		hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+		return (hash ^ (hash >> 31)) % size;
+	}
+
+	uint64T Runtime_static_dictionary_size(const Runtime_static_dictionary* self);
+	//nullptr if key isn't in the table
+	const void* Runtime_static_dictionary_at(const Runtime_static_dictionary* self, Runtime_string_handle key);
+	const void* Runtime_static_dictionary_at_bytes(const Runtime_static_dictionary* self, const charT* key, uint64T size);
+
+	//----------------------------------------------------------------------------
+
+
+
+	//----------------------------------------------------------------------------
+	//concurrent hashtable
+	//safe to use from any number of threads. Lookups never lock,
+	//writers lock one of a set of stripes picked by the key's hash.
+	//Same key/value ownership rules as Runtime_hashtable
+	typedef void* Runtime_concurrent_hashtable_handle;
+
+	Runtime_concurrent_hashtable_handle Runtime_concurrent_hashtable_new(Runtime_TypeDescriptor keyType, Runtime_TypeDescriptor valType);
+	//not thread safe, nothing else may be using the table
+	void Runtime_concurrent_hashtable_delete(Runtime_concurrent_hashtable_handle self);
+
+	uint64T Runtime_concurrent_hashtable_size(Runtime_concurrent_hashtable_handle self);
+	uint64T Runtime_concurrent_hashtable_capacity(Runtime_concurrent_hashtable_handle self);
+
+	void Runtime_concurrent_hashtable_insert(Runtime_concurrent_hashtable_handle self, void* key, void* val);
+	bool Runtime_concurrent_hashtable_erase(Runtime_concurrent_hashtable_handle self, void* key);
+
+	//copies the value for key into valOut, returns false if the key
+	//isn't there. Handle values (string/array/dictionary/set) come 
+	//back as a deep copy the caller deletes, user types are copied 
+	//with their copy hook
+	bool Runtime_concurrent_hashtable_get(Runtime_concurrent_hashtable_handle self, void* key, void* valOut);
+	bool Runtime_concurrent_hashtable_contains(Runtime_concurrent_hashtable_handle self, void* key);
+
+
+
 	//----------------------------------------------------------------------------
 	//runtime environment methods
 	//startup
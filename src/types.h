@@ -31,6 +31,7 @@ namespace typesystem {
 		typeArray,
 		typeDictionary,
 		typeMessage,
+		typeSet,
 	};
 
 	inline bool isTypePrimitive(TypeDescriptor td) {
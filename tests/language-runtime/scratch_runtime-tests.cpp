@@ -1,6 +1,13 @@
 #include "pch.h"
 
 #include "scratch_runtime.h"
+#include "perfect_hash.h"
+
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <string>
+#include <algorithm>
 
 
 
@@ -52,3 +59,1971 @@ TEST(TestScratchRuntime, Test_runtime_mem) {
 }
 
 
+
+
+TEST(TestScratchRuntime, Test_runtime_mapped_array) {
+
+	Runtime_init();
+
+	const char* path = "scratch_mapped_array_test.bin";
+
+	auto arr = Runtime_array_new_mapped_with_size(path, 1000, typeInteger32);
+	ASSERT_NE(arr, nullptr);
+	EXPECT_EQ(Runtime_array_is_mapped(arr), true);
+	EXPECT_EQ(Runtime_array_size(arr), 1000);
+	EXPECT_EQ(Runtime_array_type(arr), typeInteger32);
+
+	for (int32T i = 0; i < 1000; i++) {
+		*((int32T*)Runtime_array_at(arr, i)) = i * 3;
+	}
+	EXPECT_EQ(Runtime_array_flush(arr), true);
+	Runtime_array_delete(arr);
+
+	arr = Runtime_array_new_mapped(path, typeDouble64, rtArrayMapReadOnly);
+	EXPECT_EQ(arr, nullptr);
+
+	//2^62 int32's is 2^64 bytes, it wraps to a tiny file
+	EXPECT_EQ(Runtime_array_new_mapped_with_size(path, 0x4000000000000000ULL, typeInteger32), nullptr);
+
+	arr = Runtime_array_new_mapped(path, typeInteger32, rtArrayMapReadOnly);
+	ASSERT_NE(arr, nullptr);
+	EXPECT_EQ(Runtime_array_size(arr), 1000);
+	EXPECT_EQ(*((int32T*)Runtime_array_at(arr, 999)), 999 * 3);
+
+	auto copy = Runtime_array_new_copy(arr);
+	EXPECT_EQ(Runtime_array_is_mapped(copy), false);
+	EXPECT_EQ(Runtime_array_compare(copy, arr), rtArrayCmpEqual);
+
+	Runtime_array_delete(copy);
+	Runtime_array_delete(arr);
+
+	remove(path);
+
+	Runtime_terminate();
+}
+
+
+TEST(TestScratchRuntime, Test_runtime_bitarray) {
+
+	Runtime_init();
+
+	auto bits = Runtime_array_new(1000, typeBit1);
+	EXPECT_EQ(Runtime_array_size(bits), 1000);
+	EXPECT_EQ(Runtime_array_type(bits), typeBit1);
+	EXPECT_EQ(Runtime_bitarray_count(bits), 0);
+
+	for (uint64T i = 0; i < 1000; i += 3) {
+		Runtime_bitarray_set(bits, i, true);
+	}
+	EXPECT_EQ(Runtime_bitarray_get(bits, 999), true);
+	EXPECT_EQ(Runtime_bitarray_get(bits, 998), false);
+	EXPECT_EQ(Runtime_bitarray_count(bits), 334);
+	EXPECT_EQ(Runtime_bitarray_rank(bits, 10), 4);
+	EXPECT_EQ(Runtime_bitarray_find_next_set(bits, 1), 3);
+
+	Runtime_bitarray_flip(bits, 0);
+	EXPECT_EQ(Runtime_bitarray_get(bits, 0), false);
+
+	auto other = Runtime_bitarray_new(1000);
+	Runtime_bitarray_set_all(other, true);
+	EXPECT_EQ(Runtime_bitarray_count(other), 1000);
+
+	Runtime_bitarray_andnot(other, bits);
+	EXPECT_EQ(Runtime_bitarray_count(other), 1000 - 333);
+
+	Runtime_bitarray_and(other, bits);
+	EXPECT_EQ(Runtime_bitarray_count(other), 0);
+
+	Runtime_bitarray_or(other, bits);
+	Runtime_bitarray_xor(other, bits);
+	EXPECT_EQ(Runtime_bitarray_count(other), 0);
+
+	Runtime_bitarray_set_all(other, false);
+	Runtime_bitarray_set(other, 900, true);
+	EXPECT_EQ(Runtime_bitarray_find_next_set(other, 1), 900);
+	EXPECT_EQ(Runtime_bitarray_find_next_set(other, 901), Runtime_NoIndx);
+
+	Runtime_bitarray_resize(other, 10);
+	Runtime_bitarray_append(other, true);
+	EXPECT_EQ(Runtime_array_size(other), 11);
+	EXPECT_EQ(Runtime_bitarray_count(other), 1);
+
+	Runtime_array_delete(other);
+	Runtime_array_delete(bits);
+
+	//the generic insert/append shift the packed bits
+	auto shifted = Runtime_array_new(0, typeBit1);
+	std::vector<bool> model;
+	uint32T seed = 12345;
+	for (int i = 0; i < 300; i++) {
+		seed = seed * 1103515245 + 12345;
+		bool val = 0 != ((seed >> 16) & 1);
+		uint64T at = (seed >> 8) % (model.size() + 1);
+		Runtime_array_insert(shifted, &val, at);
+		model.insert(model.begin() + at, val);
+	}
+	bool one = true;
+	Runtime_array_append(shifted, &one);
+	model.push_back(true);
+	Runtime_array_append_from(shifted, shifted);
+	model.insert(model.end(), model.begin(), model.end());
+
+	ASSERT_EQ(Runtime_array_size(shifted), model.size());
+	uint64T mismatches = 0;
+	for (uint64T i = 0; i < model.size(); i++) {
+		mismatches += Runtime_bitarray_get(shifted, i) != model[i];
+	}
+	EXPECT_EQ(mismatches, 0);
+	EXPECT_EQ(Runtime_bitarray_count(shifted), (uint64T)std::count(model.begin(), model.end(), true));
+
+	//the generic reserve/resize/copy work in bits too
+	auto copied = Runtime_array_new(3, typeBit1);
+	Runtime_array_reserve(copied, 1000);
+	EXPECT_GE(Runtime_array_capacity(copied), 1000);
+	EXPECT_EQ(Runtime_array_size(copied), 3);
+	Runtime_array_copy(copied, shifted);
+	ASSERT_EQ(Runtime_array_size(copied), model.size());
+	mismatches = 0;
+	for (uint64T i = 0; i < model.size(); i++) {
+		mismatches += Runtime_bitarray_get(copied, i) != model[i];
+	}
+	EXPECT_EQ(mismatches, 0);
+
+	Runtime_array_resize(copied, 70);
+	EXPECT_EQ(Runtime_array_size(copied), 70);
+	EXPECT_EQ(Runtime_bitarray_count(copied), (uint64T)std::count(model.begin(), model.begin() + 70, true));
+	Runtime_array_resize(copied, 5000);
+	EXPECT_EQ(Runtime_array_size(copied), 5000);
+	EXPECT_EQ(Runtime_bitarray_find_next_set(copied, 70), Runtime_NoIndx);
+
+	//bytes_copy keeps the size of the destination
+	auto head = Runtime_array_new(100, typeBit1);
+	Runtime_array_bytes_copy(head, shifted);
+	EXPECT_EQ(Runtime_array_size(head), 100);
+	EXPECT_EQ(Runtime_bitarray_count(head), (uint64T)std::count(model.begin(), model.begin() + 100, true));
+
+	//mixing bit and non bit arrays is refused
+	auto ints = Runtime_array_new(4, typeInteger32);
+	Runtime_array_copy(ints, shifted);
+	EXPECT_EQ(Runtime_array_size(ints), 4);
+	Runtime_array_copy(copied, ints);
+	EXPECT_EQ(Runtime_array_size(copied), 5000);
+
+	Runtime_array_delete(ints);
+	Runtime_array_delete(head);
+	Runtime_array_delete(copied);
+	Runtime_array_delete(shifted);
+
+	Runtime_terminate();
+}
+
+
+struct TestPoint {
+	int32T x;
+	int32T y;
+	double64T weight;
+};
+
+static int testPointDestroyCount = 0;
+
+static void TestPoint_destroy(void* obj)
+{
+	testPointDestroyCount++;
+}
+
+TEST(TestScratchRuntime, Test_runtime_type_registry) {
+
+	Runtime_init();
+
+	Runtime_type_info info = {};
+	info.baseType = typeRecord;
+	info.size = sizeof(TestPoint);
+	info.alignment = alignof(TestPoint);
+	info.destroy = TestPoint_destroy;
+	info.name = "TestPoint";
+
+	auto pointType = Runtime_register_type(&info);
+	EXPECT_EQ((uint32T)pointType, (uint32T)typeUserTypeBase);
+
+	auto registered = Runtime_get_type_info(pointType);
+	ASSERT_NE(registered, nullptr);
+	EXPECT_EQ(registered->size, sizeof(TestPoint));
+	EXPECT_EQ(registered->type, pointType);
+
+	info.alignment = 3;
+	EXPECT_EQ(Runtime_register_type(&info), typeUnknown);
+
+	auto arr = Runtime_array_new_empty(pointType);
+	TestPoint p = { 1, 2, 0.5 };
+	Runtime_array_append(arr, &p);
+	p.x = 10;
+	Runtime_array_append(arr, &p);
+	EXPECT_EQ(Runtime_array_size(arr), 2);
+	EXPECT_EQ(((TestPoint*)Runtime_array_at(arr, 1))->x, 10);
+	EXPECT_EQ(((TestPoint*)Runtime_array_at(arr, 0))->weight, 0.5);
+
+	Runtime_array_delete(arr);
+	EXPECT_EQ(testPointDestroyCount, 2);
+
+	auto ht = Runtime_hashtable_new(typeInteger32, pointType);
+	int32T k = 7;
+	Runtime_hashtable_insert(ht, &k, &p);
+	auto found = (TestPoint*)Runtime_hashtable_at(ht, &k);
+	ASSERT_NE(found, nullptr);
+	EXPECT_EQ(found->x, 10);
+	Runtime_hashtable_delete(ht);
+	EXPECT_EQ(testPointDestroyCount, 3);
+
+	Runtime_terminate();
+}
+
+struct TestOwned {
+	int* value;
+};
+
+static int testOwnedCopyCount = 0;
+static int testOwnedDestroyCount = 0;
+
+static void TestOwned_copy(void* dest, const void* src)
+{
+	testOwnedCopyCount++;
+	((TestOwned*)dest)->value = new int(*((const TestOwned*)src)->value);
+}
+
+static void TestOwned_destroy(void* obj)
+{
+	testOwnedDestroyCount++;
+	delete ((TestOwned*)obj)->value;
+}
+
+TEST(TestScratchRuntime, Test_runtime_array_copy_hooks) {
+
+	Runtime_init();
+
+	Runtime_type_info info = {};
+	info.baseType = typeRecord;
+	info.size = sizeof(TestOwned);
+	info.alignment = alignof(TestOwned);
+	info.copy = TestOwned_copy;
+	info.destroy = TestOwned_destroy;
+	info.name = "TestOwned";
+	auto ownedType = Runtime_register_type(&info);
+
+	int values[] = { 1, 2, 3, 4, 5 };
+	TestOwned item = { &values[0] };
+
+	//every element that gets in is copied, the caller keeps theirs
+	auto arr = Runtime_array_new_empty(ownedType);
+	for (int i = 0; i < 3; i++) {
+		item.value = &values[i];
+		Runtime_array_append(arr, &item);
+	}
+	item.value = &values[3];
+	Runtime_array_insert(arr, &item, 0);
+	EXPECT_EQ(testOwnedCopyCount, 4);
+	EXPECT_NE(((TestOwned*)Runtime_array_at(arr, 0))->value, &values[3]);
+	EXPECT_EQ(*((TestOwned*)Runtime_array_at(arr, 1))->value, 1);
+
+	auto more = Runtime_array_new_empty(ownedType);
+	item.value = &values[4];
+	Runtime_array_append(more, &item);
+	Runtime_array_append(more, &item);
+	Runtime_array_append_from(arr, more);
+	EXPECT_EQ(testOwnedCopyCount, 8);
+	EXPECT_EQ(Runtime_array_size(arr), 6);
+	EXPECT_EQ(*((TestOwned*)Runtime_array_at(arr, 5))->value, 5);
+
+	auto copy = Runtime_array_new_copy(arr);
+	EXPECT_EQ(testOwnedCopyCount, 14);
+	Runtime_array_copy(more, arr);
+	EXPECT_EQ(testOwnedDestroyCount, 2);
+	EXPECT_EQ(testOwnedCopyCount, 20);
+	EXPECT_EQ(*((TestOwned*)Runtime_array_at(more, 0))->value, 4);
+
+	Runtime_array_delete(arr);
+	Runtime_array_delete(more);
+	Runtime_array_delete(copy);
+	EXPECT_EQ(testOwnedDestroyCount, testOwnedCopyCount);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_hashtable) {
+
+	Runtime_init();
+
+	auto ht = Runtime_hashtable_new(typeInteger32, typeInteger32);
+	EXPECT_TRUE(Runtime_hashtable_empty(ht));
+	EXPECT_EQ(Runtime_hashtable_capacity(ht), 8);
+
+	for (int32T i = 0; i < 5000; i++) {
+		int32T k = i * 7;
+		int32T v = i;
+		Runtime_hashtable_insert(ht, &k, &v);
+	}
+	EXPECT_EQ(Runtime_hashtable_size(ht), 5000);
+	EXPECT_GE(Runtime_hashtable_capacity(ht), 5000);
+	EXPECT_EQ(Runtime_hashtable_capacity(ht) & (Runtime_hashtable_capacity(ht) - 1), 0);
+
+	int32T k = 70;
+	int32T v = 1234;
+	Runtime_hashtable_insert(ht, &k, &v);
+	EXPECT_EQ(Runtime_hashtable_size(ht), 5000);
+	EXPECT_EQ(*(int32T*)Runtime_hashtable_at(ht, &k), 1234);
+
+	k = 71;
+	EXPECT_EQ(Runtime_hashtable_at(ht, &k), nullptr);
+
+	for (int32T i = 0; i < 5000; i += 2) {
+		k = i * 7;
+		Runtime_hashtable_erase(ht, &k);
+	}
+	EXPECT_EQ(Runtime_hashtable_size(ht), 2500);
+
+	for (int32T i = 0; i < 5000; i++) {
+		k = i * 7;
+		auto val = (int32T*)Runtime_hashtable_at(ht, &k);
+		if (i % 2 == 0) {
+			EXPECT_EQ(val, nullptr);
+		}
+		else {
+			ASSERT_NE(val, nullptr);
+			EXPECT_EQ(*val, i);
+		}
+	}
+
+	//churn through tombstones without growing
+	auto capacity = Runtime_hashtable_capacity(ht);
+	for (int32T i = 0; i < 20000; i++) {
+		k = -1 - i;
+		Runtime_hashtable_insert(ht, &k, &i);
+		Runtime_hashtable_erase(ht, &k);
+	}
+	EXPECT_EQ(Runtime_hashtable_size(ht), 2500);
+	EXPECT_EQ(Runtime_hashtable_capacity(ht), capacity);
+
+	Runtime_hashtable_clear(ht);
+	EXPECT_TRUE(Runtime_hashtable_empty(ht));
+	Runtime_hashtable_delete(ht);
+
+	auto strHt = Runtime_hashtable_new(typeString, typeInteger64);
+	int64T num = 100;
+	Runtime_hashtable_insert(strHt, Runtime_string_new("Number1"), &num);
+	num = 200;
+	Runtime_hashtable_insert(strHt, Runtime_string_new("Number2"), &num);
+	num = 300;
+	Runtime_hashtable_insert(strHt, Runtime_string_new("Number1"), &num);
+	EXPECT_EQ(Runtime_hashtable_size(strHt), 2);
+
+	auto key = Runtime_string_new("Number1");
+	EXPECT_EQ(*(int64T*)Runtime_hashtable_at(strHt, key), 300);
+	Runtime_hashtable_erase(strHt, key);
+	EXPECT_EQ(Runtime_hashtable_at(strHt, key), nullptr);
+	Runtime_string_delete(key);
+
+	Runtime_hashtable_delete(strHt);
+
+	Runtime_terminate();
+}
+
+static bool Test_incremental_key_erased(int64T key, int64T inserted)
+{
+	//key/2 is erased when key is inserted and key % 3 == 0
+	for (int64T i = key * 2; i <= key * 2 + 1; i++) {
+		if (i <= inserted && i % 3 == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+TEST(TestScratchRuntime, Test_runtime_hashtable_incremental_resize) {
+
+	Runtime_init();
+
+	auto ht = Runtime_hashtable_new(typeInteger64, typeInteger64);
+	EXPECT_TRUE(Runtime_hashtable_incremental_resize(ht));
+
+	//keys are erased and checked while resizes are in flight
+	const int64T count = 200000;
+	for (int64T i = 0; i < count; i++) {
+		Runtime_hashtable_insert(ht, &i, &i);
+		if (i % 3 == 0) {
+			int64T k = i / 2;
+			Runtime_hashtable_erase(ht, &k);
+		}
+		if (i % 1000 == 999) {
+			for (int64T k = i - 600; k < i; k++) {
+				auto val = (int64T*)Runtime_hashtable_at(ht, &k);
+				if (Test_incremental_key_erased(k, i)) {
+					EXPECT_EQ(val, nullptr);
+				}
+				else {
+					ASSERT_NE(val, nullptr);
+					EXPECT_EQ(*val, k);
+				}
+			}
+		}
+	}
+
+	uint64T expected = 0;
+	for (int64T i = 0; i < count; i++) {
+		auto val = (int64T*)Runtime_hashtable_at(ht, &i);
+		if (Test_incremental_key_erased(i, count - 1)) {
+			EXPECT_EQ(val, nullptr);
+		}
+		else {
+			expected++;
+			ASSERT_NE(val, nullptr);
+			EXPECT_EQ(*val, i);
+		}
+	}
+	EXPECT_EQ(Runtime_hashtable_size(ht), expected);
+
+	Runtime_hashtable_set_incremental_resize(ht, false);
+	Runtime_hashtable_set_capacity(ht, 1 << 20);
+	EXPECT_EQ(Runtime_hashtable_capacity(ht), 1 << 20);
+	EXPECT_EQ(Runtime_hashtable_size(ht), expected);
+
+	Runtime_hashtable_delete(ht);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_hashtable_iter) {
+
+	Runtime_init();
+
+	//stops just after a 4096 slot table starts resizing
+	//incrementally, so both tables are live
+	auto ht = Runtime_hashtable_new(typeInteger64, typeInteger64);
+	int64T keySum = 0;
+	for (int64T i = 0; i < 3600; i++) {
+		int64T v = i * 2;
+		Runtime_hashtable_insert(ht, &i, &v);
+		keySum += i;
+	}
+
+	Runtime_hashtable_iter it;
+	Runtime_hashtable_iter_init(ht, &it);
+	uint64T count = 0;
+	int64T iterKeySum = 0;
+	while (Runtime_hashtable_iter_next(&it)) {
+		auto k = *(int64T*)Runtime_hashtable_iter_key(&it);
+		EXPECT_EQ(*(int64T*)Runtime_hashtable_iter_value(&it), k * 2);
+		iterKeySum += k;
+		count++;
+	}
+	EXPECT_EQ(count, 3600);
+	EXPECT_EQ(iterKeySum, keySum);
+	EXPECT_FALSE(Runtime_hashtable_iter_next(&it));
+	Runtime_hashtable_delete(ht);
+
+	auto ordered = Runtime_hashtable_new_ordered(typeInteger32, typeInteger32);
+	EXPECT_TRUE(Runtime_hashtable_is_ordered(ordered));
+	for (int32T i = 0; i < 1000; i++) {
+		int32T k = (i * 7919) % 1000;
+		Runtime_hashtable_insert(ordered, &k, &i);
+	}
+	//erase enough to compact the entries
+	for (int32T i = 0; i < 1000; i += 3) {
+		int32T k = (i * 7919) % 1000;
+		Runtime_hashtable_erase(ordered, &k);
+	}
+	//updates keep their position, reinserts go to the end
+	int32T k = (1 * 7919) % 1000;
+	int32T v = -1;
+	Runtime_hashtable_insert(ordered, &k, &v);
+	k = 0;
+	v = 5000;
+	Runtime_hashtable_insert(ordered, &k, &v);
+
+	Runtime_hashtable_iter_init(ordered, &it);
+	int32T expectedIdx = 1;
+	count = 0;
+	while (Runtime_hashtable_iter_next(&it)) {
+		auto key = *(int32T*)it.key;
+		auto val = *(int32T*)it.value;
+		if (expectedIdx < 1000) {
+			EXPECT_EQ(key, (expectedIdx * 7919) % 1000);
+			EXPECT_EQ(val, expectedIdx == 1 ? -1 : expectedIdx);
+			expectedIdx += (expectedIdx % 3 == 1) ? 1 : 2;
+		}
+		else {
+			EXPECT_EQ(key, 0);
+			EXPECT_EQ(val, 5000);
+		}
+		count++;
+	}
+	EXPECT_EQ(count, Runtime_hashtable_size(ordered));
+	EXPECT_EQ(count, 667);
+
+	k = 0;
+	EXPECT_EQ(*(int32T*)Runtime_hashtable_at(ordered, &k), 5000);
+	Runtime_hashtable_delete(ordered);
+
+	auto dict = Runtime_dictionary_new_ordered(typeInteger32);
+	const char* names[] = { "zeta", "alpha", "mid" };
+	for (int32T i = 0; i < 3; i++) {
+		Runtime_dictionary_insert(dict, Runtime_string_new(names[i]), &i);
+	}
+
+	Runtime_dictionary_iter dit;
+	Runtime_dictionary_iter_init(dict, &dit);
+	int32T idx = 0;
+	while (Runtime_dictionary_iter_next(&dit)) {
+		auto expectedKey = Runtime_string_new(names[idx]);
+		EXPECT_EQ(Runtime_string_compare(Runtime_dictionary_iter_key(&dit), expectedKey), 0);
+		EXPECT_EQ(*(int32T*)Runtime_dictionary_iter_value(&dit), idx);
+		Runtime_string_delete(expectedKey);
+		idx++;
+	}
+	EXPECT_EQ(idx, 3);
+	Runtime_dictionary_delete(dict);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_concurrent_hashtable) {
+
+	Runtime_init();
+
+	auto ht = Runtime_concurrent_hashtable_new(typeInteger64, typeInteger64);
+
+	const int64T perThread = 20000;
+	const int threadCount = 4;
+
+	//writers own disjoint key ranges, readers hammer the whole 
+	//range while the table resizes underneath them
+	std::vector<std::thread> threads;
+	std::atomic<int64T> badReads(0);
+	std::atomic<bool> writersDone(false);
+
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back([ht, t, perThread]() {
+			for (int64T i = 0; i < perThread; i++) {
+				int64T k = t * perThread + i;
+				int64T v = k * 10;
+				Runtime_concurrent_hashtable_insert(ht, &k, &v);
+			}
+			for (int64T i = 0; i < perThread; i += 2) {
+				int64T k = t * perThread + i;
+				Runtime_concurrent_hashtable_erase(ht, &k);
+			}
+			for (int64T i = 1; i < perThread; i += 2) {
+				int64T k = t * perThread + i;
+				int64T v = k * 100;
+				Runtime_concurrent_hashtable_insert(ht, &k, &v);
+			}
+		});
+	}
+
+	for (int t = 0; t < 2; t++) {
+		threads.emplace_back([ht, &badReads, &writersDone, perThread, threadCount]() {
+			while (!writersDone.load()) {
+				for (int64T k = 0; k < perThread * threadCount; k += 7) {
+					int64T v = 0;
+					if (Runtime_concurrent_hashtable_get(ht, &k, &v) && v != k * 10 && v != k * 100) {
+						badReads++;
+					}
+				}
+			}
+		});
+	}
+
+	for (int t = 0; t < threadCount; t++) {
+		threads[t].join();
+	}
+	writersDone = true;
+	for (size_t t = threadCount; t < threads.size(); t++) {
+		threads[t].join();
+	}
+
+	EXPECT_EQ(badReads.load(), 0);
+	EXPECT_EQ(Runtime_concurrent_hashtable_size(ht), perThread * threadCount / 2);
+
+	for (int64T k = 0; k < perThread * threadCount; k++) {
+		int64T v = 0;
+		bool found = Runtime_concurrent_hashtable_get(ht, &k, &v);
+		EXPECT_EQ(found, (k % 2) == 1);
+		if (found) {
+			EXPECT_EQ(v, k * 100);
+		}
+	}
+
+	Runtime_concurrent_hashtable_delete(ht);
+
+	auto strHt = Runtime_concurrent_hashtable_new(typeString, typeInteger32);
+	int32T num = 1;
+	auto key = Runtime_string_new("shared");
+	Runtime_concurrent_hashtable_insert(strHt, key, &num);
+	num = 2;
+	Runtime_concurrent_hashtable_insert(strHt, key, &num);
+	num = 0;
+	EXPECT_TRUE(Runtime_concurrent_hashtable_get(strHt, key, &num));
+	EXPECT_EQ(num, 2);
+	EXPECT_TRUE(Runtime_concurrent_hashtable_contains(strHt, key));
+	Runtime_concurrent_hashtable_delete(strHt);
+
+	//erased slots are reused, cycling the same keys doesn't grow the table
+	auto cycled = Runtime_concurrent_hashtable_new(typeInteger64, typeInteger64);
+	for (int round = 0; round < 50; round++) {
+		for (int64T k = 0; k < 40; k++) {
+			Runtime_concurrent_hashtable_insert(cycled, &k, &k);
+		}
+		for (int64T k = 0; k < 40; k++) {
+			Runtime_concurrent_hashtable_erase(cycled, &k);
+		}
+	}
+	EXPECT_EQ(Runtime_concurrent_hashtable_capacity(cycled), 64);
+	EXPECT_EQ(Runtime_concurrent_hashtable_size(cycled), 0);
+	Runtime_concurrent_hashtable_delete(cycled);
+
+	//handle values come back as copies that outlive the stored value
+	auto names = Runtime_concurrent_hashtable_new(typeInteger32, typeString);
+	int32T id = 7;
+	Runtime_concurrent_hashtable_insert(names, &id, Runtime_string_new("first"));
+	Runtime_string_handle got = nullptr;
+	EXPECT_TRUE(Runtime_concurrent_hashtable_get(names, &id, &got));
+	for (int32T i = 0; i < 200; i++) {
+		Runtime_concurrent_hashtable_insert(names, &id, Runtime_string_new("next"));
+	}
+	Runtime_concurrent_hashtable_erase(names, &id);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(got), "first");
+	Runtime_string_delete(got);
+	Runtime_concurrent_hashtable_delete(names);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_hashtable_batch) {
+
+	Runtime_init();
+
+	const uint64T count = 1000;
+	std::vector<int32T> keys(count);
+	std::vector<double64T> vals(count);
+	for (uint64T i = 0; i < count; i++) {
+		keys[i] = (int32T)(i * 31);
+		vals[i] = i * 0.5;
+	}
+
+	auto ht = Runtime_hashtable_new(typeInteger32, typeDouble64);
+	Runtime_hashtable_insert_batch(ht, keys.data(), vals.data(), count);
+	EXPECT_EQ(Runtime_hashtable_size(ht), count);
+
+	//every other query misses
+	std::vector<int32T> queries(count * 2);
+	for (uint64T i = 0; i < count; i++) {
+		queries[i * 2] = keys[count - 1 - i];
+		queries[i * 2 + 1] = keys[i] + 1;
+	}
+
+	std::vector<void*> results(queries.size());
+	Runtime_hashtable_at_batch(ht, queries.data(), results.data(), queries.size());
+	for (uint64T i = 0; i < count; i++) {
+		ASSERT_NE(results[i * 2], nullptr);
+		EXPECT_EQ(*(double64T*)results[i * 2], (count - 1 - i) * 0.5);
+		EXPECT_EQ(results[i * 2 + 1], nullptr);
+	}
+	Runtime_hashtable_delete(ht);
+
+	//handle keys are passed as an array of handles
+	auto strHt = Runtime_hashtable_new(typeString, typeInteger64);
+	Runtime_string_handle strKeys[3] = { Runtime_string_new("a"), Runtime_string_new("b"), Runtime_string_new("c") };
+	int64T strVals[3] = { 1, 2, 3 };
+	Runtime_hashtable_insert_batch(strHt, strKeys, strVals, 3);
+
+	Runtime_string_handle strQueries[2] = { Runtime_string_new("c"), Runtime_string_new("d") };
+	void* strResults[2] = {};
+	Runtime_hashtable_at_batch(strHt, strQueries, strResults, 2);
+	ASSERT_NE(strResults[0], nullptr);
+	EXPECT_EQ(*(int64T*)strResults[0], 3);
+	EXPECT_EQ(strResults[1], nullptr);
+
+	Runtime_string_delete(strQueries[0]);
+	Runtime_string_delete(strQueries[1]);
+	Runtime_hashtable_delete(strHt);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_hashtable_small_map) {
+
+	Runtime_init();
+
+	auto ht = Runtime_hashtable_new_ordered(typeInteger32, typeInteger32);
+	for (int32T i = 0; i < 8; i++) {
+		int32T v = i * 10;
+		Runtime_hashtable_insert(ht, &i, &v);
+	}
+	EXPECT_EQ(Runtime_hashtable_capacity(ht), 8);
+
+	int32T k = 3;
+	Runtime_hashtable_erase(ht, &k);
+	EXPECT_EQ(Runtime_hashtable_at(ht, &k), nullptr);
+	k = 7;
+	EXPECT_EQ(*(int32T*)Runtime_hashtable_at(ht, &k), 70);
+
+	//refill, then the 9th key moves everything to a full table
+	k = 3;
+	int32T v = 300;
+	Runtime_hashtable_insert(ht, &k, &v);
+	k = 8;
+	v = 80;
+	Runtime_hashtable_insert(ht, &k, &v);
+	EXPECT_GT(Runtime_hashtable_capacity(ht), 8);
+	EXPECT_EQ(Runtime_hashtable_size(ht), 9);
+
+	int32T expectedOrder[] = { 0, 1, 2, 4, 5, 6, 7, 3, 8 };
+	Runtime_hashtable_iter it;
+	Runtime_hashtable_iter_init(ht, &it);
+	int32T idx = 0;
+	while (Runtime_hashtable_iter_next(&it)) {
+		EXPECT_EQ(*(int32T*)it.key, expectedOrder[idx]);
+		idx++;
+	}
+	EXPECT_EQ(idx, 9);
+	Runtime_hashtable_delete(ht);
+
+	auto dict = Runtime_dictionary_new(typeString);
+	Runtime_dictionary_insert(dict, Runtime_string_new("name"), Runtime_string_new("scratch"));
+	Runtime_dictionary_insert(dict, Runtime_string_new("kind"), Runtime_string_new("runtime"));
+	auto key = Runtime_string_new("kind");
+	auto val = (Runtime_string_handle)Runtime_dictionary_at(dict, key);
+	ASSERT_NE(val, nullptr);
+	auto expected = Runtime_string_new("runtime");
+	EXPECT_EQ(Runtime_string_compare(val, expected), 0);
+	Runtime_string_delete(expected);
+	Runtime_string_delete(key);
+	Runtime_dictionary_clear(dict);
+	EXPECT_EQ(Runtime_dictionary_size(dict), 0);
+	Runtime_dictionary_delete(dict);
+
+	Runtime_terminate();
+}
+
+
+TEST(TestScratchRuntime, Test_runtime_hashtable_typed) {
+
+	Runtime_init();
+
+	//typed and generic calls work on the same table
+	auto ht = Runtime_hashtable_new(typeInteger32, typeInteger32);
+	for (int32T i = 0; i < 1000; i++) {
+		Runtime_hashtable_insert_i32_i32(ht, i, i * 2);
+	}
+	EXPECT_EQ(Runtime_hashtable_size(ht), 1000);
+	for (int32T i = 0; i < 1000; i++) {
+		auto val = (int32T*)Runtime_hashtable_at(ht, &i);
+		ASSERT_NE(val, nullptr);
+		EXPECT_EQ(*val, i * 2);
+	}
+	int32T k = 500;
+	Runtime_hashtable_erase(ht, &k);
+	EXPECT_EQ(Runtime_hashtable_at_i32_i32(ht, 500), nullptr);
+	Runtime_hashtable_insert_i32_i32(ht, 7, -7);
+	EXPECT_EQ(*Runtime_hashtable_at_i32_i32(ht, 7), -7);
+	EXPECT_EQ(Runtime_hashtable_size(ht), 999);
+	Runtime_hashtable_delete(ht);
+
+	auto strTable = Runtime_hashtable_new_ordered(typeString, typeDouble64);
+	Runtime_hashtable_insert_str_f64(strTable, Runtime_string_new("pi"), 3.14159);
+	Runtime_hashtable_insert_str_f64(strTable, Runtime_string_new("e"), 2.71828);
+	//replaces, the old key string is freed
+	Runtime_hashtable_insert_str_f64(strTable, Runtime_string_new("pi"), 3.0);
+	EXPECT_EQ(Runtime_hashtable_size(strTable), 2);
+
+	auto key = Runtime_string_new("pi");
+	EXPECT_DOUBLE_EQ(*Runtime_hashtable_at_str_f64(strTable, key), 3.0);
+	EXPECT_DOUBLE_EQ(*(double64T*)Runtime_hashtable_at(strTable, key), 3.0);
+	Runtime_string_delete(key);
+
+	double64T val = 1.5;
+	Runtime_hashtable_insert(strTable, Runtime_string_new("one and a half"), &val);
+	Runtime_hashtable_iter it;
+	Runtime_hashtable_iter_init(strTable, &it);
+	int32T count = 0;
+	while (Runtime_hashtable_iter_next(&it)) {
+		count++;
+	}
+	EXPECT_EQ(count, 3);
+	Runtime_hashtable_delete(strTable);
+
+	Runtime_terminate();
+}
+
+
+TEST(TestScratchRuntime, Test_runtime_static_dictionary) {
+
+	Runtime_init();
+
+	//what the compiler emits for { "red":1, "green":2, "blue":3, 
+	//"alpha":4, "depth":5 }, placed by its builder
+	const char* keys[] = { "red", "green", "blue", "alpha", "depth" };
+	const int32T values[] = { 1, 2, 3, 4, 5 };
+	const uint64T keyCount = 5;
+
+	compiletime::PerfectHash perfectHash;
+	ASSERT_TRUE(perfectHash.build(std::vector<compiletime::CppString>(keys, keys + keyCount)));
+	ASSERT_EQ(perfectHash.bucketCount(), 2);
+	ASSERT_EQ(perfectHash.slots.size(), keyCount);
+
+	Runtime_static_dictionary_entry entries[keyCount] = {};
+	for (uint64T i = 0; i < keyCount; i++) {
+		EXPECT_EQ(perfectHash.hashKey(keys[i]), Runtime_static_dictionary_hash((const charT*)keys[i], strlen(keys[i])));
+		//the string hash covers size chars only, so it's the same one
+		auto keyStr = Runtime_string_new(keys[i]);
+		EXPECT_EQ(perfectHash.hashKey(keys[i]), Runtime_string_hash(keyStr));
+		Runtime_string_delete(keyStr);
+		auto slot = perfectHash.slots[i];
+		ASSERT_LT(slot, keyCount);
+		EXPECT_EQ(entries[slot].key, nullptr);
+		entries[slot] = { (const charT*)keys[i], strlen(keys[i]), &values[i] };
+	}
+	const uint32T* seeds = perfectHash.seeds.data();
+
+	Runtime_static_dictionary dict = { keyCount, 2, seeds, entries };
+	EXPECT_EQ(Runtime_static_dictionary_size(&dict), keyCount);
+
+	for (uint64T i = 0; i < keyCount; i++) {
+		auto key = Runtime_string_new((const charT*)keys[i]);
+		auto val = (const int32T*)Runtime_static_dictionary_at(&dict, key);
+		ASSERT_NE(val, nullptr);
+		EXPECT_EQ(*val, values[i]);
+		Runtime_string_delete(key);
+	}
+
+	auto missing = Runtime_string_new("purple");
+	EXPECT_EQ(Runtime_static_dictionary_at(&dict, missing), nullptr);
+	Runtime_string_delete(missing);
+	EXPECT_EQ(Runtime_static_dictionary_at_bytes(&dict, (const charT*)"gree", 4), nullptr);
+	EXPECT_EQ(*(const int32T*)Runtime_static_dictionary_at_bytes(&dict, (const charT*)"blue", 4), 3);
+
+	//a repeated key can't be placed, the builder says so at once
+	compiletime::PerfectHash duplicated;
+	EXPECT_FALSE(duplicated.build({ "red", "green", "blue", "green" }));
+	EXPECT_EQ(duplicated.bucketCount(), 0);
+	EXPECT_TRUE(duplicated.slots.empty());
+	EXPECT_TRUE(duplicated.build({}));
+
+	//a bigger set still gets every key its own slot
+	std::vector<compiletime::CppString> many;
+	for (int i = 0; i < 1000; i++) {
+		many.push_back("key" + std::to_string(i));
+	}
+	compiletime::PerfectHash larger;
+	ASSERT_TRUE(larger.build(many));
+	std::vector<bool> used(many.size(), false);
+	for (uint64T i = 0; i < many.size(); i++) {
+		auto hash = compiletime::PerfectHash::hashKey(many[i]);
+		auto seed = larger.seeds[compiletime::PerfectHash::bucketFor(hash, larger.bucketCount())];
+		auto slot = compiletime::PerfectHash::slotFor(hash, seed, many.size());
+		EXPECT_EQ(slot, larger.slots[i]);
+		EXPECT_EQ(Runtime_static_dictionary_slot(hash, seed, many.size()), slot);
+		EXPECT_FALSE(used[slot]);
+		used[slot] = true;
+	}
+
+	Runtime_terminate();
+}
+
+
+TEST(TestScratchRuntime, Test_runtime_set) {
+
+	Runtime_init();
+
+	auto evens = Runtime_set_new(typeInteger32);
+	auto small = Runtime_set_new(typeInteger32);
+	for (int32T i = 0; i < 100; i += 2) {
+		EXPECT_TRUE(Runtime_set_insert(evens, &i));
+	}
+	for (int32T i = 0; i < 10; i++) {
+		Runtime_set_insert(small, &i);
+	}
+	int32T k = 4;
+	EXPECT_FALSE(Runtime_set_insert(evens, &k));
+	EXPECT_EQ(Runtime_set_size(evens), 50);
+	EXPECT_TRUE(Runtime_set_contains(evens, &k));
+	k = 5;
+	EXPECT_FALSE(Runtime_set_contains(evens, &k));
+
+	auto both = Runtime_set_intersection(small, evens);
+	EXPECT_EQ(Runtime_set_size(both), 5);
+	auto all = Runtime_set_union(evens, small);
+	EXPECT_EQ(Runtime_set_size(all), 55);
+	auto odd = Runtime_set_difference(small, evens);
+	EXPECT_EQ(Runtime_set_size(odd), 5);
+	auto bigOnly = Runtime_set_difference(evens, small);
+	EXPECT_EQ(Runtime_set_size(bigOnly), 45);
+
+	Runtime_set_iter it;
+	Runtime_set_iter_init(odd, &it);
+	while (Runtime_set_iter_next(&it)) {
+		EXPECT_EQ(*(int32T*)Runtime_set_iter_key(&it) % 2, 1);
+	}
+
+	k = 0;
+	EXPECT_TRUE(Runtime_set_erase(both, &k));
+	EXPECT_FALSE(Runtime_set_erase(both, &k));
+	EXPECT_EQ(Runtime_set_size(both), 4);
+
+	Runtime_set_delete(evens);
+	Runtime_set_delete(small);
+	Runtime_set_delete(both);
+	Runtime_set_delete(all);
+	Runtime_set_delete(odd);
+	Runtime_set_delete(bigOnly);
+
+	//string keys, results own copies
+	auto names = Runtime_set_new_ordered(typeString);
+	auto other = Runtime_set_new(typeString);
+	Runtime_set_insert(names, Runtime_string_new("ann"));
+	Runtime_set_insert(names, Runtime_string_new("bob"));
+	Runtime_set_insert(names, Runtime_string_new("cy"));
+	Runtime_set_insert(other, Runtime_string_new("bob"));
+
+	auto common = Runtime_set_intersection(names, other);
+	auto rest = Runtime_set_difference(names, other);
+	Runtime_set_delete(other);
+	EXPECT_EQ(Runtime_set_size(common), 1);
+	EXPECT_EQ(Runtime_set_size(rest), 2);
+
+	auto key = Runtime_string_new("bob");
+	EXPECT_TRUE(Runtime_set_contains(common, key));
+	EXPECT_FALSE(Runtime_set_contains(rest, key));
+	Runtime_string_delete(key);
+
+	Runtime_set_delete(names);
+	Runtime_set_delete(common);
+	Runtime_set_delete(rest);
+
+	Runtime_terminate();
+}
+
+
+TEST(TestScratchRuntime, Test_runtime_hashtable_stats) {
+
+	Runtime_init();
+
+	Runtime_hashtable_stats stats;
+	auto ht = Runtime_hashtable_new(typeInteger64, typeInteger64);
+	Runtime_hashtable_get_stats(ht, &stats);
+	EXPECT_EQ(stats.size, 0);
+	EXPECT_EQ(stats.maxProbeLength, 0);
+	EXPECT_EQ(stats.tableBytes, 0);
+
+	for (int64T i = 0; i < 1000; i++) {
+		Runtime_hashtable_insert(ht, &i, &i);
+	}
+	for (int64T i = 0; i < 100; i++) {
+		Runtime_hashtable_erase(ht, &i);
+	}
+	Runtime_hashtable_get_stats(ht, &stats);
+	EXPECT_EQ(stats.size, 900);
+	EXPECT_EQ(stats.capacity, Runtime_hashtable_capacity(ht));
+	EXPECT_DOUBLE_EQ(stats.loadFactor, 900.0 / (double)stats.capacity);
+	EXPECT_GE(stats.maxProbeLength, 1);
+	EXPECT_GE(stats.avgProbeLength, 1.0);
+	EXPECT_LE(stats.avgProbeLength, (double)stats.maxProbeLength);
+	EXPECT_GE(stats.resizeCount, 6);
+	EXPECT_EQ(stats.entryBytes, stats.capacity * 16);
+	EXPECT_EQ(stats.tableBytes, stats.capacity + 16);
+
+	Runtime_hashtable_set_stats_dump(2);
+	auto small = Runtime_hashtable_new(typeInteger32, typeInteger32);
+	int32T k = 1;
+	Runtime_hashtable_insert(small, &k, &k);
+	Runtime_hashtable_delete(small);
+	Runtime_hashtable_delete(ht);
+	auto dict = Runtime_dictionary_new(typeInteger32);
+	Runtime_dictionary_delete(dict);
+
+	Runtime_terminate();
+}
+
+
+//every key lands on the same hash
+static uint64T TestPoint_bad_hash(const void* obj)
+{
+	return 42;
+}
+
+TEST(TestScratchRuntime, Test_runtime_persistent_map) {
+
+	Runtime_init();
+
+	auto map = Runtime_persistent_map_new(typeInteger32, typeInteger32);
+	Runtime_persistent_map_handle snapshot = nullptr;
+	for (int32T i = 0; i < 2000; i++) {
+		auto next = Runtime_persistent_map_insert(map, &i, &i);
+		Runtime_persistent_map_delete(map);
+		map = next;
+		if (999 == i) {
+			snapshot = Runtime_persistent_map_copy(map);
+		}
+	}
+	EXPECT_EQ(Runtime_persistent_map_size(map), 2000);
+	EXPECT_EQ(Runtime_persistent_map_size(snapshot), 1000);
+
+	//updates don't show up in older maps
+	int32T k = 10;
+	int32T v = -10;
+	auto updated = Runtime_persistent_map_insert(snapshot, &k, &v);
+	EXPECT_EQ(Runtime_persistent_map_size(updated), 1000);
+	EXPECT_EQ(*(int32T*)Runtime_persistent_map_at(updated, &k), -10);
+	EXPECT_EQ(*(int32T*)Runtime_persistent_map_at(snapshot, &k), 10);
+	k = 1500;
+	EXPECT_EQ(Runtime_persistent_map_at(snapshot, &k), nullptr);
+	EXPECT_EQ(*(int32T*)Runtime_persistent_map_at(map, &k), 1500);
+
+	for (int32T i = 0; i < 2000; i += 2) {
+		auto next = Runtime_persistent_map_erase(map, &i);
+		Runtime_persistent_map_delete(map);
+		map = next;
+	}
+	EXPECT_EQ(Runtime_persistent_map_size(map), 1000);
+	for (int32T i = 0; i < 2000; i++) {
+		auto val = (int32T*)Runtime_persistent_map_at(map, &i);
+		if (i % 2) {
+			ASSERT_NE(val, nullptr);
+			EXPECT_EQ(*val, i);
+		}
+		else {
+			EXPECT_EQ(val, nullptr);
+		}
+	}
+	k = 0;
+	auto same = Runtime_persistent_map_erase(map, &k);
+	EXPECT_EQ(Runtime_persistent_map_size(same), 1000);
+
+	Runtime_persistent_map_delete(same);
+	Runtime_persistent_map_delete(updated);
+	Runtime_persistent_map_delete(snapshot);
+	Runtime_persistent_map_delete(map);
+
+	//colliding keys
+	Runtime_type_info info = {};
+	info.baseType = typeRecord;
+	info.size = sizeof(TestPoint);
+	info.alignment = alignof(TestPoint);
+	info.hash = TestPoint_bad_hash;
+	auto pointType = Runtime_register_type(&info);
+
+	auto points = Runtime_persistent_map_new(pointType, typeString);
+	for (int32T i = 0; i < 5; i++) {
+		TestPoint p = { i, i, 0.0 };
+		auto next = Runtime_persistent_map_insert(points, &p, Runtime_string_new("point"));
+		Runtime_persistent_map_delete(points);
+		points = next;
+	}
+	EXPECT_EQ(Runtime_persistent_map_size(points), 5);
+	TestPoint p = { 3, 3, 0.0 };
+	EXPECT_NE(Runtime_persistent_map_at(points, &p), nullptr);
+	auto fewer = Runtime_persistent_map_erase(points, &p);
+	EXPECT_EQ(Runtime_persistent_map_at(fewer, &p), nullptr);
+	EXPECT_NE(Runtime_persistent_map_at(points, &p), nullptr);
+	EXPECT_EQ(Runtime_persistent_map_size(fewer), 4);
+	Runtime_persistent_map_delete(fewer);
+	Runtime_persistent_map_delete(points);
+
+	//values that need 16 byte alignment get it in the leaves
+	struct alignas(16) TestVector {
+		float lanes[4];
+	};
+	Runtime_type_info vectorInfo = {};
+	vectorInfo.baseType = typeRecord;
+	vectorInfo.size = sizeof(TestVector);
+	vectorInfo.alignment = alignof(TestVector);
+	vectorInfo.name = "TestVector";
+	auto vectorType = Runtime_register_type(&vectorInfo);
+
+	auto vectors = Runtime_persistent_map_new(typeInteger32, vectorType);
+	for (int32T i = 0; i < 100; i++) {
+		TestVector v = { { (float)i, 0, 0, 1 } };
+		auto next = Runtime_persistent_map_insert(vectors, &i, &v);
+		Runtime_persistent_map_delete(vectors);
+		vectors = next;
+	}
+	for (int32T i = 0; i < 100; i++) {
+		auto v = (TestVector*)Runtime_persistent_map_at(vectors, &i);
+		ASSERT_NE(v, nullptr);
+		EXPECT_EQ((uint64T)v & 15, 0);
+		EXPECT_EQ(v->lanes[0], (float)i);
+	}
+	Runtime_persistent_map_delete(vectors);
+
+	Runtime_terminate();
+}
+
+
+TEST(TestScratchRuntime, Test_runtime_string) {
+
+	Runtime_init();
+
+	auto shortStr = Runtime_string_new("identifier");
+	EXPECT_EQ(Runtime_string_size(shortStr), 10);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(shortStr), "identifier");
+	EXPECT_EQ(Runtime_string_at(shortStr, 2), 'e');
+	EXPECT_EQ(Runtime_string_at(shortStr, 10), 0);
+
+	auto longStr = Runtime_string_new("a string that is too long to fit inline");
+	EXPECT_EQ(Runtime_string_size(longStr), 39);
+	auto copy = Runtime_string_new_copy(longStr);
+	EXPECT_EQ(Runtime_string_compare(copy, longStr), 0);
+	EXPECT_EQ(Runtime_string_hash(copy), Runtime_string_hash(longStr));
+
+	//grow a short string past its capacity and shrink it again
+	Runtime_string_assign_copy(shortStr, longStr);
+	EXPECT_EQ(Runtime_string_compare(shortStr, longStr), 0);
+	Runtime_string_assign(shortStr, (charT*)"tiny");
+	EXPECT_EQ(Runtime_string_size(shortStr), 4);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(shortStr), "tiny");
+
+	//equal strings hash the same however they were built
+	auto tiny = Runtime_string_new("tiny");
+	EXPECT_EQ(Runtime_string_hash(tiny), Runtime_string_hash(shortStr));
+	EXPECT_EQ(Runtime_string_compare(tiny, shortStr), 0);
+
+	auto stars = Runtime_string_new_char_count('*', 30);
+	EXPECT_EQ(Runtime_string_size(stars), 30);
+	EXPECT_EQ(Runtime_string_at(stars, 29), '*');
+	Runtime_string_clear(stars);
+	EXPECT_TRUE(Runtime_string_empty(stars));
+
+	auto sub = Runtime_string_substr(longStr, 2, 6);
+	ASSERT_NE(sub, nullptr);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(sub), "string");
+	EXPECT_EQ(Runtime_string_substr(longStr, 35, 5), nullptr);
+
+	Runtime_string_delete(sub);
+	Runtime_string_delete(stars);
+	Runtime_string_delete(tiny);
+	Runtime_string_delete(copy);
+	Runtime_string_delete(longStr);
+	Runtime_string_delete(shortStr);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_string_intern) {
+
+	Runtime_init();
+
+	auto name = Runtime_string_intern_cstr("name");
+	EXPECT_TRUE(Runtime_string_is_interned(name));
+	EXPECT_EQ(Runtime_string_intern_cstr("name"), name);
+
+	auto plain = Runtime_string_new("name");
+	EXPECT_FALSE(Runtime_string_is_interned(plain));
+	EXPECT_EQ(Runtime_string_intern(plain), name);
+	EXPECT_EQ(Runtime_string_intern(name), name);
+	EXPECT_TRUE(Runtime_string_equals(plain, name));
+
+	auto longName = Runtime_string_intern_cstr("a field name that is too long to fit inline");
+	EXPECT_NE(longName, name);
+	EXPECT_FALSE(Runtime_string_equals(longName, name));
+	EXPECT_EQ(Runtime_string_intern_with_size((const charT*)"a field name that is too long to fit inline!!", 43), longName);
+
+	//the dictionary owns its keys, deleting an interned key does nothing
+	auto dict = Runtime_dictionary_new(typeInteger32);
+	for (int32T i = 0; i < 100; i++) {
+		charT buf[] = "field00";
+		buf[5] = (charT)('0' + i / 10);
+		buf[6] = (charT)('0' + i % 10);
+		Runtime_dictionary_insert(dict, Runtime_string_intern_cstr(buf), &i);
+	}
+	for (int32T i = 0; i < 100; i++) {
+		charT buf[] = "field00";
+		buf[5] = (charT)('0' + i / 10);
+		buf[6] = (charT)('0' + i % 10);
+		auto val = (int32T*)Runtime_dictionary_at(dict, Runtime_string_intern_cstr(buf));
+		ASSERT_NE(val, nullptr);
+		EXPECT_EQ(*val, i);
+	}
+	Runtime_dictionary_delete(dict);
+
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(Runtime_string_intern_cstr("field07")), "field07");
+
+	Runtime_string_delete(name);
+	Runtime_string_delete(plain);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_string_builder) {
+
+	Runtime_init();
+
+	auto str = Runtime_string_new("aa");
+	for (int i = 0; i < 20; i++) {
+		Runtime_string_append(str, (const charT*)" from me");
+	}
+	EXPECT_EQ(Runtime_string_size(str), 2 + 20 * 8);
+	Runtime_string_append_with_size(str, Runtime_string_get_cstr(str), 2);
+	EXPECT_EQ(Runtime_string_at(str, 162), 'a');
+	EXPECT_EQ(Runtime_string_at(str, 164), 0);
+
+	auto builder = Runtime_string_builder_new(0);
+	Runtime_string_builder_append(builder, (const charT*)"short");
+	auto shortStr = Runtime_string_builder_to_string(builder);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(shortStr), "short");
+	EXPECT_EQ(Runtime_string_builder_size(builder), 0);
+
+	Runtime_string_handle parts[] = { str, shortStr, str };
+	Runtime_string_builder_append_many(builder, parts, 3);
+	Runtime_string_builder_append_char(builder, '!');
+	auto longStr = Runtime_string_builder_to_string(builder);
+	EXPECT_EQ(Runtime_string_size(longStr), 164 * 2 + 5 + 1);
+	EXPECT_EQ(Runtime_string_at(longStr, 164), 's');
+	EXPECT_EQ(Runtime_string_at(longStr, 164 * 2 + 5), '!');
+
+	auto concat = Runtime_string_concat(str, shortStr);
+	EXPECT_EQ(Runtime_string_size(concat), 169);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(concat) + 164, "short");
+
+	//rope against a plain buffer
+	static charT expected[20000];
+	uint64T expectedSize = 0;
+	auto rope = Runtime_rope_new();
+	uint32T seed = 1;
+	for (int i = 0; i < 2000; i++) {
+		seed = seed * 1103515245 + 12345;
+		uint32T op = (seed >> 16) % 4;
+		charT chars[40];
+		uint64T count = (seed >> 8) % 40;
+		for (uint64T k = 0; k < count; k++) {
+			chars[k] = (charT)('a' + (i + k) % 26);
+		}
+		uint64T index = expectedSize == 0 ? 0 : (seed >> 4) % expectedSize;
+
+		if (op == 3 && expectedSize > 0) {
+			Runtime_rope_erase(rope, index, count);
+			uint64T erased = count > expectedSize - index ? expectedSize - index : count;
+			for (uint64T k = index; k + erased < expectedSize; k++) {
+				expected[k] = expected[k + erased];
+			}
+			expectedSize -= erased;
+		}
+		else if (op == 2 && expectedSize + count < sizeof(expected)) {
+			Runtime_rope_insert(rope, index, chars, count);
+			for (uint64T k = expectedSize; k > index; k--) {
+				expected[k - 1 + count] = expected[k - 1];
+			}
+			for (uint64T k = 0; k < count; k++) {
+				expected[index + k] = chars[k];
+			}
+			expectedSize += count;
+		}
+		else if (expectedSize + count < sizeof(expected)) {
+			Runtime_rope_append_with_size(rope, chars, count);
+			for (uint64T k = 0; k < count; k++) {
+				expected[expectedSize + k] = chars[k];
+			}
+			expectedSize += count;
+		}
+	}
+	ASSERT_EQ(Runtime_rope_size(rope), expectedSize);
+	auto ropeStr = Runtime_rope_to_string(rope);
+	uint64T mismatches = 0;
+	for (uint64T k = 0; k < expectedSize; k++) {
+		mismatches += Runtime_string_at(ropeStr, k) != expected[k] ? 1 : 0;
+	}
+	EXPECT_EQ(mismatches, 0);
+	EXPECT_EQ(Runtime_rope_at(rope, expectedSize / 2), expected[expectedSize / 2]);
+
+	auto other = Runtime_rope_new_from_string(longStr);
+	Runtime_rope_append_rope(rope, other);
+	EXPECT_EQ(Runtime_rope_size(rope), expectedSize + Runtime_string_size(longStr));
+	EXPECT_EQ(Runtime_rope_at(rope, expectedSize + 164), 's');
+
+	Runtime_string_delete(ropeStr);
+	Runtime_rope_delete(rope);
+	Runtime_string_delete(concat);
+	Runtime_string_delete(longStr);
+	Runtime_string_delete(shortStr);
+	Runtime_string_builder_delete(builder);
+	Runtime_string_delete(str);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_string_find) {
+
+	Runtime_init();
+
+	auto text = Runtime_string_new("error: disk full; warning: retrying; error: disk still full; info: giving up after the error");
+	auto error = Runtime_string_new("error");
+	auto full = Runtime_string_new("full");
+	auto missing = Runtime_string_new("fatal");
+	auto ch = Runtime_string_new(";");
+
+	EXPECT_EQ(Runtime_string_find(text, error), 0);
+	EXPECT_EQ(Runtime_string_find_from(text, error, 1), 37);
+	EXPECT_EQ(Runtime_string_find_last(text, error), 87);
+	EXPECT_EQ(Runtime_string_find(text, full), 12);
+	EXPECT_EQ(Runtime_string_find_last(text, full), 55);
+	EXPECT_EQ(Runtime_string_find(text, missing), Runtime_NoIndx);
+	EXPECT_EQ(Runtime_string_find_last(text, missing), Runtime_NoIndx);
+	EXPECT_EQ(Runtime_string_count(text, error), 3);
+	EXPECT_EQ(Runtime_string_count(text, ch), 3);
+	EXPECT_EQ(Runtime_string_find_last(text, ch), 59);
+
+	//overlapping candidates and the scalar tail
+	auto aaa = Runtime_string_new_char_count('a', 40);
+	Runtime_string_append(aaa, (const charT*)"ab");
+	auto ab = Runtime_string_new("aab");
+	EXPECT_EQ(Runtime_string_find(aaa, ab), 39);
+	EXPECT_EQ(Runtime_string_find_last(aaa, ab), 39);
+	auto aa = Runtime_string_new("aa");
+	EXPECT_EQ(Runtime_string_count(aaa, aa), 20);
+
+	Runtime_string_handle patterns[] = { Runtime_string_new("disk"), Runtime_string_new("warning"), Runtime_string_new("up"), Runtime_string_new("giving up") };
+	auto matcher = Runtime_string_matcher_new(patterns, 4);
+	uint64T patternIdx = 0;
+	EXPECT_EQ(Runtime_string_matcher_find(matcher, text, 0, &patternIdx), 7);
+	EXPECT_EQ(patternIdx, 0);
+	EXPECT_EQ(Runtime_string_matcher_find(matcher, text, 11, &patternIdx), 18);
+	EXPECT_EQ(patternIdx, 1);
+	//"up" and "giving up" end at the same char, the longer wins
+	EXPECT_EQ(Runtime_string_matcher_find(matcher, text, 61, &patternIdx), 67);
+	EXPECT_EQ(patternIdx, 3);
+	EXPECT_EQ(Runtime_string_matcher_find(matcher, text, 77, nullptr), Runtime_NoIndx);
+	EXPECT_EQ(Runtime_string_matcher_count(matcher, text), 5);
+	Runtime_string_matcher_delete(matcher);
+
+	for (auto pattern : patterns) {
+		Runtime_string_delete(pattern);
+	}
+	Runtime_string_delete(aa);
+	Runtime_string_delete(ab);
+	Runtime_string_delete(aaa);
+	Runtime_string_delete(ch);
+	Runtime_string_delete(missing);
+	Runtime_string_delete(full);
+	Runtime_string_delete(error);
+	Runtime_string_delete(text);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_string_view) {
+
+	Runtime_init();
+
+	auto doc = Runtime_string_new("the quick brown fox jumps over the lazy dog, the quick brown fox jumps again");
+
+	//tokenize without copying
+	std::vector<Runtime_string_handle> words;
+	uint64T start = 0;
+	for (uint64T i = 0; i <= Runtime_string_size(doc); i++) {
+		charT ch = Runtime_string_at(doc, i);
+		if (ch == ' ' || ch == ',' || ch == 0) {
+			if (i > start) {
+				words.push_back(Runtime_string_substr(doc, start, i - start));
+			}
+			start = i + 1;
+		}
+	}
+	ASSERT_EQ(words.size(), 15);
+	//short ones are copies, they fit in the object
+	EXPECT_FALSE(Runtime_string_is_view(words[1]));
+	EXPECT_EQ(Runtime_string_size(words[1]), 5);
+	EXPECT_EQ(Runtime_string_at(words[1], 0), 'q');
+	EXPECT_TRUE(Runtime_string_equals(words[0], words[9]));
+	EXPECT_EQ(Runtime_string_hash(words[1]), Runtime_string_hash(words[10]));
+
+	auto clause = Runtime_string_substr(doc, 0, 43);
+	EXPECT_TRUE(Runtime_string_is_view(clause));
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(clause), "the quick brown fox jumps over the lazy dog");
+
+	//a view of a view shares the same chars
+	auto sub = Runtime_string_substr(clause, 4, 26);
+	EXPECT_TRUE(Runtime_string_is_view(sub));
+	auto tail = Runtime_string_substr(doc, 45, 31);
+	EXPECT_TRUE(Runtime_string_is_view(tail));
+
+	//the parent moves to new chars, the views keep theirs
+	Runtime_string_append(doc, (const charT*)"!");
+	EXPECT_EQ(Runtime_string_at(doc, 76), '!');
+	Runtime_string_assign(doc, (charT*)"gone");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(doc), "gone");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(sub), "quick brown fox jumps over");
+
+	//the parent outlives its deletion while views remain
+	Runtime_string_delete(doc);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(tail), "the quick brown fox jumps again");
+	EXPECT_TRUE(Runtime_string_is_view(tail));
+
+	Runtime_string_compact(sub);
+	EXPECT_FALSE(Runtime_string_is_view(sub));
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(sub), "quick brown fox jumps over");
+
+	//writing to a view copies it first
+	Runtime_string_append(clause, (const charT*)"s");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(clause), "the quick brown fox jumps over the lazy dogs");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(tail), "the quick brown fox jumps again");
+	Runtime_string_assign_copy(tail, tail);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(tail), "the quick brown fox jumps again");
+
+	//chars grown out of the object are shared through a holder
+	auto grown = Runtime_string_new("a");
+	for (int i = 0; i < 40; i++) {
+		Runtime_string_append(grown, (const charT*)"bc");
+	}
+	auto front = Runtime_string_substr(grown, 0, 30);
+	auto back = Runtime_string_substr(grown, 51, 30);
+	EXPECT_TRUE(Runtime_string_is_view(front));
+	Runtime_string_append(grown, (const charT*)"d");
+	Runtime_string_assign_char_count(grown, 'z', 3);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(grown), "zzz");
+	EXPECT_EQ(Runtime_string_at(front, 28), 'c');
+	Runtime_string_delete(front);
+
+	//the last view of the old chars goes with back
+	auto again = Runtime_string_substr(back, 1, 24);
+	Runtime_string_delete(back);
+	EXPECT_EQ(Runtime_string_at(again, 0), 'c');
+	Runtime_string_delete(again);
+
+	//with no views left the buffer is kept
+	for (int i = 0; i < 20; i++) {
+		Runtime_string_append(grown, (const charT*)"yz");
+	}
+	auto last = Runtime_string_substr(grown, 3, 40);
+	Runtime_string_delete(last);
+	Runtime_string_append(grown, (const charT*)"!");
+	EXPECT_EQ(Runtime_string_size(grown), 44);
+	Runtime_string_delete(grown);
+
+	for (auto word : words) {
+		Runtime_string_delete(word);
+	}
+	Runtime_string_delete(clause);
+	Runtime_string_delete(sub);
+	Runtime_string_delete(tail);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_utf8) {
+
+	Runtime_init();
+
+	//"naïve café €5 😀" plus enough ascii to take the block paths
+	const charT* text = (const charT*)"plain ascii text to start with, na\xc3\xafve caf\xc3\xa9 \xe2\x82\xac" "5 \xf0\x9f\x98\x80";
+	auto str = Runtime_string_new(text);
+	uint64T size = Runtime_string_size(str);
+	EXPECT_TRUE(Runtime_string_is_utf8(str));
+	EXPECT_EQ(Runtime_string_utf8_length(str), size - 1 - 1 - 2 - 3);
+
+	const char* invalid[] = { "\x80", "\xc0\xaf", "\xed\xa0\x80", "\xf4\x90\x80\x80", "\xe2\x82", "abc\xff", "\xe0\x80\x80" };
+	for (auto bytes : invalid) {
+		EXPECT_FALSE(Runtime_utf8_validate((const charT*)bytes, strlen(bytes)));
+	}
+
+	//cached until the chars change
+	auto truncated = Runtime_string_new_with_size(text, size - 1);
+	EXPECT_FALSE(Runtime_string_is_utf8(truncated));
+	EXPECT_FALSE(Runtime_string_is_utf8(truncated));
+	Runtime_string_append(truncated, text + size - 1);
+	EXPECT_TRUE(Runtime_string_is_utf8(truncated));
+
+	uint16T utf16[128];
+	uint64T units = Runtime_utf8_to_utf16(text, size, utf16);
+	EXPECT_EQ(units, Runtime_string_utf8_length(str) + 1);
+	EXPECT_EQ(utf16[34], 0xEF);
+	EXPECT_EQ(utf16[units - 2], 0xD83D);
+	EXPECT_EQ(utf16[units - 1], 0xDE00);
+
+	auto back = Runtime_string_new_from_utf16(utf16, units);
+	ASSERT_NE(back, nullptr);
+	EXPECT_TRUE(Runtime_string_equals(back, str));
+
+	uint32T utf32[128];
+	uint64T codePoints = Runtime_utf8_to_utf32(text, size, utf32);
+	EXPECT_EQ(codePoints, Runtime_string_utf8_length(str));
+	EXPECT_EQ(utf32[codePoints - 1], 0x1F600);
+	EXPECT_EQ(utf32[codePoints - 4], 0x20AC);
+
+	charT utf8[512];
+	EXPECT_EQ(Runtime_utf32_to_utf8(utf32, codePoints, utf8), size);
+	auto fromUtf32 = Runtime_string_new_with_size(utf8, size);
+	EXPECT_EQ(Runtime_string_compare(fromUtf32, str), 0);
+
+	EXPECT_EQ(Runtime_utf8_to_utf16((const charT*)"\xc0\xaf", 2, utf16), Runtime_NoIndx);
+	uint16T loneSurrogate[] = { 'a', 0xDC00 };
+	EXPECT_EQ(Runtime_utf16_to_utf8(loneSurrogate, 2, utf8), Runtime_NoIndx);
+	EXPECT_EQ(Runtime_string_new_from_utf16(loneSurrogate, 2), nullptr);
+
+	Runtime_string_delete(fromUtf32);
+	Runtime_string_delete(back);
+	Runtime_string_delete(truncated);
+	Runtime_string_delete(str);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_number_conversion) {
+
+	Runtime_init();
+
+	charT buffer[Runtime_number_buffer_size];
+
+	EXPECT_EQ(Runtime_format_int64(0, buffer), 1);
+	EXPECT_STREQ((const char*)buffer, "0");
+	Runtime_format_int64(-9223372036854775807LL - 1, buffer);
+	EXPECT_STREQ((const char*)buffer, "-9223372036854775808");
+	EXPECT_EQ(Runtime_format_uint64(18446744073709551615ULL, buffer), 20);
+	EXPECT_STREQ((const char*)buffer, "18446744073709551615");
+
+	struct {
+		double64T value;
+		const char* text;
+	} doubles[] = {
+		{ 0.0, "0.0" }, { -0.0, "-0.0" }, { 1.0, "1.0" }, { 345.78, "345.78" }, { 0.1, "0.1" },
+		{ 1.0 / 3.0, "0.3333333333333333" }, { 1e21, "1e21" }, { 123456789012.0, "123456789012.0" },
+		{ 0.000001, "0.000001" }, { 1.5e-7, "1.5e-7" }, { 5e-324, "5e-324" },
+		{ 1.7976931348623157e308, "1.7976931348623157e308" }, { -2.5e100, "-2.5e100" },
+	};
+	for (auto& d : doubles) {
+		Runtime_format_double(d.value, buffer);
+		EXPECT_STREQ((const char*)buffer, d.text);
+
+		double64T parsed = 1;
+		EXPECT_EQ(Runtime_parse_double((const charT*)d.text, strlen(d.text), &parsed), strlen(d.text));
+		EXPECT_EQ(parsed, d.value);
+	}
+
+	//correct rounding where the fast paths can't tell
+	const char* halfway = "9007199254740993";
+	double64T parsed = 0;
+	Runtime_parse_double((const charT*)halfway, strlen(halfway), &parsed);
+	EXPECT_EQ(parsed, 9007199254740992.0);
+	const char* exactHalf = "1.00000000000000011102230246251565404236316680908203125";
+	Runtime_parse_double((const charT*)exactHalf, strlen(exactHalf), &parsed);
+	EXPECT_EQ(parsed, 1.0);
+	const char* aboveHalf = "1.000000000000000111022302462515654042363166809082031250000001";
+	Runtime_parse_double((const charT*)aboveHalf, strlen(aboveHalf), &parsed);
+	EXPECT_EQ(parsed, 1.0000000000000002);
+	const char* tiny = "2.4703282292062328e-324";
+	Runtime_parse_double((const charT*)tiny, strlen(tiny), &parsed);
+	EXPECT_EQ(parsed, 5e-324);
+
+	int64T intVal = 0;
+	EXPECT_EQ(Runtime_parse_int64((const charT*)"-1234567890123456789x", 21, &intVal), 20);
+	EXPECT_EQ(intVal, -1234567890123456789LL);
+	EXPECT_EQ(Runtime_parse_int64((const charT*)"9223372036854775808", 19, &intVal), 0);
+	EXPECT_EQ(Runtime_parse_int64((const charT*)"abc", 3, &intVal), 0);
+
+	//the conversion messages
+	auto str = Runtime_int64_stringVal(4);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(str), "4");
+	auto real = Runtime_real64_stringVal(345.78);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(real), "345.78");
+	auto text = Runtime_string_new(" 345.78");
+	EXPECT_EQ(Runtime_string_intVal(text), 345);
+	EXPECT_EQ(Runtime_string_realVal(text), 345.78);
+
+	Runtime_string_delete(text);
+	Runtime_string_delete(real);
+	Runtime_string_delete(str);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_formatted_output) {
+
+	Runtime_init();
+
+	charT buffer[512];
+
+	auto format = [&](const char* expected, const char* fmtStr, auto... args) {
+		auto length = Runtime_snprintf(buffer, sizeof(buffer), fmtStr, args...);
+		EXPECT_STREQ((const char*)buffer, expected);
+		EXPECT_EQ(length, strlen(expected));
+	};
+
+	format("42 -7 ff 0X1F 017", "%d %i %x %#X %#o", 42, -7, 255, 31, 15);
+	format("[   12][12   ][00012][+12][  012]", "[%5d][%-5d][%05d][%+d][%5.3d]", 12, 12, 12, 12, 12);
+	format("18446744073709551615 -9223372036854775808", "%I64u %lld", 0xFFFFFFFFFFFFFFFFULL, (int64T)(-9223372036854775807LL - 1));
+	format("ab|   xyz|x  |c", "%.2s|%6s|%-3s|%c", "abcdef", "xyz", "x", 'c');
+	format("100%", "%d%%", 100);
+
+	format("3.141593 3.14 3 3.1416", "%f %.2f %.0f %.4f", 3.14159265, 3.14159265, 3.14159265, 3.14159265);
+	format("0.125 0.12 2 0.0", "%.3f %.2f %.0f %.1f", 0.125, 0.125, 2.5, 0.0);
+	format("1.000000e+21 1.5E-07 -0.00", "%e %.1E %.2f", 1e21, 1.5e-7, -0.0);
+	format("100000 1e+06 0.0001 1e-05 0.1 1.00000", "%g %g %g %g %g %#g", 100000.0, 1000000.0, 0.0001, 0.00001, 0.1, 1.0);
+	format("  1.50|1.50  |001.50|+1.5", "%6.2f|%-6.2f|%06.2f|%+g", 1.5, 1.5, 1.5, 1.5);
+	format("inf -INF", "%f %F", 1.0 / 0.0, -1.0 / 0.0);
+	//the exact binary value, not the shortest digits
+	format("0.1000000000000000055511", "%.22f", 0.1);
+	format("179769313486231570814527423731704356798070567525844996598917476803157260780028538760589558632766878171540458953514382464234321326889464182768467546703537516986049910576551282076245490090389328944075868508455133942304583236903222948165808559332123348274797826204144723168738177180919299881250404026184124858368.000000", "%f", 1.7976931348623157e308);
+	format("0 0 00", "%#.0o %#o %#.2o", 0, 0, 0);
+
+	//all the digits of the smallest double, then 0's past them
+	charT wide[2400];
+	auto length = Runtime_snprintf(wide, sizeof(wide), "%.1080f", 4.9406564584124654e-324);
+	EXPECT_EQ(length, 1082);
+	EXPECT_EQ(0, strncmp((const char*)wide + 1070, "2656250000000", 12));
+	EXPECT_EQ(wide[1075], '5');
+	length = Runtime_snprintf(wide, sizeof(wide), "%.1100e|%.1100g|%#.1080g", 0.5, 0.5, 0.5);
+	EXPECT_EQ(length, 1107 + 1 + 3 + 1 + 1081);
+	EXPECT_EQ(0, strncmp((const char*)wide + 1100, "00e-01|0.5|0.5000", 17));
+	EXPECT_EQ(wide[length - 1], '0');
+
+	//cut to fit, still reports the full length
+	EXPECT_EQ(Runtime_snprintf(buffer, 6, "%s", "overflowing"), 11);
+	EXPECT_STREQ((const char*)buffer, "overf");
+
+	auto policy = Runtime_output_flush_policy();
+	Runtime_output_set_flush_policy(rtFlushExplicit);
+	EXPECT_EQ(Runtime_output_flush_policy(), rtFlushExplicit);
+	Runtime_printf("buffered until the flush, %.2f\n", 1.25);
+	Runtime_output_write((const charT*)"written\n", 8);
+	Runtime_output_flush();
+	Runtime_output_set_flush_policy(policy);
+
+	Runtime_terminate();
+}
+
+//what the compiler does for a literal's hashval, Runtime_string_hash
+constexpr uint64T Test_static_string_hash(const char* chars, uint64T size)
+{
+	uint64T result = 0;
+	for (uint64T i = 0; i < size; i++) {
+		result ^= (uint8T)chars[i];
+		result *= 1099511628211ULL;
+	}
+	return result;
+}
+
+struct Test_long_static_string {
+	Runtime_static_string header;
+	charT rest[40 - Runtime_static_string_small_capacity];
+};
+
+//const, so they're in read only memory like the compiler's, any 
+//write would fault
+static const Runtime_static_string testShortLiteral = { testShortLiteral.chars, 5, Runtime_static_string_small_capacity, 
+	Test_static_string_hash("hello", 5), Runtime_static_string_flags | Runtime_static_string_utf8_valid, 1, "hello" };
+
+static const Test_long_static_string testLongLiteral = { { testLongLiteral.header.chars, 40, 40,
+	Test_static_string_hash("a literal longer than twenty three chars", 40), Runtime_static_string_flags | Runtime_static_string_utf8_valid, 1,
+	{ 'a',' ','l','i','t','e','r','a','l',' ','l','o','n','g','e','r',' ','t','h','a','n',' ','t','w' } }, "enty three chars" };
+
+TEST(TestScratchRuntime, Test_runtime_static_string) {
+
+	Runtime_init();
+
+	auto shortLit = (Runtime_string_handle)&testShortLiteral;
+	auto longLit = (Runtime_string_handle)&testLongLiteral;
+
+	EXPECT_TRUE(Runtime_string_is_immortal(shortLit));
+	EXPECT_EQ(Runtime_string_size(shortLit), 5);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(shortLit), "hello");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(longLit), "a literal longer than twenty three chars");
+	EXPECT_TRUE(Runtime_string_is_utf8(longLit));
+
+	auto heapStr = Runtime_string_new("a literal longer than twenty three chars");
+	EXPECT_FALSE(Runtime_string_is_immortal(heapStr));
+	EXPECT_EQ(Runtime_string_hash(longLit), Runtime_string_hash(heapStr));
+	EXPECT_TRUE(Runtime_string_equals(longLit, heapStr));
+	EXPECT_EQ(Runtime_string_find(longLit, shortLit), Runtime_NoIndx);
+
+	//views, copies and interning leave the literal alone
+	auto view = Runtime_string_substr(longLit, 2, 7);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(view), "literal");
+	Runtime_string_append(view, (const charT*)"s");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(view), "literals");
+	Runtime_string_delete(view);
+	view = Runtime_string_substr(longLit, 2, 7);
+	Runtime_string_delete(view);
+	EXPECT_EQ(testLongLiteral.header.refCount, 1);
+
+	auto copy = Runtime_string_new_copy(shortLit);
+	Runtime_string_append(copy, (const charT*)" world");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(copy), "hello world");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(shortLit), "hello");
+
+	auto interned = Runtime_string_intern(shortLit);
+	EXPECT_NE(interned, shortLit);
+	EXPECT_EQ(interned, Runtime_string_intern_cstr((const charT*)"hello"));
+
+	//a no-op
+	Runtime_string_delete(shortLit);
+	EXPECT_EQ(Runtime_string_size(shortLit), 5);
+
+	//changes are refused too, the literals are in read only memory
+	Runtime_string_append(longLit, (const charT*)"!");
+	Runtime_string_set(shortLit, 0, 'j');
+	Runtime_string_clear(shortLit);
+	Runtime_string_assign_copy(interned, copy);
+	Runtime_string_assign_char_count(interned, 'z', 2);
+	Runtime_string_set(interned, 0, 'j');
+	EXPECT_EQ(Runtime_string_size(longLit), 40);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(shortLit), "hello");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr(interned), "hello");
+	EXPECT_EQ(interned, Runtime_string_intern_cstr((const charT*)"hello"));
+
+	Runtime_string_delete(copy);
+	Runtime_string_delete(heapStr);
+
+	Runtime_terminate();
+}
+
+TEST(TestScratchRuntime, Test_runtime_dictionary_bytes) {
+
+	Runtime_init();
+
+	//keys are read straight out of one buffer, like a tokenizer would
+	const char* text = "alpha beta gamma alpha delta beta alpha";
+	auto dict = Runtime_dictionary_new(typeInteger32);
+	const char* start = text;
+	for (const char* p = text;; p++) {
+		if (' ' == *p || 0 == *p) {
+			auto count = (int32T*)Runtime_dictionary_at_bytes(dict, (const charT*)start, p - start);
+			int32T val = nullptr == count ? 1 : *count + 1;
+			Runtime_dictionary_insert_bytes(dict, (const charT*)start, p - start, &val);
+			if (0 == *p) {
+				break;
+			}
+			start = p + 1;
+		}
+	}
+	EXPECT_EQ(Runtime_dictionary_size(dict), 4);
+	EXPECT_EQ(*(int32T*)Runtime_dictionary_at_bytes(dict, (const charT*)"alpha", 5), 3);
+	EXPECT_EQ(*(int32T*)Runtime_dictionary_at_bytes(dict, (const charT*)"beta", 4), 2);
+	EXPECT_EQ(Runtime_dictionary_at_bytes(dict, (const charT*)"alph", 4), nullptr);
+
+	//same hash as the string, and lookups by string still work
+	auto alpha = Runtime_string_new("alpha");
+	EXPECT_EQ(Runtime_dictionary_hash_bytes((const charT*)"alpha", 5), Runtime_string_hash(alpha));
+	EXPECT_EQ(*(int32T*)Runtime_dictionary_at(dict, alpha), 3);
+
+	Runtime_dictionary_erase_bytes(dict, (const charT*)"alpha", 5);
+	EXPECT_EQ(Runtime_dictionary_at(dict, alpha), nullptr);
+	EXPECT_EQ(Runtime_dictionary_size(dict), 3);
+
+	//a hash computed once serves insert, lookup and erase
+	auto hash = Runtime_dictionary_hash_bytes((const charT*)"alpha", 5);
+	int32T seven = 7;
+	Runtime_dictionary_insert_hashed(dict, (const charT*)"alpha", 5, hash, &seven);
+	EXPECT_EQ(*(int32T*)Runtime_dictionary_at(dict, alpha), 7);
+	Runtime_dictionary_erase_hashed(dict, (const charT*)"alpha", 5, hash);
+	EXPECT_EQ(Runtime_dictionary_at_hashed(dict, (const charT*)"alpha", 5, hash), nullptr);
+	EXPECT_EQ(Runtime_dictionary_size(dict), 3);
+	Runtime_string_delete(alpha);
+	Runtime_dictionary_delete(dict);
+
+	//replacing a value keeps the key string that is already stored
+	auto names = Runtime_dictionary_new(typeString);
+	Runtime_dictionary_insert_bytes(names, (const charT*)"k", 1, Runtime_string_new("one"));
+	Runtime_dictionary_iter iter;
+	Runtime_dictionary_iter_init(names, &iter);
+	ASSERT_TRUE(Runtime_dictionary_iter_next(&iter));
+	auto storedKey = Runtime_dictionary_iter_key(&iter);
+	Runtime_dictionary_insert_bytes(names, (const charT*)"k", 1, Runtime_string_new("two"));
+	Runtime_dictionary_iter_init(names, &iter);
+	ASSERT_TRUE(Runtime_dictionary_iter_next(&iter));
+	EXPECT_EQ(Runtime_dictionary_iter_key(&iter), storedKey);
+	EXPECT_EQ(Runtime_dictionary_size(names), 1);
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr((Runtime_string_handle)Runtime_dictionary_at_bytes(names, (const charT*)"k", 1)), "two");
+	Runtime_dictionary_delete(names);
+
+	//one hash reused across dictionaries, and lookups while a
+	//resize is moving the entries over
+	auto first = Runtime_dictionary_new(typeString);
+	auto second = Runtime_dictionary_new_ordered(typeInteger64);
+	const int64T count = 20000;
+	for (int64T i = 0; i < count; i++) {
+		charT buf[] = "key00000";
+		for (int64T n = i, d = 7; d >= 3; d--, n /= 10) {
+			buf[d] = (charT)('0' + n % 10);
+		}
+		auto hash = Runtime_dictionary_hash_bytes(buf, 8);
+		Runtime_dictionary_insert_bytes(first, buf, 8, Runtime_string_new_with_size(buf, 8));
+		Runtime_dictionary_insert_bytes(second, buf, 8, &i);
+
+		auto str = (Runtime_string_handle)Runtime_dictionary_at_hashed(first, buf, 8, hash);
+		ASSERT_NE(str, nullptr);
+		EXPECT_STREQ((const char*)Runtime_string_get_cstr(str), (const char*)buf);
+		auto val = (int64T*)Runtime_dictionary_at_hashed(second, buf, 8, hash);
+		ASSERT_NE(val, nullptr);
+		EXPECT_EQ(*val, i);
+	}
+	EXPECT_EQ(Runtime_dictionary_size(first), count);
+	EXPECT_EQ(Runtime_dictionary_size(second), count);
+
+	Runtime_dictionary_delete(first);
+	Runtime_dictionary_delete(second);
+
+	Runtime_terminate();
+}
+
+struct TestScore {
+	int32T points;
+	int32T id;
+};
+
+//highest points first
+static int32T TestScore_compare(const void* lhs, const void* rhs)
+{
+	auto a = (const TestScore*)lhs;
+	auto b = (const TestScore*)rhs;
+	if (a->points != b->points) {
+		return a->points > b->points ? -1 : 1;
+	}
+	return a->id < b->id ? -1 : (a->id > b->id ? 1 : 0);
+}
+
+TEST(TestScratchRuntime, Test_runtime_ordered_map) {
+
+	Runtime_init();
+
+	//inserted out of order, enough to need several levels, then 
+	//every third key erased
+	const int64T count = 50000;
+	auto map = Runtime_ordered_map_new(typeInteger64, typeInteger64);
+	for (int64T i = 0; i < count; i++) {
+		int64T key = (i * 7919) % count;
+		int64T val = key * 2;
+		Runtime_ordered_map_insert(map, &key, &val);
+	}
+	EXPECT_EQ(Runtime_ordered_map_size(map), count);
+	for (int64T i = 0; i < count; i++) {
+		int64T key = (i * 104729) % count;
+		if (key % 3 == 0) {
+			EXPECT_TRUE(Runtime_ordered_map_erase(map, &key));
+		}
+	}
+	int64T missing = 3;
+	EXPECT_FALSE(Runtime_ordered_map_erase(map, &missing));
+	EXPECT_EQ(Runtime_ordered_map_at(map, &missing), nullptr);
+
+	Runtime_ordered_map_iter iter;
+	Runtime_ordered_map_iter_init(map, &iter);
+	int64T expected = 1;
+	uint64T seen = 0;
+	while (Runtime_ordered_map_iter_next(&iter)) {
+		EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), expected);
+		EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_value(&iter), expected * 2);
+		expected += expected % 3 == 1 ? 1 : 2;
+		seen++;
+	}
+	EXPECT_EQ(seen, Runtime_ordered_map_size(map));
+
+	Runtime_ordered_map_iter_init_reverse(map, &iter);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), count - 1);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), count - 3);
+
+	//bounds on an erased key and a present one
+	int64T low = 300;
+	Runtime_ordered_map_lower_bound(map, &iter, &low);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), 301);
+	low = 301;
+	Runtime_ordered_map_upper_bound(map, &iter, &low);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), 302);
+
+	int64T high = 310;
+	Runtime_ordered_map_range(map, &iter, &low, &high);
+	seen = 0;
+	while (Runtime_ordered_map_iter_next(&iter)) {
+		seen++;
+	}
+	EXPECT_EQ(seen, 6);
+	high = count;
+	Runtime_ordered_map_upper_bound(map, &iter, &high);
+	EXPECT_FALSE(Runtime_ordered_map_iter_next(&iter));
+
+	//erase everything, the tree shrinks back to nothing
+	for (int64T i = 0; i < count; i++) {
+		Runtime_ordered_map_erase(map, &i);
+	}
+	EXPECT_TRUE(Runtime_ordered_map_empty(map));
+	Runtime_ordered_map_iter_init(map, &iter);
+	EXPECT_FALSE(Runtime_ordered_map_iter_next(&iter));
+	Runtime_ordered_map_delete(map);
+
+	//bulk load, then changed like any other map
+	std::vector<int64T> keys;
+	std::vector<double64T> vals;
+	for (int64T i = 0; i < count; i++) {
+		keys.push_back(i * 10);
+		vals.push_back(i * 0.5);
+	}
+	map = Runtime_ordered_map_new_from_sorted(typeInteger64, typeDouble64, keys.data(), vals.data(), count);
+	EXPECT_EQ(Runtime_ordered_map_size(map), count);
+	int64T key = 12340;
+	EXPECT_EQ(*(double64T*)Runtime_ordered_map_at(map, &key), 617.0);
+	key = 12345;
+	double64T val = -1.0;
+	Runtime_ordered_map_insert(map, &key, &val);
+	for (int64T i = 0; i < count; i += 2) {
+		key = i * 10;
+		Runtime_ordered_map_erase(map, &key);
+	}
+	low = 12330;
+	Runtime_ordered_map_lower_bound(map, &iter, &low);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), 12330);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), 12345);
+	EXPECT_EQ(*(double64T*)Runtime_ordered_map_iter_value(&iter), -1.0);
+	ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+	EXPECT_EQ(*(int64T*)Runtime_ordered_map_iter_key(&iter), 12350);
+	EXPECT_EQ(Runtime_ordered_map_size(map), count / 2 + 1);
+	Runtime_ordered_map_delete(map);
+
+	//strings by their bytes, the map owns keys and values
+	auto strMap = Runtime_ordered_map_new(typeString, typeString);
+	const char* words[] = { "pear", "apple", "b", "aa", "apples", "fig" };
+	for (auto word : words) {
+		Runtime_ordered_map_insert(strMap, Runtime_string_new((const charT*)word), Runtime_string_new((const charT*)word));
+	}
+	Runtime_ordered_map_insert(strMap, Runtime_string_new("fig"), Runtime_string_new("dried"));
+	auto b = Runtime_string_new("b");
+	EXPECT_TRUE(Runtime_ordered_map_erase(strMap, b));
+	Runtime_string_delete(b);
+
+	const char* sorted[] = { "aa", "apple", "apples", "fig", "pear" };
+	Runtime_ordered_map_iter_init(strMap, &iter);
+	for (auto word : sorted) {
+		ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+		EXPECT_STREQ((const char*)Runtime_string_get_cstr((Runtime_string_handle)Runtime_ordered_map_iter_key(&iter)), word);
+	}
+	EXPECT_FALSE(Runtime_ordered_map_iter_next(&iter));
+
+	auto fig = Runtime_string_new("fig");
+	EXPECT_STREQ((const char*)Runtime_string_get_cstr((Runtime_string_handle)Runtime_ordered_map_at(strMap, fig)), "dried");
+	Runtime_string_delete(fig);
+	Runtime_ordered_map_delete(strMap);
+
+	//user type keys ordered by their compare hook, a leaderboard
+	Runtime_type_info info = {};
+	info.baseType = typeRecord;
+	info.size = sizeof(TestScore);
+	info.alignment = alignof(TestScore);
+	info.compare = TestScore_compare;
+	info.name = "TestScore";
+	auto scoreType = Runtime_register_type(&info);
+
+	auto board = Runtime_ordered_map_new(scoreType, typeInteger32);
+	TestScore scores[] = { { 10, 1 }, { 50, 2 }, { 30, 3 }, { 50, 4 } };
+	for (auto& score : scores) {
+		Runtime_ordered_map_insert(board, &score, &score.id);
+	}
+	int32T ranking[] = { 2, 4, 3, 1 };
+	Runtime_ordered_map_iter_init(board, &iter);
+	for (auto id : ranking) {
+		ASSERT_TRUE(Runtime_ordered_map_iter_next(&iter));
+		EXPECT_EQ(*(int32T*)Runtime_ordered_map_iter_value(&iter), id);
+	}
+	Runtime_ordered_map_delete(board);
+
+	Runtime_terminate();
+}